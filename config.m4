@@ -28,9 +28,41 @@ if test "$PHP_XDEBUG" != "no"; then
 
   PHP_CHECK_LIBRARY(m, cos, [ PHP_ADD_LIBRARY(m,, XDEBUG_SHARED_LIBADD) ])
 
+  dnl xdebug_sampler.c and xdebug_compress.c don't include config.h, so they are told
+  dnl about the functions and libraries they can use on the command line
+  XDEBUG_CFLAGS=""
+
+  dnl xdebug.profiler_mode=sample
+  PHP_CHECK_LIBRARY(rt, timer_create, [
+    PHP_ADD_LIBRARY(rt,, XDEBUG_SHARED_LIBADD)
+    XDEBUG_CFLAGS="$XDEBUG_CFLAGS -DXDEBUG_HAVE_TIMER_CREATE"
+  ], [
+    AC_CHECK_FUNC(timer_create, [ XDEBUG_CFLAGS="$XDEBUG_CFLAGS -DXDEBUG_HAVE_TIMER_CREATE" ])
+  ])
+
+  dnl xdebug.output_compression
+  PHP_CHECK_LIBRARY(z, deflateInit2_, [
+    AC_CHECK_HEADER([zlib.h], [
+      PHP_ADD_LIBRARY(z,, XDEBUG_SHARED_LIBADD)
+      XDEBUG_CFLAGS="$XDEBUG_CFLAGS -DXDEBUG_HAVE_ZLIB"
+    ])
+  ])
+  PHP_CHECK_LIBRARY(zstd, ZSTD_compressStream2, [
+    AC_CHECK_HEADER([zstd.h], [
+      PHP_ADD_LIBRARY(zstd,, XDEBUG_SHARED_LIBADD)
+      XDEBUG_CFLAGS="$XDEBUG_CFLAGS -DXDEBUG_HAVE_ZSTD"
+    ])
+  ])
+  PHP_CHECK_LIBRARY(pthread, pthread_create, [ PHP_ADD_LIBRARY(pthread,, XDEBUG_SHARED_LIBADD) ])
+
   CPPFLAGS=$old_CPPFLAGS
 
-  PHP_NEW_EXTENSION(xdebug, xdebug.c xdebug_branch_info.c xdebug_code_coverage.c xdebug_com.c xdebug_compat.c xdebug_handler_dbgp.c xdebug_handlers.c xdebug_llist.c xdebug_monitor.c xdebug_hash.c xdebug_private.c xdebug_profiler.c xdebug_set.c xdebug_stack.c xdebug_str.c xdebug_superglobals.c xdebug_tracing.c xdebug_trace_textual.c xdebug_trace_computerized.c xdebug_trace_html.c xdebug_var.c xdebug_xml.c usefulstuff.c phuck_off.c phuck_off_logger.c phuck_off_mmap.c phuck_off_parser.c phuck_off_sanity_check.c, $ext_shared,,,,yes)
+  dnl the phuck_off sources don't include php_config.h, so they can't see ZTS themselves
+  if test "$PHP_THREAD_SAFETY" = "yes"; then
+    XDEBUG_CFLAGS="$XDEBUG_CFLAGS -DPHUCK_OFF_ZTS"
+  fi
+
+  PHP_NEW_EXTENSION(xdebug, xdebug.c xdebug_aggr_shm.c xdebug_arena.c xdebug_branch_info.c xdebug_clock.c xdebug_code_coverage.c xdebug_com.c xdebug_compat.c xdebug_compress.c xdebug_handler_dbgp.c xdebug_handlers.c xdebug_llist.c xdebug_monitor.c xdebug_hash.c xdebug_intern.c xdebug_private.c xdebug_profiler.c xdebug_sampler.c xdebug_set.c xdebug_stack.c xdebug_str.c xdebug_superglobals.c xdebug_tracing.c xdebug_trace_textual.c xdebug_trace_computerized.c xdebug_trace_html.c xdebug_var.c xdebug_xml.c usefulstuff.c phuck_off.c phuck_off_ignore.c phuck_off_logger.c phuck_off_mmap.c phuck_off_parser.c phuck_off_placement.c phuck_off_sanity_check.c, $ext_shared,,$XDEBUG_CFLAGS,,yes)
   PHP_SUBST(XDEBUG_SHARED_LIBADD)
   PHP_ADD_MAKEFILE_FRAGMENT
 fi
@@ -30,9 +30,13 @@
 #include "php.h"
 
 #include "xdebug_compat.h"
+#include "xdebug_arena.h"
+#include "xdebug_clock.h"
+#include "xdebug_intern.h"
 #include "xdebug_handlers.h"
 #include "xdebug_hash.h"
 #include "xdebug_llist.h"
+#include "xdebug_str.h"
 #include "xdebug_branch_info.h"
 #include "xdebug_code_coverage.h"
 
@@ -115,6 +119,7 @@ PHP_FUNCTION(xdebug_get_monitored_functions);
 PHP_FUNCTION(xdebug_get_profiler_filename);
 PHP_FUNCTION(xdebug_dump_aggr_profiling_data);
 PHP_FUNCTION(xdebug_clear_aggr_profiling_data);
+PHP_FUNCTION(xdebug_get_aggr_profiling_data);
 
 /* misc functions */
 PHP_FUNCTION(xdebug_dump_superglobals);
@@ -129,6 +134,10 @@ ZEND_BEGIN_MODULE_GLOBALS(xdebug)
 
 	unsigned long level;
 	xdebug_llist *stack;
+	struct _function_stack_entry **stack_segments;
+	unsigned int  stack_segment_count;
+	xdebug_arena  request_arena;
+	xdebug_intern_table interned_strings;
 	iniLONG       max_nesting_level;
 	iniLONG       max_stack_frames;
 	zend_bool     default_enable;
@@ -142,7 +151,9 @@ ZEND_BEGIN_MODULE_GLOBALS(xdebug)
 	zend_bool     show_error_trace;
 	zend_bool     show_local_vars;
 	zend_bool     show_mem_delta;
-	double        start_time;
+	uint64_t      start_time; /* from xdebug_get_nanotime() */
+	char         *clock_source; /* "auto", "tsc" or "monotonic" */
+	char         *output_compression; /* "", "none", "gzip" or "zstd" */
 	HashTable    *active_symbol_table;
 	zend_execute_data *active_execute_data;
 	zval              *This;
@@ -167,6 +178,8 @@ ZEND_BEGIN_MODULE_GLOBALS(xdebug)
 	char         *trace_enable_trigger_value;
 	char         *trace_output_dir;
 	char         *trace_output_name;
+	double        trace_sample_rate;
+	char         *trace_sample_rate_uris;
 	iniLONG       trace_options;
 	iniLONG       trace_format;
 	char         *last_exception_trace;
@@ -261,15 +274,39 @@ ZEND_BEGIN_MODULE_GLOBALS(xdebug)
 	zend_bool     profiler_enable_trigger;
 	char         *profiler_enable_trigger_value;
 	zend_bool     profiler_append;
+	long          profiler_buffer_size;
+	long          profiler_mode; /* XDEBUG_PROFILER_INSTRUMENT, XDEBUG_PROFILER_SAMPLE */
+	long          profiler_sample_interval; /* in microseconds of CPU time */
+	zend_bool     profiler_call_paths;
+	zend_bool     profiler_overhead_compensation;
+	double        profiler_sample_rate;
+	char         *profiler_sample_rate_uris; /* "/prefix=rate,..." */
+
+	/* request sampling */
+	zend_bool     sampling_decided;
+	uint64_t      sample_rng_state;
+	long          sample_rng_pid;
 
 	/* profiler globals */
 	zend_bool     profiler_enabled;
 	FILE         *profile_file;
 	char         *profile_filename;
-	xdebug_hash  *profile_filename_refs;
+	xdebug_str    profile_buffer;
+	long          profile_pid; /* process that opened profile_file */
+	unsigned int  profile_refs_generation; /* see xdebug_interned_string */
 	int           profile_last_filename_ref;
-	xdebug_hash  *profile_functionname_refs;
 	int           profile_last_functionname_ref;
+	char         *profile_internal_filename;
+	xdebug_hash  *profile_paths; /* (parent id, function) -> xdebug_path_node */
+	struct _xdebug_path_node *profile_path_root;
+	unsigned int  profile_last_path_id;
+
+	/* The profiler's own time per call, in nanoseconds, that ends up inside
+	 * a call's time, and that its caller is charged for around it */
+	zend_bool     profiler_calibrated; /* 1 for calls, 2 for call paths */
+	zend_bool     profiler_calibrating;
+	uint64_t      profiler_overhead_inner;
+	uint64_t      profiler_overhead_outer;
 
 	/* DBGp globals */
 	char         *lastcmd;
@@ -281,6 +318,8 @@ ZEND_BEGIN_MODULE_GLOBALS(xdebug)
 	/* aggregate profiling */
 	HashTable  aggr_calls;
 	zend_bool  profiler_aggregate;
+	zend_bool  profiler_aggregate_shared;
+	long       profiler_aggregate_shared_slots;
 
 	/* scream */
 	zend_bool  do_scream;
@@ -22,12 +22,16 @@ typedef struct phuck_off {
     char* user_code_root;
     size_t user_code_root_len;
     size_t function_count;
-    // maps each absolute file path to a xdebug_hash* mapping
-    // its functions' line numbers to their line # in the input file, or NULL if the file is ignored
-    xdebug_hash* files;
+    // maps each absolute file path to its functions' line numbers and their
+    // line # in the input file, built per file on first use
+    phuck_off_index* index;
+    // files and directories the dumper skipped
+    phuck_off_ignore* ignored;
 } phuck_off;
 
-static phuck_off handler = { 0, NULL, 0, 0, NULL };
+// built in MINIT, before any request thread exists; after that only the index's per-file line maps
+// get filled in, see phuck_off_index_find()
+static phuck_off handler = { 0, NULL, 0, 0, NULL, NULL };
 
 static int phuck_off_is_enabled(void) {
     const char* enabled = getenv(PHUCK_OFF_ENABLED_ENV_VAR);
@@ -49,34 +53,42 @@ static int function_id(const char* path, const int line_no, const char* function
         return -1;
     }
 
-    const size_t path_len = strlen(path);
-    void* file_entry;
-    if (!xdebug_hash_find(handler.files, (char*) path, (unsigned int) path_len, &file_entry)) {
-        // we found a file that the dumper missed
-        phuck_off_log(PHUCK_OFF_LOG_LEVEL_ERROR, "No function map entry for \"%s\":%d:%s", path, line_no, function_name);
+    if (phuck_off_ignore_match(handler.ignored, path)) {
         return -1;
     }
 
-    if (file_entry == NULL) {
-        // means we ignore this file
-        return -1;
-    }
+    const size_t path_len = strlen(path);
+    unsigned long id = 0;
+    char error[512];
 
-    xdebug_hash* line_map = (xdebug_hash*) file_entry;
-    void* line_entry = NULL;
-    if (!xdebug_hash_index_find(line_map, (unsigned long) line_no, &line_entry)) {
-        // we found a function that the dumper missed
-        phuck_off_log(PHUCK_OFF_LOG_LEVEL_ERROR, "No function id entry for \"%s\":%d:%s", path, line_no, function_name);
-        return -1;
-    }
+    switch (phuck_off_index_find(handler.index, path, path_len, (unsigned long) line_no, &id, error, sizeof(error))) {
+        case PHUCK_OFF_INDEX_FOUND:
+            return (int) id;
 
-    return (int) (uintptr_t) line_entry;
+        case PHUCK_OFF_INDEX_MISSING_FILE:
+            // we found a file that the dumper missed
+            phuck_off_log(PHUCK_OFF_LOG_LEVEL_ERROR, "No function map entry for \"%s\":%d:%s", path, line_no, function_name);
+            return -1;
+
+        case PHUCK_OFF_INDEX_ERROR:
+            phuck_off_log(PHUCK_OFF_LOG_LEVEL_ERROR, "Failed to load function map for \"%s\" from %s: %s", path, PHUCK_OFF_FUNCS_PATH, error);
+            return -1;
+
+        default:
+            // we found a function that the dumper missed
+            phuck_off_log(PHUCK_OFF_LOG_LEVEL_ERROR, "No function id entry for \"%s\":%d:%s", path, line_no, function_name);
+            return -1;
+    }
 }
 
 static void shutdown_handler(void) {
-    if (handler.files != NULL) {
-        xdebug_hash_destroy(handler.files);
-        handler.files = NULL;
+    if (handler.index != NULL) {
+        phuck_off_index_destroy(handler.index);
+        handler.index = NULL;
+    }
+    if (handler.ignored != NULL) {
+        phuck_off_ignore_destroy(handler.ignored);
+        handler.ignored = NULL;
     }
     if (handler.user_code_root != NULL) {
         free(handler.user_code_root);
@@ -92,12 +104,24 @@ static void init_handler(void) {
 
     shutdown_handler();
 
-    if (!phuck_off_parse_funcs_file(PHUCK_OFF_FUNCS_PATH, &handler.files, &handler.user_code_root, &handler.function_count, error, sizeof(error))) {
+    if (!phuck_off_parse_funcs_file(PHUCK_OFF_FUNCS_PATH, &handler.index, &handler.ignored, &handler.user_code_root, &handler.function_count, error, sizeof(error))) {
         phuck_off_log(PHUCK_OFF_LOG_LEVEL_ERROR, "Failed to initialize handler from %s: %s", PHUCK_OFF_FUNCS_PATH, error);
         handler.initialized = 0;
         return;
     }
 
+    if (handler.index->region) {
+        phuck_off_log(
+            PHUCK_OFF_LOG_LEVEL_DEBUG,
+            "phuck-off index placement bytes=%lu huge_pages=%s numa_interleave=%s",
+            (unsigned long) handler.index->region->size,
+            handler.index->region->huge_pages,
+            handler.index->region->numa_interleave
+        );
+    } else if (phuck_off_placement_requested()) {
+        phuck_off_log(PHUCK_OFF_LOG_LEVEL_WARN, "Failed to place the phuck-off index, it stays on the heap");
+    }
+
     handler.user_code_root_len = strlen(handler.user_code_root);
     handler.initialized = 1;
 }
@@ -165,7 +189,9 @@ void phuck_off_process_stackframe(zend_execute_data* zdata, zend_op_array* op_ar
 
     const int phuck_off_offset = XG(phuck_off_tracker_offset);
     const int line_no = op_array->line_start;
-    const int cached_id = (int) (intptr_t) op_array->reserved[phuck_off_offset];
+    // op_arrays can be shared between threads, in which case they might all cache the ID at once,
+    // always the same one though
+    const int cached_id = (int) (intptr_t) phuck_off_atomic_load(&op_array->reserved[phuck_off_offset]);
     int retrieve_from_handler = cached_id == 0 ? 1 : 0;
     int func_id = cached_id;
 
@@ -179,10 +205,10 @@ void phuck_off_process_stackframe(zend_execute_data* zdata, zend_op_array* op_ar
         func_id = function_id(path, line_no, function_name);
 
         if (cached_id == 0) {
-            op_array->reserved[phuck_off_offset] = (void*) (intptr_t) func_id;
+            phuck_off_atomic_store(&op_array->reserved[phuck_off_offset], (void*) (intptr_t) func_id);
             phuck_off_log(PHUCK_OFF_LOG_LEVEL_TRACE, "Caching: function %s:%d is ID %d", path, line_no, func_id);
         } else if (cached_id != func_id) {
-            op_array->reserved[phuck_off_offset] = (void*) (intptr_t) func_id;
+            phuck_off_atomic_store(&op_array->reserved[phuck_off_offset], (void*) (intptr_t) func_id);
             phuck_off_log(PHUCK_OFF_LOG_LEVEL_ERROR, "Cache error!! function %s:%d is ID %d, but cached is %d",
                           path, line_no, func_id, cached_id);
         } else {
@@ -192,7 +218,10 @@ void phuck_off_process_stackframe(zend_execute_data* zdata, zend_op_array* op_ar
         phuck_off_log(PHUCK_OFF_LOG_LEVEL_TRACE, "Already cached: function %s:%d is ID %d", path, line_no, func_id);
     }
 
-    if (func_id > 0 && phuck_off_mmap_bytes != NULL) {
-        phuck_off_mmap_set(func_id - 1);
+    if (phuck_off_mmap_bytes != NULL) {
+        if (func_id > 0) {
+            phuck_off_mmap_set(func_id - 1);
+        }
+        phuck_off_mmap_tick();
     }
 }
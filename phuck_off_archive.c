@@ -0,0 +1,767 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "phuck_off_archive.h"
+
+typedef enum {
+    PHUCK_OFF_ARCHIVE_MERGE_UNION        = 0,
+    PHUCK_OFF_ARCHIVE_MERGE_INTERSECTION = 1,
+    PHUCK_OFF_ARCHIVE_MERGE_DIFFERENCE   = 2
+} phuck_off_archive_merge_mode;
+
+static inline unsigned int phuck_off_archive_popcount(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned int) __builtin_popcountll(word);
+#else
+    unsigned int count = 0;
+
+    while (word) {
+        word &= word - 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+static inline unsigned int phuck_off_archive_ctz(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned int) __builtin_ctzll(word);
+#else
+    unsigned int count = 0;
+
+    while (!(word & 1u)) {
+        word >>= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+// number of meaningful bits in the given chunk, only the last one can be partial
+static uint32_t phuck_off_archive_chunk_limit(const phuck_off_archive* archive, uint32_t key) {
+    const uint64_t start = (uint64_t) key * PHUCK_OFF_ARCHIVE_CHUNK_BITS;
+    const uint64_t remaining = archive->bit_count - start;
+
+    return remaining >= PHUCK_OFF_ARCHIVE_CHUNK_BITS ? PHUCK_OFF_ARCHIVE_CHUNK_BITS : (uint32_t) remaining;
+}
+
+static phuck_off_archive* phuck_off_archive_alloc(uint64_t bit_count, size_t capacity) {
+    phuck_off_archive* archive;
+
+    archive = (phuck_off_archive*) calloc(1, sizeof(phuck_off_archive));
+    if (!archive) {
+        return NULL;
+    }
+
+    archive->bit_count = bit_count;
+    if (capacity > 0) {
+        archive->containers = (phuck_off_archive_container*) malloc(capacity * sizeof(phuck_off_archive_container));
+        if (!archive->containers) {
+            free(archive);
+            return NULL;
+        }
+    }
+    archive->capacity = capacity;
+
+    return archive;
+}
+
+void phuck_off_archive_destroy(phuck_off_archive* archive) {
+    size_t i;
+
+    if (!archive) {
+        return;
+    }
+
+    for (i = 0; i < archive->count; i++) {
+        free(archive->containers[i].data);
+    }
+    free(archive->containers);
+    free(archive);
+}
+
+// takes ownership of container->data, and frees it on failure
+static int phuck_off_archive_append(phuck_off_archive* archive, phuck_off_archive_container* container) {
+    if (archive->count == archive->capacity) {
+        const size_t capacity = archive->capacity == 0 ? 8 : archive->capacity * 2;
+        phuck_off_archive_container* tmp;
+
+        tmp = (phuck_off_archive_container*) realloc(archive->containers, capacity * sizeof(phuck_off_archive_container));
+        if (!tmp) {
+            free(container->data);
+            return 0;
+        }
+        archive->containers = tmp;
+        archive->capacity = capacity;
+    }
+
+    archive->containers[archive->count++] = *container;
+    return 1;
+}
+
+static int phuck_off_archive_positions_contain(const uint16_t* positions, uint32_t count, uint32_t position) {
+    uint32_t low = 0;
+    uint32_t high = count;
+
+    while (low < high) {
+        const uint32_t mid = low + (high - low) / 2;
+
+        if (positions[mid] == position) {
+            return 1;
+        }
+        if (positions[mid] < position) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return 0;
+}
+
+static int phuck_off_archive_container_contains(const phuck_off_archive_container* container, uint32_t position) {
+    switch (container->type) {
+        case PHUCK_OFF_ARCHIVE_ARRAY:
+            return phuck_off_archive_positions_contain((const uint16_t*) container->data, container->count, position);
+        case PHUCK_OFF_ARCHIVE_INVERTED:
+            return !phuck_off_archive_positions_contain((const uint16_t*) container->data, container->count, position);
+        default:
+            return (int) ((((const uint64_t*) container->data)[position >> 6] >> (position & 63u)) & 1u);
+    }
+}
+
+// writes the positions of the set (or clear, if inverted) bits among the first limit ones
+static uint32_t phuck_off_archive_words_to_positions(const uint64_t* words, uint32_t limit, int inverted, uint16_t* positions) {
+    uint32_t count = 0;
+    uint32_t i;
+
+    for (i = 0; i * 64u < limit; i++) {
+        uint64_t word = inverted ? ~words[i] : words[i];
+
+        if ((i + 1) * 64u > limit) {
+            word &= (((uint64_t) 1) << (limit - i * 64u)) - 1u;
+        }
+        while (word) {
+            positions[count++] = (uint16_t) (i * 64u + phuck_off_archive_ctz(word));
+            word &= word - 1;
+        }
+    }
+
+    return count;
+}
+
+static void phuck_off_archive_container_to_words(const phuck_off_archive_container* container, uint32_t limit, uint64_t* words) {
+    const uint16_t* positions = (const uint16_t*) container->data;
+    uint32_t i;
+
+    switch (container->type) {
+        case PHUCK_OFF_ARCHIVE_ARRAY:
+            memset(words, 0, PHUCK_OFF_ARCHIVE_CHUNK_WORDS * sizeof(uint64_t));
+            for (i = 0; i < container->count; i++) {
+                words[positions[i] >> 6] |= ((uint64_t) 1) << (positions[i] & 63u);
+            }
+            break;
+        case PHUCK_OFF_ARCHIVE_INVERTED:
+            memset(words, 0, PHUCK_OFF_ARCHIVE_CHUNK_WORDS * sizeof(uint64_t));
+            memset(words, 0xff, (limit >> 6) * sizeof(uint64_t));
+            if (limit & 63u) {
+                words[limit >> 6] = (((uint64_t) 1) << (limit & 63u)) - 1u;
+            }
+            for (i = 0; i < container->count; i++) {
+                words[positions[i] >> 6] &= ~(((uint64_t) 1) << (positions[i] & 63u));
+            }
+            break;
+        default:
+            memcpy(words, container->data, PHUCK_OFF_ARCHIVE_CHUNK_WORDS * sizeof(uint64_t));
+            break;
+    }
+}
+
+// picks the smallest container for the given chunk bits, and appends it unless it's empty
+static int phuck_off_archive_append_words(phuck_off_archive* archive, uint32_t key, const uint64_t* words) {
+    const uint32_t limit = phuck_off_archive_chunk_limit(archive, key);
+    phuck_off_archive_container container;
+    uint32_t cardinality = 0;
+    uint32_t i;
+
+    for (i = 0; i < PHUCK_OFF_ARCHIVE_CHUNK_WORDS; i++) {
+        cardinality += phuck_off_archive_popcount(words[i]);
+    }
+    if (cardinality == 0) {
+        return 1;
+    }
+
+    container.key = key;
+    container.cardinality = cardinality;
+
+    if (cardinality <= PHUCK_OFF_ARCHIVE_ARRAY_MAX || limit - cardinality <= PHUCK_OFF_ARCHIVE_ARRAY_MAX) {
+        const int inverted = cardinality > PHUCK_OFF_ARCHIVE_ARRAY_MAX;
+        const uint32_t count = inverted ? limit - cardinality : cardinality;
+
+        container.type = inverted ? PHUCK_OFF_ARCHIVE_INVERTED : PHUCK_OFF_ARCHIVE_ARRAY;
+        // + 1 so that a full chunk doesn't ask for a 0-byte allocation
+        container.data = malloc((count + 1) * sizeof(uint16_t));
+        if (!container.data) {
+            return 0;
+        }
+        container.count = phuck_off_archive_words_to_positions(words, limit, inverted, (uint16_t*) container.data);
+    } else {
+        container.type = PHUCK_OFF_ARCHIVE_BITMAP;
+        container.count = 0;
+        container.data = malloc(PHUCK_OFF_ARCHIVE_CHUNK_WORDS * sizeof(uint64_t));
+        if (!container.data) {
+            return 0;
+        }
+        memcpy(container.data, words, PHUCK_OFF_ARCHIVE_CHUNK_WORDS * sizeof(uint64_t));
+    }
+
+    return phuck_off_archive_append(archive, &container);
+}
+
+// positions is a malloc'd buffer, whose ownership is taken
+static int phuck_off_archive_append_positions(
+    phuck_off_archive* archive,
+    uint32_t key,
+    uint32_t type,
+    uint16_t* positions,
+    uint32_t count
+) {
+    const uint32_t limit = phuck_off_archive_chunk_limit(archive, key);
+    phuck_off_archive_container container;
+
+    container.key = key;
+    container.type = type;
+    container.count = count;
+    container.cardinality = type == PHUCK_OFF_ARCHIVE_ARRAY ? count : limit - count;
+    container.data = positions;
+
+    if (container.cardinality == 0) {
+        free(positions);
+        return 1;
+    }
+
+    return phuck_off_archive_append(archive, &container);
+}
+
+static uint32_t phuck_off_archive_merge_positions(
+    const uint16_t* a,
+    uint32_t a_count,
+    const uint16_t* b,
+    uint32_t b_count,
+    phuck_off_archive_merge_mode mode,
+    uint16_t* out
+) {
+    uint32_t i = 0;
+    uint32_t j = 0;
+    uint32_t count = 0;
+
+    while (i < a_count && j < b_count) {
+        if (a[i] == b[j]) {
+            if (mode != PHUCK_OFF_ARCHIVE_MERGE_DIFFERENCE) {
+                out[count++] = a[i];
+            }
+            i++;
+            j++;
+        } else if (a[i] < b[j]) {
+            if (mode != PHUCK_OFF_ARCHIVE_MERGE_INTERSECTION) {
+                out[count++] = a[i];
+            }
+            i++;
+        } else {
+            if (mode == PHUCK_OFF_ARCHIVE_MERGE_UNION) {
+                out[count++] = b[j];
+            }
+            j++;
+        }
+    }
+
+    if (mode != PHUCK_OFF_ARCHIVE_MERGE_INTERSECTION) {
+        while (i < a_count) {
+            out[count++] = a[i++];
+        }
+    }
+    if (mode == PHUCK_OFF_ARCHIVE_MERGE_UNION) {
+        while (j < b_count) {
+            out[count++] = b[j++];
+        }
+    }
+
+    return count;
+}
+
+static int phuck_off_archive_copy_container(phuck_off_archive* archive, const phuck_off_archive_container* source) {
+    phuck_off_archive_container container = *source;
+    const size_t size = source->type == PHUCK_OFF_ARCHIVE_BITMAP
+        ? PHUCK_OFF_ARCHIVE_CHUNK_WORDS * sizeof(uint64_t)
+        : (source->count + 1) * sizeof(uint16_t);
+
+    container.data = malloc(size);
+    if (!container.data) {
+        return 0;
+    }
+    memcpy(container.data, source->data, size);
+
+    return phuck_off_archive_append(archive, &container);
+}
+
+// merges two position containers, a and b's types say whether these are set or clear positions
+static int phuck_off_archive_merge_position_containers(
+    phuck_off_archive* archive,
+    const phuck_off_archive_container* a,
+    const phuck_off_archive_container* b,
+    phuck_off_archive_merge_mode mode,
+    uint32_t type
+) {
+    uint16_t* positions;
+    uint32_t count;
+
+    positions = (uint16_t*) malloc((a->count + b->count + 1) * sizeof(uint16_t));
+    if (!positions) {
+        return 0;
+    }
+
+    count = phuck_off_archive_merge_positions(
+        (const uint16_t*) a->data, a->count, (const uint16_t*) b->data, b->count, mode, positions
+    );
+
+    if (count > PHUCK_OFF_ARCHIVE_ARRAY_MAX) {
+        // only happens when merging two arrays of set (resp. clear) bits into a bigger one
+        const phuck_off_archive_container merged = { a->key, type, count, 0, positions };
+        uint64_t words[PHUCK_OFF_ARCHIVE_CHUNK_WORDS];
+
+        phuck_off_archive_container_to_words(&merged, phuck_off_archive_chunk_limit(archive, a->key), words);
+        free(positions);
+        return phuck_off_archive_append_words(archive, a->key, words);
+    }
+
+    return phuck_off_archive_append_positions(archive, a->key, type, positions, count);
+}
+
+static int phuck_off_archive_union_containers(
+    phuck_off_archive* archive,
+    const phuck_off_archive_container* a,
+    const phuck_off_archive_container* b
+) {
+    const uint32_t limit = phuck_off_archive_chunk_limit(archive, a->key);
+    uint64_t words[PHUCK_OFF_ARCHIVE_CHUNK_WORDS];
+    uint64_t other[PHUCK_OFF_ARCHIVE_CHUNK_WORDS];
+    uint32_t i;
+
+    if (a->type == PHUCK_OFF_ARCHIVE_ARRAY && b->type == PHUCK_OFF_ARCHIVE_ARRAY) {
+        return phuck_off_archive_merge_position_containers(archive, a, b, PHUCK_OFF_ARCHIVE_MERGE_UNION, PHUCK_OFF_ARCHIVE_ARRAY);
+    }
+    if (a->type == PHUCK_OFF_ARCHIVE_INVERTED && b->type == PHUCK_OFF_ARCHIVE_INVERTED) {
+        // a bit is clear in the union iff it's clear in both
+        return phuck_off_archive_merge_position_containers(archive, a, b, PHUCK_OFF_ARCHIVE_MERGE_INTERSECTION, PHUCK_OFF_ARCHIVE_INVERTED);
+    }
+    if (a->type == PHUCK_OFF_ARCHIVE_INVERTED && b->type == PHUCK_OFF_ARCHIVE_ARRAY) {
+        return phuck_off_archive_merge_position_containers(archive, a, b, PHUCK_OFF_ARCHIVE_MERGE_DIFFERENCE, PHUCK_OFF_ARCHIVE_INVERTED);
+    }
+    if (a->type == PHUCK_OFF_ARCHIVE_ARRAY && b->type == PHUCK_OFF_ARCHIVE_INVERTED) {
+        return phuck_off_archive_merge_position_containers(archive, b, a, PHUCK_OFF_ARCHIVE_MERGE_DIFFERENCE, PHUCK_OFF_ARCHIVE_INVERTED);
+    }
+
+    // at least one side is raw bits
+    if (a->type == PHUCK_OFF_ARCHIVE_BITMAP) {
+        const phuck_off_archive_container* swap = a;
+
+        a = b;
+        b = swap;
+    }
+    memcpy(words, b->data, sizeof(words));
+    if (a->type == PHUCK_OFF_ARCHIVE_ARRAY) {
+        const uint16_t* positions = (const uint16_t*) a->data;
+
+        for (i = 0; i < a->count; i++) {
+            words[positions[i] >> 6] |= ((uint64_t) 1) << (positions[i] & 63u);
+        }
+    } else {
+        phuck_off_archive_container_to_words(a, limit, other);
+        for (i = 0; i < PHUCK_OFF_ARCHIVE_CHUNK_WORDS; i++) {
+            words[i] |= other[i];
+        }
+    }
+
+    return phuck_off_archive_append_words(archive, a->key, words);
+}
+
+static int phuck_off_archive_intersect_containers(
+    phuck_off_archive* archive,
+    const phuck_off_archive_container* a,
+    const phuck_off_archive_container* b
+) {
+    const uint32_t limit = phuck_off_archive_chunk_limit(archive, a->key);
+    uint64_t words[PHUCK_OFF_ARCHIVE_CHUNK_WORDS];
+    uint64_t other[PHUCK_OFF_ARCHIVE_CHUNK_WORDS];
+    uint32_t i;
+
+    if (a->type == PHUCK_OFF_ARCHIVE_ARRAY && b->type == PHUCK_OFF_ARCHIVE_ARRAY) {
+        return phuck_off_archive_merge_position_containers(archive, a, b, PHUCK_OFF_ARCHIVE_MERGE_INTERSECTION, PHUCK_OFF_ARCHIVE_ARRAY);
+    }
+    if (a->type == PHUCK_OFF_ARCHIVE_INVERTED && b->type == PHUCK_OFF_ARCHIVE_INVERTED) {
+        // a bit is clear in the intersection iff it's clear in either
+        return phuck_off_archive_merge_position_containers(archive, a, b, PHUCK_OFF_ARCHIVE_MERGE_UNION, PHUCK_OFF_ARCHIVE_INVERTED);
+    }
+    if (a->type != PHUCK_OFF_ARCHIVE_ARRAY && b->type == PHUCK_OFF_ARCHIVE_ARRAY) {
+        const phuck_off_archive_container* swap = a;
+
+        a = b;
+        b = swap;
+    }
+    if (a->type == PHUCK_OFF_ARCHIVE_ARRAY) {
+        // the result can only be smaller than a, so just filter it
+        const uint16_t* positions = (const uint16_t*) a->data;
+        uint16_t* filtered;
+        uint32_t count = 0;
+
+        filtered = (uint16_t*) malloc((a->count + 1) * sizeof(uint16_t));
+        if (!filtered) {
+            return 0;
+        }
+        for (i = 0; i < a->count; i++) {
+            if (phuck_off_archive_container_contains(b, positions[i])) {
+                filtered[count++] = positions[i];
+            }
+        }
+
+        return phuck_off_archive_append_positions(archive, a->key, PHUCK_OFF_ARCHIVE_ARRAY, filtered, count);
+    }
+
+    phuck_off_archive_container_to_words(a, limit, words);
+    phuck_off_archive_container_to_words(b, limit, other);
+    for (i = 0; i < PHUCK_OFF_ARCHIVE_CHUNK_WORDS; i++) {
+        words[i] &= other[i];
+    }
+
+    return phuck_off_archive_append_words(archive, a->key, words);
+}
+
+static phuck_off_archive* phuck_off_archive_combine(const phuck_off_archive* a, const phuck_off_archive* b, int intersect) {
+    phuck_off_archive* result;
+    size_t i = 0;
+    size_t j = 0;
+    int ok = 1;
+
+    if (!a || !b || a->bit_count != b->bit_count) {
+        return NULL;
+    }
+
+    result = phuck_off_archive_alloc(a->bit_count, intersect ? (a->count < b->count ? a->count : b->count) : a->count + b->count);
+    if (!result) {
+        return NULL;
+    }
+
+    while (ok && i < a->count && j < b->count) {
+        const phuck_off_archive_container* ca = &a->containers[i];
+        const phuck_off_archive_container* cb = &b->containers[j];
+
+        if (ca->key == cb->key) {
+            ok = intersect
+                ? phuck_off_archive_intersect_containers(result, ca, cb)
+                : phuck_off_archive_union_containers(result, ca, cb);
+            i++;
+            j++;
+        } else if (ca->key < cb->key) {
+            ok = intersect || phuck_off_archive_copy_container(result, ca);
+            i++;
+        } else {
+            ok = intersect || phuck_off_archive_copy_container(result, cb);
+            j++;
+        }
+    }
+
+    while (ok && !intersect && i < a->count) {
+        ok = phuck_off_archive_copy_container(result, &a->containers[i++]);
+    }
+    while (ok && !intersect && j < b->count) {
+        ok = phuck_off_archive_copy_container(result, &b->containers[j++]);
+    }
+
+    if (!ok) {
+        phuck_off_archive_destroy(result);
+        return NULL;
+    }
+
+    return result;
+}
+
+phuck_off_archive* phuck_off_archive_union(const phuck_off_archive* a, const phuck_off_archive* b) {
+    return phuck_off_archive_combine(a, b, 0);
+}
+
+phuck_off_archive* phuck_off_archive_intersection(const phuck_off_archive* a, const phuck_off_archive* b) {
+    return phuck_off_archive_combine(a, b, 1);
+}
+
+phuck_off_archive* phuck_off_archive_from_bitmap(const unsigned char* bytes, size_t byte_count) {
+    const size_t chunk_bytes = PHUCK_OFF_ARCHIVE_CHUNK_BITS / 8u;
+    phuck_off_archive* archive;
+    uint64_t words[PHUCK_OFF_ARCHIVE_CHUNK_WORDS];
+    size_t offset;
+
+    archive = phuck_off_archive_alloc((uint64_t) byte_count * 8u, 0);
+    if (!archive) {
+        return NULL;
+    }
+
+    for (offset = 0; offset < byte_count; offset += chunk_bytes) {
+        const size_t len = byte_count - offset < chunk_bytes ? byte_count - offset : chunk_bytes;
+        size_t i;
+
+        // map bit i lives in byte i >> 3 at position i & 7, which are the little endian words' bits
+        memset(words, 0, sizeof(words));
+        for (i = 0; i < len; i++) {
+            words[i >> 3] |= ((uint64_t) bytes[offset + i]) << ((i & 7u) * 8u);
+        }
+
+        if (!phuck_off_archive_append_words(archive, (uint32_t) (offset / chunk_bytes), words)) {
+            phuck_off_archive_destroy(archive);
+            return NULL;
+        }
+    }
+
+    return archive;
+}
+
+uint64_t phuck_off_archive_byte_count(const phuck_off_archive* archive) {
+    return archive->bit_count / 8u + (archive->bit_count % 8u != 0);
+}
+
+int phuck_off_archive_to_bitmap(const phuck_off_archive* archive, unsigned char* bytes, size_t byte_count) {
+    const size_t chunk_bytes = PHUCK_OFF_ARCHIVE_CHUNK_BITS / 8u;
+    uint64_t words[PHUCK_OFF_ARCHIVE_CHUNK_WORDS];
+    size_t c;
+
+    if (!archive || (uint64_t) byte_count != phuck_off_archive_byte_count(archive)) {
+        return 0;
+    }
+
+    memset(bytes, 0, byte_count);
+    for (c = 0; c < archive->count; c++) {
+        const phuck_off_archive_container* container = &archive->containers[c];
+        const size_t offset = (size_t) container->key * chunk_bytes;
+        const size_t len = byte_count - offset < chunk_bytes ? byte_count - offset : chunk_bytes;
+        size_t i;
+
+        phuck_off_archive_container_to_words(container, phuck_off_archive_chunk_limit(archive, container->key), words);
+        for (i = 0; i < len; i++) {
+            bytes[offset + i] = (unsigned char) (words[i >> 3] >> ((i & 7u) * 8u));
+        }
+    }
+
+    return 1;
+}
+
+int phuck_off_archive_contains(const phuck_off_archive* archive, uint64_t bit) {
+    const uint32_t key = (uint32_t) (bit / PHUCK_OFF_ARCHIVE_CHUNK_BITS);
+    size_t low = 0;
+    size_t high;
+
+    if (!archive || bit >= archive->bit_count) {
+        return 0;
+    }
+
+    high = archive->count;
+    while (low < high) {
+        const size_t mid = low + (high - low) / 2;
+        const phuck_off_archive_container* container = &archive->containers[mid];
+
+        if (container->key == key) {
+            return phuck_off_archive_container_contains(container, (uint32_t) (bit % PHUCK_OFF_ARCHIVE_CHUNK_BITS));
+        }
+        if (container->key < key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return 0;
+}
+
+uint64_t phuck_off_archive_cardinality(const phuck_off_archive* archive) {
+    uint64_t cardinality = 0;
+    size_t i;
+
+    if (!archive) {
+        return 0;
+    }
+
+    for (i = 0; i < archive->count; i++) {
+        cardinality += archive->containers[i].cardinality;
+    }
+
+    return cardinality;
+}
+
+// the on-disk format is little endian: the magic, a version byte, the bit count (u64),
+// the container count (u32), then for each container its key (u32), type (u8), count (u32)
+// and payload: count u16 positions, or the raw chunk bits
+static int phuck_off_archive_write_uint(FILE* fp, uint64_t value, size_t size) {
+    unsigned char buffer[8];
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        buffer[i] = (unsigned char) (value >> (i * 8u));
+    }
+
+    return fwrite(buffer, 1, size, fp) == size;
+}
+
+static int phuck_off_archive_read_uint(FILE* fp, uint64_t* value, size_t size) {
+    unsigned char buffer[8];
+    size_t i;
+
+    if (fread(buffer, 1, size, fp) != size) {
+        return 0;
+    }
+
+    *value = 0;
+    for (i = 0; i < size; i++) {
+        *value |= ((uint64_t) buffer[i]) << (i * 8u);
+    }
+
+    return 1;
+}
+
+int phuck_off_archive_write(const phuck_off_archive* archive, FILE* fp) {
+    size_t c;
+    uint32_t i;
+
+    if (!archive
+        || fwrite(PHUCK_OFF_ARCHIVE_MAGIC, 1, 4, fp) != 4
+        || !phuck_off_archive_write_uint(fp, PHUCK_OFF_ARCHIVE_VERSION, 1)
+        || !phuck_off_archive_write_uint(fp, archive->bit_count, 8)
+        || !phuck_off_archive_write_uint(fp, archive->count, 4)
+    ) {
+        return 0;
+    }
+
+    for (c = 0; c < archive->count; c++) {
+        const phuck_off_archive_container* container = &archive->containers[c];
+
+        if (!phuck_off_archive_write_uint(fp, container->key, 4)
+            || !phuck_off_archive_write_uint(fp, container->type, 1)
+            || !phuck_off_archive_write_uint(fp, container->count, 4)
+        ) {
+            return 0;
+        }
+
+        if (container->type == PHUCK_OFF_ARCHIVE_BITMAP) {
+            const uint64_t* words = (const uint64_t*) container->data;
+
+            for (i = 0; i < PHUCK_OFF_ARCHIVE_CHUNK_WORDS; i++) {
+                if (!phuck_off_archive_write_uint(fp, words[i], 8)) {
+                    return 0;
+                }
+            }
+        } else {
+            const uint16_t* positions = (const uint16_t*) container->data;
+
+            for (i = 0; i < container->count; i++) {
+                if (!phuck_off_archive_write_uint(fp, positions[i], 2)) {
+                    return 0;
+                }
+            }
+        }
+    }
+
+    return 1;
+}
+
+static int phuck_off_archive_read_container(phuck_off_archive* archive, FILE* fp, uint32_t min_key) {
+    phuck_off_archive_container container;
+    uint64_t value;
+    uint32_t limit;
+    uint32_t i;
+
+    if (!phuck_off_archive_read_uint(fp, &value, 4)) {
+        return 0;
+    }
+    container.key = (uint32_t) value;
+    if (container.key < min_key || (uint64_t) container.key * PHUCK_OFF_ARCHIVE_CHUNK_BITS >= archive->bit_count) {
+        return 0;
+    }
+    limit = phuck_off_archive_chunk_limit(archive, container.key);
+
+    if (!phuck_off_archive_read_uint(fp, &value, 1)) {
+        return 0;
+    }
+    container.type = (uint32_t) value;
+    if (!phuck_off_archive_read_uint(fp, &value, 4) || value > limit) {
+        return 0;
+    }
+    container.count = (uint32_t) value;
+
+    if (container.type == PHUCK_OFF_ARCHIVE_BITMAP) {
+        uint64_t* words = (uint64_t*) malloc(PHUCK_OFF_ARCHIVE_CHUNK_WORDS * sizeof(uint64_t));
+
+        if (!words) {
+            return 0;
+        }
+        container.cardinality = 0;
+        for (i = 0; i < PHUCK_OFF_ARCHIVE_CHUNK_WORDS; i++) {
+            if (!phuck_off_archive_read_uint(fp, &value, 8)) {
+                free(words);
+                return 0;
+            }
+            words[i] = value;
+            container.cardinality += phuck_off_archive_popcount(value);
+        }
+        container.data = words;
+    } else if (container.type == PHUCK_OFF_ARCHIVE_ARRAY || container.type == PHUCK_OFF_ARCHIVE_INVERTED) {
+        uint16_t* positions = (uint16_t*) malloc((container.count + 1) * sizeof(uint16_t));
+
+        if (!positions) {
+            return 0;
+        }
+        for (i = 0; i < container.count; i++) {
+            if (!phuck_off_archive_read_uint(fp, &value, 2) || value >= limit || (i > 0 && value <= positions[i - 1])) {
+                free(positions);
+                return 0;
+            }
+            positions[i] = (uint16_t) value;
+        }
+        container.cardinality = container.type == PHUCK_OFF_ARCHIVE_ARRAY ? container.count : limit - container.count;
+        container.data = positions;
+    } else {
+        return 0;
+    }
+
+    return phuck_off_archive_append(archive, &container);
+}
+
+phuck_off_archive* phuck_off_archive_read(FILE* fp) {
+    phuck_off_archive* archive;
+    char magic[4];
+    uint64_t version;
+    uint64_t bit_count;
+    uint64_t count;
+    uint64_t i;
+
+    if (fread(magic, 1, 4, fp) != 4
+        || memcmp(magic, PHUCK_OFF_ARCHIVE_MAGIC, 4) != 0
+        || !phuck_off_archive_read_uint(fp, &version, 1)
+        || version != PHUCK_OFF_ARCHIVE_VERSION
+        || !phuck_off_archive_read_uint(fp, &bit_count, 8)
+        || !phuck_off_archive_read_uint(fp, &count, 4)
+    ) {
+        return NULL;
+    }
+
+    archive = phuck_off_archive_alloc(bit_count, 0);
+    if (!archive) {
+        return NULL;
+    }
+
+    for (i = 0; i < count; i++) {
+        const uint32_t min_key = archive->count == 0 ? 0 : archive->containers[archive->count - 1].key + 1;
+
+        if (!phuck_off_archive_read_container(archive, fp, min_key)) {
+            phuck_off_archive_destroy(archive);
+            return NULL;
+        }
+    }
+
+    return archive;
+}
@@ -0,0 +1,65 @@
+#ifndef __HAVE_PHUCK_OFF_ARCHIVE_H__
+#define __HAVE_PHUCK_OFF_ARCHIVE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// compressed at-rest format for archived maps
+//
+// the map is cut into chunks of 2^16 bits, and each non-empty chunk is stored in whichever
+// container is the smallest for its density: the sorted positions of its set bits for sparse
+// chunks, the sorted positions of its clear bits for dense ones, or the raw bits otherwise
+// union and intersection work container by container, without decompressing the archives
+
+#define PHUCK_OFF_ARCHIVE_EXTENSION ".poar"
+#define PHUCK_OFF_ARCHIVE_MAGIC "POAR"
+#define PHUCK_OFF_ARCHIVE_VERSION 1
+
+#define PHUCK_OFF_ARCHIVE_CHUNK_BITS 65536u
+#define PHUCK_OFF_ARCHIVE_CHUNK_WORDS (PHUCK_OFF_ARCHIVE_CHUNK_BITS / 64u)
+// past that many positions, the raw bits are smaller
+#define PHUCK_OFF_ARCHIVE_ARRAY_MAX 4096u
+
+typedef enum {
+    PHUCK_OFF_ARCHIVE_ARRAY    = 1,
+    PHUCK_OFF_ARCHIVE_INVERTED = 2,
+    PHUCK_OFF_ARCHIVE_BITMAP   = 3
+} phuck_off_archive_container_type;
+
+typedef struct phuck_off_archive_container {
+    uint32_t key;
+    uint32_t type;
+    // number of positions for arrays and inverted arrays
+    uint32_t count;
+    uint32_t cardinality;
+    // uint16_t positions, or PHUCK_OFF_ARCHIVE_CHUNK_WORDS uint64_t words
+    void* data;
+} phuck_off_archive_container;
+
+typedef struct phuck_off_archive {
+    uint64_t bit_count;
+    // sorted by key, empty chunks are omitted
+    phuck_off_archive_container* containers;
+    size_t count;
+    size_t capacity;
+} phuck_off_archive;
+
+phuck_off_archive* phuck_off_archive_from_bitmap(const unsigned char* bytes, size_t byte_count);
+// the archive's size in bytes, with a last partial byte counted in full
+uint64_t phuck_off_archive_byte_count(const phuck_off_archive* archive);
+// byte_count must match phuck_off_archive_byte_count()
+int phuck_off_archive_to_bitmap(const phuck_off_archive* archive, unsigned char* bytes, size_t byte_count);
+void phuck_off_archive_destroy(phuck_off_archive* archive);
+
+// both return NULL if the archives don't have the same bit count
+phuck_off_archive* phuck_off_archive_union(const phuck_off_archive* a, const phuck_off_archive* b);
+phuck_off_archive* phuck_off_archive_intersection(const phuck_off_archive* a, const phuck_off_archive* b);
+
+int phuck_off_archive_contains(const phuck_off_archive* archive, uint64_t bit);
+uint64_t phuck_off_archive_cardinality(const phuck_off_archive* archive);
+
+int phuck_off_archive_write(const phuck_off_archive* archive, FILE* fp);
+phuck_off_archive* phuck_off_archive_read(FILE* fp);
+
+#endif
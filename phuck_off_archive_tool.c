@@ -0,0 +1,229 @@
+// command line tool to pack, merge and inspect archived phuck-off maps
+//
+// build with:
+//   cc -O2 -I. phuck_off_archive_tool.c phuck_off_archive.c -o phuck_off_archive
+//
+// usage:
+//   phuck_off_archive pack <map> <out.poar>
+//   phuck_off_archive unpack <in.poar> <out map>
+//   phuck_off_archive union <out.poar> <in> [<in>...]
+//   phuck_off_archive intersect <out.poar> <in> [<in>...]
+//   phuck_off_archive stat <in> [<in>...]
+//
+// inputs can be either raw maps or archives, the latter being recognized by their extension
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "phuck_off_archive.h"
+
+static int is_archive_path(const char* path) {
+    const size_t len = strlen(path);
+    const size_t extension_len = strlen(PHUCK_OFF_ARCHIVE_EXTENSION);
+
+    return len > extension_len && strcmp(path + len - extension_len, PHUCK_OFF_ARCHIVE_EXTENSION) == 0;
+}
+
+static phuck_off_archive* load(const char* path) {
+    phuck_off_archive* archive = NULL;
+    unsigned char* bytes = NULL;
+    long length;
+    FILE* fp;
+
+    fp = fopen(path, "rb");
+    if (!fp) {
+        fprintf(stderr, "failed to open \"%s\": %s\n", path, strerror(errno));
+        return NULL;
+    }
+
+    if (is_archive_path(path)) {
+        archive = phuck_off_archive_read(fp);
+        if (!archive) {
+            fprintf(stderr, "\"%s\" is not a valid archive\n", path);
+        }
+        fclose(fp);
+        return archive;
+    }
+
+    if (fseek(fp, 0, SEEK_END) != 0 || (length = ftell(fp)) < 0 || fseek(fp, 0, SEEK_SET) != 0) {
+        fprintf(stderr, "failed to get the size of \"%s\"\n", path);
+        fclose(fp);
+        return NULL;
+    }
+
+    bytes = (unsigned char*) malloc((size_t) length + 1);
+    if (!bytes || fread(bytes, 1, (size_t) length, fp) != (size_t) length) {
+        fprintf(stderr, "failed to read \"%s\"\n", path);
+    } else {
+        archive = phuck_off_archive_from_bitmap(bytes, (size_t) length);
+        if (!archive) {
+            fprintf(stderr, "failed to compress \"%s\"\n", path);
+        }
+    }
+
+    free(bytes);
+    fclose(fp);
+    return archive;
+}
+
+static int save(const phuck_off_archive* archive, const char* path) {
+    FILE* fp;
+    int ok;
+
+    fp = fopen(path, "wb");
+    if (!fp) {
+        fprintf(stderr, "failed to open \"%s\": %s\n", path, strerror(errno));
+        return 0;
+    }
+
+    ok = phuck_off_archive_write(archive, fp);
+    if (fclose(fp) != 0 || !ok) {
+        fprintf(stderr, "failed to write \"%s\"\n", path);
+        return 0;
+    }
+
+    return 1;
+}
+
+static int unpack(const char* in, const char* out) {
+    phuck_off_archive* archive;
+    unsigned char* bytes = NULL;
+    uint64_t archive_bytes;
+    size_t byte_count;
+    FILE* fp;
+    int ok = 0;
+
+    archive = load(in);
+    if (!archive) {
+        return 0;
+    }
+
+    archive_bytes = phuck_off_archive_byte_count(archive);
+    byte_count = (size_t) archive_bytes;
+    if (archive_bytes >= SIZE_MAX) {
+        fprintf(stderr, "\"%s\" is too large to unpack\n", in);
+    } else if (!(bytes = (unsigned char*) malloc(byte_count + 1))) {
+        fprintf(stderr, "failed to allocate %lu bytes to unpack \"%s\"\n", (unsigned long) byte_count, in);
+    } else if (!phuck_off_archive_to_bitmap(archive, bytes, byte_count)) {
+        fprintf(stderr, "\"%s\" has invalid contents\n", in);
+    } else {
+        fp = fopen(out, "wb");
+        if (fp) {
+            ok = fwrite(bytes, 1, byte_count, fp) == byte_count;
+            ok = fclose(fp) == 0 && ok;
+        }
+        if (!ok) {
+            fprintf(stderr, "failed to write \"%s\"\n", out);
+        }
+    }
+
+    free(bytes);
+    phuck_off_archive_destroy(archive);
+    return ok;
+}
+
+static int combine(const char* out, char** inputs, int input_count, int intersect) {
+    phuck_off_archive* result;
+    int i;
+    int ok;
+
+    result = load(inputs[0]);
+    for (i = 1; result && i < input_count; i++) {
+        phuck_off_archive* next = load(inputs[i]);
+        phuck_off_archive* merged = NULL;
+
+        if (next) {
+            merged = intersect ? phuck_off_archive_intersection(result, next) : phuck_off_archive_union(result, next);
+            if (!merged) {
+                fprintf(stderr, "failed to merge \"%s\", maps must be of the same size\n", inputs[i]);
+            }
+        }
+
+        phuck_off_archive_destroy(next);
+        phuck_off_archive_destroy(result);
+        result = merged;
+    }
+
+    if (!result) {
+        return 0;
+    }
+
+    ok = save(result, out);
+    phuck_off_archive_destroy(result);
+    return ok;
+}
+
+static int stat_archives(char** inputs, int input_count) {
+    int i;
+
+    for (i = 0; i < input_count; i++) {
+        phuck_off_archive* archive = load(inputs[i]);
+        size_t arrays = 0;
+        size_t inverted = 0;
+        size_t bitmaps = 0;
+        size_t c;
+
+        if (!archive) {
+            return 0;
+        }
+
+        for (c = 0; c < archive->count; c++) {
+            switch (archive->containers[c].type) {
+                case PHUCK_OFF_ARCHIVE_ARRAY: arrays++; break;
+                case PHUCK_OFF_ARCHIVE_INVERTED: inverted++; break;
+                default: bitmaps++; break;
+            }
+        }
+
+        printf(
+            "%s: bits=%llu set=%llu containers=%lu arrays=%lu inverted=%lu bitmaps=%lu\n",
+            inputs[i],
+            (unsigned long long) archive->bit_count,
+            (unsigned long long) phuck_off_archive_cardinality(archive),
+            (unsigned long) archive->count,
+            (unsigned long) arrays,
+            (unsigned long) inverted,
+            (unsigned long) bitmaps
+        );
+        phuck_off_archive_destroy(archive);
+    }
+
+    return 1;
+}
+
+static void usage(const char* program) {
+    fprintf(stderr, "usage: %s pack <map> <out%s>\n", program, PHUCK_OFF_ARCHIVE_EXTENSION);
+    fprintf(stderr, "       %s unpack <in%s> <out map>\n", program, PHUCK_OFF_ARCHIVE_EXTENSION);
+    fprintf(stderr, "       %s union <out%s> <in> [<in>...]\n", program, PHUCK_OFF_ARCHIVE_EXTENSION);
+    fprintf(stderr, "       %s intersect <out%s> <in> [<in>...]\n", program, PHUCK_OFF_ARCHIVE_EXTENSION);
+    fprintf(stderr, "       %s stat <in> [<in>...]\n", program);
+}
+
+int main(int argc, char** argv) {
+    int ok;
+
+    if (argc < 3) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (strcmp(argv[1], "pack") == 0 && argc == 4) {
+        ok = combine(argv[3], &argv[2], 1, 0);
+    } else if (strcmp(argv[1], "unpack") == 0 && argc == 4) {
+        ok = unpack(argv[2], argv[3]);
+    } else if (strcmp(argv[1], "union") == 0 && argc >= 4) {
+        ok = combine(argv[2], &argv[3], argc - 3, 0);
+    } else if (strcmp(argv[1], "intersect") == 0 && argc >= 4) {
+        ok = combine(argv[2], &argv[3], argc - 3, 1);
+    } else if (strcmp(argv[1], "stat") == 0) {
+        ok = stat_archives(&argv[2], argc - 2);
+    } else {
+        usage(argv[0]);
+        return 2;
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,200 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "phuck_off_ignore.h"
+
+// only valid during phuck_off_ignore_compile(), qsort has no user data argument
+static const char* phuck_off_ignore_sort_pool = NULL;
+
+static const char* phuck_off_ignore_rule_str(const phuck_off_ignore* ignore, const phuck_off_ignore_rule* rule) {
+    return ignore->pool + rule->offset;
+}
+
+static int phuck_off_ignore_compare_rules(const void* a, const void* b) {
+    const phuck_off_ignore_rule* left = (const phuck_off_ignore_rule*) a;
+    const phuck_off_ignore_rule* right = (const phuck_off_ignore_rule*) b;
+
+    return strcmp(phuck_off_ignore_sort_pool + left->offset, phuck_off_ignore_sort_pool + right->offset);
+}
+
+static int phuck_off_ignore_reserve_pool(phuck_off_ignore* ignore, size_t extra) {
+    size_t capacity = ignore->pool_capacity;
+    char* tmp;
+
+    if (ignore->pool_len + extra <= capacity) {
+        return 1;
+    }
+
+    while (ignore->pool_len + extra > capacity) {
+        capacity *= 2;
+    }
+
+    tmp = (char*) realloc(ignore->pool, capacity);
+    if (!tmp) {
+        return 0;
+    }
+
+    ignore->pool = tmp;
+    ignore->pool_capacity = capacity;
+    return 1;
+}
+
+static int phuck_off_ignore_reserve_rule(phuck_off_ignore* ignore) {
+    phuck_off_ignore_rule* tmp;
+
+    if (ignore->count < ignore->capacity) {
+        return 1;
+    }
+
+    tmp = (phuck_off_ignore_rule*) realloc(ignore->rules, ignore->capacity * 2 * sizeof(phuck_off_ignore_rule));
+    if (!tmp) {
+        return 0;
+    }
+
+    ignore->rules = tmp;
+    ignore->capacity *= 2;
+    return 1;
+}
+
+phuck_off_ignore* phuck_off_ignore_alloc(void) {
+    phuck_off_ignore* ignore;
+
+    ignore = (phuck_off_ignore*) calloc(1, sizeof(phuck_off_ignore));
+    if (!ignore) {
+        return NULL;
+    }
+
+    ignore->rules = (phuck_off_ignore_rule*) malloc(PHUCK_OFF_IGNORE_INITIAL_RULES * sizeof(phuck_off_ignore_rule));
+    ignore->pool = (char*) malloc(PHUCK_OFF_IGNORE_INITIAL_POOL_SIZE);
+    if (!ignore->rules || !ignore->pool) {
+        phuck_off_ignore_destroy(ignore);
+        return NULL;
+    }
+
+    ignore->capacity = PHUCK_OFF_IGNORE_INITIAL_RULES;
+    ignore->pool_capacity = PHUCK_OFF_IGNORE_INITIAL_POOL_SIZE;
+    return ignore;
+}
+
+void phuck_off_ignore_destroy(phuck_off_ignore* ignore) {
+    if (!ignore) {
+        return;
+    }
+
+    free(ignore->rules);
+    free(ignore->pool);
+    free(ignore);
+}
+
+int phuck_off_ignore_add(phuck_off_ignore* ignore, const char* user_code_root, const char* rule) {
+    size_t rule_len;
+    size_t root_len = 0;
+    size_t total_len;
+    phuck_off_ignore_rule* entry;
+    char* dest;
+
+    if (!ignore || !rule || rule[0] == '\0') {
+        return 0;
+    }
+
+    rule_len = strlen(rule);
+    if (rule[0] != '/' && user_code_root) {
+        root_len = strlen(user_code_root);
+        while (root_len > 0 && user_code_root[root_len - 1] == '/') {
+            root_len--;
+        }
+    }
+
+    // + 1 for the separator between the root and a relative rule
+    total_len = root_len > 0 ? root_len + 1 + rule_len : rule_len;
+    if (!phuck_off_ignore_reserve_rule(ignore) || !phuck_off_ignore_reserve_pool(ignore, total_len + 1)) {
+        return 0;
+    }
+
+    entry = &ignore->rules[ignore->count++];
+    entry->offset = ignore->pool_len;
+    entry->len = total_len;
+    entry->is_prefix = rule[rule_len - 1] == '/';
+
+    dest = ignore->pool + ignore->pool_len;
+    if (root_len > 0) {
+        memcpy(dest, user_code_root, root_len);
+        dest[root_len] = '/';
+        dest += root_len + 1;
+    }
+    memcpy(dest, rule, rule_len + 1);
+    ignore->pool_len += total_len + 1;
+    ignore->compiled = 0;
+
+    return 1;
+}
+
+void phuck_off_ignore_compile(phuck_off_ignore* ignore) {
+    size_t i;
+    size_t kept = 0;
+    const phuck_off_ignore_rule* covering = NULL;
+
+    if (!ignore || ignore->compiled) {
+        return;
+    }
+
+    phuck_off_ignore_sort_pool = ignore->pool;
+    qsort(ignore->rules, ignore->count, sizeof(phuck_off_ignore_rule), phuck_off_ignore_compare_rules);
+    phuck_off_ignore_sort_pool = NULL;
+
+    // once sorted, everything a directory prefix covers immediately follows it,
+    // so we can drop duplicates and covered rules in a single pass
+    for (i = 0; i < ignore->count; i++) {
+        const phuck_off_ignore_rule* rule = &ignore->rules[i];
+        const char* value = phuck_off_ignore_rule_str(ignore, rule);
+
+        if (covering && strncmp(value, phuck_off_ignore_rule_str(ignore, covering), covering->len) == 0) {
+            continue;
+        }
+        if (kept > 0 && strcmp(value, phuck_off_ignore_rule_str(ignore, &ignore->rules[kept - 1])) == 0) {
+            continue;
+        }
+
+        ignore->rules[kept] = *rule;
+        if (rule->is_prefix) {
+            covering = &ignore->rules[kept];
+        }
+        kept++;
+    }
+
+    ignore->count = kept;
+    ignore->compiled = 1;
+}
+
+int phuck_off_ignore_match(const phuck_off_ignore* ignore, const char* path) {
+    size_t low = 0;
+    size_t high;
+    const phuck_off_ignore_rule* candidate = NULL;
+
+    if (!ignore || !path || !ignore->compiled) {
+        return 0;
+    }
+
+    // find the greatest rule <= path; since no kept rule covers another,
+    // that's the only one that can possibly be a prefix of path
+    high = ignore->count;
+    while (low < high) {
+        const size_t mid = low + (high - low) / 2;
+        const phuck_off_ignore_rule* rule = &ignore->rules[mid];
+        const int cmp = strcmp(phuck_off_ignore_rule_str(ignore, rule), path);
+
+        if (cmp == 0) {
+            return 1;
+        }
+        if (cmp < 0) {
+            candidate = rule;
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return candidate != NULL
+        && candidate->is_prefix
+        && strncmp(path, phuck_off_ignore_rule_str(ignore, candidate), candidate->len) == 0;
+}
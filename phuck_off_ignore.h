@@ -0,0 +1,40 @@
+#ifndef __HAVE_PHUCK_OFF_IGNORE_H__
+#define __HAVE_PHUCK_OFF_IGNORE_H__
+
+#include <stddef.h>
+
+#define PHUCK_OFF_IGNORE_INITIAL_RULES 64
+#define PHUCK_OFF_IGNORE_INITIAL_POOL_SIZE 4096
+
+// a rule is either an exact file path, or a directory prefix if it ends with a '/'
+typedef struct phuck_off_ignore_rule {
+    // offset of the NUL-terminated rule into the pool
+    size_t offset;
+    size_t len;
+    int is_prefix;
+} phuck_off_ignore_rule;
+
+// ignore rules are appended while parsing, then compiled once into a sorted array
+// where no rule is covered by a directory prefix rule; that way the only rule that can
+// match a given path is the greatest one that sorts before it, found with a single binary search
+typedef struct phuck_off_ignore {
+    phuck_off_ignore_rule* rules;
+    size_t count;
+    size_t capacity;
+    // all the rule strings, back to back
+    char* pool;
+    size_t pool_len;
+    size_t pool_capacity;
+    int compiled;
+} phuck_off_ignore;
+
+phuck_off_ignore* phuck_off_ignore_alloc(void);
+void phuck_off_ignore_destroy(phuck_off_ignore* ignore);
+
+// relative rules are resolved against user_code_root
+int phuck_off_ignore_add(phuck_off_ignore* ignore, const char* user_code_root, const char* rule);
+void phuck_off_ignore_compile(phuck_off_ignore* ignore);
+
+int phuck_off_ignore_match(const phuck_off_ignore* ignore, const char* path);
+
+#endif
@@ -14,6 +14,8 @@ typedef struct phuck_off_logger {
     int fd;
 } phuck_off_logger;
 
+// only changed in MINIT/MSHUTDOWN; each line is formatted on the caller's stack and written with
+// a single write() to an O_APPEND fd, so threads can log at the same time without interleaving
 static phuck_off_logger logger = { PHUCK_OFF_LOG_LEVEL_DISABLED, -1 };
 
 static phuck_off_log_level parse_log_level(const char* s, int* invalid) {
@@ -15,6 +15,8 @@
 
 #define PHUCK_OFF_MMAP_FLUSH_INTERVAL_SECONDS 3
 #define PHUCK_OFF_MMAP_PATH_TEMPLATE "/tmp/phuck_off_map_%ld"
+#define PHUCK_OFF_MMAP_SNAPSHOT_SUFFIX ".snap"
+#define PHUCK_OFF_MMAP_SNAPSHOT_TMP_SUFFIX ".snap.tmp"
 
 typedef struct phuck_off_mmap {
     int fd;
@@ -23,11 +25,17 @@ typedef struct phuck_off_mmap {
     time_t last_flush_at;
     int keep_file_on_shutdown;
     pid_t owner_pid;
+    // 0 if snapshots are disabled
+    long snapshot_interval;
+    time_t last_snapshot_at;
 } phuck_off_mmap;
 
 unsigned char* phuck_off_mmap_bytes = NULL;
+PHUCK_OFF_THREAD_LOCAL unsigned int phuck_off_mmap_snapshot_countdown = PHUCK_OFF_MMAP_SNAPSHOT_CHECK_EVERY;
 
-static phuck_off_mmap phuck_off_mmap_state = { -1, 0, NULL, 0, 0, 0 };
+static phuck_off_mmap phuck_off_mmap_state = { -1, 0, NULL, 0, 0, 0, 0, 0 };
+// guards phuck_off_mmap_state and the mapping itself, but not the bits in it
+static phuck_off_mutex phuck_off_mmap_lock = PHUCK_OFF_MUTEX_INITIALIZER;
 
 static size_t phuck_off_mmap_byte_count(const int n) {
     return (((size_t) n) + 7u) >> 3;
@@ -69,10 +77,45 @@ static char* phuck_off_mmap_strdup(const char* path) {
     return copy;
 }
 
+static int phuck_off_mmap_env_flag(const char* name) {
+    const char* value = getenv(name);
+
+    return value != NULL && strcmp(value, "1") == 0;
+}
+
 static int phuck_off_mmap_keep_file_on_shutdown(void) {
-    const char* no_cleanup = getenv(PHUCK_OFF_NO_CLEANUP_ENV_VAR);
+    return phuck_off_mmap_env_flag(PHUCK_OFF_NO_CLEANUP_ENV_VAR);
+}
+
+static long phuck_off_mmap_snapshot_interval(void) {
+    const char* value = getenv(PHUCK_OFF_SNAPSHOT_INTERVAL_ENV_VAR);
+    char* end = NULL;
+    long parsed;
+
+    if (!value) {
+        return PHUCK_OFF_DEFAULT_SNAPSHOT_INTERVAL_SECONDS;
+    }
+
+    errno = 0;
+    parsed = strtol(value, &end, 10);
+    if (errno != 0 || end == value || *end != '\0' || parsed < 0) {
+        phuck_off_log(
+            PHUCK_OFF_LOG_LEVEL_WARN,
+            "Invalid %s=\"%s\", defaulting to %d",
+            PHUCK_OFF_SNAPSHOT_INTERVAL_ENV_VAR,
+            value,
+            PHUCK_OFF_DEFAULT_SNAPSHOT_INTERVAL_SECONDS
+        );
+        return PHUCK_OFF_DEFAULT_SNAPSHOT_INTERVAL_SECONDS;
+    }
 
-    return no_cleanup != NULL && strcmp(no_cleanup, "1") == 0;
+    return parsed;
+}
+
+static int phuck_off_mmap_snapshot_path(char* buffer, const size_t buffer_len, const char* suffix) {
+    const int written = snprintf(buffer, buffer_len, "%s%s", phuck_off_mmap_state.path, suffix);
+
+    return written > 0 && (size_t) written < buffer_len;
 }
 
 static void phuck_off_mmap_detach(const int sync_on_shutdown, const int unlink_file, const int log_errors) {
@@ -113,9 +156,17 @@ static void phuck_off_mmap_detach(const int sync_on_shutdown, const int unlink_f
     phuck_off_mmap_state.byte_count = 0;
     phuck_off_mmap_state.last_flush_at = 0;
     phuck_off_mmap_state.owner_pid = 0;
+    phuck_off_mmap_state.snapshot_interval = 0;
+    phuck_off_mmap_state.last_snapshot_at = 0;
+    phuck_off_mmap_snapshot_countdown = PHUCK_OFF_MMAP_SNAPSHOT_CHECK_EVERY;
     if (phuck_off_mmap_state.path != NULL) {
         if (unlink_file) {
+            char snapshot_path[PHUCK_OFF_MMAP_SNAPSHOT_PATH_MAX];
+
             unlink(phuck_off_mmap_state.path);
+            if (phuck_off_mmap_snapshot_path(snapshot_path, sizeof(snapshot_path), PHUCK_OFF_MMAP_SNAPSHOT_SUFFIX)) {
+                unlink(snapshot_path);
+            }
         }
         free(phuck_off_mmap_state.path);
         phuck_off_mmap_state.path = NULL;
@@ -127,12 +178,26 @@ static void phuck_off_mmap_release_inherited(void) {
     phuck_off_mmap_detach(0, 0, 0);
 }
 
+// must hold phuck_off_mmap_lock
+static void phuck_off_mmap_shutdown_locked(void) {
+    const int keep_file_on_shutdown = phuck_off_mmap_state.keep_file_on_shutdown;
+
+    phuck_off_mmap_detach(keep_file_on_shutdown, !keep_file_on_shutdown, 1);
+}
+
+static int phuck_off_mmap_attach(const char* path, const int n);
+
+// with threads, every thread's first request ends up here, and only the first one maps
 int phuck_off_mmap_init_for_pid(const int n) {
     char path[64];
     const pid_t current_pid = getpid();
     int written;
+    int result;
+
+    phuck_off_mutex_lock(&phuck_off_mmap_lock);
 
     if (phuck_off_mmap_bytes != NULL && phuck_off_mmap_state.owner_pid == current_pid) {
+        phuck_off_mutex_unlock(&phuck_off_mmap_lock);
         return 1;
     }
 
@@ -142,14 +207,29 @@ int phuck_off_mmap_init_for_pid(const int n) {
 
     written = snprintf(path, sizeof(path), PHUCK_OFF_MMAP_PATH_TEMPLATE, (long) current_pid);
     if (written <= 0 || (size_t) written >= sizeof(path)) {
+        phuck_off_mutex_unlock(&phuck_off_mmap_lock);
         phuck_off_log(PHUCK_OFF_LOG_LEVEL_ERROR, "Failed to build phuck-off mmap path for pid %ld", (long) current_pid);
         return 0;
     }
 
-    return phuck_off_mmap_init(path, n);
+    result = phuck_off_mmap_attach(path, n);
+    phuck_off_mutex_unlock(&phuck_off_mmap_lock);
+
+    return result;
 }
 
 int phuck_off_mmap_init(const char* path, const int n) {
+    int result;
+
+    phuck_off_mutex_lock(&phuck_off_mmap_lock);
+    result = phuck_off_mmap_attach(path, n);
+    phuck_off_mutex_unlock(&phuck_off_mmap_lock);
+
+    return result;
+}
+
+// must hold phuck_off_mmap_lock
+static int phuck_off_mmap_attach(const char* path, const int n) {
     size_t byte_count;
     void* mapping;
     int fd;
@@ -167,7 +247,7 @@ int phuck_off_mmap_init(const char* path, const int n) {
         return 0;
     }
 
-    phuck_off_mmap_shutdown();
+    phuck_off_mmap_shutdown_locked();
 
     byte_count = phuck_off_mmap_byte_count(n);
     path_copy = phuck_off_mmap_strdup(path);
@@ -210,6 +290,9 @@ int phuck_off_mmap_init(const char* path, const int n) {
     phuck_off_mmap_state.last_flush_at = now == (time_t) -1 ? 0 : now;
     phuck_off_mmap_state.keep_file_on_shutdown = phuck_off_mmap_keep_file_on_shutdown();
     phuck_off_mmap_state.owner_pid = getpid();
+    phuck_off_mmap_state.snapshot_interval = phuck_off_mmap_snapshot_interval();
+    phuck_off_mmap_state.last_snapshot_at = phuck_off_mmap_state.last_flush_at;
+    phuck_off_mmap_snapshot_countdown = PHUCK_OFF_MMAP_SNAPSHOT_CHECK_EVERY;
     phuck_off_mmap_bytes = (unsigned char*) mapping;
     if (now == (time_t) -1) {
         saved_errno = errno;
@@ -226,7 +309,8 @@ int phuck_off_mmap_init(const char* path, const int n) {
     return 1;
 }
 
-void phuck_off_mmap_post_request(void) {
+// must hold phuck_off_mmap_lock
+static void phuck_off_mmap_post_request_locked(void) {
     time_t now;
     int saved_errno;
     long elapsed_since_flush;
@@ -318,8 +402,115 @@ void phuck_off_mmap_post_request(void) {
     );
 }
 
-void phuck_off_mmap_shutdown(void) {
-    const int keep_file_on_shutdown = phuck_off_mmap_state.keep_file_on_shutdown;
+// with threads, another one holding the lock is either syncing already or setting things up, so
+// skipping is always fine: bits set meanwhile dirty their page again and get picked up next time
+void phuck_off_mmap_post_request(void) {
+    if (!phuck_off_mutex_trylock(&phuck_off_mmap_lock)) {
+        phuck_off_log(PHUCK_OFF_LOG_LEVEL_TRACE, "phuck_off_mmap_post_request: syncing=no reason=busy");
+        return;
+    }
 
-    phuck_off_mmap_detach(keep_file_on_shutdown, !keep_file_on_shutdown, 1);
+    phuck_off_mmap_post_request_locked();
+    phuck_off_mutex_unlock(&phuck_off_mmap_lock);
+}
+
+// writes the whole map to <map>.snap.tmp and renames it over <map>.snap, so that readers only
+// ever see a complete copy
+static int phuck_off_mmap_write_snapshot(const char* tmp_path, const char* snapshot_path) {
+    size_t done = 0;
+    ssize_t rc;
+    int fd;
+    int saved_errno;
+
+    fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return 0;
+    }
+
+    while (done < phuck_off_mmap_state.byte_count) {
+        rc = write(fd, phuck_off_mmap_bytes + done, phuck_off_mmap_state.byte_count - done);
+        if (rc < 0 && errno == EINTR) {
+            continue;
+        }
+        if (rc <= 0) {
+            saved_errno = rc < 0 ? errno : EIO;
+            close(fd);
+            unlink(tmp_path);
+            errno = saved_errno;
+            return 0;
+        }
+        done += (size_t) rc;
+    }
+
+    if (close(fd) != 0 || rename(tmp_path, snapshot_path) != 0) {
+        saved_errno = errno;
+        unlink(tmp_path);
+        errno = saved_errno;
+        return 0;
+    }
+
+    return 1;
+}
+
+// must hold phuck_off_mmap_lock
+static void phuck_off_mmap_snapshot_locked(void) {
+    char tmp_path[PHUCK_OFF_MMAP_SNAPSHOT_PATH_MAX];
+    char snapshot_path[PHUCK_OFF_MMAP_SNAPSHOT_PATH_MAX];
+    time_t now;
+
+    if (phuck_off_mmap_bytes == NULL || phuck_off_mmap_state.snapshot_interval <= 0) {
+        return;
+    }
+
+    now = time(NULL);
+    if (now == (time_t) -1 || (long) (now - phuck_off_mmap_state.last_snapshot_at) < phuck_off_mmap_state.snapshot_interval) {
+        return;
+    }
+
+    phuck_off_mmap_state.last_snapshot_at = now;
+    if (!phuck_off_mmap_snapshot_path(tmp_path, sizeof(tmp_path), PHUCK_OFF_MMAP_SNAPSHOT_TMP_SUFFIX)
+        || !phuck_off_mmap_snapshot_path(snapshot_path, sizeof(snapshot_path), PHUCK_OFF_MMAP_SNAPSHOT_SUFFIX)
+    ) {
+        phuck_off_log(PHUCK_OFF_LOG_LEVEL_ERROR, "Snapshot path too long for \"%s\"", phuck_off_mmap_state.path);
+        return;
+    }
+
+    if (!phuck_off_mmap_write_snapshot(tmp_path, snapshot_path)) {
+        const int saved_errno = errno;
+
+        phuck_off_log(
+            PHUCK_OFF_LOG_LEVEL_ERROR,
+            "Failed to write snapshot \"%s\": %s (%d)",
+            snapshot_path,
+            strerror(saved_errno),
+            saved_errno
+        );
+        return;
+    }
+
+    phuck_off_log(
+        PHUCK_OFF_LOG_LEVEL_DEBUG,
+        "phuck_off_mmap_snapshot_check: snapshot=yes bytes=%lu path=\"%s\"",
+        (unsigned long) phuck_off_mmap_state.byte_count,
+        snapshot_path
+    );
+}
+
+// called every PHUCK_OFF_MMAP_SNAPSHOT_CHECK_EVERY ticks. The copy only goes to the page cache,
+// the kernel writes it back on its own schedule, and it never waits on the lock either.
+void phuck_off_mmap_snapshot_check(void) {
+    phuck_off_mmap_snapshot_countdown = PHUCK_OFF_MMAP_SNAPSHOT_CHECK_EVERY;
+
+    if (!phuck_off_mutex_trylock(&phuck_off_mmap_lock)) {
+        return;
+    }
+
+    phuck_off_mmap_snapshot_locked();
+    phuck_off_mutex_unlock(&phuck_off_mmap_lock);
+}
+
+void phuck_off_mmap_shutdown(void) {
+    phuck_off_mutex_lock(&phuck_off_mmap_lock);
+    phuck_off_mmap_shutdown_locked();
+    phuck_off_mutex_unlock(&phuck_off_mmap_lock);
 }
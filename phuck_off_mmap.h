@@ -3,20 +3,59 @@
 
 #include <sys/types.h>
 
+#include "phuck_off_thread.h"
+
 #ifndef PHUCK_OFF_NO_CLEANUP_ENV_VAR
 #define PHUCK_OFF_NO_CLEANUP_ENV_VAR "PHUCK_OFF_NO_CLEANUP"
 #endif
 
+// long-running processes (e.g. CLI queue consumers) never reach RSHUTDOWN, so the map also gets
+// periodically copied to <map>.snap from the hot path. Unlike the map, which bits keep landing
+// in, the copy is a consistent point in time that collectors can pick up while the process
+// runs, and it is replaced atomically. "0" disables it
+#ifndef PHUCK_OFF_SNAPSHOT_INTERVAL_ENV_VAR
+#define PHUCK_OFF_SNAPSHOT_INTERVAL_ENV_VAR "PHUCK_OFF_SNAPSHOT_INTERVAL"
+#endif
+
+#ifndef PHUCK_OFF_DEFAULT_SNAPSHOT_INTERVAL_SECONDS
+#define PHUCK_OFF_DEFAULT_SNAPSHOT_INTERVAL_SECONDS 60
+#endif
+
+#ifndef PHUCK_OFF_MMAP_SNAPSHOT_PATH_MAX
+#define PHUCK_OFF_MMAP_SNAPSHOT_PATH_MAX 4096
+#endif
+
+// how many ticks between two clock reads
+#ifndef PHUCK_OFF_MMAP_SNAPSHOT_CHECK_EVERY
+#define PHUCK_OFF_MMAP_SNAPSHOT_CHECK_EVERY 4096
+#endif
+
 // Exposed so phuck_off_mmap_set() can stay as a tiny hot-path inline.
 extern unsigned char* phuck_off_mmap_bytes;
+// Same for phuck_off_mmap_tick(). Per thread, so that ticking never races.
+extern PHUCK_OFF_THREAD_LOCAL unsigned int phuck_off_mmap_snapshot_countdown;
 
 int phuck_off_mmap_init_for_pid(const int n);
 int phuck_off_mmap_init(const char* path, const int n);
 void phuck_off_mmap_post_request(void);
 void phuck_off_mmap_shutdown(void);
+void phuck_off_mmap_snapshot_check(void);
 
 static inline void phuck_off_mmap_set(const int i) {
-    phuck_off_mmap_bytes[((unsigned int) i) >> 3] |= (unsigned char) (1u << (((unsigned int) i) & 7u));
+    unsigned char* byte = &phuck_off_mmap_bytes[((unsigned int) i) >> 3];
+    const unsigned char bit = (unsigned char) (1u << (((unsigned int) i) & 7u));
+
+    // almost every call is for a function that's already been seen, and skipping the write then
+    // also keeps threads from bouncing the cache line between cores
+    if ((phuck_off_atomic_load(byte) & bit) == 0) {
+        phuck_off_atomic_or(byte, bit);
+    }
+}
+
+static inline void phuck_off_mmap_tick(void) {
+    if (--phuck_off_mmap_snapshot_countdown == 0) {
+        phuck_off_mmap_snapshot_check();
+    }
 }
 
 #endif
@@ -1,18 +1,14 @@
 #include <errno.h>
-#include <limits.h>
+#include <fcntl.h>
 #include <stdarg.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "phuck_off_parser.h"
-
-typedef struct phuck_off_resize_state {
-    int ok;
-    char* error;
-    size_t error_len;
-} phuck_off_resize_state;
+#include "phuck_off_thread.h"
 
 static void phuck_off_parser_set_error(char* error, size_t error_len, const char* format, ...) {
     va_list args;
@@ -44,7 +40,7 @@ static char* phuck_off_parser_strdup(const char* value) {
     return copy;
 }
 
-static char* phuck_off_parser_read_line(FILE* fp) {
+char* phuck_off_parser_read_line(FILE* fp) {
     char* buffer;
     char* tmp;
     size_t capacity = 256;
@@ -82,7 +78,21 @@ static char* phuck_off_parser_read_line(FILE* fp) {
     return buffer;
 }
 
-static void phuck_off_parser_chomp(char* line) {
+// like phuck_off_parser_read_line(), but into a buffer that is reused from one line to the next;
+// returns the line's length including its newline, 0 on EOF and -1 on failure. getline() counts
+// every byte it consumed, so a NUL inside a line can't make the offsets drift from the file
+static long phuck_off_parser_read_line_into(FILE* fp, char** buffer, size_t* capacity) {
+    ssize_t length;
+
+    length = getline(buffer, capacity, fp);
+    if (length < 0) {
+        return ferror(fp) ? -1 : 0;
+    }
+
+    return (long) length;
+}
+
+void phuck_off_parser_chomp(char* line) {
     size_t len;
 
     if (!line) {
@@ -95,101 +105,143 @@ static void phuck_off_parser_chomp(char* line) {
     }
 }
 
-static void phuck_off_parser_files_dtor(void* value) {
-    if (value) {
-        xdebug_hash_destroy((xdebug_hash*) value);
-    }
-}
-
-static int phuck_off_parser_target_slots(size_t entries) {
-    size_t slots;
+static void phuck_off_index_file_dtor(void* value) {
+    phuck_off_index_file* file = (phuck_off_index_file*) value;
+    phuck_off_index_span* span;
+    phuck_off_index_span* next;
 
-    if (entries == 0) {
-        return 1;
+    if (!file) {
+        return;
     }
 
-    slots = entries / 2;
-    if (entries % 2 != 0) {
-        slots++;
+    for (span = file->first_span.next; span != NULL; span = next) {
+        next = span->next;
+        free(span);
+    }
+    if (file->lines) {
+        xdebug_hash_destroy(file->lines);
     }
+    free(file);
+}
 
-    if (slots > (size_t) INT_MAX) {
-        return INT_MAX;
+// hashes grow on their own while parsing, but may be left half way through
+// an incremental growth, in which case misses would probe two tables on the
+// hot path. Resizing to the current slot count just finishes that growth.
+static void phuck_off_parser_settle_hash(xdebug_hash* hash) {
+    if (hash) {
+        xdebug_hash_resize(hash, hash->slots);
     }
+}
 
-    return (int) slots;
+// sized so that they never need to grow
+static int phuck_off_parser_fixed_slots(size_t size) {
+    return (int) (size + size / 3 + 1);
 }
 
-static int phuck_off_parser_maybe_grow_hash(xdebug_hash* hash, char* error, size_t error_len) {
-    int target_slots;
+typedef struct phuck_off_parser_placement {
+    xdebug_hash* files;
+    phuck_off_placement_region* region;
+    int failed;
+} phuck_off_parser_placement;
 
-    if (!hash) {
-        return 1;
-    }
+static void phuck_off_parser_place_file(void* user, xdebug_hash_element* element) {
+    phuck_off_parser_placement* placement = (phuck_off_parser_placement*) user;
+    phuck_off_index_file* file = (phuck_off_index_file*) element->ptr;
 
-    target_slots = phuck_off_parser_target_slots(hash->size);
-    if (target_slots <= hash->slots) {
-        return 1;
+    file->region_table = phuck_off_placement_region_take(placement->region, xdebug_hash_table_bytes(phuck_off_parser_fixed_slots(file->function_count)));
+    if (!file->region_table
+        || !xdebug_hash_add(placement->files, element->key.value.str.val, element->key.value.str.len, file)
+    ) {
+        placement->failed = 1;
     }
+}
 
-    if (!xdebug_hash_resize(hash, target_slots)) {
-        phuck_off_parser_set_error(
-            error,
-            error_len,
-            "failed to resize hash from %d to %d slots",
-            hash->slots,
-            target_slots
-        );
-        return 0;
-    }
+static void phuck_off_parser_sum_table_bytes(void* user, xdebug_hash_element* element) {
+    *(size_t*) user += xdebug_hash_table_bytes(phuck_off_parser_fixed_slots(((phuck_off_index_file*) element->ptr)->function_count));
+}
 
-    return 1;
+static void phuck_off_parser_unplace_file(void* user, xdebug_hash_element* element) {
+    (void) user;
+    ((phuck_off_index_file*) element->ptr)->region_table = NULL;
 }
 
-static void phuck_off_parser_resize_inner_hashes(void* user, xdebug_hash_element* element) {
-    phuck_off_resize_state* state = (phuck_off_resize_state*) user;
-    xdebug_hash* inner = (xdebug_hash*) element->ptr;
+// moves the files hash into a placement region, and reserves each file's line map table there;
+// the index stays as it was if anything fails
+static void phuck_off_parser_place_index(phuck_off_index* index) {
+    phuck_off_parser_placement placement;
+    size_t byte_count;
+    int files_slots;
+
+    if (!phuck_off_placement_requested()) {
+        return;
+    }
+
+    files_slots = phuck_off_parser_fixed_slots(index->files->size);
+    byte_count = xdebug_hash_table_bytes(files_slots);
+    xdebug_hash_apply(index->files, &byte_count, phuck_off_parser_sum_table_bytes);
 
-    if (!state->ok || !inner) {
+    placement.region = phuck_off_placement_region_alloc(byte_count);
+    if (!placement.region) {
+        return;
+    }
+    placement.files = xdebug_hash_alloc_in(
+        files_slots,
+        phuck_off_index_file_dtor,
+        phuck_off_placement_region_take(placement.region, xdebug_hash_table_bytes(files_slots))
+    );
+    placement.failed = placement.files == NULL;
+    if (!placement.failed) {
+        xdebug_hash_apply(index->files, &placement, phuck_off_parser_place_file);
+    }
+
+    if (placement.failed) {
+        xdebug_hash_apply(index->files, NULL, phuck_off_parser_unplace_file);
+        if (placement.files) {
+            placement.files->dtor = NULL;
+            xdebug_hash_destroy(placement.files);
+        }
+        phuck_off_placement_region_destroy(placement.region);
         return;
     }
 
-    state->ok = phuck_off_parser_maybe_grow_hash(inner, state->error, state->error_len);
+    index->files->dtor = NULL;
+    xdebug_hash_destroy(index->files);
+    index->files = placement.files;
+    index->region = placement.region;
 }
 
-static xdebug_hash* phuck_off_parser_get_or_create_file_lines(xdebug_hash* files, const char* path) {
-    xdebug_hash* line_map;
+static phuck_off_index_file* phuck_off_parser_get_or_create_file(xdebug_hash* files, const char* path, size_t path_len) {
+    phuck_off_index_file* file;
     void* existing = NULL;
 
-    if (xdebug_hash_find(files, (char*) path, (unsigned int) strlen(path), &existing)) {
-        return (xdebug_hash*) existing;
+    if (xdebug_hash_find(files, (char*) path, (unsigned int) path_len, &existing)) {
+        return (phuck_off_index_file*) existing;
     }
 
-    line_map = xdebug_hash_alloc(PHUCK_OFF_FILE_LINES_INITIAL_SLOTS, NULL);
-    if (!line_map) {
+    file = (phuck_off_index_file*) calloc(1, sizeof(phuck_off_index_file));
+    if (!file) {
         return NULL;
     }
 
-    if (!xdebug_hash_add(files, (char*) path, (unsigned int) strlen(path), line_map)) {
-        xdebug_hash_destroy(line_map);
+    if (!xdebug_hash_add(files, (char*) path, (unsigned int) path_len, file)) {
+        free(file);
         return NULL;
     }
 
-    return line_map;
+    return file;
 }
 
-static int phuck_off_parser_add_function_entry(
-    xdebug_hash* files,
+int phuck_off_parser_split_function_entry(
     char* line,
     unsigned long input_line_no,
+    char** path_out,
+    unsigned long* function_line_no_out,
     char* error,
     size_t error_len
 ) {
     char* separator;
-    char* path;
     char* end = NULL;
     unsigned long function_line_no;
-    xdebug_hash* line_map;
 
     separator = strrchr(line, ':');
     if (!separator || separator == line || separator[1] == '\0') {
@@ -197,9 +249,6 @@ static int phuck_off_parser_add_function_entry(
         return 0;
     }
 
-    *separator = '\0';
-    path = line;
-
     errno = 0;
     function_line_no = strtoul(separator + 1, &end, 10);
     if (errno != 0 || !end || *end != '\0') {
@@ -207,29 +256,131 @@ static int phuck_off_parser_add_function_entry(
         return 0;
     }
 
-    line_map = phuck_off_parser_get_or_create_file_lines(files, path);
-    if (!line_map) {
-        phuck_off_parser_set_error(error, error_len, "failed to allocate line map for \"%s\"", path);
+    *separator = '\0';
+    *path_out = line;
+    *function_line_no_out = function_line_no;
+    return 1;
+}
+
+// what the scan remembers of the previous entry; dumpers list a file's entries one after the
+// other, so most entries are for the same file as the one before and don't need hashing
+typedef struct phuck_off_parser_scan {
+    phuck_off_index_file* previous;
+    char* previous_path;
+    size_t previous_path_len;
+    size_t previous_path_capacity;
+} phuck_off_parser_scan;
+
+// checks that the entry is "<path>:<digits>" and returns the length of the path, or 0. Nothing
+// gets split or converted, phuck_off_index_load_span() does that for the files that get used.
+static size_t phuck_off_parser_scan_function_entry(const char* line, size_t line_len, unsigned long input_line_no, char* error, size_t error_len) {
+    size_t digits = line_len;
+    size_t i;
+
+    while (digits > 0 && line[digits - 1] != ':') {
+        digits--;
+    }
+    if (digits <= 1 || digits == line_len) {
+        phuck_off_parser_set_error(error, error_len, "invalid function entry on line %lu", input_line_no);
         return 0;
     }
 
-    if (!xdebug_hash_index_add(line_map, function_line_no, (void*) (uintptr_t) input_line_no)) {
-        phuck_off_parser_set_error(error, error_len, "failed to store function entry for \"%s\"", path);
+    for (i = digits; i < line_len; i++) {
+        if (line[i] < '0' || line[i] > '9') {
+            phuck_off_parser_set_error(error, error_len, "invalid line number on line %lu", input_line_no);
+            return 0;
+        }
+    }
+
+    return digits - 1;
+}
+
+static int phuck_off_parser_remember_path(phuck_off_parser_scan* scan, const char* path, size_t path_len) {
+    char* tmp;
+
+    if (path_len > scan->previous_path_capacity) {
+        tmp = (char*) realloc(scan->previous_path, path_len);
+        if (!tmp) {
+            return 0;
+        }
+        scan->previous_path = tmp;
+        scan->previous_path_capacity = path_len;
+    }
+
+    memcpy(scan->previous_path, path, path_len);
+    scan->previous_path_len = path_len;
+    return 1;
+}
+
+// only records where the entry is, its line map gets built by phuck_off_index_load_span()
+static int phuck_off_parser_add_function_entry(
+    xdebug_hash* files,
+    phuck_off_parser_scan* scan,
+    char* line,
+    size_t line_len,
+    off_t offset,
+    size_t raw_length,
+    unsigned long input_line_no,
+    char* error,
+    size_t error_len
+) {
+    size_t path_len;
+    phuck_off_index_file* file;
+    phuck_off_index_span* span;
+
+    path_len = phuck_off_parser_scan_function_entry(line, line_len, input_line_no, error, error_len);
+    if (path_len == 0) {
         return 0;
     }
 
+    if (scan->previous && path_len == scan->previous_path_len && memcmp(line, scan->previous_path, path_len) == 0) {
+        file = scan->previous;
+    } else {
+        file = phuck_off_parser_get_or_create_file(files, line, path_len);
+        if (!file || !phuck_off_parser_remember_path(scan, line, path_len)) {
+            line[path_len] = '\0';
+            phuck_off_parser_set_error(error, error_len, "failed to allocate index entry for \"%s\"", line);
+            return 0;
+        }
+    }
+
+    if (file == scan->previous) {
+        // also covers any blank lines since the previous entry
+        file->last_span->length = (size_t) (offset - file->last_span->offset) + raw_length;
+    } else {
+        if (file->function_count == 0) {
+            span = &file->first_span;
+        } else {
+            span = (phuck_off_index_span*) calloc(1, sizeof(phuck_off_index_span));
+            if (!span) {
+                line[path_len] = '\0';
+                phuck_off_parser_set_error(error, error_len, "failed to store function entry for \"%s\"", line);
+                return 0;
+            }
+            file->last_span->next = span;
+        }
+        span->offset = offset;
+        span->length = raw_length;
+        span->first_line_no = input_line_no;
+        file->last_span = span;
+    }
+
+    file->function_count++;
+    scan->previous = file;
+
     return 1;
 }
 
 static int phuck_off_parser_add_ignored_file(
-    xdebug_hash* files,
+    phuck_off_ignore* ignored,
+    const char* user_code_root,
     const char* path,
     unsigned long input_line_no,
     char* error,
     size_t error_len
 ) {
-    if (!xdebug_hash_update(files, (char*) path, (unsigned int) strlen(path), NULL)) {
-        phuck_off_parser_set_error(error, error_len, "failed to store ignored file on line %lu", input_line_no);
+    if (!phuck_off_ignore_add(ignored, user_code_root, path)) {
+        phuck_off_parser_set_error(error, error_len, "failed to store ignore rule on line %lu", input_line_no);
         return 0;
     }
 
@@ -238,7 +389,8 @@ static int phuck_off_parser_add_ignored_file(
 
 int phuck_off_parse_funcs_file(
     const char* path,
-    xdebug_hash** files_out,
+    phuck_off_index** index_out,
+    phuck_off_ignore** ignored_out,
     char** user_code_root_out,
     size_t* function_count_out,
     char* error,
@@ -251,14 +403,26 @@ int phuck_off_parse_funcs_file(
     } state = PHUCK_OFF_PARSE_FUNCTIONS;
 
     FILE* fp;
+    phuck_off_index* index = NULL;
     xdebug_hash* files = NULL;
+    phuck_off_parser_scan scan = { NULL, NULL, 0, 0 };
+    phuck_off_ignore* ignored = NULL;
     char* line = NULL;
+    size_t line_capacity = 0;
+    size_t line_len;
+    long read_length = 0;
     char* user_code_root = NULL;
     unsigned long input_line_no = 0;
-    phuck_off_resize_state resize_state = { 1, error, error_len };
+    off_t offset = 0;
+    size_t raw_length;
+    int failed = 0;
+    int fd = -1;
 
-    if (files_out) {
-        *files_out = NULL;
+    if (index_out) {
+        *index_out = NULL;
+    }
+    if (ignored_out) {
+        *ignored_out = NULL;
     }
     if (user_code_root_out) {
         *user_code_root_out = NULL;
@@ -276,69 +440,86 @@ int phuck_off_parse_funcs_file(
         return 0;
     }
 
-    files = xdebug_hash_alloc(PHUCK_OFF_FILES_INITIAL_SLOTS, phuck_off_parser_files_dtor);
+    files = xdebug_hash_alloc(PHUCK_OFF_FILES_INITIAL_SLOTS, phuck_off_index_file_dtor);
     if (!files) {
         phuck_off_parser_set_error(error, error_len, "failed to allocate files hash");
         fclose(fp);
         return 0;
     }
 
-    while ((line = phuck_off_parser_read_line(fp)) != NULL) {
+    ignored = phuck_off_ignore_alloc();
+    if (!ignored) {
+        phuck_off_parser_set_error(error, error_len, "failed to allocate ignore rules");
+        fclose(fp);
+        xdebug_hash_destroy(files);
+        phuck_off_ignore_destroy(ignored);
+        return 0;
+    }
+
+    while (!failed && (read_length = phuck_off_parser_read_line_into(fp, &line, &line_capacity)) > 0) {
         input_line_no++;
-        phuck_off_parser_chomp(line);
+        raw_length = (size_t) read_length;
+        line_len = raw_length;
+        while (line_len > 0 && (line[line_len - 1] == '\n' || line[line_len - 1] == '\r')) {
+            line[--line_len] = '\0';
+        }
+        offset += (off_t) raw_length;
+
+        // everything below reads the line as a C string
+        if (memchr(line, '\0', line_len) != NULL) {
+            phuck_off_parser_set_error(error, error_len, "NUL byte on line %lu", input_line_no);
+            failed = 1;
+            break;
+        }
 
-        if (state != PHUCK_OFF_PARSE_ROOT && line[0] == '\0') {
-            free(line);
-            line = NULL;
+        if (state != PHUCK_OFF_PARSE_ROOT && line_len == 0) {
             continue;
         }
 
         if (state == PHUCK_OFF_PARSE_FUNCTIONS) {
             if (strcmp(line, PHUCK_OFF_GENERATED_FOR_MARKER) == 0) {
                 state = PHUCK_OFF_PARSE_ROOT;
-            } else if (!phuck_off_parser_add_function_entry(files, line, input_line_no, error, error_len)) {
-                free(line);
-                fclose(fp);
-                xdebug_hash_destroy(files);
-                return 0;
+            } else if (!phuck_off_parser_add_function_entry(files, &scan, line, line_len, offset - (off_t) raw_length, raw_length, input_line_no, error, error_len)) {
+                failed = 1;
             } else if (function_count_out) {
                 (*function_count_out)++;
             }
         } else if (state == PHUCK_OFF_PARSE_ROOT) {
-            if (line[0] == '\0') {
+            if (line_len == 0) {
                 phuck_off_parser_set_error(error, error_len, "missing user_code_root on line %lu", input_line_no);
-                free(line);
-                fclose(fp);
-                xdebug_hash_destroy(files);
-                return 0;
-            }
-
-            user_code_root = phuck_off_parser_strdup(line);
-            if (!user_code_root) {
+                failed = 1;
+            } else if (!(user_code_root = phuck_off_parser_strdup(line))) {
                 phuck_off_parser_set_error(error, error_len, "failed to allocate user_code_root");
-                free(line);
-                fclose(fp);
-                xdebug_hash_destroy(files);
-                return 0;
+                failed = 1;
             }
             state = PHUCK_OFF_PARSE_IGNORED;
-        } else if (!phuck_off_parser_add_ignored_file(files, line, input_line_no, error, error_len)) {
-            free(line);
-            fclose(fp);
-            free(user_code_root);
-            xdebug_hash_destroy(files);
-            return 0;
+        } else if (!phuck_off_parser_add_ignored_file(ignored, user_code_root, line, input_line_no, error, error_len)) {
+            failed = 1;
         }
-
-        free(line);
-        line = NULL;
     }
+    free(line);
+    free(scan.previous_path);
 
-    if (ferror(fp)) {
+    if (!failed && (read_length < 0 || ferror(fp))) {
         phuck_off_parser_set_error(error, error_len, "failed while reading \"%s\"", path);
+        failed = 1;
+    }
+
+    // pread() later on goes through this same open file, so a funcs file replaced by rename in
+    // the meantime can't make the spans point into different content
+    if (!failed) {
+        fd = fcntl(fileno(fp), F_DUPFD_CLOEXEC, 0);
+        if (fd < 0) {
+            phuck_off_parser_set_error(error, error_len, "failed to keep \"%s\" open: %s", path, strerror(errno));
+            failed = 1;
+        }
+    }
+
+    if (failed) {
         fclose(fp);
         free(user_code_root);
         xdebug_hash_destroy(files);
+        phuck_off_ignore_destroy(ignored);
         return 0;
     }
 
@@ -346,33 +527,49 @@ int phuck_off_parse_funcs_file(
 
     if (state == PHUCK_OFF_PARSE_FUNCTIONS) {
         phuck_off_parser_set_error(error, error_len, "missing \"%s\" marker", PHUCK_OFF_GENERATED_FOR_MARKER);
+        close(fd);
         free(user_code_root);
         xdebug_hash_destroy(files);
+        phuck_off_ignore_destroy(ignored);
         return 0;
     }
 
     if (state == PHUCK_OFF_PARSE_ROOT || !user_code_root) {
         phuck_off_parser_set_error(error, error_len, "missing user_code_root after \"%s\"", PHUCK_OFF_GENERATED_FOR_MARKER);
+        close(fd);
         free(user_code_root);
         xdebug_hash_destroy(files);
+        phuck_off_ignore_destroy(ignored);
         return 0;
     }
 
-    if (!phuck_off_parser_maybe_grow_hash(files, error, error_len)) {
-        free(user_code_root);
-        xdebug_hash_destroy(files);
-        return 0;
-    }
+    phuck_off_parser_settle_hash(files);
+
+    phuck_off_ignore_compile(ignored);
 
-    xdebug_hash_apply(files, &resize_state, phuck_off_parser_resize_inner_hashes);
-    if (!resize_state.ok) {
+    index = (phuck_off_index*) malloc(sizeof(phuck_off_index));
+    if (!index) {
+        phuck_off_parser_set_error(error, error_len, "failed to allocate the index");
+        close(fd);
         free(user_code_root);
         xdebug_hash_destroy(files);
+        phuck_off_ignore_destroy(ignored);
         return 0;
     }
+    index->fd = fd;
+    index->files = files;
+    index->region = NULL;
+    phuck_off_parser_place_index(index);
 
-    if (files_out) {
-        *files_out = files;
+    if (index_out) {
+        *index_out = index;
+    } else {
+        phuck_off_index_destroy(index);
+    }
+    if (ignored_out) {
+        *ignored_out = ignored;
+    } else {
+        phuck_off_ignore_destroy(ignored);
     }
     if (user_code_root_out) {
         *user_code_root_out = user_code_root;
@@ -380,3 +577,209 @@ int phuck_off_parse_funcs_file(
 
     return 1;
 }
+
+static int phuck_off_index_read_span(phuck_off_index* index, const phuck_off_index_span* span, char* buffer) {
+    size_t done = 0;
+    ssize_t rc;
+
+    while (done < span->length) {
+        rc = pread(index->fd, buffer + done, span->length - done, span->offset + (off_t) done);
+        if (rc < 0 && errno == EINTR) {
+            continue;
+        }
+        if (rc <= 0) {
+            return 0;
+        }
+        done += (size_t) rc;
+    }
+
+    buffer[done] = '\0';
+    return 1;
+}
+
+static int phuck_off_index_load_span(
+    phuck_off_index* index,
+    const char* path,
+    const phuck_off_index_span* span,
+    xdebug_hash* lines,
+    char* error,
+    size_t error_len
+) {
+    char* buffer;
+    char* line;
+    char* end;
+    char* entry_path;
+    unsigned long line_no = span->first_line_no;
+    unsigned long function_line_no;
+
+    buffer = (char*) malloc(span->length + 1);
+    if (!buffer) {
+        phuck_off_parser_set_error(error, error_len, "failed to allocate %lu bytes for \"%s\"", (unsigned long) span->length, path);
+        return 0;
+    }
+
+    if (!phuck_off_index_read_span(index, span, buffer)) {
+        phuck_off_parser_set_error(error, error_len, "failed to read the entries for \"%s\" at offset %ld", path, (long) span->offset);
+        free(buffer);
+        return 0;
+    }
+
+    for (line = buffer; *line != '\0'; line = end, line_no++) {
+        end = strchr(line, '\n');
+        if (end) {
+            *end++ = '\0';
+        } else {
+            end = line + strlen(line);
+        }
+
+        phuck_off_parser_chomp(line);
+        if (line[0] == '\0') {
+            continue;
+        }
+
+        // an in-place rewrite of the funcs file is the only way this can fail
+        if (!phuck_off_parser_split_function_entry(line, line_no, &entry_path, &function_line_no, error, error_len)
+            || strcmp(entry_path, path) != 0
+        ) {
+            phuck_off_parser_set_error(error, error_len, "entries for \"%s\" changed since they were indexed (line %lu)", path, line_no);
+            free(buffer);
+            return 0;
+        }
+
+        if (!xdebug_hash_index_add(lines, function_line_no, (void*) (uintptr_t) line_no)) {
+            phuck_off_parser_set_error(error, error_len, "failed to store function entry for \"%s\"", path);
+            free(buffer);
+            return 0;
+        }
+    }
+
+    free(buffer);
+    return 1;
+}
+
+// with threads, two of them may build the same map at once; the first one to publish it wins
+static xdebug_hash* phuck_off_index_materialize(
+    phuck_off_index* index,
+    const char* path,
+    phuck_off_index_file* file,
+    int* failed,
+    char* error,
+    size_t error_len
+) {
+    const phuck_off_index_span* span;
+    xdebug_hash* lines;
+    xdebug_hash* expected = NULL;
+    void* table = phuck_off_atomic_load_acquire(&file->region_table);
+
+    *failed = 0;
+
+    // the table in the region goes to whichever thread claims it first, the others fall back to
+    // the heap and will most likely lose the race to publish anyway
+    if (table && phuck_off_atomic_publish(&file->region_table, table, NULL)) {
+        lines = xdebug_hash_alloc_in(phuck_off_parser_fixed_slots(file->function_count), NULL, table);
+    } else {
+        lines = xdebug_hash_alloc(phuck_off_parser_fixed_slots(file->function_count), NULL);
+    }
+    for (span = &file->first_span; lines != NULL && span != NULL; span = span->next) {
+        if (!phuck_off_index_load_span(index, path, span, lines, error, error_len)) {
+            // publish an empty map so that the error is only reported once
+            xdebug_hash_destroy(lines);
+            lines = xdebug_hash_alloc(1, NULL);
+            *failed = 1;
+            break;
+        }
+    }
+
+    if (!lines) {
+        if (!*failed) {
+            phuck_off_parser_set_error(error, error_len, "failed to allocate line map for \"%s\"", path);
+        }
+        *failed = 1;
+        return NULL;
+    }
+
+    if (!phuck_off_atomic_publish(&file->lines, expected, lines)) {
+        xdebug_hash_destroy(lines);
+        *failed = 0;
+        return expected;
+    }
+
+    return lines;
+}
+
+static phuck_off_index_file* phuck_off_index_find_file(phuck_off_index* index, const char* path, size_t path_len) {
+    void* file = NULL;
+
+    if (!index || !xdebug_hash_find(index->files, (char*) path, (unsigned int) path_len, &file)) {
+        return NULL;
+    }
+
+    return (phuck_off_index_file*) file;
+}
+
+xdebug_hash* phuck_off_index_file_lines(phuck_off_index* index, const char* path, size_t path_len, char* error, size_t error_len) {
+    phuck_off_index_file* file = phuck_off_index_find_file(index, path, path_len);
+    xdebug_hash* lines;
+    int failed;
+
+    if (!file) {
+        return NULL;
+    }
+
+    lines = phuck_off_atomic_load_acquire(&file->lines);
+    if (!lines) {
+        lines = phuck_off_index_materialize(index, path, file, &failed, error, error_len);
+    }
+
+    return lines;
+}
+
+phuck_off_index_result phuck_off_index_find(
+    phuck_off_index* index,
+    const char* path,
+    size_t path_len,
+    unsigned long line_no,
+    unsigned long* id_out,
+    char* error,
+    size_t error_len
+) {
+    phuck_off_index_file* file = phuck_off_index_find_file(index, path, path_len);
+    xdebug_hash* lines;
+    void* id = NULL;
+    int failed = 0;
+
+    if (!file) {
+        return PHUCK_OFF_INDEX_MISSING_FILE;
+    }
+
+    lines = phuck_off_atomic_load_acquire(&file->lines);
+    if (!lines) {
+        lines = phuck_off_index_materialize(index, path, file, &failed, error, error_len);
+        if (failed) {
+            return PHUCK_OFF_INDEX_ERROR;
+        }
+    }
+
+    if (!xdebug_hash_index_find(lines, line_no, &id)) {
+        return PHUCK_OFF_INDEX_MISSING_LINE;
+    }
+
+    *id_out = (unsigned long) (uintptr_t) id;
+    return PHUCK_OFF_INDEX_FOUND;
+}
+
+void phuck_off_index_destroy(phuck_off_index* index) {
+    if (!index) {
+        return;
+    }
+
+    if (index->files) {
+        xdebug_hash_destroy(index->files);
+    }
+    // after the files hash, whose line maps may still have their tables in it
+    phuck_off_placement_region_destroy(index->region);
+    if (index->fd >= 0) {
+        close(index->fd);
+    }
+    free(index);
+}
@@ -2,24 +2,102 @@
 #define __HAVE_PHUCK_OFF_PARSER_H__
 
 #include <stddef.h>
+#include <stdio.h>
+#include <sys/types.h>
 
 #include "xdebug_hash.h"
+#include "phuck_off_ignore.h"
+#include "phuck_off_placement.h"
 
 #ifndef PHUCK_OFF_FUNCS_PATH
 #define PHUCK_OFF_FUNCS_PATH "/etc/funcs.txt"
 #endif
 
 #define PHUCK_OFF_FILES_INITIAL_SLOTS 1024
-#define PHUCK_OFF_FILE_LINES_INITIAL_SLOTS 8
 #define PHUCK_OFF_GENERATED_FOR_MARKER "### GENERATED FOR ###"
 
+// the funcs file format: one "<absolute path>:<line>" entry per function, whose ID is its
+// 1-based line number in the file, then PHUCK_OFF_GENERATED_FOR_MARKER, the user code root,
+// and finally one ignore rule per line
+// these are exposed so that offline tools can stream the file with the exact same rules
+
+// returns a malloc'd line including its trailing newline, or NULL on EOF
+char* phuck_off_parser_read_line(FILE* fp);
+void phuck_off_parser_chomp(char* line);
+// splits line in place
+int phuck_off_parser_split_function_entry(
+    char* line,
+    unsigned long input_line_no,
+    char** path_out,
+    unsigned long* function_line_no_out,
+    char* error,
+    size_t error_len
+);
+
+// a run of entries for one file, which may have blank lines in between
+typedef struct phuck_off_index_span {
+    off_t offset;
+    size_t length;
+    unsigned long first_line_no;
+    struct phuck_off_index_span* next;
+} phuck_off_index_span;
+
+typedef struct phuck_off_index_file {
+    // maps the file's function line numbers to their IDs; NULL until the first lookup in the file
+    xdebug_hash* lines;
+    unsigned long function_count;
+    // usually the only one, dumpers list files one after the other
+    phuck_off_index_span first_span;
+    phuck_off_index_span* last_span;
+    // the line map's table in the index's region, until the first lookup claims it
+    void* region_table;
+} phuck_off_index_file;
+
+// MINIT only scans the funcs file for where each file's entries are: one sequential read, with
+// no allocation per entry and one hash lookup per run of entries for the same file. Every worker
+// then builds line maps for the files it actually runs, so that memory follows the working set
+// rather than the size of the codebase, although MINIT still reads the whole file.
+typedef struct phuck_off_index {
+    // the very file that was parsed, kept open for pread(), so a funcs file replaced by rename
+    // keeps serving the old content
+    int fd;
+    // maps each absolute file path to its phuck_off_index_file*
+    xdebug_hash* files;
+    // with PHUCK_OFF_HUGE_PAGES or PHUCK_OFF_NUMA_INTERLEAVE, holds the files hash's table and
+    // room for every line map's, so that lookups stay within the advised pages; NULL otherwise.
+    // Only the pages of maps that get built are ever touched.
+    phuck_off_placement_region* region;
+} phuck_off_index;
+
+typedef enum {
+    PHUCK_OFF_INDEX_FOUND = 0,
+    PHUCK_OFF_INDEX_MISSING_FILE = 1,
+    PHUCK_OFF_INDEX_MISSING_LINE = 2,
+    // the file's entries couldn't be loaded; it's then treated as having no functions
+    PHUCK_OFF_INDEX_ERROR = 3
+} phuck_off_index_result;
+
 int phuck_off_parse_funcs_file(
     const char* path,
-    xdebug_hash** files_out,
+    phuck_off_index** index_out,
+    phuck_off_ignore** ignored_out,
     char** user_code_root_out,
     size_t* function_count_out,
     char* error,
     size_t error_len
 );
 
+phuck_off_index_result phuck_off_index_find(
+    phuck_off_index* index,
+    const char* path,
+    size_t path_len,
+    unsigned long line_no,
+    unsigned long* id_out,
+    char* error,
+    size_t error_len
+);
+// returns the file's line map, loading it if needed, or NULL if the file isn't in the index
+xdebug_hash* phuck_off_index_file_lines(phuck_off_index* index, const char* path, size_t path_len, char* error, size_t error_len);
+void phuck_off_index_destroy(phuck_off_index* index);
+
 #endif
@@ -0,0 +1,132 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#include "phuck_off_placement.h"
+
+// from linux/mempolicy.h, which we don't want to depend on just for this
+#define PHUCK_OFF_PLACEMENT_MPOL_INTERLEAVE 3
+#define PHUCK_OFF_PLACEMENT_CACHE_LINE 64
+
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+static int phuck_off_placement_env_flag(const char* name) {
+    const char* value = getenv(name);
+
+    return value != NULL && strcmp(value, "1") == 0;
+}
+
+int phuck_off_placement_requested(void) {
+    return phuck_off_placement_env_flag(PHUCK_OFF_HUGE_PAGES_ENV_VAR)
+        || phuck_off_placement_env_flag(PHUCK_OFF_NUMA_INTERLEAVE_ENV_VAR);
+}
+
+static const char* phuck_off_placement_advise_huge_pages(void* mapping, const size_t byte_count) {
+    if (!phuck_off_placement_env_flag(PHUCK_OFF_HUGE_PAGES_ENV_VAR)) {
+        return "off";
+    }
+
+#ifdef MADV_HUGEPAGE
+    return madvise(mapping, byte_count, MADV_HUGEPAGE) == 0 ? "on" : "failed";
+#else
+    (void) mapping;
+    (void) byte_count;
+    return "unsupported";
+#endif
+}
+
+static const char* phuck_off_placement_interleave_numa(void* mapping, const size_t byte_count) {
+    if (!phuck_off_placement_env_flag(PHUCK_OFF_NUMA_INTERLEAVE_ENV_VAR)) {
+        return "off";
+    }
+
+#if defined(__linux__) && defined(SYS_mbind)
+    {
+        // the kernel intersects this with the nodes that are actually online and allowed
+        unsigned long node_mask = ~0ul;
+
+        if (syscall(SYS_mbind, mapping, byte_count, PHUCK_OFF_PLACEMENT_MPOL_INTERLEAVE, &node_mask, sizeof(node_mask) * 8, 0) != 0) {
+            return "failed";
+        }
+    }
+    return "on";
+#else
+    (void) mapping;
+    (void) byte_count;
+    return "unsupported";
+#endif
+}
+
+phuck_off_placement_region* phuck_off_placement_region_alloc(size_t byte_count) {
+    phuck_off_placement_region* region;
+    char* mapping;
+    char* base;
+    size_t size;
+    size_t head;
+
+    if (!phuck_off_placement_requested() || byte_count == 0) {
+        return NULL;
+    }
+
+    region = (phuck_off_placement_region*) calloc(1, sizeof(phuck_off_placement_region));
+    if (!region) {
+        return NULL;
+    }
+
+    // mmap() only promises page alignment, so map an extra 2MB and trim both ends
+    size = (byte_count + PHUCK_OFF_PLACEMENT_ALIGNMENT - 1) & ~(PHUCK_OFF_PLACEMENT_ALIGNMENT - 1);
+    mapping = (char*) mmap(NULL, size + PHUCK_OFF_PLACEMENT_ALIGNMENT, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == (char*) MAP_FAILED) {
+        free(region);
+        return NULL;
+    }
+
+    base = (char*) (((uintptr_t) mapping + PHUCK_OFF_PLACEMENT_ALIGNMENT - 1) & ~((uintptr_t) PHUCK_OFF_PLACEMENT_ALIGNMENT - 1));
+    head = (size_t) (base - mapping);
+    if (head > 0) {
+        munmap(mapping, head);
+    }
+    munmap(base + size, PHUCK_OFF_PLACEMENT_ALIGNMENT - head);
+
+    region->base = base;
+    region->size = size;
+    region->used = 0;
+    region->huge_pages = phuck_off_placement_advise_huge_pages(base, size);
+    region->numa_interleave = phuck_off_placement_interleave_numa(base, size);
+
+    return region;
+}
+
+void* phuck_off_placement_region_take(phuck_off_placement_region* region, size_t byte_count) {
+    void* p;
+
+    if (!region || byte_count > region->size - region->used) {
+        return NULL;
+    }
+
+    p = region->base + region->used;
+    byte_count = (byte_count + PHUCK_OFF_PLACEMENT_CACHE_LINE - 1) & ~((size_t) PHUCK_OFF_PLACEMENT_CACHE_LINE - 1);
+    region->used = byte_count < region->size - region->used ? region->used + byte_count : region->size;
+
+    return p;
+}
+
+int phuck_off_placement_region_contains(const phuck_off_placement_region* region, const void* p) {
+    return region != NULL && (const char*) p >= region->base && (const char*) p < region->base + region->size;
+}
+
+void phuck_off_placement_region_destroy(phuck_off_placement_region* region) {
+    if (!region) {
+        return;
+    }
+
+    munmap(region->base, region->size);
+    free(region);
+}
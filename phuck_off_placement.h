@@ -0,0 +1,40 @@
+#ifndef __HAVE_PHUCK_OFF_PLACEMENT_H__
+#define __HAVE_PHUCK_OFF_PLACEMENT_H__
+
+#include <stddef.h>
+
+// set to "1" to back the function index's hash tables with transparent huge pages, to cut dTLB
+// misses on lookups in very large indexes
+#ifndef PHUCK_OFF_HUGE_PAGES_ENV_VAR
+#define PHUCK_OFF_HUGE_PAGES_ENV_VAR "PHUCK_OFF_HUGE_PAGES"
+#endif
+
+// set to "1" to interleave the index's hash tables across all NUMA nodes
+#ifndef PHUCK_OFF_NUMA_INTERLEAVE_ENV_VAR
+#define PHUCK_OFF_NUMA_INTERLEAVE_ENV_VAR "PHUCK_OFF_NUMA_INTERLEAVE"
+#endif
+
+#define PHUCK_OFF_PLACEMENT_ALIGNMENT ((size_t) 2 * 1024 * 1024)
+
+// one anonymous mapping, aligned to and rounded up to 2MB so that every part of it can be a huge
+// page, which the index's tables are carved from. The advice is given before anything touches
+// the pages, and the memory comes zeroed.
+typedef struct phuck_off_placement_region {
+    char* base;
+    size_t size;
+    size_t used;
+    // "off", "on", "failed" or "unsupported", for the init log
+    const char* huge_pages;
+    const char* numa_interleave;
+} phuck_off_placement_region;
+
+// whether either of the env vars above asks for a region
+int phuck_off_placement_requested(void);
+// NULL if the mapping fails, or if neither option is set
+phuck_off_placement_region* phuck_off_placement_region_alloc(size_t byte_count);
+// cache line aligned, NULL once the region is used up
+void* phuck_off_placement_region_take(phuck_off_placement_region* region, size_t byte_count);
+int phuck_off_placement_region_contains(const phuck_off_placement_region* region, const void* p);
+void phuck_off_placement_region_destroy(phuck_off_placement_region* region);
+
+#endif
@@ -0,0 +1,500 @@
+// offline tool joining phuck-off maps back to the funcs file they were generated from
+//
+// build with:
+//   cc -O2 -I. phuck_off_report.c phuck_off_parser.c phuck_off_placement.c phuck_off_ignore.c phuck_off_archive.c xdebug_hash.c xdebug_llist.c xdebug_arena.c -o phuck_off_report
+//
+// usage:
+//   phuck_off_report [-f csv|json] [-r functions|used|unused|directories] <funcs.txt> <map> [<map>...]
+//
+// maps ending in PHUCK_OFF_ARCHIVE_EXTENSION are read as archives
+//
+// the funcs file is streamed once, in order, and never indexed: since a function's ID is its line
+// number in the funcs file, each entry's bit can be looked up in the merged map as it goes by
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "phuck_off_archive.h"
+#include "phuck_off_parser.h"
+#include "phuck_off_report.h"
+
+typedef struct phuck_off_report_map {
+    unsigned char* bytes;
+    size_t byte_count;
+} phuck_off_report_map;
+
+typedef struct phuck_off_report_directory {
+    char* path;
+    unsigned long functions;
+    unsigned long used;
+} phuck_off_report_directory;
+
+typedef struct phuck_off_report_directories {
+    phuck_off_report_directory** entries;
+    size_t count;
+} phuck_off_report_directories;
+
+static void phuck_off_report_set_error(char* error, size_t error_len, const char* format, ...) {
+    va_list args;
+
+    if (!error || error_len == 0) {
+        return;
+    }
+
+    va_start(args, format);
+    vsnprintf(error, error_len, format, args);
+    va_end(args);
+}
+
+static int phuck_off_report_is_archive(const char* path) {
+    const size_t len = strlen(path);
+    const size_t extension_len = strlen(PHUCK_OFF_ARCHIVE_EXTENSION);
+
+    return len > extension_len && strcmp(path + len - extension_len, PHUCK_OFF_ARCHIVE_EXTENSION) == 0;
+}
+
+static int phuck_off_report_or_bytes(phuck_off_report_map* map, size_t offset, const unsigned char* bytes, size_t len) {
+    size_t i;
+
+    if (offset + len > map->byte_count) {
+        unsigned char* tmp = (unsigned char*) realloc(map->bytes, offset + len);
+
+        if (!tmp) {
+            return 0;
+        }
+        memset(tmp + map->byte_count, 0, offset + len - map->byte_count);
+        map->bytes = tmp;
+        map->byte_count = offset + len;
+    }
+
+    for (i = 0; i < len; i++) {
+        map->bytes[offset + i] |= bytes[i];
+    }
+
+    return 1;
+}
+
+static int phuck_off_report_or_archive_file(phuck_off_report_map* map, FILE* fp, const char* path, char* error, size_t error_len) {
+    phuck_off_archive* archive;
+    unsigned char* bytes = NULL;
+    uint64_t archive_bytes;
+    size_t byte_count;
+    int ok = 0;
+
+    archive = phuck_off_archive_read(fp);
+    if (!archive) {
+        phuck_off_report_set_error(error, error_len, "\"%s\" is not a valid archive", path);
+        return 0;
+    }
+
+    archive_bytes = phuck_off_archive_byte_count(archive);
+    byte_count = (size_t) archive_bytes;
+    if (archive_bytes >= SIZE_MAX) {
+        phuck_off_report_set_error(error, error_len, "archive \"%s\" is too large to unpack", path);
+    } else if (!(bytes = (unsigned char*) malloc(byte_count + 1))) {
+        phuck_off_report_set_error(error, error_len, "failed to allocate %lu bytes to unpack \"%s\"", (unsigned long) byte_count, path);
+    } else if (!phuck_off_archive_to_bitmap(archive, bytes, byte_count)) {
+        phuck_off_report_set_error(error, error_len, "archive \"%s\" has invalid contents", path);
+    } else if (!phuck_off_report_or_bytes(map, 0, bytes, byte_count)) {
+        phuck_off_report_set_error(error, error_len, "failed to allocate map for \"%s\"", path);
+    } else {
+        ok = 1;
+    }
+
+    free(bytes);
+    phuck_off_archive_destroy(archive);
+    return ok;
+}
+
+static int phuck_off_report_or_map_file(phuck_off_report_map* map, const char* path, char* error, size_t error_len) {
+    FILE* fp;
+    unsigned char buffer[8192];
+    size_t offset = 0;
+    size_t read_bytes;
+
+    fp = fopen(path, "rb");
+    if (!fp) {
+        phuck_off_report_set_error(error, error_len, "failed to open map \"%s\": %s", path, strerror(errno));
+        return 0;
+    }
+
+    if (phuck_off_report_is_archive(path)) {
+        const int ok = phuck_off_report_or_archive_file(map, fp, path, error, error_len);
+
+        fclose(fp);
+        return ok;
+    }
+
+    while ((read_bytes = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+        if (!phuck_off_report_or_bytes(map, offset, buffer, read_bytes)) {
+            phuck_off_report_set_error(error, error_len, "failed to allocate map for \"%s\"", path);
+            fclose(fp);
+            return 0;
+        }
+        offset += read_bytes;
+    }
+
+    if (ferror(fp)) {
+        phuck_off_report_set_error(error, error_len, "failed while reading map \"%s\"", path);
+        fclose(fp);
+        return 0;
+    }
+
+    fclose(fp);
+    return 1;
+}
+
+static int phuck_off_report_is_used(const phuck_off_report_map* map, unsigned long function_id) {
+    const unsigned long bit = function_id - 1;
+
+    if ((bit >> 3) >= map->byte_count) {
+        return 0;
+    }
+
+    return (map->bytes[bit >> 3] >> (bit & 7u)) & 1u;
+}
+
+static void phuck_off_report_write_csv_string(FILE* out, const char* value) {
+    const char* c;
+
+    if (strpbrk(value, ",\"\n\r") == NULL) {
+        fputs(value, out);
+        return;
+    }
+
+    fputc('"', out);
+    for (c = value; *c; c++) {
+        if (*c == '"') {
+            fputc('"', out);
+        }
+        fputc(*c, out);
+    }
+    fputc('"', out);
+}
+
+static void phuck_off_report_write_json_string(FILE* out, const char* value) {
+    const unsigned char* c;
+
+    fputc('"', out);
+    for (c = (const unsigned char*) value; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', out);
+            fputc(*c, out);
+        } else if (*c < 0x20) {
+            fprintf(out, "\\u%04x", *c);
+        } else {
+            fputc(*c, out);
+        }
+    }
+    fputc('"', out);
+}
+
+static void phuck_off_report_write_function(
+    const phuck_off_report_options* options,
+    FILE* out,
+    unsigned long* rows,
+    unsigned long function_id,
+    const char* path,
+    unsigned long line_no,
+    int used
+) {
+    if ((options->kind == PHUCK_OFF_REPORT_USED && !used) || (options->kind == PHUCK_OFF_REPORT_UNUSED && used)) {
+        return;
+    }
+
+    if (options->format == PHUCK_OFF_REPORT_FORMAT_CSV) {
+        fprintf(out, "%lu,", function_id);
+        phuck_off_report_write_csv_string(out, path);
+        fprintf(out, ",%lu,%d\n", line_no, used);
+    } else {
+        fputs(*rows == 0 ? "\n  " : ",\n  ", out);
+        fprintf(out, "{\"id\": %lu, \"path\": ", function_id);
+        phuck_off_report_write_json_string(out, path);
+        fprintf(out, ", \"line\": %lu, \"used\": %s}", line_no, used ? "true" : "false");
+    }
+
+    (*rows)++;
+}
+
+static void phuck_off_report_directory_dtor(void* value) {
+    phuck_off_report_directory* directory = (phuck_off_report_directory*) value;
+
+    free(directory->path);
+    free(directory);
+}
+
+static int phuck_off_report_count_directory(xdebug_hash* directories, const char* path, int used) {
+    const char* slash = strrchr(path, '/');
+    const size_t len = slash ? (size_t) (slash - path) : 0;
+    phuck_off_report_directory* directory;
+    void* existing = NULL;
+
+    if (xdebug_hash_find(directories, (char*) path, (unsigned int) len, &existing)) {
+        directory = (phuck_off_report_directory*) existing;
+    } else {
+        directory = (phuck_off_report_directory*) calloc(1, sizeof(phuck_off_report_directory));
+        if (!directory) {
+            return 0;
+        }
+        directory->path = (char*) malloc(len + 1);
+        if (!directory->path) {
+            free(directory);
+            return 0;
+        }
+        memcpy(directory->path, path, len);
+        directory->path[len] = '\0';
+
+        if (!xdebug_hash_add(directories, directory->path, (unsigned int) len, directory)) {
+            phuck_off_report_directory_dtor(directory);
+            return 0;
+        }
+    }
+
+    directory->functions++;
+    if (used) {
+        directory->used++;
+    }
+
+    return 1;
+}
+
+static void phuck_off_report_collect_directory(void* user, xdebug_hash_element* element) {
+    phuck_off_report_directories* collected = (phuck_off_report_directories*) user;
+
+    collected->entries[collected->count++] = (phuck_off_report_directory*) element->ptr;
+}
+
+static int phuck_off_report_compare_directories(const void* a, const void* b) {
+    const phuck_off_report_directory* left = *(const phuck_off_report_directory* const*) a;
+    const phuck_off_report_directory* right = *(const phuck_off_report_directory* const*) b;
+
+    return strcmp(left->path, right->path);
+}
+
+static int phuck_off_report_write_directories(
+    const phuck_off_report_options* options,
+    FILE* out,
+    xdebug_hash* directories,
+    char* error,
+    size_t error_len
+) {
+    phuck_off_report_directories collected = { NULL, 0 };
+    size_t i;
+
+    if (directories->size > 0) {
+        collected.entries = (phuck_off_report_directory**) malloc(directories->size * sizeof(phuck_off_report_directory*));
+        if (!collected.entries) {
+            phuck_off_report_set_error(error, error_len, "failed to allocate directory rollup");
+            return 0;
+        }
+    }
+
+    xdebug_hash_apply(directories, &collected, phuck_off_report_collect_directory);
+    qsort(collected.entries, collected.count, sizeof(phuck_off_report_directory*), phuck_off_report_compare_directories);
+
+    for (i = 0; i < collected.count; i++) {
+        const phuck_off_report_directory* directory = collected.entries[i];
+
+        if (options->format == PHUCK_OFF_REPORT_FORMAT_CSV) {
+            phuck_off_report_write_csv_string(out, directory->path);
+            fprintf(out, ",%lu,%lu,%lu\n", directory->functions, directory->used, directory->functions - directory->used);
+        } else {
+            fputs(i == 0 ? "\n  " : ",\n  ", out);
+            fputs("{\"directory\": ", out);
+            phuck_off_report_write_json_string(out, directory->path);
+            fprintf(
+                out,
+                ", \"functions\": %lu, \"used\": %lu, \"unused\": %lu}",
+                directory->functions,
+                directory->used,
+                directory->functions - directory->used
+            );
+        }
+    }
+
+    free(collected.entries);
+    return 1;
+}
+
+int phuck_off_report(const phuck_off_report_options* options, FILE* out, char* error, size_t error_len) {
+    phuck_off_report_map map = { NULL, 0 };
+    xdebug_hash* directories = NULL;
+    FILE* fp = NULL;
+    char* line = NULL;
+    unsigned long input_line_no = 0;
+    unsigned long rows = 0;
+    int found_marker = 0;
+    int ok = 0;
+    size_t i;
+
+    if (error && error_len > 0) {
+        error[0] = '\0';
+    }
+
+    for (i = 0; i < options->map_count; i++) {
+        if (!phuck_off_report_or_map_file(&map, options->map_paths[i], error, error_len)) {
+            goto cleanup;
+        }
+    }
+
+    if (options->kind == PHUCK_OFF_REPORT_DIRECTORIES) {
+        directories = xdebug_hash_alloc(PHUCK_OFF_REPORT_DIRECTORIES_INITIAL_SLOTS, phuck_off_report_directory_dtor);
+        if (!directories) {
+            phuck_off_report_set_error(error, error_len, "failed to allocate directories hash");
+            goto cleanup;
+        }
+    }
+
+    fp = fopen(options->funcs_path, "r");
+    if (!fp) {
+        phuck_off_report_set_error(error, error_len, "failed to open \"%s\": %s", options->funcs_path, strerror(errno));
+        goto cleanup;
+    }
+
+    if (options->format == PHUCK_OFF_REPORT_FORMAT_CSV) {
+        fputs(directories ? "directory,functions,used,unused\n" : "id,path,line,used\n", out);
+    } else {
+        fputc('[', out);
+    }
+
+    while (!found_marker && (line = phuck_off_parser_read_line(fp)) != NULL) {
+        char* path;
+        unsigned long function_line_no;
+        int used;
+
+        input_line_no++;
+        phuck_off_parser_chomp(line);
+
+        if (line[0] == '\0') {
+            free(line);
+            continue;
+        }
+
+        if (strcmp(line, PHUCK_OFF_GENERATED_FOR_MARKER) == 0) {
+            found_marker = 1;
+            free(line);
+            break;
+        }
+
+        if (!phuck_off_parser_split_function_entry(line, input_line_no, &path, &function_line_no, error, error_len)) {
+            free(line);
+            goto cleanup;
+        }
+
+        used = phuck_off_report_is_used(&map, input_line_no);
+        if (directories) {
+            if (!phuck_off_report_count_directory(directories, path, used)) {
+                phuck_off_report_set_error(error, error_len, "failed to count directory for \"%s\"", path);
+                free(line);
+                goto cleanup;
+            }
+        } else {
+            phuck_off_report_write_function(options, out, &rows, input_line_no, path, function_line_no, used);
+        }
+
+        free(line);
+    }
+
+    if (ferror(fp)) {
+        phuck_off_report_set_error(error, error_len, "failed while reading \"%s\"", options->funcs_path);
+        goto cleanup;
+    }
+
+    if (!found_marker) {
+        phuck_off_report_set_error(error, error_len, "missing \"%s\" marker", PHUCK_OFF_GENERATED_FOR_MARKER);
+        goto cleanup;
+    }
+
+    if (directories && !phuck_off_report_write_directories(options, out, directories, error, error_len)) {
+        goto cleanup;
+    }
+
+    if (options->format == PHUCK_OFF_REPORT_FORMAT_JSON) {
+        fputs("\n]\n", out);
+    }
+
+    ok = 1;
+
+cleanup:
+    if (fp) {
+        fclose(fp);
+    }
+    if (directories) {
+        xdebug_hash_destroy(directories);
+    }
+    free(map.bytes);
+
+    return ok;
+}
+
+#ifndef PHUCK_OFF_REPORT_NO_MAIN
+
+static void phuck_off_report_usage(const char* program) {
+    fprintf(
+        stderr,
+        "usage: %s [-f csv|json] [-r functions|used|unused|directories] <funcs.txt> <map> [<map>...]\n",
+        program
+    );
+}
+
+int main(int argc, char** argv) {
+    phuck_off_report_options options;
+    char error[512];
+    int i = 1;
+
+    memset(&options, 0, sizeof(options));
+
+    for (; i < argc && argv[i][0] == '-'; i++) {
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (strcmp(argv[i], "-f") == 0 && value) {
+            if (strcmp(value, "csv") == 0) {
+                options.format = PHUCK_OFF_REPORT_FORMAT_CSV;
+            } else if (strcmp(value, "json") == 0) {
+                options.format = PHUCK_OFF_REPORT_FORMAT_JSON;
+            } else {
+                phuck_off_report_usage(argv[0]);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "-r") == 0 && value) {
+            if (strcmp(value, "functions") == 0) {
+                options.kind = PHUCK_OFF_REPORT_FUNCTIONS;
+            } else if (strcmp(value, "used") == 0) {
+                options.kind = PHUCK_OFF_REPORT_USED;
+            } else if (strcmp(value, "unused") == 0) {
+                options.kind = PHUCK_OFF_REPORT_UNUSED;
+            } else if (strcmp(value, "directories") == 0) {
+                options.kind = PHUCK_OFF_REPORT_DIRECTORIES;
+            } else {
+                phuck_off_report_usage(argv[0]);
+                return 2;
+            }
+        } else {
+            phuck_off_report_usage(argv[0]);
+            return 2;
+        }
+        i++;
+    }
+
+    if (argc - i < 2) {
+        phuck_off_report_usage(argv[0]);
+        return 2;
+    }
+
+    options.funcs_path = argv[i];
+    options.map_paths = (const char**) &argv[i + 1];
+    options.map_count = (size_t) (argc - i - 1);
+
+    if (!phuck_off_report(&options, stdout, error, sizeof(error))) {
+        fprintf(stderr, "%s\n", error);
+        return 1;
+    }
+
+    return 0;
+}
+
+#endif
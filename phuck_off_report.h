@@ -0,0 +1,33 @@
+#ifndef __HAVE_PHUCK_OFF_REPORT_H__
+#define __HAVE_PHUCK_OFF_REPORT_H__
+
+#include <stddef.h>
+#include <stdio.h>
+
+typedef enum {
+    PHUCK_OFF_REPORT_FUNCTIONS   = 0,
+    PHUCK_OFF_REPORT_USED        = 1,
+    PHUCK_OFF_REPORT_UNUSED      = 2,
+    PHUCK_OFF_REPORT_DIRECTORIES = 3
+} phuck_off_report_kind;
+
+typedef enum {
+    PHUCK_OFF_REPORT_FORMAT_CSV  = 0,
+    PHUCK_OFF_REPORT_FORMAT_JSON = 1
+} phuck_off_report_format;
+
+typedef struct phuck_off_report_options {
+    phuck_off_report_kind kind;
+    phuck_off_report_format format;
+    const char* funcs_path;
+    // maps are OR'ed together, so that per-host or per-worker maps can be passed as is
+    const char** map_paths;
+    size_t map_count;
+} phuck_off_report_options;
+
+#define PHUCK_OFF_REPORT_DIRECTORIES_INITIAL_SLOTS 256
+
+// joins the map(s) back to the funcs file entries, streaming the funcs file once
+int phuck_off_report(const phuck_off_report_options* options, FILE* out, char* error, size_t error_len);
+
+#endif
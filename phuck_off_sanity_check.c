@@ -8,7 +8,10 @@
 #include "phuck_off_logger.h"
 #include "phuck_off_sanity_check.h"
 
-static uint32_t phuck_off_sanity_check_state = 0;
+#include "phuck_off_thread.h"
+
+// per thread and seeded on first use, so threads neither race on it nor draw the same sequence
+static PHUCK_OFF_THREAD_LOCAL uint32_t phuck_off_sanity_check_state = 0;
 static int phuck_off_sanity_check_sampling = PHUCK_OFF_DEFAULT_SANITY_CHECK_SAMPLING;
 
 static int phuck_off_sanity_check_parse_sampling(const char* value, int* sampling_out) {
@@ -43,13 +46,15 @@ void phuck_off_sanity_check_init(void) {
 
     phuck_off_sanity_check_sampling = sampling;
     phuck_off_sanity_check_state = 0;
+}
 
-    if (sampling > 0 && sampling < 100) {
-        phuck_off_sanity_check_state = ((uint32_t) time(NULL)) ^ (((uint32_t) getpid()) << 16);
-        if (phuck_off_sanity_check_state == 0) {
-            phuck_off_sanity_check_state = 0x9e3779b9u;
-        }
-    }
+static uint32_t phuck_off_sanity_check_seed(void) {
+    uint32_t seed = ((uint32_t) time(NULL)) ^ (((uint32_t) getpid()) << 16);
+
+    // the address of a thread-local differs between threads
+    seed ^= (uint32_t) (((uintptr_t) &phuck_off_sanity_check_state) >> 4);
+
+    return seed != 0 ? seed : 0x9e3779b9u;
 }
 
 int phuck_off_sanity_check_should_sample(void) {
@@ -64,6 +69,9 @@ int phuck_off_sanity_check_should_sample(void) {
     }
 
     value = phuck_off_sanity_check_state;
+    if (value == 0) {
+        value = phuck_off_sanity_check_seed();
+    }
     value ^= value << 13;
     value ^= value >> 17;
     value ^= value << 5;
@@ -0,0 +1,45 @@
+#!/bin/sh
+
+# compares xdebug_hash in the working tree against another revision
+#
+# usage: run_xdebug_hash_bench.sh [<revision>]  (defaults to HEAD~1)
+
+set -eu
+
+ROOT="$(CDPATH= cd -- "$(dirname -- "$0")/../.." && pwd)"
+CC_BIN="${CC:-cc}"
+REVISION="${1:-HEAD~1}"
+BUILD_DIR="$(mktemp -d "${TMPDIR:-/tmp}/xdebug_hash_bench.XXXXXX")"
+BENCH_SOURCE="$ROOT/phuck_off_tests/bench/xdebug_hash_bench.c"
+
+cleanup() {
+    rm -rf "$BUILD_DIR"
+}
+
+trap cleanup EXIT
+
+mkdir "$BUILD_DIR/baseline"
+for file in xdebug_hash.c xdebug_hash.h xdebug_llist.c xdebug_llist.h; do
+    git -C "$ROOT" show "$REVISION:$file" > "$BUILD_DIR/baseline/$file"
+done
+
+# xdebug_llist.c allocates its elements from xdebug_arena.c in revisions that have it
+BASELINE_SOURCES="$BUILD_DIR/baseline/xdebug_hash.c $BUILD_DIR/baseline/xdebug_llist.c"
+if git -C "$ROOT" cat-file -e "$REVISION:xdebug_arena.c" 2>/dev/null; then
+    for file in xdebug_arena.c xdebug_arena.h; do
+        git -C "$ROOT" show "$REVISION:$file" > "$BUILD_DIR/baseline/$file"
+    done
+    BASELINE_SOURCES="$BASELINE_SOURCES $BUILD_DIR/baseline/xdebug_arena.c"
+fi
+
+# BASELINE_SOURCES is split on purpose; BUILD_DIR comes from mktemp and has no spaces
+# shellcheck disable=SC2086
+"$CC_BIN" -O2 -I"$BUILD_DIR/baseline" "$BENCH_SOURCE" \
+    $BASELINE_SOURCES -o "$BUILD_DIR/baseline_bench"
+"$CC_BIN" -O2 -I"$ROOT" "$BENCH_SOURCE" \
+    "$ROOT/xdebug_hash.c" "$ROOT/xdebug_llist.c" "$ROOT/xdebug_arena.c" -o "$BUILD_DIR/current_bench"
+
+echo "== $REVISION"
+"$BUILD_DIR/baseline_bench"
+echo "== working tree"
+"$BUILD_DIR/current_bench"
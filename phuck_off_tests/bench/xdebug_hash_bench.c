@@ -0,0 +1,145 @@
+// micro benchmark for xdebug_hash, run through run_xdebug_hash_bench.sh to
+// compare the working tree against another revision
+//
+// only the public API is used, so that it builds against older versions
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "xdebug_hash.h"
+
+#define FILE_COUNT 10000
+#define LINES_PER_FILE 20
+#define LOOKUP_ROUNDS 20
+
+static char** paths;
+static unsigned int* path_lens;
+static volatile uintptr_t sink;
+
+static double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+static void report(const char* name, double started, size_t operations) {
+    double elapsed = now() - started;
+
+    printf("%-28s %10.1f ns/op\n", name, elapsed * 1e9 / (double) operations);
+}
+
+static void make_paths(void) {
+    char buffer[256];
+    int i;
+
+    paths = (char**) malloc(FILE_COUNT * sizeof(char*));
+    path_lens = (unsigned int*) malloc(FILE_COUNT * sizeof(unsigned int));
+    for (i = 0; i < FILE_COUNT; i++) {
+        path_lens[i] = (unsigned int) snprintf(
+            buffer,
+            sizeof(buffer),
+            "/srv/app/vendor/package_%d/src/Module%d/Class%d.php",
+            i % 97,
+            i % 13,
+            i
+        );
+        paths[i] = (char*) malloc(path_lens[i] + 1);
+        snprintf(paths[i], path_lens[i] + 1, "%s", buffer);
+    }
+}
+
+// the phuck-off index shape: file paths to small hashes of line numbers
+static void bench_index(void) {
+    xdebug_hash* files;
+    double started;
+    void* value;
+    int round;
+    int i;
+    int line;
+
+    started = now();
+    files = xdebug_hash_alloc(1024, (xdebug_hash_dtor) xdebug_hash_destroy);
+    for (i = 0; i < FILE_COUNT; i++) {
+        xdebug_hash* lines = xdebug_hash_alloc(8, NULL);
+
+        for (line = 0; line < LINES_PER_FILE; line++) {
+            xdebug_hash_index_add(lines, (unsigned long) (line * 7 + 3), (void*) (uintptr_t) (line + 1));
+        }
+        xdebug_hash_add(files, paths[i], path_lens[i], lines);
+    }
+    report("index build", started, FILE_COUNT * (LINES_PER_FILE + 1));
+
+    started = now();
+    for (round = 0; round < LOOKUP_ROUNDS; round++) {
+        for (i = 0; i < FILE_COUNT; i++) {
+            if (xdebug_hash_find(files, paths[i], path_lens[i], &value)) {
+                xdebug_hash_index_find((xdebug_hash*) value, (unsigned long) ((i % LINES_PER_FILE) * 7 + 3), &value);
+                sink += (uintptr_t) value;
+            }
+        }
+    }
+    report("index lookup (file+line)", started, (size_t) LOOKUP_ROUNDS * FILE_COUNT);
+
+    started = now();
+    xdebug_hash_destroy(files);
+    report("index destroy", started, FILE_COUNT * (LINES_PER_FILE + 1));
+}
+
+// code coverage and profiler refs shape: a fixed small initial size that has to cope with many files
+static void bench_small_initial(void) {
+    xdebug_hash* h;
+    double started;
+    double slowest = 0;
+    void* value;
+    int round;
+    int i;
+
+    started = now();
+    h = xdebug_hash_alloc(32, NULL);
+    for (i = 0; i < FILE_COUNT; i++) {
+        double insert_started = now();
+
+        xdebug_hash_add(h, paths[i], path_lens[i], (void*) (uintptr_t) (i + 1));
+        if (now() - insert_started > slowest) {
+            slowest = now() - insert_started;
+        }
+    }
+    report("insert into 32 slots", started, FILE_COUNT);
+    printf("%-28s %10.1f ns\n", "slowest single insert", slowest * 1e9);
+
+    started = now();
+    for (round = 0; round < LOOKUP_ROUNDS; round++) {
+        for (i = 0; i < FILE_COUNT; i++) {
+            xdebug_hash_find(h, paths[i], path_lens[i], &value);
+            sink += (uintptr_t) value;
+        }
+    }
+    report("lookup hit", started, (size_t) LOOKUP_ROUNDS * FILE_COUNT);
+
+    started = now();
+    for (round = 0; round < LOOKUP_ROUNDS; round++) {
+        for (i = 0; i < FILE_COUNT; i++) {
+            sink += (uintptr_t) xdebug_hash_find(h, paths[i], path_lens[i] - 1, &value);
+        }
+    }
+    report("lookup miss", started, (size_t) LOOKUP_ROUNDS * FILE_COUNT);
+
+    started = now();
+    for (i = 0; i < FILE_COUNT; i += 2) {
+        xdebug_hash_delete(h, paths[i], path_lens[i]);
+    }
+    report("delete half", started, FILE_COUNT / 2);
+
+    xdebug_hash_destroy(h);
+}
+
+int main(void) {
+    make_paths();
+    bench_index();
+    bench_small_initial();
+
+    return sink == 42 ? 1 : 0;
+}
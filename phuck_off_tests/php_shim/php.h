@@ -0,0 +1,17 @@
+// stands in for PHP's php.h when xdebug_str.c is built for the unit tests. Like
+// main/snprintf.h, it sends vsnprintf() to PHP's own formatter, which the test
+// provides, so that the test can tell the formatting goes through PHP
+
+#ifndef PHUCK_OFF_TESTS_PHP_SHIM_H
+#define PHUCK_OFF_TESTS_PHP_SHIM_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+
+int ap_php_vsnprintf(char* buf, size_t len, const char* format, va_list ap);
+
+#undef vsnprintf
+#define vsnprintf ap_php_vsnprintf
+
+#endif
@@ -0,0 +1,236 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "phuck_off_archive.h"
+
+// 3 full chunks plus a partial one
+#define TEST_BYTE_COUNT (3 * 8192 + 1000)
+
+static int failures = 0;
+static uint32_t rng_state = 0x12345678u;
+
+static void assert_true(int condition, const char* message) {
+    if (!condition) {
+        fprintf(stderr, "%s\n", message);
+        failures = 1;
+    }
+}
+
+static uint32_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+// each chunk gets its own density, so that all container types show up
+static void fill_map(unsigned char* bytes, const unsigned int* per_mille_by_chunk) {
+    size_t bit;
+
+    memset(bytes, 0, TEST_BYTE_COUNT);
+    for (bit = 0; bit < (size_t) TEST_BYTE_COUNT * 8u; bit++) {
+        if (next_random() % 1000u < per_mille_by_chunk[bit / PHUCK_OFF_ARCHIVE_CHUNK_BITS]) {
+            bytes[bit >> 3] |= (unsigned char) (1u << (bit & 7u));
+        }
+    }
+}
+
+static size_t count_type(const phuck_off_archive* archive, uint32_t type) {
+    size_t count = 0;
+    size_t i;
+
+    for (i = 0; i < archive->count; i++) {
+        if (archive->containers[i].type == type) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+static uint64_t naive_cardinality(const unsigned char* bytes) {
+    uint64_t count = 0;
+    size_t i;
+
+    for (i = 0; i < TEST_BYTE_COUNT; i++) {
+        unsigned char byte = bytes[i];
+
+        while (byte) {
+            byte &= (unsigned char) (byte - 1);
+            count++;
+        }
+    }
+
+    return count;
+}
+
+static void assert_archive_equals(const phuck_off_archive* archive, const unsigned char* expected, const char* message) {
+    static unsigned char actual[TEST_BYTE_COUNT];
+
+    assert_true(archive != NULL, message);
+    if (!archive) {
+        return;
+    }
+
+    assert_true(phuck_off_archive_to_bitmap(archive, actual, TEST_BYTE_COUNT), message);
+    assert_true(memcmp(actual, expected, TEST_BYTE_COUNT) == 0, message);
+    assert_true(phuck_off_archive_cardinality(archive) == naive_cardinality(expected), message);
+}
+
+static void run_operations_case(const unsigned int* a_density, const unsigned int* b_density, const char* name) {
+    static unsigned char a_bytes[TEST_BYTE_COUNT];
+    static unsigned char b_bytes[TEST_BYTE_COUNT];
+    static unsigned char expected[TEST_BYTE_COUNT];
+    phuck_off_archive* a;
+    phuck_off_archive* b;
+    phuck_off_archive* result;
+    char message[256];
+    size_t i;
+
+    fill_map(a_bytes, a_density);
+    fill_map(b_bytes, b_density);
+
+    a = phuck_off_archive_from_bitmap(a_bytes, TEST_BYTE_COUNT);
+    b = phuck_off_archive_from_bitmap(b_bytes, TEST_BYTE_COUNT);
+    snprintf(message, sizeof(message), "%s: round trip mismatch", name);
+    assert_archive_equals(a, a_bytes, message);
+    assert_archive_equals(b, b_bytes, message);
+
+    for (i = 0; i < TEST_BYTE_COUNT; i++) {
+        expected[i] = a_bytes[i] | b_bytes[i];
+    }
+    result = phuck_off_archive_union(a, b);
+    snprintf(message, sizeof(message), "%s: union mismatch", name);
+    assert_archive_equals(result, expected, message);
+    phuck_off_archive_destroy(result);
+
+    for (i = 0; i < TEST_BYTE_COUNT; i++) {
+        expected[i] = a_bytes[i] & b_bytes[i];
+    }
+    result = phuck_off_archive_intersection(a, b);
+    snprintf(message, sizeof(message), "%s: intersection mismatch", name);
+    assert_archive_equals(result, expected, message);
+    phuck_off_archive_destroy(result);
+
+    for (i = 0; i < (size_t) TEST_BYTE_COUNT * 8u; i += 997) {
+        snprintf(message, sizeof(message), "%s: contains mismatch for bit %lu", name, (unsigned long) i);
+        assert_true(phuck_off_archive_contains(a, i) == (int) ((a_bytes[i >> 3] >> (i & 7u)) & 1u), message);
+    }
+
+    phuck_off_archive_destroy(a);
+    phuck_off_archive_destroy(b);
+}
+
+static void run_container_choice_case(void) {
+    static unsigned char bytes[TEST_BYTE_COUNT];
+    // sparse, dense, middle, and an empty partial chunk
+    static const unsigned int density[] = { 5, 995, 500, 0 };
+    phuck_off_archive* archive;
+
+    fill_map(bytes, density);
+    archive = phuck_off_archive_from_bitmap(bytes, TEST_BYTE_COUNT);
+    assert_true(archive != NULL, "failed to compress mixed map");
+    if (!archive) {
+        return;
+    }
+
+    assert_true(archive->count == 3, "empty chunks should be omitted");
+    assert_true(count_type(archive, PHUCK_OFF_ARCHIVE_ARRAY) == 1, "sparse chunk should be an array");
+    assert_true(count_type(archive, PHUCK_OFF_ARCHIVE_INVERTED) == 1, "dense chunk should be an inverted array");
+    assert_true(count_type(archive, PHUCK_OFF_ARCHIVE_BITMAP) == 1, "half full chunk should be raw bits");
+    assert_true(!phuck_off_archive_contains(archive, (uint64_t) TEST_BYTE_COUNT * 8u), "out of range bit should not be set");
+
+    phuck_off_archive_destroy(archive);
+}
+
+static void run_serialization_case(void) {
+    static unsigned char bytes[TEST_BYTE_COUNT];
+    static const unsigned int density[] = { 2, 998, 300, 999 };
+    phuck_off_archive* archive;
+    phuck_off_archive* read_back;
+    FILE* fp;
+    long size;
+
+    fill_map(bytes, density);
+    archive = phuck_off_archive_from_bitmap(bytes, TEST_BYTE_COUNT);
+    fp = tmpfile();
+    assert_true(archive != NULL && fp != NULL, "failed to set up serialization case");
+    if (!archive || !fp) {
+        phuck_off_archive_destroy(archive);
+        return;
+    }
+
+    assert_true(phuck_off_archive_write(archive, fp), "failed to write archive");
+    size = ftell(fp);
+    // the raw bits chunk dominates, the sparse and dense ones only need a few hundred positions
+    assert_true(size > 0 && size < TEST_BYTE_COUNT / 2, "archive should be smaller than the raw map");
+
+    rewind(fp);
+    read_back = phuck_off_archive_read(fp);
+    assert_archive_equals(read_back, bytes, "serialization round trip mismatch");
+    phuck_off_archive_destroy(read_back);
+
+    // truncated archives must be rejected
+    rewind(fp);
+    assert_true(ftruncate(fileno(fp), size - 1) == 0, "failed to truncate archive");
+    read_back = phuck_off_archive_read(fp);
+    assert_true(read_back == NULL, "truncated archive should be rejected");
+    phuck_off_archive_destroy(read_back);
+
+    fclose(fp);
+    phuck_off_archive_destroy(archive);
+}
+
+static void run_size_mismatch_case(void) {
+    unsigned char small[4] = { 1, 2, 3, 4 };
+    unsigned char big[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    phuck_off_archive* a = phuck_off_archive_from_bitmap(small, sizeof(small));
+    phuck_off_archive* b = phuck_off_archive_from_bitmap(big, sizeof(big));
+
+    assert_true(phuck_off_archive_union(a, b) == NULL, "union of different sizes should fail");
+    assert_true(phuck_off_archive_intersection(a, b) == NULL, "intersection of different sizes should fail");
+    assert_true(!phuck_off_archive_to_bitmap(a, big, sizeof(big)), "unpacking to the wrong size should fail");
+
+    // the last byte of a map whose size isn't whole bytes is still unpacked
+    b->bit_count = 60;
+    memset(big, 0, sizeof(big));
+    assert_true(phuck_off_archive_byte_count(b) == 8, "a partial last byte should count as a byte");
+    assert_true(phuck_off_archive_to_bitmap(b, big, sizeof(big)) && big[7] == 8, "a partial last byte should be unpacked");
+    assert_true(!phuck_off_archive_to_bitmap(b, big, 7), "unpacking without the partial byte should fail");
+
+    phuck_off_archive_destroy(a);
+    phuck_off_archive_destroy(b);
+}
+
+int main(void) {
+    static const unsigned int sparse[] = { 1, 3, 0, 2 };
+    static const unsigned int dense[] = { 999, 997, 1000, 998 };
+    static const unsigned int middle[] = { 400, 600, 500, 300 };
+    static const unsigned int mixed[] = { 2, 999, 500, 1000 };
+    static const unsigned int swapped[] = { 999, 2, 1000, 500 };
+    // union of two arrays overflowing an array, intersection of two inverted arrays overflowing one
+    static const unsigned int overflow_sparse[] = { 50, 50, 50, 50 };
+    static const unsigned int overflow_dense[] = { 950, 950, 950, 950 };
+
+    run_operations_case(sparse, sparse, "sparse/sparse");
+    run_operations_case(dense, dense, "dense/dense");
+    run_operations_case(middle, middle, "middle/middle");
+    run_operations_case(sparse, dense, "sparse/dense");
+    run_operations_case(dense, middle, "dense/middle");
+    run_operations_case(mixed, swapped, "mixed/swapped");
+    run_operations_case(overflow_sparse, overflow_sparse, "overflowing arrays");
+    run_operations_case(overflow_dense, overflow_dense, "overflowing inverted arrays");
+    run_container_choice_case();
+    run_serialization_case();
+    run_size_mismatch_case();
+
+    if (failures) {
+        return 1;
+    }
+
+    printf("ok\n");
+    return 0;
+}
@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "shims.h"
 #include "phuck_off.c"
@@ -9,12 +10,6 @@
 static int failures = 0;
 static const char* test_function_name = "test_function";
 
-static void destroy_file_entry(void* value) {
-    if (value) {
-        xdebug_hash_destroy((xdebug_hash*) value);
-    }
-}
-
 static void assert_true(int condition, const char* message) {
     if (!condition) {
         fprintf(stderr, "%s\n", message);
@@ -22,95 +17,73 @@ static void assert_true(int condition, const char* message) {
     }
 }
 
-static char* dup_string(const char* value) {
-    size_t len;
-    char* copy;
-
-    len = strlen(value);
-    copy = (char*) malloc(len + 1);
-    assert_true(copy != NULL, "failed to allocate string copy");
-    if (!copy) {
-        return NULL;
-    }
-
-    memcpy(copy, value, len + 1);
-    return copy;
-}
-
 static void reset_test_handler(void) {
-    if (handler.files) {
-        xdebug_hash_destroy(handler.files);
-        handler.files = NULL;
-    }
-
-    if (handler.user_code_root) {
-        free(handler.user_code_root);
-        handler.user_code_root = NULL;
-    }
-
-    handler.user_code_root_len = 0;
-    handler.initialized = 0;
+    shutdown_handler();
 }
 
-static void setup_handler(const char* root) {
-    handler.files = xdebug_hash_alloc(8, destroy_file_entry);
-    assert_true(handler.files != NULL, "failed to allocate outer files hash");
-    handler.user_code_root = dup_string(root);
-    handler.user_code_root_len = strlen(handler.user_code_root);
-    handler.initialized = 1;
-}
+// IDs are line numbers in the funcs file
+static void setup_handler(const char* funcs) {
+    char path_template[] = "/tmp/phuck_off_function_id.XXXXXX";
+    char error[512];
+    int fd;
+    FILE* fp;
 
-static xdebug_hash* add_line_map(const char* path) {
-    xdebug_hash* line_map;
+    fd = mkstemp(path_template);
+    assert_true(fd >= 0, "failed to create funcs file");
+    if (fd < 0) {
+        return;
+    }
 
-    line_map = xdebug_hash_alloc(8, NULL);
-    assert_true(line_map != NULL, "failed to allocate inner line hash");
-    if (!line_map) {
-        return NULL;
+    fp = fdopen(fd, "w");
+    assert_true(fp != NULL, "failed to open funcs file");
+    if (!fp) {
+        close(fd);
+        unlink(path_template);
+        return;
     }
+    fputs(funcs, fp);
+    fclose(fp);
 
     assert_true(
-        xdebug_hash_add(handler.files, (char*) path, (unsigned int) strlen(path), line_map),
-        "failed to add line map to outer hash"
+        phuck_off_parse_funcs_file(path_template, &handler.index, &handler.ignored, &handler.user_code_root, &handler.function_count, error, sizeof(error)),
+        error
     );
+    // the index keeps its own descriptor
+    unlink(path_template);
     if (failures) {
-        xdebug_hash_destroy(line_map);
-        return NULL;
+        return;
     }
 
-    return line_map;
+    handler.user_code_root_len = strlen(handler.user_code_root);
+    handler.initialized = 1;
 }
 
 static void run_user_root_case(void) {
-    xdebug_hash* line_map;
     const char* main_path = "/tmp/user/code/main.php";
     const char* ignored_path = "/tmp/user/code/ignored.php";
 
     reset_test_handler();
-    setup_handler("/tmp/user/code");
-    line_map = add_line_map(main_path);
-    if (!line_map) {
+    setup_handler(
+        "/tmp/user/code/main.php:10\n"
+        "/tmp/user/code/other.php:5\n"
+        "\n"
+        "/tmp/user/code/main.php:20\n"
+        PHUCK_OFF_GENERATED_FOR_MARKER "\n"
+        "/tmp/user/code\n"
+        "/tmp/user/code/ignored.php\n"
+        "vendor/\n"
+    );
+    if (!handler.initialized) {
         return;
     }
 
-    assert_true(
-        xdebug_hash_index_add(line_map, 10, (void*) (uintptr_t) 17),
-        "failed to add first function id"
-    );
-    assert_true(
-        xdebug_hash_index_add(line_map, 20, (void*) (uintptr_t) 31),
-        "failed to add second function id"
-    );
-    assert_true(
-        xdebug_hash_add(handler.files, (char*) ignored_path, (unsigned int) strlen(ignored_path), NULL),
-        "failed to add ignored file entry"
-    );
-
-    assert_true(function_id(main_path, 10, test_function_name) == 17, "wrong function id for main.php:10");
-    assert_true(function_id(main_path, 20, test_function_name) == 31, "wrong cached function id for main.php:20");
+    assert_true(function_id(main_path, 10, test_function_name) == 1, "wrong function id for main.php:10");
+    assert_true(function_id(main_path, 20, test_function_name) == 4, "wrong cached function id for main.php:20");
+    assert_true(function_id("/tmp/user/code/other.php", 5, test_function_name) == 2, "wrong function id for other.php:5");
     assert_true(function_id(main_path, 11, test_function_name) == -1, "missing line should return -1");
     assert_true(function_id(ignored_path, 50, test_function_name) == -1, "ignored file should return -1");
     assert_true(function_id(ignored_path, 51, test_function_name) == -1, "cached ignored file should return -1");
+    assert_true(function_id("/tmp/user/code/vendor/lib/a.php", 3, test_function_name) == -1, "ignored directory should return -1");
     assert_true(function_id("/tmp/user/code/missing.php", 10, test_function_name) == -1, "missing file should return -1");
     assert_true(function_id("/tmp/user/other.php", 10, test_function_name) == -1, "outside-root path should return -1");
     assert_true(function_id("/tmp/user/codebase/main.php", 10, test_function_name) == -1, "prefix-only path should return -1");
@@ -118,20 +91,18 @@ static void run_user_root_case(void) {
 }
 
 static void run_root_prefix_case(void) {
-    xdebug_hash* line_map;
-
     reset_test_handler();
-    setup_handler("/tmp");
-    line_map = add_line_map("/tmp/anywhere.php");
-    if (!line_map) {
+    setup_handler(
+        "\n\n"
+        "/tmp/anywhere.php:7\n"
+        PHUCK_OFF_GENERATED_FOR_MARKER "\n"
+        "/tmp\n"
+    );
+    if (!handler.initialized) {
         return;
     }
 
-    assert_true(
-        xdebug_hash_index_add(line_map, 7, (void*) (uintptr_t) 91),
-        "failed to add root-prefix function id"
-    );
-    assert_true(function_id("/tmp/anywhere.php", 7, test_function_name) == 91, "root prefix should match descendant path");
+    assert_true(function_id("/tmp/anywhere.php", 7, test_function_name) == 3, "root prefix should match descendant path");
     assert_true(function_id("/tmpx/anywhere.php", 7, test_function_name) == -1, "root prefix should not match sibling prefix");
 }
 
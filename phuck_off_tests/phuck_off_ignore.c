@@ -0,0 +1,92 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "phuck_off_ignore.h"
+
+static int failures = 0;
+
+static void assert_true(int condition, const char* message) {
+    if (!condition) {
+        fprintf(stderr, "%s\n", message);
+        failures = 1;
+    }
+}
+
+static void run_rules_case(void) {
+    phuck_off_ignore* ignore;
+    int i;
+    char path[128];
+
+    ignore = phuck_off_ignore_alloc();
+    assert_true(ignore != NULL, "ignore allocation failed");
+    if (!ignore) {
+        return;
+    }
+
+    assert_true(phuck_off_ignore_add(ignore, "/srv/app/", "vendor/"), "failed to add relative prefix");
+    assert_true(phuck_off_ignore_add(ignore, "/srv/app", "/srv/app/tests/"), "failed to add absolute prefix");
+    assert_true(phuck_off_ignore_add(ignore, "/srv/app", "/srv/app/tests/fixtures/"), "failed to add covered prefix");
+    assert_true(phuck_off_ignore_add(ignore, "/srv/app", "vendor/composer/autoload_real.php"), "failed to add covered file");
+    assert_true(phuck_off_ignore_add(ignore, "/srv/app", "bootstrap.php"), "failed to add exact file");
+    assert_true(phuck_off_ignore_add(ignore, "/srv/app", "bootstrap.php"), "failed to add duplicate file");
+    assert_true(!phuck_off_ignore_add(ignore, "/srv/app", ""), "empty rule should be rejected");
+
+    // enough rules to make the pool and rules array grow
+    for (i = 0; i < 500; i++) {
+        snprintf(path, sizeof(path), "generated/proxy_%03d.php", i);
+        assert_true(phuck_off_ignore_add(ignore, "/srv/app", path), "failed to add generated file");
+    }
+
+    assert_true(!phuck_off_ignore_match(ignore, "/srv/app/vendor/a.php"), "rules should not match before compiling");
+
+    phuck_off_ignore_compile(ignore);
+    assert_true(ignore->count == 503, "covered and duplicate rules should be collapsed");
+
+    assert_true(phuck_off_ignore_match(ignore, "/srv/app/vendor/a.php"), "vendor file should be ignored");
+    assert_true(phuck_off_ignore_match(ignore, "/srv/app/vendor/composer/autoload_real.php"), "covered vendor file should be ignored");
+    assert_true(phuck_off_ignore_match(ignore, "/srv/app/tests/fixtures/x.php"), "covered test file should be ignored");
+    assert_true(phuck_off_ignore_match(ignore, "/srv/app/tests/unit/y.php"), "test file should be ignored");
+    assert_true(phuck_off_ignore_match(ignore, "/srv/app/bootstrap.php"), "exact file should be ignored");
+    assert_true(phuck_off_ignore_match(ignore, "/srv/app/generated/proxy_000.php"), "first generated file should be ignored");
+    assert_true(phuck_off_ignore_match(ignore, "/srv/app/generated/proxy_499.php"), "last generated file should be ignored");
+
+    assert_true(!phuck_off_ignore_match(ignore, "/srv/app/generated/proxy_500.php"), "unlisted generated file should not be ignored");
+    assert_true(!phuck_off_ignore_match(ignore, "/srv/app/bootstrap.php.dist"), "exact rule should not act as a prefix");
+    assert_true(!phuck_off_ignore_match(ignore, "/srv/app/vendor"), "prefix rule should not match its own directory path");
+    assert_true(!phuck_off_ignore_match(ignore, "/srv/app/vendored/a.php"), "prefix rule should not match siblings");
+    assert_true(!phuck_off_ignore_match(ignore, "/srv/app/src/a.php"), "user file should not be ignored");
+    assert_true(!phuck_off_ignore_match(ignore, "/aaa.php"), "path sorting before every rule should not be ignored");
+    assert_true(!phuck_off_ignore_match(ignore, "/zzz.php"), "path sorting after every rule should not be ignored");
+
+    phuck_off_ignore_destroy(ignore);
+}
+
+static void run_empty_case(void) {
+    phuck_off_ignore* ignore;
+
+    assert_true(!phuck_off_ignore_match(NULL, "/srv/app/a.php"), "NULL rules should not match");
+
+    ignore = phuck_off_ignore_alloc();
+    assert_true(ignore != NULL, "ignore allocation failed");
+    if (!ignore) {
+        return;
+    }
+
+    phuck_off_ignore_compile(ignore);
+    assert_true(ignore->count == 0, "empty rules should stay empty");
+    assert_true(!phuck_off_ignore_match(ignore, "/srv/app/a.php"), "empty rules should not match");
+
+    phuck_off_ignore_destroy(ignore);
+}
+
+int main(void) {
+    run_rules_case();
+    run_empty_case();
+
+    if (failures) {
+        return 1;
+    }
+
+    printf("ok\n");
+    return 0;
+}
@@ -194,11 +194,11 @@ static off_t file_size(const char* path) {
     return sb.st_size;
 }
 
-static void read_file_bytes(unsigned char* buffer, size_t byte_count) {
+static void read_path_bytes(const char* path, unsigned char* buffer, size_t byte_count) {
     FILE* fp;
     size_t read_count;
 
-    fp = fopen(test_path, "rb");
+    fp = fopen(path, "rb");
     assert_true(fp != NULL, "failed to open mmap backing file");
     if (!fp) {
         memset(buffer, 0, byte_count);
@@ -210,6 +210,10 @@ static void read_file_bytes(unsigned char* buffer, size_t byte_count) {
     fclose(fp);
 }
 
+static void read_file_bytes(unsigned char* buffer, size_t byte_count) {
+    read_path_bytes(test_path, buffer, byte_count);
+}
+
 static void remove_test_file(void) {
     phuck_off_mmap_shutdown();
     if (unlink(test_path) != 0 && errno != ENOENT) {
@@ -454,6 +458,80 @@ static void run_post_request_case(void) {
     phuck_off_logger_shutdown();
 }
 
+static void run_snapshot_case(void) {
+    unsigned char file_bytes[2];
+    char snapshot_path[sizeof(test_path) + 16];
+    char tmp_path[sizeof(test_path) + 16];
+    char* log_content;
+    unsigned int i;
+
+    snprintf(snapshot_path, sizeof(snapshot_path), "%s.snap", test_path);
+    snprintf(tmp_path, sizeof(tmp_path), "%s.snap.tmp", test_path);
+
+    remove_test_file();
+    remove_test_log();
+    setenv(PHUCK_OFF_LOG_LEVEL_ENV_VAR, "trace", 1);
+    unsetenv(PHUCK_OFF_NO_CLEANUP_ENV_VAR);
+    setenv(PHUCK_OFF_SNAPSHOT_INTERVAL_ENV_VAR, "1", 1);
+    phuck_off_logger_init();
+
+    assert_true(phuck_off_mmap_init(test_path, 10), "init(10) should succeed for snapshots");
+    phuck_off_mmap_set(0);
+    phuck_off_mmap_set(9);
+
+    for (i = 0; i < PHUCK_OFF_MMAP_SNAPSHOT_CHECK_EVERY; i++) {
+        phuck_off_mmap_tick();
+    }
+    log_content = read_log_file();
+    assert_true(count_occurrences(log_content, "snapshot=yes") == 0, "snapshot should wait for the interval");
+    free(log_content);
+
+    sleep(2);
+    for (i = 0; i < PHUCK_OFF_MMAP_SNAPSHOT_CHECK_EVERY - 1; i++) {
+        phuck_off_mmap_tick();
+    }
+    log_content = read_log_file();
+    assert_true(count_occurrences(log_content, "snapshot=yes") == 0, "snapshot should only check the clock every N ticks");
+    free(log_content);
+
+    phuck_off_mmap_tick();
+    log_content = read_log_file();
+    assert_true(count_occurrences(log_content, "snapshot=yes") == 1, "snapshot should happen once the interval elapsed");
+    free(log_content);
+
+    assert_true(file_size(snapshot_path) == 2, "the snapshot should be as large as the map");
+    assert_true(file_size(tmp_path) == -1, "the snapshot's temporary file should have been renamed");
+    read_path_bytes(snapshot_path, file_bytes, sizeof(file_bytes));
+    assert_true(file_bytes[0] == 0x01, "snapshot first byte mismatch");
+    assert_true(file_bytes[1] == 0x02, "snapshot second byte mismatch");
+
+    // the snapshot is a copy, so bits set afterwards only show up in the next one
+    phuck_off_mmap_set(1);
+    read_path_bytes(snapshot_path, file_bytes, sizeof(file_bytes));
+    assert_true(file_bytes[0] == 0x01, "the snapshot should not follow the map");
+    sleep(2);
+    for (i = 0; i < PHUCK_OFF_MMAP_SNAPSHOT_CHECK_EVERY; i++) {
+        phuck_off_mmap_tick();
+    }
+    read_path_bytes(snapshot_path, file_bytes, sizeof(file_bytes));
+    assert_true(file_bytes[0] == 0x03, "the next snapshot should replace the previous one");
+
+    setenv(PHUCK_OFF_SNAPSHOT_INTERVAL_ENV_VAR, "0", 1);
+    assert_true(phuck_off_mmap_init(test_path, 10), "init(10) should succeed with snapshots disabled");
+    sleep(2);
+    for (i = 0; i < PHUCK_OFF_MMAP_SNAPSHOT_CHECK_EVERY; i++) {
+        phuck_off_mmap_tick();
+    }
+    log_content = read_log_file();
+    assert_true(count_occurrences(log_content, "snapshot=yes") == 2, "disabled snapshots should never happen");
+    free(log_content);
+    assert_true(file_size(snapshot_path) == -1, "reinitializing should remove the previous snapshot");
+
+    phuck_off_mmap_shutdown();
+    unsetenv(PHUCK_OFF_SNAPSHOT_INTERVAL_ENV_VAR);
+    phuck_off_logger_shutdown();
+}
+
 static void run_reinit_case(void) {
     unsetenv(PHUCK_OFF_NO_CLEANUP_ENV_VAR);
     assert_true(phuck_off_mmap_init(test_path, 17), "reinit to 17 bits should succeed");
@@ -493,6 +571,7 @@ int main(void) {
     run_init_for_pid_fork_case();
     run_no_cleanup_case();
     run_post_request_case();
+    run_snapshot_case();
     run_reinit_case();
     run_shutdown_case();
 
@@ -28,15 +28,293 @@ static void write_fixture_file(FILE* fp) {
     for (i = 0; i < 2047; i++) {
         fprintf(fp, "/tmp/user/code/vendor/file_%04d.php\n", i);
     }
+    fprintf(fp, "generated/\n");
+    fprintf(fp, "/tmp/user/code/tests/\n");
+    fprintf(fp, "/tmp/user/code/tests/unit/covered.php\n");
+}
+
+static int write_funcs_file(char* path_template, const char* funcs) {
+    int fd;
+    FILE* fp;
+
+    fd = mkstemp(path_template);
+    if (fd < 0) {
+        return 0;
+    }
+
+    fp = fdopen(fd, "w");
+    if (!fp) {
+        close(fd);
+        return 0;
+    }
+    fputs(funcs, fp);
+    return fclose(fp) == 0;
+}
+
+static unsigned long find_id(phuck_off_index* index, const char* path, unsigned long line_no) {
+    unsigned long id = 0;
+    char error[512];
+
+    if (phuck_off_index_find(index, path, strlen(path), line_no, &id, error, sizeof(error)) != PHUCK_OFF_INDEX_FOUND) {
+        return 0;
+    }
+
+    return id;
+}
+
+static void run_split_spans_case(void) {
+    char path_template[] = "/tmp/phuck_off_parser_spans.XXXXXX";
+    phuck_off_index* index = NULL;
+    void* value = NULL;
+    char* user_code_root = NULL;
+    size_t function_count = 0;
+    char error[512];
+
+    assert_true(
+        write_funcs_file(
+            path_template,
+            "/tmp/user/code/a.php:3\n"
+            "\n"
+            "/tmp/user/code/a.php:9\r\n"
+            "/tmp/user/code/b.php:4\n"
+            "/tmp/user/code/a.php:15\n"
+            "\n"
+            PHUCK_OFF_GENERATED_FOR_MARKER "\n"
+            "/tmp/user/code\n"
+        ),
+        "failed to write spans fixture"
+    );
+
+    assert_true(
+        phuck_off_parse_funcs_file(path_template, &index, NULL, &user_code_root, &function_count, error, sizeof(error)),
+        error
+    );
+    if (index) {
+        assert_true(function_count == 4, "unexpected spans function count");
+        assert_true(xdebug_hash_find(index->files, "/tmp/user/code/a.php", sizeof("/tmp/user/code/a.php") - 1, &value), "a.php missing");
+        assert_true(
+            value != NULL && ((phuck_off_index_file*) value)->first_span.next != NULL && ((phuck_off_index_file*) value)->first_span.next->next == NULL,
+            "a.php entries should be split in two spans"
+        );
+
+        assert_true(find_id(index, "/tmp/user/code/a.php", 3) == 1, "a.php:3 has the wrong ID");
+        assert_true(find_id(index, "/tmp/user/code/a.php", 9) == 3, "blank lines inside a span should still count");
+        assert_true(find_id(index, "/tmp/user/code/a.php", 15) == 5, "a.php:15 in the second span has the wrong ID");
+        assert_true(find_id(index, "/tmp/user/code/b.php", 4) == 4, "b.php:4 has the wrong ID");
+    }
+
+    free(user_code_root);
+    phuck_off_index_destroy(index);
+    unlink(path_template);
+}
+
+static void run_changed_file_case(void) {
+    char path_template[] = "/tmp/phuck_off_parser_changed.XXXXXX";
+    phuck_off_index* index = NULL;
+    char* user_code_root = NULL;
+    size_t function_count = 0;
+    unsigned long id = 0;
+    char error[512];
+    FILE* fp;
+
+    assert_true(
+        write_funcs_file(
+            path_template,
+            "/tmp/user/code/a.php:3\n"
+            "/tmp/user/code/b.php:4\n"
+            PHUCK_OFF_GENERATED_FOR_MARKER "\n"
+            "/tmp/user/code\n"
+        ),
+        "failed to write changed fixture"
+    );
+
+    assert_true(
+        phuck_off_parse_funcs_file(path_template, &index, NULL, &user_code_root, &function_count, error, sizeof(error)),
+        error
+    );
+
+    // rewritten in place after MINIT, with the same layout
+    fp = fopen(path_template, "r+");
+    assert_true(fp != NULL, "failed to reopen changed fixture");
+    if (fp) {
+        fputs("/tmp/user/code/c.php:3\n", fp);
+        fclose(fp);
+    }
+
+    if (index) {
+        assert_true(
+            phuck_off_index_find(index, "/tmp/user/code/a.php", sizeof("/tmp/user/code/a.php") - 1, 3, &id, error, sizeof(error)) == PHUCK_OFF_INDEX_ERROR,
+            "changed entries should not be loaded"
+        );
+        assert_true(strstr(error, "changed since they were indexed") != NULL, "changed entries should say so");
+        assert_true(
+            phuck_off_index_find(index, "/tmp/user/code/a.php", sizeof("/tmp/user/code/a.php") - 1, 3, &id, error, sizeof(error)) == PHUCK_OFF_INDEX_MISSING_LINE,
+            "a file that failed to load should only report it once"
+        );
+        assert_true(find_id(index, "/tmp/user/code/b.php", 4) == 2, "untouched entries should still load");
+    }
+
+    free(user_code_root);
+    phuck_off_index_destroy(index);
+    unlink(path_template);
+}
+
+// the index keeps reading the funcs file it parsed, even once another one took its name
+static void run_replaced_file_case(void) {
+    char path_template[] = "/tmp/phuck_off_parser_replaced.XXXXXX";
+    char replacement_template[] = "/tmp/phuck_off_parser_replacement.XXXXXX";
+    phuck_off_index* index = NULL;
+    char* user_code_root = NULL;
+    char error[512];
+    char long_path[600];
+    char funcs[1024];
+
+    // longer than the line buffer starts out as
+    memset(long_path, 'd', sizeof(long_path));
+    memcpy(long_path, "/tmp/user/code/", sizeof("/tmp/user/code/") - 1);
+    memcpy(long_path + sizeof(long_path) - sizeof(".php"), ".php", sizeof(".php"));
+    snprintf(funcs, sizeof(funcs), "/tmp/user/code/a.php:3\n%s:7\n" PHUCK_OFF_GENERATED_FOR_MARKER "\n/tmp/user/code\n", long_path);
+    assert_true(write_funcs_file(path_template, funcs), "failed to write replaced fixture");
+
+    assert_true(
+        phuck_off_parse_funcs_file(path_template, &index, NULL, &user_code_root, NULL, error, sizeof(error)),
+        error
+    );
+
+    assert_true(
+        write_funcs_file(
+            replacement_template,
+            "/tmp/user/code/b.php:1\n"
+            "/tmp/user/code/a.php:3\n"
+            PHUCK_OFF_GENERATED_FOR_MARKER "\n"
+            "/tmp/user/code\n"
+        ),
+        "failed to write replacement fixture"
+    );
+    assert_true(rename(replacement_template, path_template) == 0, "failed to replace fixture");
+
+    if (index) {
+        assert_true(find_id(index, "/tmp/user/code/a.php", 3) == 1, "a.php:3 should keep its ID from the parsed file");
+        assert_true(find_id(index, long_path, 7) == 2, "long paths should be indexed whole");
+    }
+
+    free(user_code_root);
+    phuck_off_index_destroy(index);
+    unlink(path_template);
+}
+
+static void run_invalid_entry_case(void) {
+    static const char* entries[] = {
+        "/tmp/user/code/a.php\n",
+        ":3\n",
+        "/tmp/user/code/a.php:\n",
+        "/tmp/user/code/a.php:3x\n",
+        "/tmp/user/code/a.php:-3\n"
+    };
+    static const char* messages[] = {
+        "invalid function entry on line 2",
+        "invalid function entry on line 2",
+        "invalid function entry on line 2",
+        "invalid line number on line 2",
+        "invalid line number on line 2"
+    };
+    char path_template[64];
+    char funcs[256];
+    char error[512];
+    phuck_off_index* index = NULL;
+    size_t i;
+
+    for (i = 0; i < sizeof(entries) / sizeof(entries[0]); i++) {
+        snprintf(path_template, sizeof(path_template), "/tmp/phuck_off_parser_bad.XXXXXX");
+        snprintf(funcs, sizeof(funcs), "/tmp/user/code/b.php:1\n%s" PHUCK_OFF_GENERATED_FOR_MARKER "\n/tmp/user/code\n", entries[i]);
+        assert_true(write_funcs_file(path_template, funcs), "failed to write invalid fixture");
+
+        assert_true(!phuck_off_parse_funcs_file(path_template, &index, NULL, NULL, NULL, error, sizeof(error)), "invalid entries should fail the parse");
+        assert_true(index == NULL, "a failed parse should not return an index");
+        assert_true(strcmp(error, messages[i]) == 0, messages[i]);
+        unlink(path_template);
+    }
+}
+
+// fgets() would stop counting at a NUL, and a line starting with one would end the scan early
+static void run_nul_byte_case(void) {
+    static const char funcs[] = "/tmp/user/code/b.php:1\n\0/tmp/user/code/a.php:3\n" PHUCK_OFF_GENERATED_FOR_MARKER "\n/tmp/user/code\n";
+    static const char middle[] = "/tmp/user/code/b.php:1\n/tmp/user/code/a\0.php:3\n" PHUCK_OFF_GENERATED_FOR_MARKER "\n/tmp/user/code\n";
+    const char* fixtures[] = { funcs, middle };
+    size_t lengths[] = { sizeof(funcs) - 1, sizeof(middle) - 1 };
+    char path_template[64];
+    char error[512];
+    phuck_off_index* index = NULL;
+    FILE* fp;
+    size_t i;
+
+    for (i = 0; i < 2; i++) {
+        snprintf(path_template, sizeof(path_template), "/tmp/phuck_off_parser_nul.XXXXXX");
+        assert_true(write_funcs_file(path_template, ""), "failed to create NUL fixture");
+        fp = fopen(path_template, "wb");
+        assert_true(fp != NULL && fwrite(fixtures[i], 1, lengths[i], fp) == lengths[i], "failed to write NUL fixture");
+        if (fp) {
+            fclose(fp);
+        }
+
+        assert_true(!phuck_off_parse_funcs_file(path_template, &index, NULL, NULL, NULL, error, sizeof(error)), "a NUL byte should fail the parse");
+        assert_true(index == NULL, "a failed parse should not return an index");
+        assert_true(strcmp(error, "NUL byte on line 2") == 0, "a NUL byte should be reported on its line");
+        unlink(path_template);
+    }
+}
+
+// with placement on, the files hash and the line maps built on lookup live in the region
+static void run_placement_case(void) {
+    char path_template[] = "/tmp/phuck_off_parser_placement.XXXXXX";
+    phuck_off_index* index = NULL;
+    xdebug_hash* lines;
+    char* user_code_root = NULL;
+    char error[512];
+
+    setenv(PHUCK_OFF_HUGE_PAGES_ENV_VAR, "1", 1);
+    assert_true(
+        write_funcs_file(
+            path_template,
+            "/tmp/user/code/a.php:3\n"
+            "/tmp/user/code/b.php:4\n"
+            "/tmp/user/code/a.php:15\n"
+            PHUCK_OFF_GENERATED_FOR_MARKER "\n"
+            "/tmp/user/code\n"
+        ),
+        "failed to write placement fixture"
+    );
+
+    assert_true(
+        phuck_off_parse_funcs_file(path_template, &index, NULL, &user_code_root, NULL, error, sizeof(error)),
+        error
+    );
+    if (index) {
+        assert_true(index->region != NULL, "the index should have a placement region");
+        assert_true(phuck_off_placement_region_contains(index->region, index->files->table), "the files hash should be in the region");
+
+        lines = phuck_off_index_file_lines(index, "/tmp/user/code/a.php", sizeof("/tmp/user/code/a.php") - 1, error, sizeof(error));
+        assert_true(lines != NULL && phuck_off_placement_region_contains(index->region, lines->table), "a.php's line map should be in the region");
+        assert_true(find_id(index, "/tmp/user/code/a.php", 15) == 3, "a.php:15 has the wrong ID with placement");
+        assert_true(find_id(index, "/tmp/user/code/b.php", 4) == 2, "b.php:4 has the wrong ID with placement");
+    }
+
+    free(user_code_root);
+    phuck_off_index_destroy(index);
+    unlink(path_template);
+    unsetenv(PHUCK_OFF_HUGE_PAGES_ENV_VAR);
 }
 
 int main(void) {
     char path_template[] = "/tmp/phuck_off_parser.XXXXXX";
     int fd;
     FILE* fp;
-    xdebug_hash* files = NULL;
+    phuck_off_index* index = NULL;
+    phuck_off_ignore* ignored = NULL;
+    phuck_off_index_file* main_file = NULL;
     xdebug_hash* main_lines = NULL;
     void* value = NULL;
+    unsigned long id = 0;
     char* user_code_root = NULL;
     size_t function_count = 0;
     char error[512];
@@ -59,55 +337,101 @@ int main(void) {
     fclose(fp);
 
     assert_true(
-        phuck_off_parse_funcs_file(path_template, &files, &user_code_root, &function_count, error, sizeof(error)),
+        phuck_off_parse_funcs_file(path_template, &index, &ignored, &user_code_root, &function_count, error, sizeof(error)),
         error
     );
 
-    if (files && user_code_root) {
+    if (index && ignored && user_code_root) {
         assert_true(strcmp(user_code_root, "/tmp/user/code") == 0, "unexpected user_code_root");
         assert_true(function_count == 18, "unexpected parsed function count");
-        assert_true(files->size == 2049, "unexpected outer hash size");
-        assert_true(files->slots == 1025, "outer hash did not resize as expected");
+        assert_true(index->files->size == 2, "ignored files should not be stored in the outer hash");
+        assert_true(index->files->slots == PHUCK_OFF_FILES_INITIAL_SLOTS, "outer hash should not have resized");
+        assert_true(ignored->count == 2050, "covered ignore rules should be collapsed");
 
         assert_true(
-            xdebug_hash_find(files, "/tmp/user/code/main.php", sizeof("/tmp/user/code/main.php") - 1, &value),
+            xdebug_hash_find(index->files, "/tmp/user/code/main.php", sizeof("/tmp/user/code/main.php") - 1, &value),
             "main.php missing from outer hash"
         );
-        main_lines = (xdebug_hash*) value;
-        assert_true(main_lines != NULL, "main.php should not be ignored");
-        if (main_lines) {
-            assert_true(main_lines->size == 17, "unexpected main.php inner hash size");
-            assert_true(main_lines->slots == 9, "main.php inner hash did not resize as expected");
+        main_file = (phuck_off_index_file*) value;
+        assert_true(main_file != NULL, "main.php should not be ignored");
+        if (main_file) {
+            assert_true(main_file->function_count == 17, "unexpected main.php function count");
+            assert_true(main_file->lines == NULL, "main.php should only get a line map once it's looked up");
+            assert_true(main_file->first_span.next == NULL, "main.php entries should be a single span");
 
             assert_true(
-                xdebug_hash_index_find(main_lines, 10, &value) && (unsigned long) (uintptr_t) value == 1,
+                phuck_off_index_find(index, "/tmp/user/code/main.php", sizeof("/tmp/user/code/main.php") - 1, 10, &id, error, sizeof(error)) == PHUCK_OFF_INDEX_FOUND
+                    && id == 1,
                 "main.php:10 has the wrong input line number"
             );
             assert_true(
-                xdebug_hash_index_find(main_lines, 26, &value) && (unsigned long) (uintptr_t) value == 17,
+                phuck_off_index_find(index, "/tmp/user/code/main.php", sizeof("/tmp/user/code/main.php") - 1, 26, &id, error, sizeof(error)) == PHUCK_OFF_INDEX_FOUND
+                    && id == 17,
                 "main.php:26 has the wrong input line number"
             );
+            assert_true(
+                phuck_off_index_find(index, "/tmp/user/code/main.php", sizeof("/tmp/user/code/main.php") - 1, 27, &id, error, sizeof(error)) == PHUCK_OFF_INDEX_MISSING_LINE,
+                "main.php:27 should not be found"
+            );
+            assert_true(
+                phuck_off_index_find(index, "/tmp/user/code/other.php", sizeof("/tmp/user/code/other.php") - 1, 10, &id, error, sizeof(error)) == PHUCK_OFF_INDEX_MISSING_FILE,
+                "other.php should not be found"
+            );
+
+            main_lines = main_file->lines;
+            assert_true(main_lines != NULL, "main.php line map should exist after a lookup");
+            if (main_lines) {
+                assert_true(main_lines->size == 17, "unexpected main.php inner hash size");
+                assert_true(main_lines->old_table == NULL, "main.php inner hash should be sized up front");
+                assert_true(
+                    xdebug_hash_index_find(main_lines, 10, &value) && (unsigned long) (uintptr_t) value == 1,
+                    "main.php line map has the wrong input line number"
+                );
+            }
         }
 
         assert_true(
-            xdebug_hash_find(files, "/tmp/user/code/ignored_later.php", sizeof("/tmp/user/code/ignored_later.php") - 1, &value),
-            "ignored_later.php missing from outer hash"
+            phuck_off_ignore_match(ignored, "/tmp/user/code/ignored_later.php"),
+            "ignored_later.php should be ignored even though it has functions"
+        );
+        assert_true(
+            phuck_off_ignore_match(ignored, "/tmp/user/code/vendor/file_0000.php"),
+            "ignored vendor file should be ignored"
+        );
+        assert_true(
+            !phuck_off_ignore_match(ignored, "/tmp/user/code/vendor/file_9999.php"),
+            "vendor file that isn't listed should not be ignored"
         );
-        assert_true(value == NULL, "ignored_later.php should map to NULL");
-
         assert_true(
-            xdebug_hash_find(files, "/tmp/user/code/vendor/file_0000.php", sizeof("/tmp/user/code/vendor/file_0000.php") - 1, &value),
-            "ignored vendor file missing from outer hash"
+            phuck_off_ignore_match(ignored, "/tmp/user/code/generated/deep/proxy.php"),
+            "relative directory rule should be resolved against user_code_root"
+        );
+        assert_true(
+            phuck_off_ignore_match(ignored, "/tmp/user/code/tests/unit/other.php"),
+            "absolute directory rule should ignore descendants"
+        );
+        assert_true(
+            !phuck_off_ignore_match(ignored, "/tmp/user/code/tests_helper.php"),
+            "directory rule should not match sibling prefixes"
+        );
+        assert_true(
+            !phuck_off_ignore_match(ignored, "/tmp/user/code/main.php"),
+            "main.php should not be ignored"
         );
-        assert_true(value == NULL, "ignored vendor file should map to NULL");
     }
 
     free(user_code_root);
-    if (files) {
-        xdebug_hash_destroy(files);
-    }
+    phuck_off_index_destroy(index);
+    phuck_off_ignore_destroy(ignored);
     unlink(path_template);
 
+    run_split_spans_case();
+    run_changed_file_case();
+    run_replaced_file_case();
+    run_invalid_entry_case();
+    run_nul_byte_case();
+    run_placement_case();
+
     if (failures) {
         return 1;
     }
@@ -241,7 +241,7 @@ static int init_handler_from_file(const char* path) {
 
     shutdown_handler();
 
-    if (!phuck_off_parse_funcs_file(path, &handler.files, &handler.user_code_root, &handler.function_count, error, sizeof(error))) {
+    if (!phuck_off_parse_funcs_file(path, &handler.index, &handler.ignored, &handler.user_code_root, &handler.function_count, error, sizeof(error))) {
         fprintf(stderr, "failed to initialize handler from %s: %s\n", path, error);
         failures = 1;
         handler.initialized = 0;
@@ -288,8 +288,8 @@ static void run_fixture_case(const fixture_case* fixture) {
 
     snprintf(message, sizeof(message), "%s handler failed to initialize", fixture->name);
     assert_true(handler.initialized == 1, message);
-    snprintf(message, sizeof(message), "%s handler files hash missing", fixture->name);
-    assert_true(handler.files != NULL, message);
+    snprintf(message, sizeof(message), "%s handler index missing", fixture->name);
+    assert_true(handler.index != NULL, message);
     snprintf(message, sizeof(message), "unexpected user_code_root for %s", fixture->name);
     assert_true(strcmp(handler.user_code_root, fixture->expected_root) == 0, message);
     snprintf(message, sizeof(message), "unexpected function_count for %s", fixture->name);
@@ -0,0 +1,138 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "phuck_off_placement.h"
+
+static int failures = 0;
+
+static void assert_true(int condition, const char* message) {
+    if (!condition) {
+        fprintf(stderr, "%s\n", message);
+        failures = 1;
+    }
+}
+
+// finds the mapping containing p in a /proc/self file made of "<start>-<end> ..." headers, and
+// returns its start along with the first following line that begins with 'field'
+static int find_mapping_field(const char* proc_path, const void* p, const char* field, unsigned long* start_out, char* value, size_t value_len) {
+    char line[1024];
+    unsigned long start, end;
+    int in_mapping = 0;
+    FILE* fp = fopen(proc_path, "r");
+
+    if (!fp) {
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), fp)) {
+        if (sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+            in_mapping = start <= (unsigned long) (uintptr_t) p && (unsigned long) (uintptr_t) p < end;
+            if (in_mapping) {
+                *start_out = start;
+            }
+        } else if (in_mapping && strncmp(line, field, strlen(field)) == 0) {
+            snprintf(value, value_len, "%s", line);
+            fclose(fp);
+            return 1;
+        }
+    }
+
+    fclose(fp);
+    return 0;
+}
+
+// numa_maps has one "<start> <policy> ..." line per mapping
+static int find_numa_policy(unsigned long mapping_start, char* value, size_t value_len) {
+    char line[1024];
+    unsigned long start;
+    FILE* fp = fopen("/proc/self/numa_maps", "r");
+
+    if (!fp) {
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), fp)) {
+        if (sscanf(line, "%lx ", &start) == 1 && start == mapping_start) {
+            snprintf(value, value_len, "%s", line);
+            fclose(fp);
+            return 1;
+        }
+    }
+
+    fclose(fp);
+    return 0;
+}
+
+static void run_not_requested_case(void) {
+    unsetenv(PHUCK_OFF_HUGE_PAGES_ENV_VAR);
+    unsetenv(PHUCK_OFF_NUMA_INTERLEAVE_ENV_VAR);
+
+    assert_true(!phuck_off_placement_requested(), "placement should be off by default");
+    assert_true(phuck_off_placement_region_alloc(4096) == NULL, "no region should be made when placement is off");
+
+    setenv(PHUCK_OFF_HUGE_PAGES_ENV_VAR, "yes", 1);
+    assert_true(!phuck_off_placement_requested(), "only \"1\" should enable placement");
+    unsetenv(PHUCK_OFF_HUGE_PAGES_ENV_VAR);
+}
+
+static void run_region_case(void) {
+    phuck_off_placement_region* region;
+    unsigned long mapping_start = 0;
+    char value[1024];
+    char* first;
+    char* second;
+
+    setenv(PHUCK_OFF_HUGE_PAGES_ENV_VAR, "1", 1);
+    setenv(PHUCK_OFF_NUMA_INTERLEAVE_ENV_VAR, "1", 1);
+
+    region = phuck_off_placement_region_alloc(PHUCK_OFF_PLACEMENT_ALIGNMENT + 1);
+    assert_true(region != NULL, "a region should be made when placement is on");
+    if (!region) {
+        return;
+    }
+
+    assert_true(((uintptr_t) region->base & (PHUCK_OFF_PLACEMENT_ALIGNMENT - 1)) == 0, "the region should be 2MB aligned");
+    assert_true(region->size == 2 * PHUCK_OFF_PLACEMENT_ALIGNMENT, "the region should be rounded up to 2MB");
+
+    first = (char*) phuck_off_placement_region_take(region, 100);
+    second = (char*) phuck_off_placement_region_take(region, 8);
+    assert_true(first == region->base, "the first take should start the region");
+    assert_true(second == region->base + 128, "takes should be cache line aligned");
+    assert_true(phuck_off_placement_region_take(region, region->size) == NULL, "takes beyond the region should fail");
+    assert_true(phuck_off_placement_region_contains(region, region->base + region->size - 1), "the last byte should be in the region");
+    assert_true(!phuck_off_placement_region_contains(region, region->base + region->size), "the byte after should not be");
+    assert_true(first[0] == 0 && first[region->size - 1] == 0, "the region should come zeroed");
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    assert_true(strcmp(region->huge_pages, "on") == 0, "huge pages should have been advised");
+    if (find_mapping_field("/proc/self/smaps", region->base, "VmFlags:", &mapping_start, value, sizeof(value))) {
+        assert_true(strstr(value, " hg") != NULL, "the region's mapping should carry MADV_HUGEPAGE");
+        assert_true(mapping_start <= (unsigned long) (uintptr_t) region->base, "the advice should cover the start of the region");
+    }
+#endif
+
+    // mbind() may be refused in containers, in which case there's no policy to look for
+    if (strcmp(region->numa_interleave, "on") == 0 && mapping_start != 0 && find_numa_policy(mapping_start, value, sizeof(value))) {
+        assert_true(strstr(value, "interleave") != NULL, "the region should be interleaved across NUMA nodes");
+    }
+    assert_true(strcmp(region->numa_interleave, "off") != 0, "NUMA interleaving should have been attempted");
+
+    phuck_off_placement_region_destroy(region);
+    unsetenv(PHUCK_OFF_HUGE_PAGES_ENV_VAR);
+    unsetenv(PHUCK_OFF_NUMA_INTERLEAVE_ENV_VAR);
+}
+
+int main(void) {
+    run_not_requested_case();
+    run_region_case();
+
+    if (failures) {
+        return 1;
+    }
+
+    printf("ok\n");
+    return 0;
+}
@@ -249,14 +249,12 @@ static zend_op_array make_op_array(const char* path, int line_no) {
 }
 
 static xdebug_hash* line_map_for(const char* path) {
-    void* file_entry = NULL;
+    char error[512];
+    xdebug_hash* line_map = phuck_off_index_file_lines(handler.index, path, strlen(path), error, sizeof(error));
 
-    assert_true(
-        xdebug_hash_find(handler.files, (char*) path, (unsigned int) strlen(path), &file_entry),
-        "failed to find line map for stackframe fixture path"
-    );
+    assert_true(line_map != NULL, "failed to find line map for stackframe fixture path");
 
-    return (xdebug_hash*) file_entry;
+    return line_map;
 }
 
 static void run_process_stackframe_case(void) {
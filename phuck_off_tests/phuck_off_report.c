@@ -0,0 +1,214 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "phuck_off_archive.h"
+#include "phuck_off_parser.h"
+#include "phuck_off_report.h"
+
+static int failures = 0;
+static char funcs_template[] = "/tmp/phuck_off_report.funcs.XXXXXX";
+static char first_map_template[] = "/tmp/phuck_off_report.map1.XXXXXX";
+static char second_map_template[] = "/tmp/phuck_off_report.map2.XXXXXX";
+static char archive_template[] = "/tmp/phuck_off_report.archive.XXXXXX" PHUCK_OFF_ARCHIVE_EXTENSION;
+
+static void assert_true(int condition, const char* message) {
+    if (!condition) {
+        fprintf(stderr, "%s\n", message);
+        failures = 1;
+    }
+}
+
+static void assert_output(const char* actual, const char* expected, const char* message) {
+    if (!actual || strcmp(actual, expected) != 0) {
+        fprintf(stderr, "%s\nexpected:\n%s\ngot:\n%s\n", message, expected, actual ? actual : "(null)");
+        failures = 1;
+    }
+}
+
+static void write_fixture(char* path_template, const char* content, size_t len) {
+    int fd;
+
+    fd = mkstemp(path_template);
+    assert_true(fd >= 0, "failed to create report fixture");
+    if (fd < 0) {
+        return;
+    }
+
+    assert_true(write(fd, content, len) == (ssize_t) len, "failed to write report fixture");
+    close(fd);
+}
+
+static void write_archive_fixture(const unsigned char* bytes, size_t byte_count) {
+    phuck_off_archive* archive;
+    FILE* fp;
+    int fd;
+
+    fd = mkstemps(archive_template, (int) strlen(PHUCK_OFF_ARCHIVE_EXTENSION));
+    assert_true(fd >= 0, "failed to create report archive fixture");
+    if (fd < 0) {
+        return;
+    }
+
+    fp = fdopen(fd, "wb");
+    archive = phuck_off_archive_from_bitmap(bytes, byte_count);
+    assert_true(fp != NULL && archive != NULL && phuck_off_archive_write(archive, fp), "failed to write report archive fixture");
+    phuck_off_archive_destroy(archive);
+    if (fp) {
+        fclose(fp);
+    }
+}
+
+static char* run_report_with_maps(phuck_off_report_kind kind, phuck_off_report_format format, const char** map_paths, size_t map_count) {
+    phuck_off_report_options options;
+    char error[512];
+    FILE* out;
+    long length;
+    char* buffer;
+
+    options.kind = kind;
+    options.format = format;
+    options.funcs_path = funcs_template;
+    options.map_paths = map_paths;
+    options.map_count = map_count;
+
+    out = tmpfile();
+    assert_true(out != NULL, "failed to create report output");
+    if (!out) {
+        return NULL;
+    }
+
+    assert_true(phuck_off_report(&options, out, error, sizeof(error)), error);
+
+    fseek(out, 0, SEEK_END);
+    length = ftell(out);
+    fseek(out, 0, SEEK_SET);
+    buffer = (char*) calloc(1, (size_t) length + 1);
+    assert_true(buffer != NULL && fread(buffer, 1, (size_t) length, out) == (size_t) length, "failed to read report output");
+    fclose(out);
+
+    return buffer;
+}
+
+static char* run_report(phuck_off_report_kind kind, phuck_off_report_format format, size_t map_count) {
+    const char* map_paths[2] = { first_map_template, second_map_template };
+
+    return run_report_with_maps(kind, format, map_paths, map_count);
+}
+
+int main(void) {
+    static const char funcs[] =
+        "/srv/app/src/a.php:10\n"
+        "/srv/app/src/a.php:20\n"
+        "/srv/app/src/b,\"c\".php:5\n"
+        "/srv/app/lib/d.php:7\n"
+        "\n"
+        "/srv/app/lib/d.php:9\n"
+        PHUCK_OFF_GENERATED_FOR_MARKER "\n"
+        "/srv/app\n"
+        "vendor/\n";
+    // IDs are input line numbers, so bits 0, 1, 2, 3 and 5
+    static const unsigned char first_map[] = { 0x01 };
+    static const unsigned char second_map[] = { 0x24 };
+    phuck_off_report_options options;
+    const char* missing_map = "/tmp/phuck_off_report.definitely-missing";
+    const char* archive_map_paths[2];
+    char error[512];
+    char* output;
+
+    write_fixture(funcs_template, funcs, sizeof(funcs) - 1);
+    write_fixture(first_map_template, (const char*) first_map, sizeof(first_map));
+    write_fixture(second_map_template, (const char*) second_map, sizeof(second_map));
+    write_archive_fixture(second_map, sizeof(second_map));
+
+    output = run_report(PHUCK_OFF_REPORT_FUNCTIONS, PHUCK_OFF_REPORT_FORMAT_CSV, 2);
+    assert_output(
+        output,
+        "id,path,line,used\n"
+        "1,/srv/app/src/a.php,10,1\n"
+        "2,/srv/app/src/a.php,20,0\n"
+        "3,\"/srv/app/src/b,\"\"c\"\".php\",5,1\n"
+        "4,/srv/app/lib/d.php,7,0\n"
+        "6,/srv/app/lib/d.php,9,1\n",
+        "unexpected merged functions CSV report"
+    );
+    free(output);
+
+    output = run_report(PHUCK_OFF_REPORT_UNUSED, PHUCK_OFF_REPORT_FORMAT_CSV, 1);
+    assert_output(
+        output,
+        "id,path,line,used\n"
+        "2,/srv/app/src/a.php,20,0\n"
+        "3,\"/srv/app/src/b,\"\"c\"\".php\",5,0\n"
+        "4,/srv/app/lib/d.php,7,0\n"
+        "6,/srv/app/lib/d.php,9,0\n",
+        "unexpected single map unused CSV report"
+    );
+    free(output);
+
+    output = run_report(PHUCK_OFF_REPORT_USED, PHUCK_OFF_REPORT_FORMAT_JSON, 2);
+    assert_output(
+        output,
+        "[\n"
+        "  {\"id\": 1, \"path\": \"/srv/app/src/a.php\", \"line\": 10, \"used\": true},\n"
+        "  {\"id\": 3, \"path\": \"/srv/app/src/b,\\\"c\\\".php\", \"line\": 5, \"used\": true},\n"
+        "  {\"id\": 6, \"path\": \"/srv/app/lib/d.php\", \"line\": 9, \"used\": true}\n"
+        "]\n",
+        "unexpected used JSON report"
+    );
+    free(output);
+
+    output = run_report(PHUCK_OFF_REPORT_DIRECTORIES, PHUCK_OFF_REPORT_FORMAT_CSV, 2);
+    assert_output(
+        output,
+        "directory,functions,used,unused\n"
+        "/srv/app/lib,2,1,1\n"
+        "/srv/app/src,3,2,1\n",
+        "unexpected directories CSV report"
+    );
+    free(output);
+
+    output = run_report(PHUCK_OFF_REPORT_DIRECTORIES, PHUCK_OFF_REPORT_FORMAT_JSON, 0);
+    assert_output(
+        output,
+        "[\n"
+        "  {\"directory\": \"/srv/app/lib\", \"functions\": 2, \"used\": 0, \"unused\": 2},\n"
+        "  {\"directory\": \"/srv/app/src\", \"functions\": 3, \"used\": 0, \"unused\": 3}\n"
+        "]\n",
+        "unexpected directories JSON report without maps"
+    );
+    free(output);
+
+    archive_map_paths[0] = first_map_template;
+    archive_map_paths[1] = archive_template;
+    output = run_report_with_maps(PHUCK_OFF_REPORT_DIRECTORIES, PHUCK_OFF_REPORT_FORMAT_CSV, archive_map_paths, 2);
+    assert_output(
+        output,
+        "directory,functions,used,unused\n"
+        "/srv/app/lib,2,1,1\n"
+        "/srv/app/src,3,2,1\n",
+        "archived maps should be merged like raw ones"
+    );
+    free(output);
+
+    options.kind = PHUCK_OFF_REPORT_FUNCTIONS;
+    options.format = PHUCK_OFF_REPORT_FORMAT_CSV;
+    options.funcs_path = funcs_template;
+    options.map_paths = &missing_map;
+    options.map_count = 1;
+    assert_true(!phuck_off_report(&options, stdout, error, sizeof(error)), "missing map should fail");
+    assert_true(strstr(error, missing_map) != NULL, "missing map error should mention the path");
+
+    unlink(funcs_template);
+    unlink(first_map_template);
+    unlink(second_map_template);
+    unlink(archive_template);
+
+    if (failures) {
+        return 1;
+    }
+
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,186 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define PHUCK_OFF_FUNCS_PATH "/tmp/phuck-off.threads.funcs.txt"
+
+#include "shims.h"
+#include "phuck_off.c"
+
+#define THREAD_COUNT 8
+#define FILE_COUNT 64
+#define FUNCTIONS_PER_FILE 32
+#define FUNCTION_COUNT (FILE_COUNT * FUNCTIONS_PER_FILE)
+#define ROUNDS 200
+
+typedef struct {
+    char path[64];
+    zend_function function;
+    zend_op_array op_array;
+} stress_function;
+
+typedef struct {
+    int index;
+    pthread_barrier_t* barrier;
+} stress_thread;
+
+static int failures = 0;
+// op_arrays are shared by all threads, like they are with opcache
+static stress_function functions[FUNCTION_COUNT];
+
+static void assert_true(int condition, const char* message) {
+    if (!condition) {
+        fprintf(stderr, "%s\n", message);
+        failures = 1;
+    }
+}
+
+static int expected_id(int i) {
+    return i + 1;
+}
+
+static int write_funcs_file(void) {
+    FILE* fp = fopen(PHUCK_OFF_FUNCS_PATH, "w");
+    int i;
+
+    if (!fp) {
+        return 0;
+    }
+
+    for (i = 0; i < FUNCTION_COUNT; i++) {
+        fprintf(fp, "%s:%d\n", functions[i].path, functions[i].op_array.line_start);
+    }
+    fprintf(fp, "### GENERATED FOR ###\n/tmp/phuck-off-threads\n");
+
+    return fclose(fp) == 0;
+}
+
+static void setup_functions(void) {
+    int i;
+
+    memset(functions, 0, sizeof(functions));
+    for (i = 0; i < FUNCTION_COUNT; i++) {
+        snprintf(functions[i].path, sizeof(functions[i].path), "/tmp/phuck-off-threads/src/file_%d.php", i / FUNCTIONS_PER_FILE);
+        functions[i].function.type = ZEND_USER_FUNCTION;
+        functions[i].function.common.function_name = "stress";
+        functions[i].op_array.filename = functions[i].path;
+        functions[i].op_array.line_start = 10 * (i % FUNCTIONS_PER_FILE) + 3;
+    }
+}
+
+static void* run_thread(void* arg) {
+    stress_thread* thread = (stress_thread*) arg;
+    zend_execute_data zdata;
+    int round;
+    int i;
+
+    phuck_off_request_init();
+    pthread_barrier_wait(thread->barrier);
+
+    memset(&zdata, 0, sizeof(zdata));
+    for (round = 0; round < ROUNDS; round++) {
+        // every thread walks the functions from its own starting point, so that they keep
+        // colliding on the same map bytes and op_array caches
+        for (i = 0; i < FUNCTION_COUNT; i++) {
+            stress_function* f = &functions[(i * 7 + thread->index * (FUNCTION_COUNT / THREAD_COUNT) + round) % FUNCTION_COUNT];
+
+            zdata.function_state.function = &f->function;
+            phuck_off_process_stackframe(&zdata, &f->op_array);
+        }
+    }
+
+    phuck_off_post_request();
+    return NULL;
+}
+
+static char* read_log_file(void) {
+    FILE* fp;
+    long length;
+    char* buffer;
+
+    fp = fopen(PHUCK_OFF_LOG_FILE, "rb");
+    if (!fp) {
+        return NULL;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    length = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    buffer = (char*) malloc((size_t) length + 1);
+    if (buffer) {
+        buffer[fread(buffer, 1, (size_t) length, fp)] = '\0';
+    }
+    fclose(fp);
+
+    return buffer;
+}
+
+static void run_stress_case(void) {
+    pthread_t threads[THREAD_COUNT];
+    stress_thread args[THREAD_COUNT];
+    pthread_barrier_t barrier;
+    char* log_content;
+    int i;
+
+    setup_functions();
+    assert_true(write_funcs_file(), "failed to write threads funcs file");
+    unlink(PHUCK_OFF_LOG_FILE);
+
+    setenv(PHUCK_OFF_ENABLED_ENV_VAR, "1", 1);
+    setenv(PHUCK_OFF_LOG_LEVEL_ENV_VAR, "error", 1);
+    // re-resolve some of the cached IDs all the time, from every thread
+    setenv(PHUCK_OFF_SANITY_CHECK_SAMPLING_ENV_VAR, "50", 1);
+    unsetenv(PHUCK_OFF_NO_CLEANUP_ENV_VAR);
+    XG(phuck_off_tracker_offset) = 2;
+
+    phuck_off_init();
+    assert_true(handler.initialized && handler.function_count == FUNCTION_COUNT, "phuck_off_init should load the threads fixture");
+
+    pthread_barrier_init(&barrier, NULL, THREAD_COUNT);
+    for (i = 0; i < THREAD_COUNT; i++) {
+        args[i].index = i;
+        args[i].barrier = &barrier;
+        assert_true(pthread_create(&threads[i], NULL, run_thread, &args[i]) == 0, "failed to start thread");
+    }
+    for (i = 0; i < THREAD_COUNT; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    pthread_barrier_destroy(&barrier);
+
+    assert_true(phuck_off_mmap_bytes != NULL, "threads should share one mmap");
+    if (phuck_off_mmap_bytes != NULL) {
+        for (i = 0; i < FUNCTION_COUNT / 8; i++) {
+            assert_true(phuck_off_mmap_bytes[i] == 0xff, "every function should have its mmap bit set");
+        }
+    }
+    for (i = 0; i < FUNCTION_COUNT; i++) {
+        assert_true((intptr_t) functions[i].op_array.reserved[2] == expected_id(i), "shared op_array cached the wrong ID");
+    }
+
+    phuck_off_shutdown();
+
+    log_content = read_log_file();
+    assert_true(log_content == NULL || log_content[0] == '\0', "threads should not log any errors");
+    if (log_content && log_content[0] != '\0') {
+        fprintf(stderr, "%s", log_content);
+    }
+    free(log_content);
+
+    unlink(PHUCK_OFF_LOG_FILE);
+    unlink(PHUCK_OFF_FUNCS_PATH);
+}
+
+int main(void) {
+    run_stress_case();
+
+    if (failures) {
+        return 1;
+    }
+
+    printf("ok\n");
+    return 0;
+}
@@ -33,9 +33,35 @@ run_script_test() {
 }
 
 run_test "xdebug_hash_resize" "$ROOT/phuck_off_tests/xdebug_hash_resize.c" \
-    "$ROOT/xdebug_hash.c" "$ROOT/xdebug_llist.c"
+    "$ROOT/xdebug_hash.c" "$ROOT/xdebug_llist.c" "$ROOT/xdebug_arena.c"
+run_test "xdebug_hash" "$ROOT/phuck_off_tests/xdebug_hash.c" \
+    "$ROOT/xdebug_hash.c" "$ROOT/xdebug_llist.c" "$ROOT/xdebug_arena.c"
+run_test "xdebug_arena" "$ROOT/phuck_off_tests/xdebug_arena.c" \
+    "$ROOT/xdebug_arena.c" "$ROOT/xdebug_llist.c"
+run_test "xdebug_intern" "$ROOT/phuck_off_tests/xdebug_intern.c" \
+    "$ROOT/xdebug_intern.c" "$ROOT/xdebug_hash.c"
+run_test "xdebug_set" "$ROOT/phuck_off_tests/xdebug_set.c" \
+    "$ROOT/xdebug_set.c"
+run_test "xdebug_str" "$ROOT/phuck_off_tests/xdebug_str.c" \
+    -I"$ROOT/phuck_off_tests/php_shim" "$ROOT/xdebug_str.c"
+run_test "xdebug_clock" "$ROOT/phuck_off_tests/xdebug_clock.c" \
+    "$ROOT/xdebug_clock.c"
+run_test "xdebug_aggr_shm" "$ROOT/phuck_off_tests/xdebug_aggr_shm.c" \
+    "$ROOT/xdebug_aggr_shm.c"
+run_test "xdebug_aggr_shm_collisions" "$ROOT/phuck_off_tests/xdebug_aggr_shm.c" \
+    -DXDEBUG_AGGR_SHM_HASH_MASK=0 "$ROOT/xdebug_aggr_shm.c"
+run_test "xdebug_compress" "$ROOT/phuck_off_tests/xdebug_compress.c" \
+    -DXDEBUG_HAVE_ZLIB "$ROOT/xdebug_compress.c" -lz -lpthread
+run_test "phuck_off_ignore" "$ROOT/phuck_off_tests/phuck_off_ignore.c" \
+    "$ROOT/phuck_off_ignore.c"
+run_test "phuck_off_placement" "$ROOT/phuck_off_tests/phuck_off_placement.c" \
+    "$ROOT/phuck_off_placement.c"
 run_test "phuck_off_parser" "$ROOT/phuck_off_tests/phuck_off_parser.c" \
-    "$ROOT/xdebug_hash.c" "$ROOT/xdebug_llist.c" "$ROOT/phuck_off_parser.c"
+    "$ROOT/xdebug_hash.c" "$ROOT/xdebug_llist.c" "$ROOT/xdebug_arena.c" "$ROOT/phuck_off_parser.c" "$ROOT/phuck_off_placement.c" "$ROOT/phuck_off_ignore.c"
+run_test "phuck_off_report" "$ROOT/phuck_off_tests/phuck_off_report.c" \
+    -DPHUCK_OFF_REPORT_NO_MAIN "$ROOT/phuck_off_report.c" "$ROOT/xdebug_hash.c" "$ROOT/xdebug_llist.c" "$ROOT/xdebug_arena.c" "$ROOT/phuck_off_parser.c" "$ROOT/phuck_off_placement.c" "$ROOT/phuck_off_ignore.c" "$ROOT/phuck_off_archive.c"
+run_test "phuck_off_archive" "$ROOT/phuck_off_tests/phuck_off_archive.c" \
+    "$ROOT/phuck_off_archive.c"
 run_test "phuck_off_logger" "$ROOT/phuck_off_tests/phuck_off_logger.c" \
     -include "$SHIMS_HEADER" "$ROOT/phuck_off_logger.c"
 run_test "phuck_off_sanity_check" "$ROOT/phuck_off_tests/phuck_off_sanity_check.c" \
@@ -43,11 +69,13 @@ run_test "phuck_off_sanity_check" "$ROOT/phuck_off_tests/phuck_off_sanity_check.
 run_test "phuck_off_mmap" "$ROOT/phuck_off_tests/phuck_off_mmap.c" \
     "$ROOT/phuck_off_mmap.c" "$ROOT/phuck_off_logger.c"
 run_test "phuck_off_function_id" "$ROOT/phuck_off_tests/phuck_off_function_id.c" \
-    -include "$SHIMS_HEADER" "$ROOT/xdebug_hash.c" "$ROOT/xdebug_llist.c" "$ROOT/phuck_off_parser.c" "$ROOT/phuck_off_logger.c" "$ROOT/phuck_off_mmap.c" "$ROOT/phuck_off_sanity_check.c"
+    -include "$SHIMS_HEADER" "$ROOT/xdebug_hash.c" "$ROOT/xdebug_llist.c" "$ROOT/xdebug_arena.c" "$ROOT/phuck_off_parser.c" "$ROOT/phuck_off_placement.c" "$ROOT/phuck_off_ignore.c" "$ROOT/phuck_off_logger.c" "$ROOT/phuck_off_mmap.c" "$ROOT/phuck_off_sanity_check.c"
 run_test "phuck_off_process_stackframe" "$ROOT/phuck_off_tests/phuck_off_process_stackframe.c" \
-    -include "$SHIMS_HEADER" "$ROOT/xdebug_hash.c" "$ROOT/xdebug_llist.c" "$ROOT/phuck_off_parser.c" "$ROOT/phuck_off_logger.c" "$ROOT/phuck_off_mmap.c" "$ROOT/phuck_off_sanity_check.c"
+    -include "$SHIMS_HEADER" "$ROOT/xdebug_hash.c" "$ROOT/xdebug_llist.c" "$ROOT/xdebug_arena.c" "$ROOT/phuck_off_parser.c" "$ROOT/phuck_off_placement.c" "$ROOT/phuck_off_ignore.c" "$ROOT/phuck_off_logger.c" "$ROOT/phuck_off_mmap.c" "$ROOT/phuck_off_sanity_check.c"
+run_test "phuck_off_threads" "$ROOT/phuck_off_tests/phuck_off_threads.c" \
+    -DPHUCK_OFF_ZTS -DPHUCK_OFF_LOG_FILE="\"/tmp/phuck-off.threads.log\"" -pthread -include "$SHIMS_HEADER" "$ROOT/xdebug_hash.c" "$ROOT/xdebug_llist.c" "$ROOT/xdebug_arena.c" "$ROOT/phuck_off_parser.c" "$ROOT/phuck_off_placement.c" "$ROOT/phuck_off_ignore.c" "$ROOT/phuck_off_logger.c" "$ROOT/phuck_off_mmap.c" "$ROOT/phuck_off_sanity_check.c"
 run_script_test "phuck_off_process_stackframe_log_lines" "$ROOT/phuck_off_tests/phuck_off_process_stackframe_log_lines.sh"
 run_test "phuck_off_parser_lookup" "$ROOT/phuck_off_tests/phuck_off_parser_lookup.c" \
-    -include "$SHIMS_HEADER" "$ROOT/xdebug_hash.c" "$ROOT/xdebug_llist.c" "$ROOT/phuck_off_parser.c" "$ROOT/phuck_off_logger.c" "$ROOT/phuck_off_mmap.c" "$ROOT/phuck_off_sanity_check.c"
+    -include "$SHIMS_HEADER" "$ROOT/xdebug_hash.c" "$ROOT/xdebug_llist.c" "$ROOT/xdebug_arena.c" "$ROOT/phuck_off_parser.c" "$ROOT/phuck_off_placement.c" "$ROOT/phuck_off_ignore.c" "$ROOT/phuck_off_logger.c" "$ROOT/phuck_off_mmap.c" "$ROOT/phuck_off_sanity_check.c"
 
 echo "all fork tests passed"
@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "xdebug_aggr_shm.h"
+
+// built a second time with XDEBUG_AGGR_SHM_HASH_MASK=0, which gives every
+// function the same hash, to check that slots are told apart by their names
+
+#define CHILD_COUNT 4
+#define FUNCTION_COUNT 50
+#define CALLS_PER_CHILD 1000
+
+typedef struct {
+    int functions;
+    int wrong;
+    uint64_t calls;
+    uint64_t time_own;
+} totals;
+
+static int failures = 0;
+
+static void assert_true(int condition, const char* message) {
+    if (!condition) {
+        fprintf(stderr, "%s\n", message);
+        failures = 1;
+    }
+}
+
+static void function_name(char* buffer, size_t size, int i) {
+    snprintf(buffer, size, "Class_%d::method", i);
+}
+
+static void sum_function(void* ctxt, const char* filename, const char* function, int lineno, uint64_t calls, uint64_t time_own, uint64_t time_inclusive) {
+    totals* t = (totals*) ctxt;
+    char expected[64];
+
+    function_name(expected, sizeof(expected), lineno);
+    if (strcmp(filename, "/srv/app/src/a.php") != 0 || strcmp(function, expected) != 0 || time_inclusive != 2 * time_own) {
+        t->wrong++;
+    }
+    t->functions++;
+    t->calls += calls;
+    t->time_own += time_own;
+}
+
+static void run_child(void) {
+    char name[64];
+    int i;
+
+    // every child adds every function, so they race to claim the same slots
+    for (i = 0; i < CALLS_PER_CHILD; i++) {
+        xdebug_aggr_shm_slot* slot;
+
+        function_name(name, sizeof(name), i % FUNCTION_COUNT);
+        slot = xdebug_aggr_shm_find("/srv/app/src/a.php", name, i % FUNCTION_COUNT);
+        if (!slot) {
+            _exit(1);
+        }
+        xdebug_aggr_shm_add(slot, 10, 20);
+    }
+    _exit(0);
+}
+
+static void run_fork_case(void) {
+    pid_t children[CHILD_COUNT];
+    totals t;
+    int i, status;
+
+    assert_true(xdebug_aggr_shm_init(1000), "failed to create the shared table");
+    assert_true(xdebug_aggr_shm_is_owner(), "the creating process should own the table");
+
+    for (i = 0; i < CHILD_COUNT; i++) {
+        children[i] = fork();
+        if (children[i] == 0) {
+            run_child();
+        }
+    }
+    for (i = 0; i < CHILD_COUNT; i++) {
+        assert_true(waitpid(children[i], &status, 0) == children[i] && WIFEXITED(status) && WEXITSTATUS(status) == 0, "child failed to record its calls");
+    }
+
+    memset(&t, 0, sizeof(t));
+    xdebug_aggr_shm_apply(sum_function, &t);
+    assert_true(t.functions == FUNCTION_COUNT, "every function should have one slot");
+    assert_true(t.wrong == 0, "slots have the wrong names or totals");
+    assert_true(t.calls == CHILD_COUNT * CALLS_PER_CHILD, "calls from the children were lost");
+    assert_true(t.time_own == 10 * CHILD_COUNT * CALLS_PER_CHILD, "time from the children was lost");
+    assert_true(xdebug_aggr_shm_dropped() == 0, "nothing should have been dropped");
+
+    // clearing keeps the slots, but lists nothing until they are used again
+    xdebug_aggr_shm_clear();
+    memset(&t, 0, sizeof(t));
+    xdebug_aggr_shm_apply(sum_function, &t);
+    assert_true(t.functions == 0, "clear should reset the totals");
+
+    xdebug_aggr_shm_shutdown();
+    assert_true(!xdebug_aggr_shm_enabled(), "shutdown should disable the table");
+}
+
+static void run_full_case(void) {
+    char name[64];
+    totals t;
+    xdebug_aggr_shm_slot* slot;
+    xdebug_aggr_shm_slot* overflow = NULL;
+    int i;
+
+    assert_true(xdebug_aggr_shm_init(3), "failed to create the small table");
+    for (i = 0; i < 10; i++) {
+        function_name(name, sizeof(name), i);
+        slot = xdebug_aggr_shm_find("/srv/app/src/a.php", name, i);
+        assert_true(slot != NULL, "functions that don't fit should still get the overflow slot");
+        if (i >= 4) {
+            assert_true(overflow == NULL || slot == overflow, "functions that don't fit should share one slot");
+            overflow = slot;
+        }
+        if (slot) {
+            xdebug_aggr_shm_add(slot, 10, 20);
+            xdebug_aggr_shm_add(slot, 10, 20);
+        }
+    }
+
+    memset(&t, 0, sizeof(t));
+    xdebug_aggr_shm_apply(sum_function, &t);
+    assert_true(t.functions == 4, "the table should round up to 4 slots");
+    assert_true(xdebug_aggr_shm_dropped() == 12, "calls to functions that don't fit should be counted");
+
+    xdebug_aggr_shm_clear();
+    assert_true(xdebug_aggr_shm_dropped() == 0, "clear should reset the dropped calls");
+
+    xdebug_aggr_shm_shutdown();
+}
+
+static void run_names_full_case(void) {
+    char filename[200];
+    totals t;
+    xdebug_aggr_shm_slot* slot;
+
+    // one slot has room for 128 bytes of names
+    assert_true(xdebug_aggr_shm_init(1), "failed to create the one slot table");
+    memset(filename, 'f', sizeof(filename) - 1);
+    filename[sizeof(filename) - 1] = '\0';
+
+    slot = xdebug_aggr_shm_find(filename, "Class_0::method", 0);
+    assert_true(slot != NULL, "a function whose names don't fit should still get a slot");
+    assert_true(xdebug_aggr_shm_find(filename, "Class_0::method", 0) == slot, "the slot should be found again by its line");
+    assert_true(xdebug_aggr_shm_find(filename, "Class_0::method", 1) != slot, "another line should not match the slot");
+    if (slot) {
+        xdebug_aggr_shm_add(slot, 10, 20);
+        xdebug_aggr_shm_add(slot, 10, 20);
+    }
+    assert_true(xdebug_aggr_shm_dropped() == 2, "the calls of a slot whose names don't fit should be counted as dropped");
+
+    memset(&t, 0, sizeof(t));
+    xdebug_aggr_shm_apply(sum_function, &t);
+    assert_true(t.functions == 0, "a slot without names should not be listed");
+
+    xdebug_aggr_shm_shutdown();
+}
+
+int main(void) {
+    run_fork_case();
+    run_full_case();
+    run_names_full_case();
+
+    if (failures) {
+        return 1;
+    }
+
+    printf("ok\n");
+    return 0;
+}
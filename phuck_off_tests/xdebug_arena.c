@@ -0,0 +1,175 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "xdebug_arena.h"
+#include "xdebug_llist.h"
+
+static int failures = 0;
+static int dtor_calls = 0;
+
+static void assert_true(int condition, const char* message) {
+    if (!condition) {
+        fprintf(stderr, "%s\n", message);
+        failures = 1;
+    }
+}
+
+typedef struct {
+    int value;
+    xdebug_llist_element link;
+} embedded_value;
+
+static void count_dtor(void* user, void* ptr) {
+    (void) user;
+    (void) ptr;
+    dtor_calls++;
+}
+
+static void free_embedded_dtor(void* user, void* ptr) {
+    (void) user;
+    dtor_calls++;
+    // the element lives in here, the list must not touch it afterwards
+    free(ptr);
+}
+
+static void run_allocation_case(void) {
+    xdebug_arena arena;
+    void* blocks[4096];
+    void* recycled;
+    void* big;
+    size_t i;
+
+    xdebug_arena_init(&arena);
+
+    // enough to span several chunks
+    for (i = 0; i < 4096; i++) {
+        blocks[i] = xdebug_arena_malloc(&arena, 40);
+        assert_true(blocks[i] != NULL, "arena allocation failed");
+        assert_true(((uintptr_t) blocks[i] % XDEBUG_ARENA_ALIGNMENT) == 0, "arena block is not aligned");
+        memset(blocks[i], (int) (i & 0xff), 40);
+    }
+    for (i = 0; i < 4096; i++) {
+        assert_true(((unsigned char*) blocks[i])[39] == (unsigned char) (i & 0xff), "arena blocks overlap");
+    }
+    assert_true(arena.stats.allocations == 4096, "unexpected allocation count");
+    assert_true(arena.stats.chunk_bytes > XDEBUG_ARENA_CHUNK_SIZE, "arena should have added chunks");
+
+    // sizes in the same class share a free list
+    xdebug_arena_free(&arena, blocks[7], 40);
+    recycled = xdebug_arena_malloc(&arena, 33);
+    assert_true(recycled == blocks[7], "freed block should be recycled for the same size class");
+    assert_true(arena.stats.recycled == 1, "recycled count not updated");
+    assert_true(xdebug_arena_malloc(&arena, 40) != blocks[7], "recycled block handed out twice");
+
+    big = xdebug_arena_malloc(&arena, XDEBUG_ARENA_MAX_CLASS_SIZE + 1);
+    assert_true(big != NULL && arena.stats.oversized == 1, "oversized blocks should go to malloc");
+    xdebug_arena_free(&arena, big, XDEBUG_ARENA_MAX_CLASS_SIZE + 1);
+
+    xdebug_arena_reset(&arena);
+    assert_true(arena.stats.chunk_bytes == XDEBUG_ARENA_CHUNK_SIZE, "reset should keep a single chunk");
+    assert_true(arena.stats.resets == 1, "reset count not updated");
+    assert_true(arena.chunks != NULL && arena.chunks->next == NULL, "reset should keep exactly one chunk");
+    for (i = 0; i < XDEBUG_ARENA_CLASS_COUNT; i++) {
+        assert_true(arena.free_lists[i] == NULL, "reset should empty the free lists");
+    }
+    assert_true(xdebug_arena_malloc(&arena, 16) != NULL, "allocation after reset failed");
+
+    xdebug_arena_destroy(&arena);
+    assert_true(arena.chunks == NULL && arena.stats.chunk_bytes == 0, "destroy should release all chunks");
+}
+
+static void run_llist_case(void) {
+    xdebug_arena arena;
+    xdebug_llist* l;
+    unsigned long recycled_before;
+    int i;
+
+    xdebug_arena_init(&arena);
+    l = xdebug_llist_alloc_in_arena(count_dtor, &arena);
+    assert_true(l != NULL && l->arena == &arena, "arena list allocation failed");
+
+    for (i = 0; i < 100; i++) {
+        xdebug_llist_insert_next(l, XDEBUG_LLIST_TAIL(l), (void*) (intptr_t) i);
+    }
+    xdebug_llist_insert_prev(l, XDEBUG_LLIST_HEAD(l), (void*) (intptr_t) -1);
+    assert_true(XDEBUG_LLIST_COUNT(l) == 101, "unexpected list size");
+    assert_true(XDEBUG_LLIST_VALP(XDEBUG_LLIST_HEAD(l)) == (void*) (intptr_t) -1, "insert_prev went to the wrong place");
+
+    // push/pop like the stack does, elements should be recycled
+    recycled_before = arena.stats.recycled;
+    for (i = 0; i < 1000; i++) {
+        xdebug_llist_insert_next(l, XDEBUG_LLIST_TAIL(l), (void*) (intptr_t) i);
+        xdebug_llist_remove(l, XDEBUG_LLIST_TAIL(l), NULL);
+    }
+    assert_true(arena.stats.recycled - recycled_before >= 999, "stack-like use should recycle list elements");
+    assert_true(dtor_calls == 1000, "remove should call the dtor");
+
+    xdebug_llist_destroy(l, NULL);
+    assert_true(dtor_calls == 1101, "destroy should call the dtor for the remaining elements");
+
+    xdebug_arena_destroy(&arena);
+}
+
+static void run_intrusive_case(void) {
+    xdebug_arena arena;
+    xdebug_llist* l;
+    embedded_value* v;
+    xdebug_llist_element* le;
+    unsigned long allocations_before;
+    int i;
+    int expected;
+
+    xdebug_arena_init(&arena);
+    l = xdebug_llist_alloc_intrusive(free_embedded_dtor, &arena);
+    assert_true(l != NULL && l->intrusive, "intrusive list allocation failed");
+    allocations_before = arena.stats.allocations;
+    dtor_calls = 0;
+
+    for (i = 0; i < 100; i++) {
+        v = malloc(sizeof(embedded_value));
+        v->value = i;
+        xdebug_llist_insert_element_next(l, XDEBUG_LLIST_TAIL(l), &v->link, v);
+    }
+    v = malloc(sizeof(embedded_value));
+    v->value = -1;
+    xdebug_llist_insert_element_prev(l, NULL, &v->link, v);
+
+    assert_true(arena.stats.allocations == allocations_before, "intrusive lists should not allocate elements");
+    assert_true(XDEBUG_LLIST_COUNT(l) == 101, "unexpected intrusive list size");
+    assert_true(XDEBUG_LLIST_HEAD(l) == &v->link, "insert_element_prev went to the wrong place");
+
+    expected = -1;
+    for (le = XDEBUG_LLIST_HEAD(l); le != NULL; le = XDEBUG_LLIST_NEXT(le)) {
+        assert_true(((embedded_value*) XDEBUG_LLIST_VALP(le))->value == expected, "intrusive list is out of order");
+        expected++;
+    }
+
+    // removing from the middle and both ends, the dtor frees the element too
+    xdebug_llist_remove(l, XDEBUG_LLIST_NEXT(XDEBUG_LLIST_HEAD(l)), NULL);
+    xdebug_llist_remove(l, XDEBUG_LLIST_HEAD(l), NULL);
+    xdebug_llist_remove(l, XDEBUG_LLIST_TAIL(l), NULL);
+    assert_true(XDEBUG_LLIST_COUNT(l) == 98, "remove did not update the size");
+    assert_true(((embedded_value*) XDEBUG_LLIST_VALP(XDEBUG_LLIST_HEAD(l)))->value == 1, "wrong head after removal");
+    assert_true(((embedded_value*) XDEBUG_LLIST_VALP(XDEBUG_LLIST_TAIL(l)))->value == 98, "wrong tail after removal");
+    assert_true(XDEBUG_LLIST_PREV(XDEBUG_LLIST_HEAD(l)) == NULL && XDEBUG_LLIST_NEXT(XDEBUG_LLIST_TAIL(l)) == NULL, "ends are not terminated");
+
+    xdebug_llist_destroy(l, NULL);
+    assert_true(dtor_calls == 101, "destroy should call the dtor for every value");
+
+    xdebug_arena_destroy(&arena);
+}
+
+int main(void) {
+    run_allocation_case();
+    run_llist_case();
+    run_intrusive_case();
+
+    if (failures) {
+        return 1;
+    }
+
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "xdebug_clock.h"
+
+static int failures = 0;
+
+static void assert_true(int condition, const char* message) {
+    if (!condition) {
+        fprintf(stderr, "%s\n", message);
+        failures = 1;
+    }
+}
+
+static void sleep_nanos(long nanos) {
+    struct timespec ts;
+
+    ts.tv_sec = nanos / 1000000000L;
+    ts.tv_nsec = nanos % 1000000000L;
+    nanosleep(&ts, NULL);
+}
+
+static void run_source_case(const char* source) {
+    uint64_t previous, now, start, mono_start, elapsed, mono_elapsed;
+    int i, resolved = 0;
+
+    xdebug_clock_init(&xdebug_global_clock, source);
+    assert_true(xdebug_global_clock.source == XDEBUG_CLOCK_MONOTONIC, "the TSC should only be used once calibrated");
+    if (strcmp(source, "monotonic") == 0) {
+        assert_true(!xdebug_global_clock.pending, "monotonic should not use the TSC");
+    }
+
+    // straight after init, calibrating has to wait for the shortest window
+    start = xdebug_clock_monotonic_nanos();
+    xdebug_clock_calibrate(&xdebug_global_clock);
+    assert_true(!xdebug_global_clock.pending, "calibrating should only happen once");
+    if (xdebug_global_clock.source == XDEBUG_CLOCK_TSC) {
+        assert_true(xdebug_clock_monotonic_nanos() - start >= 1000 * 1000, "a calibration straight after init should take about 2ms");
+    }
+
+    // never goes backwards, and resolves well below a microsecond
+    previous = xdebug_get_nanotime();
+    for (i = 0; i < 100000; i++) {
+        now = xdebug_get_nanotime();
+        assert_true(now >= previous, "clock went backwards");
+        if (now > previous && now - previous < XDEBUG_NANOS_IN_MICRO) {
+            resolved = 1;
+        }
+        previous = now;
+    }
+    assert_true(resolved, "clock should resolve less than a microsecond");
+
+    // agrees with the monotonic clock over a longer stretch
+    start = xdebug_get_nanotime();
+    mono_start = xdebug_clock_monotonic_nanos();
+    sleep_nanos(50 * 1000 * 1000);
+    elapsed = xdebug_get_nanotime() - start;
+    mono_elapsed = xdebug_clock_monotonic_nanos() - mono_start;
+
+    assert_true(elapsed >= 50 * 1000 * 1000, "clock ran slow");
+    assert_true(
+        (elapsed > mono_elapsed ? elapsed - mono_elapsed : mono_elapsed - elapsed) < mono_elapsed / 100,
+        "clock should agree with the monotonic clock"
+    );
+    assert_true(XDEBUG_SECONDS_SINCE(start, start + XDEBUG_NANOS_IN_SEC / 4) == 0.25, "seconds conversion is wrong");
+}
+
+// a calibration that comes long after init doesn't wait, and still agrees with the monotonic clock
+static void run_late_calibration_case(void) {
+#ifdef XDEBUG_CLOCK_HAVE_TSC
+    uint64_t start, tsc_now, mono_now;
+
+    xdebug_clock_init(&xdebug_global_clock, "auto");
+    if (!xdebug_global_clock.pending) {
+        return;
+    }
+    sleep_nanos(20 * 1000 * 1000);
+
+    start = xdebug_clock_monotonic_nanos();
+    xdebug_clock_calibrate(&xdebug_global_clock);
+    assert_true(xdebug_clock_monotonic_nanos() - start < 1000 * 1000, "a late calibration should not wait");
+    assert_true(xdebug_global_clock.source == XDEBUG_CLOCK_TSC, "an invariant TSC should be used once calibrated");
+
+    tsc_now = xdebug_get_nanotime();
+    mono_now = xdebug_clock_monotonic_nanos();
+    assert_true(
+        (tsc_now > mono_now ? tsc_now - mono_now : mono_now - tsc_now) < 100 * 1000,
+        "switching to the TSC should not make times jump"
+    );
+#endif
+}
+
+static void run_tsc_scaling_case(void) {
+#ifdef XDEBUG_CLOCK_HAVE_TSC
+    xdebug_clock clock;
+
+    // 3 ticks per nanosecond, and ten days worth of them
+    memset(&clock, 0, sizeof(clock));
+    clock.tsc_start = 1000;
+    clock.nanos_start = 5;
+    clock.mult = (1ULL << 32) / 3;
+
+    assert_true(xdebug_clock_tsc_to_nanos(&clock, 1000) == 5, "TSC start should map to the start");
+    assert_true(xdebug_clock_tsc_to_nanos(&clock, 1000 + 3000) == 5 + 999, "TSC scaling is wrong");
+    assert_true(
+        xdebug_clock_tsc_to_nanos(&clock, 1000 + 3ULL * 864000ULL * XDEBUG_NANOS_IN_SEC) / XDEBUG_NANOS_IN_SEC == 863999,
+        "TSC scaling overflowed"
+    );
+#endif
+}
+
+int main(void) {
+    run_source_case("monotonic");
+    run_source_case("auto");
+    run_late_calibration_case();
+    run_tsc_scaling_case();
+
+    if (failures) {
+        return 1;
+    }
+
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "xdebug_compress.h"
+
+#define LINE_COUNT 200000
+
+static int failures = 0;
+
+static void assert_true(int condition, const char* message) {
+    if (!condition) {
+        fprintf(stderr, "%s\n", message);
+        failures = 1;
+    }
+}
+
+static void run_name_case(void) {
+    size_t suffix_len;
+
+    assert_true(xdebug_compress_method_from_name("") == XDEBUG_COMPRESS_NONE, "an empty setting should mean no compression");
+    assert_true(xdebug_compress_method_from_name("none") == XDEBUG_COMPRESS_NONE, "\"none\" should mean no compression");
+    assert_true(xdebug_compress_method_from_name("gzip") == XDEBUG_COMPRESS_GZIP, "\"gzip\" should select gzip");
+    assert_true(xdebug_compress_method_from_name("zst") == XDEBUG_COMPRESS_ZSTD, "\"zst\" should select zstd");
+    assert_true(xdebug_compress_method_from_name("lz4") == -1, "unknown methods should be rejected");
+
+    assert_true(xdebug_compress_method_from_filename("trace.123.gz", &suffix_len) == XDEBUG_COMPRESS_GZIP && suffix_len == 3, "a .gz name should select gzip");
+    assert_true(xdebug_compress_method_from_filename("cachegrind.out.%p.zst", &suffix_len) == XDEBUG_COMPRESS_ZSTD && suffix_len == 4, "a .zst name should select zstd");
+    assert_true(xdebug_compress_method_from_filename("trace.gzip", &suffix_len) == XDEBUG_COMPRESS_NONE && suffix_len == 0, "other names should not be compressed");
+    assert_true(xdebug_compress_method_from_filename(".gz", &suffix_len) == XDEBUG_COMPRESS_NONE, "a bare suffix is not a name");
+}
+
+// writes lines the way the tracers do, flushing after each one, and reads them back through zlib
+static void run_gzip_case(void) {
+    char path[] = "/tmp/xdebug_compress_XXXXXX";
+    char expected[64], line[64];
+    FILE* file;
+    FILE* stream;
+    gzFile in;
+    int fd, i, same = 1;
+
+    fd = mkstemp(path);
+    assert_true(fd != -1, "mkstemp should work");
+    file = fdopen(fd, "w");
+
+    stream = xdebug_compress_stream(file, XDEBUG_COMPRESS_GZIP);
+    assert_true(stream != NULL, "a gzip stream should be created");
+    if (!stream) {
+        fclose(file);
+        unlink(path);
+        return;
+    }
+    for (i = 0; i < LINE_COUNT; i++) {
+        fprintf(stream, "%10.4F %10d   -> function_%d() /srv/app/a.php:%d\n", i / 1000.0, i * 8, i % 97, i % 400);
+        fflush(stream);
+    }
+    assert_true(fclose(stream) == 0, "closing the stream should finish it");
+
+    in = gzopen(path, "rb");
+    assert_true(in != NULL, "the file should open as gzip");
+    for (i = 0; in && i < LINE_COUNT; i++) {
+        snprintf(expected, sizeof(expected), "%10.4F %10d   -> function_%d() /srv/app/a.php:%d\n", i / 1000.0, i * 8, i % 97, i % 400);
+        if (!gzgets(in, line, sizeof(line)) || strcmp(line, expected) != 0) {
+            same = 0;
+            break;
+        }
+    }
+    assert_true(same, "every line should come back in order");
+    assert_true(in && gzgets(in, line, sizeof(line)) == NULL, "nothing should follow the last line");
+    if (in) {
+        gzclose(in);
+    }
+    unlink(path);
+}
+
+static void run_unsupported_case(void) {
+    FILE* file = tmpfile();
+
+    assert_true(xdebug_compress_stream(file, XDEBUG_COMPRESS_NONE) == NULL, "no compression should not wrap the file");
+    if (!xdebug_compress_supported(XDEBUG_COMPRESS_ZSTD)) {
+        assert_true(xdebug_compress_stream(file, XDEBUG_COMPRESS_ZSTD) == NULL, "a method that is not built in should not wrap the file");
+    }
+    assert_true(fputs("still usable\n", file) >= 0, "the file should be left alone");
+    fclose(file);
+}
+
+static int warnings = 0;
+
+static void count_warning(const char* message) {
+    (void) message;
+    warnings++;
+}
+
+// a forked child's writes are dropped with one warning, and the parent's stream is left intact
+static void run_fork_case(void) {
+    char path[] = "/tmp/xdebug_compress_XXXXXX";
+    char line[64];
+    FILE* file;
+    FILE* stream;
+    gzFile in;
+    pid_t child;
+    int fd, status;
+
+    fd = mkstemp(path);
+    assert_true(fd != -1, "mkstemp should work");
+    file = fdopen(fd, "w");
+    stream = xdebug_compress_stream(file, XDEBUG_COMPRESS_GZIP);
+    if (!stream) {
+        assert_true(0, "a gzip stream should be created");
+        fclose(file);
+        unlink(path);
+        return;
+    }
+    fputs("parent before\n", stream);
+    fflush(stream);
+
+    xdebug_compress_set_warning_handler(count_warning);
+    child = fork();
+    if (child == 0) {
+        fputs("child 1\n", stream);
+        fflush(stream);
+        fputs("child 2\n", stream);
+        fflush(stream);
+        fclose(stream);
+        _exit(warnings == 1 ? 0 : 1);
+    }
+    assert_true(waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0, "the child should be warned once");
+    assert_true(warnings == 0, "the parent should not be warned");
+    xdebug_compress_set_warning_handler(NULL);
+
+    fputs("parent after\n", stream);
+    assert_true(fclose(stream) == 0, "the parent should still finish the stream");
+
+    in = gzopen(path, "rb");
+    assert_true(in != NULL, "the file should open as gzip");
+    if (in) {
+        assert_true(gzgets(in, line, sizeof(line)) && strcmp(line, "parent before\n") == 0, "the parent's first line should be there");
+        assert_true(gzgets(in, line, sizeof(line)) && strcmp(line, "parent after\n") == 0, "the child's lines should not be");
+        assert_true(gzgets(in, line, sizeof(line)) == NULL, "nothing should follow the parent's lines");
+        gzclose(in);
+    }
+    unlink(path);
+}
+
+int main(void) {
+    run_name_case();
+    run_gzip_case();
+    run_unsupported_case();
+    run_fork_case();
+
+    if (failures) {
+        return 1;
+    }
+
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,225 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "xdebug_hash.h"
+
+#define KEY_COUNT 5000
+
+static int failures = 0;
+static int dtor_calls = 0;
+static uint32_t rng_state = 0x2545f491u;
+
+static void count_dtor(void* ptr) {
+    (void) ptr;
+    dtor_calls++;
+}
+
+static void assert_true(int condition, const char* message) {
+    if (!condition) {
+        fprintf(stderr, "%s\n", message);
+        failures = 1;
+    }
+}
+
+static uint32_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+// alternates between inline and heap allocated keys
+static unsigned int make_key(char* buffer, size_t buffer_len, int i) {
+    if (i % 2) {
+        return (unsigned int) snprintf(buffer, buffer_len, "/srv/app/some/rather/long/directory/file_%d.php", i);
+    }
+    return (unsigned int) snprintf(buffer, buffer_len, "k%d", i);
+}
+
+static void count_elements(void* user, xdebug_hash_element* element) {
+    size_t* count = (size_t*) user;
+
+    assert_true(element->key.type != XDEBUG_HASH_SLOT_EMPTY, "apply visited an empty slot");
+    (*count)++;
+}
+
+static void check_key_pointer(void* user, xdebug_hash_element* element) {
+    xdebug_hash* h = (xdebug_hash*) user;
+    void* value = NULL;
+
+    if (element->key.type == XDEBUG_HASH_KEY_IS_STRING) {
+        assert_true(
+            xdebug_hash_find(h, element->key.value.str.val, element->key.value.str.len, &value)
+                && value == element->ptr,
+            "key handed to apply does not find its own element"
+        );
+    }
+}
+
+static void run_random_case(void) {
+    static int present[KEY_COUNT];
+    char key[128];
+    xdebug_hash* h;
+    void* value;
+    size_t expected = 0;
+    size_t counted = 0;
+    int round;
+    int i;
+
+    h = xdebug_hash_alloc(1, count_dtor);
+    assert_true(h != NULL, "hash allocation failed");
+    if (!h) {
+        return;
+    }
+
+    for (round = 0; round < 50000; round++) {
+        unsigned int len;
+
+        i = (int) (next_random() % KEY_COUNT);
+        len = make_key(key, sizeof(key), i);
+
+        if (next_random() % 3 == 0) {
+            assert_true(xdebug_hash_delete(h, key, len) == present[i], "delete result mismatch");
+            expected -= (size_t) present[i];
+            present[i] = 0;
+        } else {
+            assert_true(xdebug_hash_add(h, key, len, (void*) (intptr_t) (i + 1)), "add failed");
+            expected += (size_t) !present[i];
+            present[i] = 1;
+        }
+
+        // numeric keys share the table with string keys
+        if (round % 7 == 0) {
+            xdebug_hash_index_update(h, (unsigned long) i + 1000000u, (void*) (intptr_t) -1);
+            xdebug_hash_index_delete(h, (unsigned long) i + 1000000u);
+        }
+    }
+
+    assert_true(h->size == expected, "size does not match the reference");
+    assert_true((h->slots & (h->slots - 1)) == 0, "slot count should be a power of two");
+    assert_true(h->size * 4 <= (size_t) h->slots * 3, "load factor exceeded");
+
+    for (i = 0; i < KEY_COUNT; i++) {
+        unsigned int len = make_key(key, sizeof(key), i);
+
+        value = NULL;
+        if (present[i]) {
+            assert_true(xdebug_hash_find(h, key, len, &value) && value == (void*) (intptr_t) (i + 1), "present key lookup failed");
+        } else {
+            assert_true(!xdebug_hash_find(h, key, len, &value), "deleted key is still found");
+        }
+    }
+
+    xdebug_hash_apply(h, &counted, count_elements);
+    assert_true(counted == expected, "apply did not visit every element once");
+    xdebug_hash_apply(h, h, check_key_pointer);
+
+    dtor_calls = 0;
+    xdebug_hash_destroy(h);
+    assert_true((size_t) dtor_calls == expected, "destroy should call the dtor for every element");
+}
+
+// lookups, updates and deletes have to work on both tables while growing
+static void run_incremental_growth_case(void) {
+    static int present[KEY_COUNT];
+    char key[128];
+    xdebug_hash* h;
+    void* value;
+    int saw_migration = 0;
+    int i;
+
+    h = xdebug_hash_alloc(4096, NULL);
+    for (i = 0; i < 3072; i++) {
+        xdebug_hash_add(h, key, make_key(key, sizeof(key), i), (void*) (intptr_t) (i + 1));
+        present[i] = 1;
+    }
+    assert_true(h->slots == 4096 && h->old_table == NULL, "filling up to the load factor should not grow");
+
+    xdebug_hash_add(h, key, make_key(key, sizeof(key), i), (void*) (intptr_t) (i + 1));
+    present[i++] = 1;
+    assert_true(h->slots == 8192 && h->old_table != NULL, "crossing the load factor should start growing");
+
+    while (h->old_table) {
+        int j = (int) (next_random() % KEY_COUNT);
+        unsigned int len = make_key(key, sizeof(key), j);
+
+        saw_migration = 1;
+        switch (next_random() % 3) {
+            case 0:
+                assert_true(xdebug_hash_delete(h, key, len) == present[j], "delete while growing mismatch");
+                present[j] = 0;
+                break;
+            case 1:
+                assert_true(xdebug_hash_add(h, key, len, (void*) (intptr_t) (j + 1)), "add while growing failed");
+                present[j] = 1;
+                break;
+            default:
+                value = NULL;
+                assert_true(
+                    xdebug_hash_find(h, key, len, &value) == present[j]
+                        && (!present[j] || value == (void*) (intptr_t) (j + 1)),
+                    "lookup while growing mismatch"
+                );
+                break;
+        }
+    }
+    assert_true(saw_migration, "growing should have been incremental");
+
+    for (i = 0; i < KEY_COUNT; i++) {
+        unsigned int len = make_key(key, sizeof(key), i);
+
+        assert_true(xdebug_hash_find(h, key, len, &value) == present[i], "lookup after growing mismatch");
+    }
+
+    xdebug_hash_destroy(h);
+}
+
+static void collect_sorted(void* user, xdebug_hash_element* element, void* argument) {
+    char* out = (char*) user;
+
+    (void) argument;
+    strcat(out, (char*) element->ptr);
+}
+
+static void run_sorted_apply_case(void) {
+    xdebug_hash* h;
+    char out[16] = "";
+
+    h = xdebug_hash_alloc(2, NULL);
+    xdebug_hash_add(h, "c", 1, "c");
+    xdebug_hash_add(h, "a", 1, "a");
+    xdebug_hash_index_add(h, 7, "d");
+    xdebug_hash_add(h, "b", 1, "b");
+    xdebug_hash_apply_with_argument(h, out, collect_sorted, NULL);
+    assert_true(strcmp(out, "abcd") == 0, "apply_with_argument should visit elements sorted by value");
+    xdebug_hash_destroy(h);
+}
+
+static void run_key_type_case(void) {
+    xdebug_hash* h;
+    void* value = NULL;
+
+    h = xdebug_hash_alloc(4, NULL);
+    xdebug_hash_add(h, "", 0, "empty");
+    xdebug_hash_index_add(h, 0, "zero");
+    assert_true(h->size == 2, "empty string and zero should be distinct keys");
+    assert_true(xdebug_hash_find(h, "", 0, &value) && strcmp((char*) value, "empty") == 0, "empty string lookup failed");
+    assert_true(xdebug_hash_index_find(h, 0, &value) && strcmp((char*) value, "zero") == 0, "zero lookup failed");
+    assert_true(!xdebug_hash_find(h, "abc", 2, &value), "key prefix should not match");
+    xdebug_hash_destroy(h);
+}
+
+int main(void) {
+    run_random_case();
+    run_incremental_growth_case();
+    run_sorted_apply_case();
+    run_key_type_case();
+
+    if (failures) {
+        return 1;
+    }
+
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "xdebug_intern.h"
+
+static int failures = 0;
+
+static void assert_true(int condition, const char* message) {
+    if (!condition) {
+        fprintf(stderr, "%s\n", message);
+        failures = 1;
+    }
+}
+
+static void run_identity_case(void) {
+    xdebug_intern_table table;
+    char buffer[128];
+    char* first;
+    char* again;
+    char* other;
+
+    xdebug_intern_table_init(&table);
+
+    first = xdebug_intern_str(&table, "/srv/app/src/a.php");
+    snprintf(buffer, sizeof(buffer), "/srv/app/src/%s", "a.php");
+    again = xdebug_intern_str(&table, buffer);
+    other = xdebug_intern_str(&table, "/srv/app/src/b.php");
+
+    assert_true(first != NULL && strcmp(first, "/srv/app/src/a.php") == 0, "interned string has the wrong content");
+    assert_true(first == again, "equal strings should intern to the same pointer");
+    assert_true(first != other, "different strings should intern to different pointers");
+    assert_true(XDEBUG_INTERNED_ID(first) == 1 && XDEBUG_INTERNED_ID(other) == 2, "IDs should count up from 1");
+    assert_true(XDEBUG_INTERNED(first)->len == strlen(first), "interned length is wrong");
+    assert_true(xdebug_intern_find_id(&table, 2) == other, "ID lookup returned the wrong string");
+    assert_true(xdebug_intern_find_id(&table, 0) == NULL && xdebug_intern_find_id(&table, 3) == NULL, "unknown IDs should not be found");
+    assert_true(xdebug_intern_str(&table, NULL) == NULL, "NULL should stay NULL");
+
+    // takes ownership of malloc()ed strings
+    strcpy(buffer, "{closure:/srv/app/src/a.php:3-5}");
+    again = xdebug_intern_take(&table, strdup(buffer));
+    assert_true(again != NULL && strcmp(again, buffer) == 0 && XDEBUG_INTERNED_ID(again) == 3, "take interned the wrong string");
+    assert_true(xdebug_intern_take(&table, strdup(buffer)) == again, "take should find existing strings");
+
+    // embedded prefixes and the empty string are distinct entries
+    assert_true(xdebug_intern(&table, "/srv/app", 4)->id != xdebug_intern(&table, "/srv/app", 8)->id, "prefixes should be distinct");
+    assert_true(xdebug_intern_str(&table, "")[0] == '\0', "empty string should intern");
+    assert_true(table.count == 6, "unexpected number of interned strings");
+
+    xdebug_intern_table_reset(&table);
+    assert_true(table.count == 0 && table.strings == NULL && table.by_id == NULL, "reset should empty the table");
+
+    first = xdebug_intern_str(&table, "/srv/app/src/b.php");
+    assert_true(first != NULL && XDEBUG_INTERNED_ID(first) == 1, "IDs should start over after a reset");
+
+    xdebug_intern_table_reset(&table);
+}
+
+static void run_stable_pointer_case(void) {
+    xdebug_intern_table table;
+    char* pointers[5000];
+    char buffer[64];
+    int i;
+
+    xdebug_intern_table_init(&table);
+
+    // grows both the hash and the ID array several times
+    for (i = 0; i < 5000; i++) {
+        snprintf(buffer, sizeof(buffer), "function_%d", i);
+        pointers[i] = xdebug_intern_str(&table, buffer);
+    }
+    for (i = 0; i < 5000; i++) {
+        snprintf(buffer, sizeof(buffer), "function_%d", i);
+        assert_true(xdebug_intern_str(&table, buffer) == pointers[i], "interned pointers should stay stable");
+        assert_true(XDEBUG_INTERNED_ID(pointers[i]) == (unsigned int) i + 1, "interned IDs should stay stable");
+        assert_true(xdebug_intern_find_id(&table, (unsigned int) i + 1) == pointers[i], "ID lookup broke while growing");
+    }
+
+    xdebug_intern_table_reset(&table);
+}
+
+int main(void) {
+    run_identity_case();
+    run_stable_pointer_case();
+
+    if (failures) {
+        return 1;
+    }
+
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "xdebug_set.h"
+
+#define SET_SIZE 1000
+
+static int failures = 0;
+static uint32_t rng_state = 0x9e3779b9u;
+
+static void assert_true(int condition, const char* message) {
+    if (!condition) {
+        fprintf(stderr, "%s\n", message);
+        failures = 1;
+    }
+}
+
+static uint32_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static void fill_randomly(xdebug_set* set, unsigned char* reference, unsigned int size, unsigned int one_in) {
+    unsigned int i;
+
+    for (i = 0; i < size; i++) {
+        reference[i] = next_random() % one_in == 0;
+        if (reference[i]) {
+            xdebug_set_add(set, i);
+        }
+    }
+}
+
+static void check_against(xdebug_set* set, const unsigned char* reference, const char* message) {
+    unsigned int expected_count = 0;
+    unsigned int expected_next;
+    unsigned int i;
+
+    for (i = 0; i < set->size; i++) {
+        assert_true(xdebug_set_in(set, i) == reference[i], message);
+        expected_count += reference[i];
+    }
+    assert_true(xdebug_set_count(set) == expected_count, message);
+
+    // walk backwards, so that every position knows its next member
+    expected_next = set->size;
+    for (i = set->size; i-- > 0;) {
+        if (reference[i]) {
+            expected_next = i;
+        }
+        assert_true(xdebug_set_next(set, i) == expected_next, message);
+    }
+    assert_true(xdebug_set_next(set, set->size) == set->size, "next past the end should return the size");
+}
+
+static void run_random_case(unsigned int one_in) {
+    static unsigned char first_bits[SET_SIZE];
+    static unsigned char second_bits[SET_SIZE];
+    static unsigned char expected[SET_SIZE];
+    xdebug_set* first;
+    xdebug_set* second;
+    xdebug_set* copy;
+    unsigned int i;
+
+    first = xdebug_set_create(SET_SIZE);
+    second = xdebug_set_create(SET_SIZE);
+    fill_randomly(first, first_bits, SET_SIZE, one_in);
+    fill_randomly(second, second_bits, SET_SIZE, one_in);
+    check_against(first, first_bits, "set does not match the reference");
+
+    copy = xdebug_set_create(SET_SIZE);
+    xdebug_set_union(copy, first);
+    xdebug_set_union(copy, second);
+    for (i = 0; i < SET_SIZE; i++) {
+        expected[i] = first_bits[i] | second_bits[i];
+    }
+    check_against(copy, expected, "union does not match the reference");
+
+    xdebug_set_intersect(copy, first);
+    xdebug_set_intersect(copy, second);
+    for (i = 0; i < SET_SIZE; i++) {
+        expected[i] = first_bits[i] & second_bits[i];
+    }
+    check_against(copy, expected, "intersection does not match the reference");
+
+    for (i = 0; i < SET_SIZE; i += 3) {
+        xdebug_set_remove(first, i);
+        first_bits[i] = 0;
+    }
+    check_against(first, first_bits, "remove does not match the reference");
+
+    xdebug_set_free(first);
+    xdebug_set_free(second);
+    xdebug_set_free(copy);
+}
+
+static void run_edge_case(void) {
+    xdebug_set* small;
+    xdebug_set* large;
+    unsigned int i;
+
+    small = xdebug_set_create(0);
+    assert_true(xdebug_set_next(small, 0) == 0 && xdebug_set_count(small) == 0, "empty set should have no members");
+    xdebug_set_free(small);
+
+    // members across word boundaries, and the very last position
+    large = xdebug_set_create(200);
+    for (i = 0; i < 200; i += 63) {
+        xdebug_set_add(large, i);
+    }
+    xdebug_set_add(large, 199);
+    assert_true(xdebug_set_next(large, 1) == 63 && xdebug_set_next(large, 190) == 199, "next skipped a member");
+
+    small = xdebug_set_create(70);
+    xdebug_set_add(small, 5);
+    xdebug_set_union(small, large);
+    assert_true(xdebug_set_in(small, 63) && xdebug_set_in(small, 5) && xdebug_set_next(small, 64) == 70, "union with a larger set went wrong");
+
+    xdebug_set_intersect(large, small);
+    assert_true(xdebug_set_count(large) == 2 && !xdebug_set_in(large, 199), "intersection with a smaller set should clear the rest");
+
+    xdebug_set_free(small);
+    xdebug_set_free(large);
+
+    // branch analysis may add the position right after the last one
+    small = xdebug_set_create(64);
+    xdebug_set_add(small, 63);
+    xdebug_set_add(small, 64);
+    assert_true(xdebug_set_in(small, 64), "the position after the last one should be accepted");
+    assert_true(xdebug_set_count(small) == 1 && xdebug_set_next(small, 0) == 63 && xdebug_set_next(small, 64) == 64, "the position after the last one is not a member");
+    xdebug_set_free(small);
+}
+
+int main(void) {
+    run_random_case(2);
+    run_random_case(40);
+    run_edge_case();
+
+    if (failures) {
+        return 1;
+    }
+
+    printf("ok\n");
+    return 0;
+}
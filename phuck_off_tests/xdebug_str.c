@@ -0,0 +1,108 @@
+#include <limits.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "xdebug_str.h"
+
+static int failures = 0;
+static int php_formatter_calls = 0;
+
+// PHP's formatter, which php_shim/php.h sends xdebug_str.c's vsnprintf() to. Its %G
+// differs from libc's ("1.0E+25" rather than "1E+25"), which the real one takes care of.
+int ap_php_vsnprintf(char* buf, size_t len, const char* format, va_list ap) {
+    php_formatter_calls++;
+    return vsnprintf(buf, len, format, ap);
+}
+
+static void assert_true(int condition, const char* message) {
+    if (!condition) {
+        fprintf(stderr, "%s\n", message);
+        failures = 1;
+    }
+}
+
+static void run_add_fmt_case(void) {
+    xdebug_str str = XDEBUG_STR_INITIALIZER;
+    char expected[4096];
+    char long_arg[3000];
+
+    xdebug_str_add_fmt(&str, "%s=%d", "calls", 42);
+    assert_true(str.l == 8 && strcmp(str.d, "calls=42") == 0, "a short format should fit the first buffer");
+    assert_true(str.a == XDEBUG_STR_PREALLOC, "the first buffer should be preallocated");
+
+    // doesn't fit in what's left, so the first vsnprintf() is cut short and has to be redone
+    memset(long_arg, 'x', sizeof(long_arg) - 1);
+    long_arg[sizeof(long_arg) - 1] = '\0';
+    xdebug_str_add_fmt(&str, " [%s] %lu", long_arg, 7ul);
+    snprintf(expected, sizeof(expected), "calls=42 [%s] 7", long_arg);
+    assert_true(str.l == (long) strlen(expected), "the length should cover the regrown output");
+    assert_true(strcmp(str.d, expected) == 0, "the output should survive the regrow");
+    assert_true(str.a >= str.l + 1 && str.a > XDEBUG_STR_PREALLOC, "the buffer should have grown");
+
+    // exactly filling the buffer still needs room for the NUL
+    xdebug_str_free(&str);
+    str.l = 0;
+    str.a = 0;
+    str.d = NULL;
+    memset(long_arg, 'y', XDEBUG_STR_PREALLOC);
+    long_arg[XDEBUG_STR_PREALLOC] = '\0';
+    xdebug_str_add_fmt(&str, "%s", long_arg);
+    assert_true(str.l == XDEBUG_STR_PREALLOC && str.d[str.l] == '\0', "a buffer-sized output should be terminated");
+    assert_true(strcmp(str.d, long_arg) == 0, "a buffer-sized output should be complete");
+
+    xdebug_str_free(&str);
+}
+
+static void run_add_long_case(void) {
+    xdebug_str str = XDEBUG_STR_INITIALIZER;
+    char expected[128];
+
+    xdebug_str_add_long(&str, 0);
+    xdebug_str_add(&str, " ", 0);
+    xdebug_str_add_long(&str, -1);
+    xdebug_str_add(&str, " ", 0);
+    xdebug_str_add_long(&str, LLONG_MAX);
+    xdebug_str_add(&str, " ", 0);
+    xdebug_str_add_long(&str, LLONG_MIN);
+    xdebug_str_add(&str, " ", 0);
+    xdebug_str_add_ulong(&str, ULLONG_MAX);
+
+    snprintf(expected, sizeof(expected), "0 -1 %lld %lld %llu", LLONG_MAX, LLONG_MIN, ULLONG_MAX);
+    assert_true(strcmp(str.d, expected) == 0, "integers should format like printf(), including LLONG_MIN");
+    assert_true(str.l == (long) strlen(expected), "the length should match the integers");
+
+    xdebug_str_free(&str);
+}
+
+static void run_add_double_case(void) {
+    xdebug_str str = XDEBUG_STR_INITIALIZER;
+    char* formatted;
+
+    // libc's own vsnprintf() would write doubles differently from the rest of PHP
+    php_formatter_calls = 0;
+    xdebug_str_add_double(&str, 0.1, 14);
+    assert_true(php_formatter_calls > 0, "doubles should be formatted by PHP's vsnprintf()");
+    assert_true(strcmp(str.d, "0.1") == 0, "the formatter's output should be added");
+
+    php_formatter_calls = 0;
+    formatted = xdebug_sprintf("%d", 7);
+    assert_true(php_formatter_calls > 0 && strcmp(formatted, "7") == 0, "xdebug_sprintf() should use PHP's vsnprintf() too");
+    free(formatted);
+
+    xdebug_str_free(&str);
+}
+
+int main(void) {
+    run_add_fmt_case();
+    run_add_long_case();
+    run_add_double_case();
+
+    if (failures) {
+        return 1;
+    }
+
+    printf("ok\n");
+    return 0;
+}
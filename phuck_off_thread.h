@@ -0,0 +1,57 @@
+#ifndef __HAVE_PHUCK_OFF_THREAD_H__
+#define __HAVE_PHUCK_OFF_THREAD_H__
+
+// threaded SAPIs need a ZTS build of PHP, where several requests run at the same time in one
+// process. ZTS itself comes from php_config.h, which the standalone phuck_off files never
+// include, so config.m4 passes PHUCK_OFF_ZTS to all of them instead.
+//
+// the rules for the state they share:
+// - the function index is built in MINIT and is read-only afterwards
+// - map bits are only ever set, with an atomic OR
+// - anything that changes on the hot path is per thread
+// - the few locks are only taken in RINIT/RSHUTDOWN, or tried from the hot path
+#if defined(ZTS) && !defined(PHUCK_OFF_ZTS)
+#define PHUCK_OFF_ZTS 1
+#endif
+
+#ifdef PHUCK_OFF_ZTS
+#include <pthread.h>
+
+#define PHUCK_OFF_THREAD_LOCAL __thread
+
+typedef pthread_mutex_t phuck_off_mutex;
+#define PHUCK_OFF_MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
+
+#define phuck_off_mutex_lock(m)    pthread_mutex_lock(m)
+#define phuck_off_mutex_trylock(m) (pthread_mutex_trylock(m) == 0)
+#define phuck_off_mutex_unlock(m)  pthread_mutex_unlock(m)
+
+#define phuck_off_atomic_load(p)     __atomic_load_n((p), __ATOMIC_RELAXED)
+#define phuck_off_atomic_store(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define phuck_off_atomic_or(p, v)    __atomic_fetch_or((p), (v), __ATOMIC_RELAXED)
+
+// for pointers to things built on first use: publish() only succeeds if *p is still 'expected',
+// and otherwise loads the winner into it
+#define phuck_off_atomic_load_acquire(p)        __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define phuck_off_atomic_publish(p, expected, v) \
+    __atomic_compare_exchange_n((p), &(expected), (v), 0, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE)
+#else
+#define PHUCK_OFF_THREAD_LOCAL
+
+typedef int phuck_off_mutex;
+#define PHUCK_OFF_MUTEX_INITIALIZER 0
+
+#define phuck_off_mutex_lock(m)    ((void) (m))
+#define phuck_off_mutex_trylock(m) ((void) (m), 1)
+#define phuck_off_mutex_unlock(m)  ((void) (m))
+
+#define phuck_off_atomic_load(p)     (*(p))
+#define phuck_off_atomic_store(p, v) (*(p) = (v))
+#define phuck_off_atomic_or(p, v)    (*(p) |= (v))
+
+#define phuck_off_atomic_load_acquire(p)        (*(p))
+#define phuck_off_atomic_publish(p, expected, v) \
+    (*(p) == (expected) ? (*(p) = (v), 1) : ((expected) = *(p), 0))
+#endif
+
+#endif
@@ -18,13 +18,14 @@ creator: xdebug %d.%s (PHP %s)
 cmd: %sbug00360.php
 part: 1
 positions: line
+desc: Overhead per call: %s
 
-events: Time
+events: Time_(10ns) Memory_Inclusive Memory_Self Peak
 
 fl=(1) %sbug00360.php
 fn=(1) func
-2 %d
+2 %d %d %d %d
 
 fl=(2) php:internal
 fn=(2) php::xdebug_get_profiler_filename
-8 %d
+8 %d %d %d %d
@@ -18,28 +18,29 @@ creator: xdebug %d.%s (PHP %s)
 cmd: %sbug00631.php
 part: 1
 positions: line
+desc: Overhead per call: %s
 
-events: Time
+events: Time_(10ns) Memory_Inclusive Memory_Self Peak
 
 fl=(1) php:internal
 fn=(1) php::register_shutdown_function
-%d %d
+%d %d %d %d %d
 
 fl=(1)
 fn=(2) php::strrev
-%d %d
+%d %d %d %d %d
 
 fl=(2) %sbug00631.php
 fn=(3) {main}
 
-summary: %d
+summary: %d %d %d %d
 
-%d %d
+%d %d %d %d %d
 cfl=(1)
 cfn=(1)
 calls=1 0 0
-%d %d
+%d %d %d %d %d
 cfl=(1)
 cfn=(2)
 calls=1 0 0
-%d %d
+%d %d %d %d %d
@@ -26,85 +26,86 @@ creator: xdebug %d.%s (PHP %s)
 cmd: %sbug00639.php
 part: 1
 positions: line
+desc: Overhead per call: %s
 
-events: Time
+events: Time_(10ns) Memory_Inclusive Memory_Self Peak
 
 fl=(1) %sbug00639-2.inc
 fn=(1) require::%sbug00639-2.inc
-1 %d
+1 %d %d %d %d
 
 fl=(2) php:internal
 fn=(2) php::strrev
-4 %d
+4 %d %d %d %d
 
 fl=(1)
 fn=(3) func2
-2 %d
+2 %d %d %d %d
 cfl=(2)
 cfn=(2)
 calls=1 0 0
-4 %d
+4 %d %d %d %d
 
 fl=(2)
 fn=(2)
-4 %d
+4 %d %d %d %d
 
 fl=(1)
 fn=(3)
-2 %d
+2 %d %d %d %d
 cfl=(2)
 cfn=(2)
 calls=1 0 0
-4 %d
+4 %d %d %d %d
 
 fl=(3) %sbug00639.php
 fn=(4) func1
-4 %d
+4 %d %d %d %d
 cfl=(1)
 cfn=(3)
 calls=1 0 0
-6 %d
+6 %d %d %d %d
 cfl=(1)
 cfn=(3)
 calls=1 0 0
-7 %d
+7 %d %d %d %d
 
 fl=(2)
 fn=(2)
-4 %d
+4 %d %d %d %d
 
 fl=(1)
 fn=(3)
-2 %d
+2 %d %d %d %d
 cfl=(2)
 cfn=(2)
 calls=1 0 0
-4 %d
+4 %d %d %d %d
 
 fl=(2)
 fn=(2)
-4 %d
+4 %d %d %d %d
 
 fl=(1)
 fn=(3)
-2 %d
+2 %d %d %d %d
 cfl=(2)
 cfn=(2)
 calls=1 0 0
-4 %d
+4 %d %d %d %d
 
 fl=(2)
 fn=(2)
-4 %d
+4 %d %d %d %d
 
 fl=(1)
 fn=(3)
-2 %d
+2 %d %d %d %d
 cfl=(2)
 cfn=(2)
 calls=1 0 0
-4 %d
+4 %d %d %d %d
 
 fl=(2)
 fn=(5) php::xdebug_get_profiler_filename
-15 %d
+15 %d %d %d %d
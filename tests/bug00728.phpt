@@ -28,29 +28,30 @@ creator: xdebug %d.%s (PHP %s)
 cmd: %sbug00728.php
 part: 1
 positions: line
+desc: Overhead per call: %s
 
-events: Time
+events: Time_(10ns) Memory_Inclusive Memory_Self Peak
 
 fl=(1) php:internal
 fn=(1) php::var_dump
-6 %d
+6 %d %d %d %d
 
 fl=(2) %sbug00728.php
 fn=(2) bankaccount->__call
-4 %d
+4 %d %d %d %d
 cfl=(1)
 cfn=(1)
 calls=1 0 0
-6 %d
+6 %d %d %d %d
 
 fl=(2)
 fn=(3) bankaccount->bar
-%r(11|4)%r %d
+%r(11|4)%r %d %d %d %d
 cfl=(2)
 cfn=(2)
 calls=1 0 0
-11 %d
+11 %d %d %d %d
 
 fl=(1)
 fn=(4) php::xdebug_get_profiler_filename
-13 %d
+13 %d %d %d %d
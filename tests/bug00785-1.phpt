@@ -15,149 +15,150 @@ creator: xdebug %d.%s (PHP %s)
 cmd: %sbug00785-1.php
 part: 1
 positions: line
+desc: Overhead per call: %s
 
-events: Time
+events: Time_(10ns) Memory_Inclusive Memory_Self Peak
 
 fl=(1) php:internal
 fn=(1) php::usleep
-5 %d
+5 %d %d %d %d
 
 fl=(2) %sbug00785-1.inc
 fn=(2) {closure:%sbug00785-1.inc:5-5}
-5 %d
+5 %d %d %d %d
 cfl=(1)
 cfn=(1)
 calls=1 0 0
-5 %d
+5 %d %d %d %d
 
 fl=(1)
 fn=(1)
-5 %d
+5 %d %d %d %d
 
 fl=(2)
 fn=(2)
-5 %d
+5 %d %d %d %d
 cfl=(1)
 cfn=(1)
 calls=1 0 0
-5 %d
+5 %d %d %d %d
 
 fl=(1)
 fn=(1)
-5 %d
+5 %d %d %d %d
 
 fl=(2)
 fn=(2)
-5 %d
+5 %d %d %d %d
 cfl=(1)
 cfn=(1)
 calls=1 0 0
-5 %d
+5 %d %d %d %d
 
 fl=(1)
 fn=(1)
-5 %d
+5 %d %d %d %d
 
 fl=(2)
 fn=(2)
-5 %d
+5 %d %d %d %d
 cfl=(1)
 cfn=(1)
 calls=1 0 0
-5 %d
+5 %d %d %d %d
 
 fl=(1)
 fn=(1)
-5 %d
+5 %d %d %d %d
 
 fl=(2)
 fn=(2)
-5 %d
+5 %d %d %d %d
 cfl=(1)
 cfn=(1)
 calls=1 0 0
-5 %d
+5 %d %d %d %d
 
 fl=(1)
 fn=(1)
-5 %d
+5 %d %d %d %d
 
 fl=(2)
 fn=(2)
-5 %d
+5 %d %d %d %d
 cfl=(1)
 cfn=(1)
 calls=1 0 0
-5 %d
+5 %d %d %d %d
 
 fl=(1)
 fn=(3) php::array_walk
-7 %d
+7 %d %d %d %d
 cfl=(2)
 cfn=(2)
 calls=1 0 0
-7 %d
+7 %d %d %d %d
 cfl=(2)
 cfn=(2)
 calls=1 0 0
-7 %d
+7 %d %d %d %d
 cfl=(2)
 cfn=(2)
 calls=1 0 0
-7 %d
+7 %d %d %d %d
 cfl=(2)
 cfn=(2)
 calls=1 0 0
-7 %d
+7 %d %d %d %d
 cfl=(2)
 cfn=(2)
 calls=1 0 0
-7 %d
+7 %d %d %d %d
 cfl=(2)
 cfn=(2)
 calls=1 0 0
-7 %d
+7 %d %d %d %d
 
 fl=(1)
 fn=(1)
-5 %d
+5 %d %d %d %d
 
 fl=(2)
 fn=(2)
-5 %d
+5 %d %d %d %d
 cfl=(1)
 cfn=(1)
 calls=1 0 0
-5 %d
+5 %d %d %d %d
 
 fl=(1)
 fn=(4) php::var_dump
-9 %d
+9 %d %d %d %d
 
 fl=(2)
 fn=(5) foo
-2 %d
+2 %d %d %d %d
 cfl=(1)
 cfn=(3)
 calls=1 0 0
-7 %d
+7 %d %d %d %d
 cfl=(2)
 cfn=(2)
 calls=1 0 0
-9 %d
+9 %d %d %d %d
 cfl=(1)
 cfn=(4)
 calls=1 0 0
-9 %d
+9 %d %d %d %d
 
 fl=(2)
 fn=(6) require_once::%sbug00785-1.inc
-1 %d
+1 %d %d %d %d
 cfl=(2)
 cfn=(5)
 calls=1 0 0
-12 %d
+12 %d %d %d %d
 
 fl=(1)
 fn=(7) php::xdebug_get_profiler_filename
-4 %d
+4 %d %d %d %d
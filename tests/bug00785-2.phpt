@@ -14,213 +14,214 @@ creator: xdebug %d.%s (PHP %s)
 cmd: %sbug00785-2.php
 part: 1
 positions: line
+desc: Overhead per call: %s
 
-events: Time
+events: Time_(10ns) Memory_Inclusive Memory_Self Peak
 
 fl=(1) php:internal
 fn=(1) php::usleep
-10 %d
+10 %d %d %d %d
 
 fl=(2) %sbug00785-2.inc
 fn=(2) nested2
-8 %d
+8 %d %d %d %d
 cfl=(1)
 cfn=(1)
 calls=1 0 0
-10 %d
+10 %d %d %d %d
 
 fl=(1)
 fn=(3) php::call_user_func_array:{%sbug00785-2.inc:24}
-24 %d
+24 %d %d %d %d
 cfl=(2)
 cfn=(2)
 calls=1 0 0
-24 %d
+24 %d %d %d %d
 
 fl=(1)
 fn=(1)
-4 %d
+4 %d %d %d %d
 
 fl=(2)
 fn=(4) nested
-2 %d
+2 %d %d %d %d
 cfl=(1)
 cfn=(1)
 calls=1 0 0
-4 %d
+4 %d %d %d %d
 
 fl=(1)
 fn=(5) php::call_user_func_array:{%sbug00785-2.inc:20}
-20 %d
+20 %d %d %d %d
 cfl=(2)
 cfn=(4)
 calls=1 0 0
-20 %d
+20 %d %d %d %d
 
 fl=(1)
 fn=(1)
-4 %d
+4 %d %d %d %d
 
 fl=(2)
 fn=(4)
-2 %d
+2 %d %d %d %d
 cfl=(1)
 cfn=(1)
 calls=1 0 0
-4 %d
+4 %d %d %d %d
 
 fl=(1)
 fn=(5)
-20 %d
+20 %d %d %d %d
 cfl=(2)
 cfn=(4)
 calls=1 0 0
-20 %d
+20 %d %d %d %d
 
 fl=(1)
 fn=(1)
-4 %d
+4 %d %d %d %d
 
 fl=(2)
 fn=(4)
-2 %d
+2 %d %d %d %d
 cfl=(1)
 cfn=(1)
 calls=1 0 0
-4 %d
+4 %d %d %d %d
 
 fl=(1)
 fn=(5)
-20 %d
+20 %d %d %d %d
 cfl=(2)
 cfn=(4)
 calls=1 0 0
-20 %d
+20 %d %d %d %d
 
 fl=(1)
 fn=(1)
-4 %d
+4 %d %d %d %d
 
 fl=(2)
 fn=(4)
-2 %d
+2 %d %d %d %d
 cfl=(1)
 cfn=(1)
 calls=1 0 0
-4 %d
+4 %d %d %d %d
 
 fl=(1)
 fn=(5)
-20 %d
+20 %d %d %d %d
 cfl=(2)
 cfn=(4)
 calls=1 0 0
-20 %d
+20 %d %d %d %d
 
 fl=(1)
 fn=(1)
-4 %d
+4 %d %d %d %d
 
 fl=(2)
 fn=(4)
-2 %d
+2 %d %d %d %d
 cfl=(1)
 cfn=(1)
 calls=1 0 0
-4 %d
+4 %d %d %d %d
 
 fl=(1)
 fn=(5)
-20 %d
+20 %d %d %d %d
 cfl=(2)
 cfn=(4)
 calls=1 0 0
-20 %d
+20 %d %d %d %d
 
 fl=(1)
 fn=(1)
-4 %d
+4 %d %d %d %d
 
 fl=(2)
 fn=(4)
-2 %d
+2 %d %d %d %d
 cfl=(1)
 cfn=(1)
 calls=1 0 0
-4 %d
+4 %d %d %d %d
 
 fl=(1)
 fn=(5)
-20 %d
+20 %d %d %d %d
 cfl=(2)
 cfn=(4)
 calls=1 0 0
-20 %d
+20 %d %d %d %d
 
 fl=(2)
 fn=(6) foo
-15 %d
+15 %d %d %d %d
 cfl=(1)
 cfn=(5)
 calls=1 0 0
-20 %d
+20 %d %d %d %d
 cfl=(1)
 cfn=(5)
 calls=1 0 0
-20 %d
+20 %d %d %d %d
 cfl=(1)
 cfn=(5)
 calls=1 0 0
-20 %d
+20 %d %d %d %d
 cfl=(1)
 cfn=(5)
 calls=1 0 0
-20 %d
+20 %d %d %d %d
 cfl=(1)
 cfn=(5)
 calls=1 0 0
-20 %d
+20 %d %d %d %d
 cfl=(1)
 cfn=(5)
 calls=1 0 0
-20 %d
+20 %d %d %d %d
 
 fl=(1)
 fn=(1)
-4 %d
+4 %d %d %d %d
 
 fl=(2)
 fn=(4)
-2 %d
+2 %d %d %d %d
 cfl=(1)
 cfn=(1)
 calls=1 0 0
-4 %d
+4 %d %d %d %d
 
 fl=(1)
 fn=(7) php::call_user_func:{%sbug00785-2.inc:26}
-26 %d
+26 %d %d %d %d
 cfl=(2)
 cfn=(4)
 calls=1 0 0
-26 %d
+26 %d %d %d %d
 
 fl=(2)
 fn=(8) require_once::%sbug00785-2.inc
-1 %d
+1 %d %d %d %d
 cfl=(1)
 cfn=(3)
 calls=1 0 0
-24 %d
+24 %d %d %d %d
 cfl=(2)
 cfn=(6)
 calls=1 0 0
-25 %d
+25 %d %d %d %d
 cfl=(1)
 cfn=(7)
 calls=1 0 0
-26 %d
+26 %d %d %d %d
 
 fl=(1)
 fn=(9) php::xdebug_get_profiler_filename
-4 %d
+4 %d %d %d %d
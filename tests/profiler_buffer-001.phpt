@@ -0,0 +1,29 @@
+--TEST--
+Profiler: records are buffered until xdebug_get_profiler_filename() flushes them
+--INI--
+xdebug.profiler_enable=1
+xdebug.profiler_output_dir=/tmp
+xdebug.profiler_output_name=cachegrind.out.buffer-001-%p
+xdebug.profiler_buffer_size=1048576
+--FILE--
+<?php
+function foo() {
+	return 42;
+}
+
+$file = '/tmp/cachegrind.out.buffer-001-' . getmypid();
+foo();
+
+$contents = file_get_contents($file);
+echo strpos($contents, "events: ") !== false ? "header written\n" : "header missing\n";
+echo strpos($contents, " foo\n") !== false ? "foo written\n" : "foo buffered\n";
+
+echo xdebug_get_profiler_filename() === $file ? "same file\n" : "other file\n";
+$contents = file_get_contents($file);
+echo strpos($contents, " foo\n") !== false ? "foo written\n" : "foo buffered\n";
+?>
+--EXPECT--
+header written
+foo buffered
+same file
+foo written
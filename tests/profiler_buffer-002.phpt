@@ -0,0 +1,23 @@
+--TEST--
+Profiler: xdebug.profiler_buffer_size=0 writes every call out straight away
+--INI--
+xdebug.profiler_enable=1
+xdebug.profiler_output_dir=/tmp
+xdebug.profiler_output_name=cachegrind.out.buffer-002-%p
+xdebug.profiler_buffer_size=0
+--FILE--
+<?php
+function foo() {
+	return 42;
+}
+
+$file = '/tmp/cachegrind.out.buffer-002-' . getmypid();
+foo();
+
+$contents = file_get_contents($file);
+echo strpos($contents, " foo\n") !== false ? "foo written\n" : "foo buffered\n";
+echo strpos($contents, "php::getmypid\n") !== false ? "getmypid written\n" : "getmypid buffered\n";
+?>
+--EXPECT--
+foo written
+getmypid written
@@ -0,0 +1,31 @@
+--TEST--
+Profiler: a small xdebug.profiler_buffer_size writes records out once it fills up
+--INI--
+xdebug.profiler_enable=1
+xdebug.profiler_output_dir=/tmp
+xdebug.profiler_output_name=cachegrind.out.buffer-003-%p
+xdebug.profiler_buffer_size=512
+--FILE--
+<?php
+function foo() {
+	return 42;
+}
+
+$file = '/tmp/cachegrind.out.buffer-003-' . getmypid();
+for ($i = 0; $i < 100; $i++) {
+	foo();
+}
+
+/* file_get_contents()'s own record only goes into the buffer once it returns */
+$contents = file_get_contents($file);
+echo strpos($contents, " foo\n") !== false ? "foo written\n" : "foo buffered\n";
+echo strpos($contents, "php::file_get_contents\n") !== false ? "file_get_contents written\n" : "file_get_contents buffered\n";
+
+xdebug_get_profiler_filename();
+$contents = file_get_contents($file);
+echo strpos($contents, "php::file_get_contents\n") !== false ? "file_get_contents written\n" : "file_get_contents buffered\n";
+?>
+--EXPECT--
+foo written
+file_get_contents buffered
+file_get_contents written
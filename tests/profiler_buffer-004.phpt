@@ -0,0 +1,33 @@
+--TEST--
+Profiler: a forked child does not write the parent's buffered records again
+--SKIPIF--
+<?php if (!extension_loaded('pcntl')) echo "skip pcntl required\n"; ?>
+--INI--
+xdebug.profiler_enable=1
+xdebug.profiler_output_dir=/tmp
+xdebug.profiler_output_name=cachegrind.out.buffer-004-%p
+xdebug.profiler_buffer_size=1048576
+--FILE--
+<?php
+function foo() {
+	return 42;
+}
+
+$file = '/tmp/cachegrind.out.buffer-004-' . getmypid();
+foo();
+
+$pid = pcntl_fork();
+if ($pid === 0) {
+	foo();
+	exit(0);
+}
+pcntl_waitpid($pid, $status);
+
+xdebug_get_profiler_filename();
+$contents = file_get_contents($file);
+echo substr_count($contents, " foo\n"), "\n";
+echo substr_count($contents, "summary: "), "\n";
+?>
+--EXPECT--
+1
+0
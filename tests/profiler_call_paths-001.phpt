@@ -0,0 +1,98 @@
+--TEST--
+Profiler: xdebug.profiler_call_paths=1 adds up calls per path, and writes folded stacks
+--INI--
+xdebug.profiler_enable=1
+xdebug.profiler_call_paths=1
+xdebug.profiler_overhead_compensation=0
+xdebug.profiler_output_dir=/tmp
+xdebug.profiler_output_name=cachegrind.out.paths-001-%p
+--FILE--
+<?php
+function leaf() {
+	return 1;
+}
+
+function rec($n) {
+	leaf();
+	return $n > 0 ? rec($n - 1) : 0;
+}
+
+function a() {
+	leaf();
+	leaf();
+}
+
+function b() {
+	leaf();
+}
+
+/* The paths are written out when {main} ends, before shutdown functions run */
+function capture() {
+	$file = xdebug_get_profiler_filename();
+
+	/* "<caller> -> <callee> calls=N" for every call line */
+	$names = array();
+	$calls = array();
+	$fn = $cfn = null;
+	foreach (file($file, FILE_IGNORE_NEW_LINES) as $line) {
+		if (preg_match('/^(c?fn)=\((\d+)\)(?: (.*))?$/', $line, $m)) {
+			if (isset($m[3])) {
+				$names[$m[2]] = $m[3];
+			}
+			if ($m[1] == 'fn') {
+				$fn = $names[$m[2]];
+			} else {
+				$cfn = $names[$m[2]];
+			}
+		} else if (preg_match('/^calls=(\d+) /', $line, $m)) {
+			$calls[] = "$fn -> $cfn calls={$m[1]}";
+		}
+	}
+	sort($calls);
+	echo implode("\n", $calls), "\n\n";
+
+	$paths = array();
+	foreach (file($file . '.folded', FILE_IGNORE_NEW_LINES) as $line) {
+		if (preg_match('/^(.*) (\d+)$/', $line, $m)) {
+			$paths[] = $m[1];
+		} else {
+			echo "bad line: $line\n";
+		}
+	}
+	sort($paths);
+	echo implode("\n", $paths), "\n";
+
+	unlink($file . '.folded');
+}
+
+register_shutdown_function('capture');
+rec(2);
+a();
+a();
+b();
+?>
+--EXPECT--
+a -> leaf calls=4
+b -> leaf calls=1
+rec -> leaf calls=1
+rec -> leaf calls=1
+rec -> leaf calls=1
+rec -> rec calls=1
+rec -> rec calls=1
+{main} -> a calls=2
+{main} -> b calls=1
+{main} -> php::register_shutdown_function calls=1
+{main} -> rec calls=1
+
+{main}
+{main};a
+{main};a;leaf
+{main};b
+{main};b;leaf
+{main};php::register_shutdown_function
+{main};rec
+{main};rec;leaf
+{main};rec;rec
+{main};rec;rec;leaf
+{main};rec;rec;rec
+{main};rec;rec;rec;leaf
@@ -0,0 +1,19 @@
+--TEST--
+Profiler: an unknown xdebug.profiler_mode warns, and instruments calls
+--FILE--
+<?php
+$php = getenv('TEST_PHP_EXECUTABLE') .
+	' -d xdebug.profiler_enable=1 -d xdebug.profiler_mode=bogus' .
+	' -d xdebug.profiler_output_dir=/tmp -d xdebug.profiler_output_name=mode-001.%p' .
+	' -d display_startup_errors=1 -d display_errors=1 -d log_errors=0';
+
+$output = shell_exec($php . ' -r ' . escapeshellarg('echo "file: ", xdebug_get_profiler_filename(), "\n";') . ' 2>&1');
+echo strpos($output, "Unknown xdebug.profiler_mode 'bogus', using 'instrument'") !== false ? "warned\n" : "not warned\n";
+
+preg_match('/^file: (.*)$/m', $output, $match);
+echo preg_match('/mode-001\.\d+$/', $match[1]) ? "cachegrind file\n" : "other file\n";
+unlink($match[1]);
+?>
+--EXPECT--
+warned
+cachegrind file
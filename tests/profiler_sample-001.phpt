@@ -0,0 +1,27 @@
+--TEST--
+Profiler: xdebug.profiler_mode=sample writes folded stacks with sample counts
+--SKIPIF--
+<?php if (substr(PHP_OS, 0, 3) == 'WIN' || PHP_ZTS) echo "skip sampling is not available on Windows or in thread safe builds\n"; ?>
+--FILE--
+<?php
+$php = getenv('TEST_PHP_EXECUTABLE') .
+	' -d xdebug.profiler_enable=1 -d xdebug.profiler_mode=sample -d xdebug.profiler_sample_interval=1000' .
+	' -d xdebug.profiler_output_dir=/tmp -d xdebug.profiler_output_name=sample-001.%p';
+
+$output = explode("\n", trim(shell_exec($php . ' ' . escapeshellarg(dirname(__FILE__) . '/profiler_sample.inc') . ' - 0.2')));
+echo substr($output[0], -7), "\n";
+echo $output[1], "\n";
+
+/* Lines are "outer;...;inner <count>" */
+$samples = 0;
+preg_match_all('/^\{main\};burn(;[^ ;]+)* (\d+)$/m', file_get_contents($output[0]), $matches);
+foreach ($matches[2] as $count) {
+	$samples += $count;
+}
+echo $samples > 0 ? "burn sampled\n" : "burn not sampled\n";
+unlink($output[0]);
+?>
+--EXPECT--
+.folded
+done
+burn sampled
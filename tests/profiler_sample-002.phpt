@@ -0,0 +1,45 @@
+--TEST--
+Profiler: xdebug.profiler_mode=sample leaves the time limit working
+--SKIPIF--
+<?php if (substr(PHP_OS, 0, 3) == 'WIN' || PHP_ZTS) echo "skip sampling is not available on Windows or in thread safe builds\n"; ?>
+--FILE--
+<?php
+$php = getenv('TEST_PHP_EXECUTABLE') .
+	' -d xdebug.profiler_enable=1 -d xdebug.profiler_mode=sample -d xdebug.profiler_sample_interval=1000' .
+	' -d xdebug.profiler_output_dir=/tmp -d xdebug.profiler_output_name=sample-002.%p' .
+	' -d display_errors=1 -d log_errors=0';
+$script = escapeshellarg(dirname(__FILE__) . '/profiler_sample.inc');
+
+function burn_samples($file)
+{
+	$samples = 0;
+	preg_match_all('/^\{main\};burn(;[^ ;]+)* (\d+)$/m', file_get_contents($file), $matches);
+	foreach ($matches[2] as $count) {
+		$samples += $count;
+	}
+	unlink($file);
+	return $samples;
+}
+
+/* The sampler's signals are not taken for the time limit running out */
+$output = explode("\n", trim(shell_exec("$php -d max_execution_time=10 $script - 0.2 2>&1")));
+echo $output[1], "\n";
+echo burn_samples($output[0]) > 0 ? "burn sampled\n" : "burn not sampled\n";
+
+/* set_time_limit() installs the engine's handler again, which has to keep working */
+$output = explode("\n", trim(shell_exec("$php -d max_execution_time=10 $script 10 0.2 2>&1")));
+echo $output[1], "\n";
+echo burn_samples($output[0]) > 0 ? "burn sampled\n" : "burn not sampled\n";
+
+$output = trim(shell_exec("$php $script 1 5 2>&1"));
+list($file) = explode("\n", $output);
+echo strpos($output, 'Maximum execution time of 1 second exceeded') !== false ? "timed out\n" : "not timed out\n";
+echo burn_samples($file) > 0 ? "burn sampled\n" : "burn not sampled\n";
+?>
+--EXPECT--
+done
+burn sampled
+done
+burn sampled
+timed out
+burn sampled
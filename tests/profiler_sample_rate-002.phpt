@@ -0,0 +1,14 @@
+--TEST--
+Profiler: xdebug.profiler_sample_rate=0 profiles no requests
+--INI--
+xdebug.profiler_enable=0
+xdebug.profiler_sample_rate=0
+xdebug.profiler_output_dir=/tmp
+xdebug.profiler_output_name=cachegrind.out.rate-002-%p
+--FILE--
+<?php
+$file = xdebug_get_profiler_filename();
+echo $file !== false ? "profiled\n" : "not profiled\n";
+?>
+--EXPECT--
+not profiled
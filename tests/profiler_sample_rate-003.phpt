@@ -0,0 +1,19 @@
+--TEST--
+Profiler: the longest prefix in xdebug.profiler_sample_rate_uris wins, wherever it is in the list
+--ENV--
+SCRIPT_NAME=/api/v1/users.php
+--GET--
+id=1
+--INI--
+xdebug.profiler_enable=0
+xdebug.profiler_sample_rate=0
+xdebug.profiler_sample_rate_uris=/api/v1/=1,/api/=0,/=0
+xdebug.profiler_output_dir=/tmp
+xdebug.profiler_output_name=cachegrind.out.rate-003-%p
+--FILE--
+<?php
+$file = xdebug_get_profiler_filename();
+echo $file !== false ? "profiled\n" : "not profiled\n";
+?>
+--EXPECT--
+profiled
@@ -0,0 +1,19 @@
+--TEST--
+Profiler: the longest prefix in xdebug.profiler_sample_rate_uris overrides the rate for all other requests
+--ENV--
+SCRIPT_NAME=/api/v1/users.php
+--GET--
+id=1
+--INI--
+xdebug.profiler_enable=0
+xdebug.profiler_sample_rate=1
+xdebug.profiler_sample_rate_uris=/=1, /api/=1, /api/v1/=0, /checkout=1
+xdebug.profiler_output_dir=/tmp
+xdebug.profiler_output_name=cachegrind.out.rate-004-%p
+--FILE--
+<?php
+$file = xdebug_get_profiler_filename();
+echo $file !== false ? "profiled\n" : "not profiled\n";
+?>
+--EXPECT--
+not profiled
@@ -0,0 +1,26 @@
+--TEST--
+Profiler: malformed xdebug.profiler_sample_rate_uris entries are skipped with a warning
+--ENV--
+SCRIPT_NAME=/api/v1/users.php
+--GET--
+id=1
+--INI--
+html_errors=0
+display_errors=1
+xdebug.profiler_enable=0
+xdebug.profiler_sample_rate=0
+xdebug.profiler_sample_rate_uris=/api/v1/users=,/api/v1/=abc,/api/v1=0.5x,/api/=1.5,=1,/api=1
+xdebug.profiler_output_dir=/tmp
+xdebug.profiler_output_name=cachegrind.out.rate-005-%p
+--FILE--
+<?php
+$file = xdebug_get_profiler_filename();
+echo $file !== false ? "profiled\n" : "not profiled\n";
+?>
+--EXPECTF--
+%AWarning: Ignoring malformed entry '/api/v1/users=' in xdebug.profiler_sample_rate_uris in %s
+%AWarning: Ignoring malformed entry '/api/v1/=abc' in xdebug.profiler_sample_rate_uris in %s
+%AWarning: Ignoring malformed entry '/api/v1=0.5x' in xdebug.profiler_sample_rate_uris in %s
+%AWarning: Ignoring malformed entry '/api/=1.5' in xdebug.profiler_sample_rate_uris in %s
+%AWarning: Ignoring malformed entry '=1' in xdebug.profiler_sample_rate_uris in %s
+%Aprofiled
@@ -36,6 +36,7 @@
 #include "xdebug_mm.h"
 #include "xdebug_str.h"
 #include "usefulstuff.h"
+#include "xdebug_compress.h"
 #include "ext/standard/php_lcg.h"
 #include "ext/standard/flock_compat.h"
 #include "main/php_ini.h"
@@ -544,6 +545,70 @@ FILE *xdebug_fopen(char *fname, char *mode, char *extension, char **new_fname)
 }
 #endif
 
+/* Opens a profile or trace file, which is compressed when 'fname' ends in
+ * ".gz" or ".zst", or else when xdebug.output_compression says so. The suffix
+ * is taken off the name, and goes after 'extension' instead. When the
+ * compressor can't be started, the file is written uncompressed, under the
+ * name without the suffix. */
+FILE *xdebug_fopen_output(char *fname, char *mode, char *extension, char **new_fname)
+{
+	size_t      suffix_len;
+	int         method;
+	char       *name, *full_extension, *opened_fname = NULL;
+	FILE       *fh, *stream;
+	struct stat buf;
+	TSRMLS_FETCH();
+
+	name = xdstrdup(fname);
+	method = xdebug_compress_method_from_filename(name, &suffix_len);
+	name[strlen(name) - suffix_len] = '\0';
+	if (method == XDEBUG_COMPRESS_NONE) {
+		method = xdebug_compress_method_from_name(XG(output_compression));
+	}
+	if (method <= XDEBUG_COMPRESS_NONE || !xdebug_compress_supported(method)) {
+		fh = xdebug_fopen(name, mode, extension, new_fname);
+		xdfree(name);
+		return fh;
+	}
+
+	if (extension) {
+		full_extension = xdebug_sprintf("%s.%s", extension, xdebug_compress_extension(method));
+	} else {
+		full_extension = xdstrdup(xdebug_compress_extension(method));
+	}
+	fh = xdebug_fopen(name, mode, full_extension, &opened_fname);
+	xdfree(full_extension);
+	if (!fh) {
+		xdfree(opened_fname);
+		xdfree(name);
+		return NULL;
+	}
+
+	stream = xdebug_compress_stream(fh, method);
+	if (stream) {
+		if (new_fname) {
+			*new_fname = opened_fname;
+		} else {
+			xdfree(opened_fname);
+		}
+		xdfree(name);
+		return stream;
+	}
+
+	/* Only a file that nothing was ever written to is removed, as appending
+	 * may have opened one from an earlier request */
+	php_error(E_WARNING, "Could not compress '%s', writing it uncompressed instead", opened_fname);
+	fclose(fh);
+	if (stat(opened_fname, &buf) == 0 && buf.st_size == 0) {
+		unlink(opened_fname);
+	}
+	xdfree(opened_fname);
+
+	fh = xdebug_fopen(name, mode, extension, new_fname);
+	xdfree(name);
+	return fh;
+}
+
 int xdebug_format_output_filename(char **filename, char *format, char *script_name)
 {
 	xdebug_str fname = XDEBUG_STR_INITIALIZER;
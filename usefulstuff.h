@@ -61,6 +61,7 @@ char* xdebug_get_time(void);
 char *xdebug_path_to_url(const char *fileurl TSRMLS_DC);
 char *xdebug_path_from_url(const char *fileurl TSRMLS_DC);
 FILE *xdebug_fopen(char *fname, char *mode, char *extension, char **new_fname);
+FILE *xdebug_fopen_output(char *fname, char *mode, char *extension, char **new_fname);
 int xdebug_format_output_filename(char **filename, char *format, char *script_name);
 int xdebug_format_file_link(char **filename, const char *error_filename, int error_lineno TSRMLS_DC);
 void xdebug_open_log(TSRMLS_D);
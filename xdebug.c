@@ -51,13 +51,16 @@
 
 #include "php_xdebug.h"
 #include "xdebug_private.h"
+#include "xdebug_aggr_shm.h"
 #include "xdebug_code_coverage.h"
 #include "xdebug_com.h"
+#include "xdebug_compress.h"
 #include "xdebug_llist.h"
 #include "xdebug_mm.h"
 #include "xdebug_monitor.h"
 #include "xdebug_var.h"
 #include "xdebug_profiler.h"
+#include "xdebug_sampler.h"
 #include "xdebug_stack.h"
 #include "xdebug_superglobals.h"
 #include "xdebug_tracing.h"
@@ -107,6 +110,7 @@ static int (*xdebug_orig_header_handler)(sapi_header_struct *h, sapi_header_op_e
 static SIZETorINT (*xdebug_orig_ub_write)(const char *string, SIZETorUINT len TSRMLS_DC);
 
 static int xdebug_trigger_enabled(int setting, char *var_name, char *var_value TSRMLS_DC);
+static int xdebug_request_sampled(double rate, char *uri_rates, const char *setting TSRMLS_DC);
 
 ZEND_BEGIN_ARG_INFO_EX(xdebug_void_args, ZEND_SEND_BY_VAL, ZEND_RETURN_VALUE, 0)
 ZEND_END_ARG_INFO()
@@ -200,6 +204,7 @@ zend_function_entry xdebug_functions[] = {
 	PHP_FE(xdebug_get_profiler_filename, xdebug_void_args)
 	PHP_FE(xdebug_dump_aggr_profiling_data, xdebug_dump_aggr_profiling_data_args)
 	PHP_FE(xdebug_clear_aggr_profiling_data, xdebug_void_args)
+	PHP_FE(xdebug_get_aggr_profiling_data, xdebug_void_args)
 
 	PHP_FE(xdebug_memory_usage,          xdebug_void_args)
 	PHP_FE(xdebug_peak_memory_usage,     xdebug_void_args)
@@ -307,6 +312,21 @@ static PHP_INI_MH(OnUpdateDebugMode)
 	return SUCCESS;
 }
 
+static PHP_INI_MH(OnUpdateProfilerMode)
+{
+	if (!new_value || strcmp(STR_NAME_VAL(new_value), "instrument") == 0) {
+		XG(profiler_mode) = XDEBUG_PROFILER_INSTRUMENT;
+
+	} else if (strcmp(STR_NAME_VAL(new_value), "sample") == 0) {
+		XG(profiler_mode) = XDEBUG_PROFILER_SAMPLE;
+
+	} else {
+		php_error(E_WARNING, "Unknown xdebug.profiler_mode '%s', using 'instrument'", STR_NAME_VAL(new_value));
+		XG(profiler_mode) = XDEBUG_PROFILER_INSTRUMENT;
+	}
+	return SUCCESS;
+}
+
 #ifdef P_tmpdir
 # define XDEBUG_TEMP_DIR P_tmpdir
 #else
@@ -324,9 +344,13 @@ PHP_INI_BEGIN()
 	STD_PHP_INI_ENTRY("xdebug.trace_enable_trigger_value", "",          PHP_INI_SYSTEM|PHP_INI_PERDIR, OnUpdateString,   trace_enable_trigger_value, zend_xdebug_globals, xdebug_globals)
 	STD_PHP_INI_ENTRY("xdebug.trace_output_dir",  XDEBUG_TEMP_DIR,      PHP_INI_ALL,    OnUpdateString, trace_output_dir,  zend_xdebug_globals, xdebug_globals)
 	STD_PHP_INI_ENTRY("xdebug.trace_output_name", "trace.%c",           PHP_INI_ALL,    OnUpdateString, trace_output_name, zend_xdebug_globals, xdebug_globals)
+	STD_PHP_INI_ENTRY("xdebug.trace_sample_rate", "0",                  PHP_INI_SYSTEM|PHP_INI_PERDIR, OnUpdateReal, trace_sample_rate, zend_xdebug_globals, xdebug_globals)
+	STD_PHP_INI_ENTRY("xdebug.trace_sample_rate_uris", "",              PHP_INI_SYSTEM|PHP_INI_PERDIR, OnUpdateString, trace_sample_rate_uris, zend_xdebug_globals, xdebug_globals)
 	STD_PHP_INI_ENTRY("xdebug.trace_format",      "0",                  PHP_INI_ALL,    OnUpdateLong,   trace_format,      zend_xdebug_globals, xdebug_globals)
 	STD_PHP_INI_ENTRY("xdebug.trace_options",     "0",                  PHP_INI_ALL,    OnUpdateLong,   trace_options,     zend_xdebug_globals, xdebug_globals)
 	STD_PHP_INI_BOOLEAN("xdebug.coverage_enable", "1",                  PHP_INI_SYSTEM, OnUpdateBool,   coverage_enable,   zend_xdebug_globals, xdebug_globals)
+	STD_PHP_INI_ENTRY("xdebug.clock_source",      "auto",               PHP_INI_SYSTEM, OnUpdateString, clock_source,      zend_xdebug_globals, xdebug_globals)
+	STD_PHP_INI_ENTRY("xdebug.output_compression", "",                 PHP_INI_ALL,    OnUpdateString, output_compression, zend_xdebug_globals, xdebug_globals)
 	STD_PHP_INI_BOOLEAN("xdebug.collect_includes","1",                  PHP_INI_ALL,    OnUpdateBool,   collect_includes,  zend_xdebug_globals, xdebug_globals)
 	STD_PHP_INI_ENTRY("xdebug.collect_params",  "0",                    PHP_INI_ALL,    OnUpdateLong,   collect_params,    zend_xdebug_globals, xdebug_globals)
 	STD_PHP_INI_BOOLEAN("xdebug.collect_return",  "0",                  PHP_INI_ALL,    OnUpdateBool,   collect_return,    zend_xdebug_globals, xdebug_globals)
@@ -367,6 +391,15 @@ PHP_INI_BEGIN()
 	STD_PHP_INI_ENTRY("xdebug.profiler_enable_trigger_value", "",   PHP_INI_SYSTEM|PHP_INI_PERDIR, OnUpdateString,   profiler_enable_trigger_value, zend_xdebug_globals, xdebug_globals)
 	STD_PHP_INI_BOOLEAN("xdebug.profiler_append",         "0",      PHP_INI_SYSTEM|PHP_INI_PERDIR, OnUpdateBool,   profiler_append,         zend_xdebug_globals, xdebug_globals)
 	STD_PHP_INI_BOOLEAN("xdebug.profiler_aggregate",      "0",      PHP_INI_SYSTEM|PHP_INI_PERDIR, OnUpdateBool,   profiler_aggregate,      zend_xdebug_globals, xdebug_globals)
+	STD_PHP_INI_BOOLEAN("xdebug.profiler_aggregate_shared", "0",    PHP_INI_SYSTEM, OnUpdateBool,   profiler_aggregate_shared, zend_xdebug_globals, xdebug_globals)
+	STD_PHP_INI_ENTRY("xdebug.profiler_aggregate_shared_slots", "16384", PHP_INI_SYSTEM, OnUpdateLong, profiler_aggregate_shared_slots, zend_xdebug_globals, xdebug_globals)
+	STD_PHP_INI_BOOLEAN("xdebug.profiler_call_paths",     "0",      PHP_INI_SYSTEM|PHP_INI_PERDIR, OnUpdateBool,   profiler_call_paths,     zend_xdebug_globals, xdebug_globals)
+	STD_PHP_INI_BOOLEAN("xdebug.profiler_overhead_compensation", "1", PHP_INI_SYSTEM|PHP_INI_PERDIR, OnUpdateBool, profiler_overhead_compensation, zend_xdebug_globals, xdebug_globals)
+	STD_PHP_INI_ENTRY("xdebug.profiler_buffer_size",      "1048576", PHP_INI_SYSTEM|PHP_INI_PERDIR, OnUpdateLong, profiler_buffer_size,    zend_xdebug_globals, xdebug_globals)
+	PHP_INI_ENTRY("xdebug.profiler_mode",                 "instrument", PHP_INI_SYSTEM|PHP_INI_PERDIR, OnUpdateProfilerMode)
+	STD_PHP_INI_ENTRY("xdebug.profiler_sample_interval",  "10000",  PHP_INI_SYSTEM|PHP_INI_PERDIR, OnUpdateLong,   profiler_sample_interval, zend_xdebug_globals, xdebug_globals)
+	STD_PHP_INI_ENTRY("xdebug.profiler_sample_rate",      "0",      PHP_INI_SYSTEM|PHP_INI_PERDIR, OnUpdateReal,   profiler_sample_rate,    zend_xdebug_globals, xdebug_globals)
+	STD_PHP_INI_ENTRY("xdebug.profiler_sample_rate_uris", "",       PHP_INI_SYSTEM|PHP_INI_PERDIR, OnUpdateString, profiler_sample_rate_uris, zend_xdebug_globals, xdebug_globals)
 
 	/* Remote debugger settings */
 	STD_PHP_INI_BOOLEAN("xdebug.remote_enable",   "0",   PHP_INI_SYSTEM|PHP_INI_PERDIR, OnUpdateBool,   remote_enable,     zend_xdebug_globals, xdebug_globals)
@@ -427,8 +460,20 @@ static void php_xdebug_init_globals (zend_xdebug_globals *xg TSRMLS_DC)
 	xg->remote_enabled       = 0;
 	xg->breakpoints_allowed  = 0;
 	xg->profiler_enabled     = 0;
+	xg->sampling_decided     = 0;
+	xg->profiler_calibrated  = 0;
+	xg->profiler_calibrating = 0;
+	xg->profiler_overhead_inner = 0;
+	xg->profiler_overhead_outer = 0;
+	xg->sample_rng_state     = 0;
+	xg->sample_rng_pid       = 0;
 	xg->do_monitor_functions = 0;
 
+	xg->stack_segments       = NULL;
+	xg->stack_segment_count  = 0;
+	xdebug_arena_init(&xg->request_arena);
+	xdebug_intern_table_init(&xg->interned_strings);
+
 	xdebug_llist_init(&xg->server, xdebug_superglobals_dump_dtor);
 	xdebug_llist_init(&xg->get, xdebug_superglobals_dump_dtor);
 	xdebug_llist_init(&xg->post, xdebug_superglobals_dump_dtor);
@@ -708,6 +753,11 @@ static int xdebug_closure_serialize_deny_wrapper(zval *object, unsigned char **b
 	return FAILURE;
 }
 
+static void xdebug_compress_warn(const char *message)
+{
+	php_error(E_WARNING, "%s", message);
+}
+
 PHP_MINIT_FUNCTION(xdebug)
 {
 	zend_extension dummy_ext;
@@ -715,9 +765,24 @@ PHP_MINIT_FUNCTION(xdebug)
 	ZEND_INIT_MODULE_GLOBALS(xdebug, php_xdebug_init_globals, php_xdebug_shutdown_globals);
 	REGISTER_INI_ENTRIES();
 
+	/* Pick the clock for all timings, which the profiler and the tracers
+	 * calibrate when they first need it */
+	xdebug_clock_init(&xdebug_global_clock, XG(clock_source));
+
 	/* initialize aggregate call information hash */
 	zend_hash_init_ex(&XG(aggr_calls), 50, NULL, (dtor_func_t) xdebug_profile_aggr_call_entry_dtor, 1, 0);
 
+	/* The shared aggregate has to exist before the SAPI forks its workers */
+	if (XG(profiler_aggregate) && XG(profiler_aggregate_shared)) {
+		if (!xdebug_aggr_shm_init(XG(profiler_aggregate_shared_slots) > 0 ? XG(profiler_aggregate_shared_slots) : 1)) {
+			php_error(E_WARNING, "Xdebug could not create the shared aggregate profile, profiles are aggregated per process instead");
+		}
+	}
+
+	/* A forked child writing to a compressed trace or profile is told why
+	 * nothing ends up in the file */
+	xdebug_compress_set_warning_handler(xdebug_compress_warn);
+
 	/* Redirect compile and execute functions to our own */
 	old_compile_file = zend_compile_file;
 	zend_compile_file = xdebug_compile_file;
@@ -898,9 +963,11 @@ PHP_MINIT_FUNCTION(xdebug)
 
 PHP_MSHUTDOWN_FUNCTION(xdebug)
 {
-	if (XG(profiler_aggregate)) {
+	/* Every worker shuts down, but the pool's totals are only written once */
+	if (XG(profiler_aggregate) && (!xdebug_aggr_shm_enabled() || xdebug_aggr_shm_is_owner())) {
 		xdebug_profiler_output_aggr_data(NULL TSRMLS_CC);
 	}
+	xdebug_aggr_shm_shutdown();
 
 	/* Reset compile, execute and error callbacks */
 	zend_compile_file = old_compile_file;
@@ -1051,6 +1118,10 @@ PHP_MSHUTDOWN_FUNCTION(xdebug)
 
 	phuck_off_shutdown();
 
+	xdebug_stack_frames_destroy(TSRMLS_C);
+	xdebug_arena_destroy(&XG(request_arena));
+	xdebug_intern_table_reset(&XG(interned_strings));
+
 	return SUCCESS;
 }
 
@@ -1080,15 +1151,8 @@ static void xdebug_stack_element_dtor(void *dummy, void *elem)
 	e->refcount--;
 
 	if (e->refcount == 0) {
-		if (e->function.function) {
-			xdfree(e->function.function);
-		}
-		if (e->function.class) {
-			xdfree(e->function.class);
-		}
-		if (e->filename) {
-			xdfree(e->filename);
-		}
+		/* The function and file names are interned, and live until the end
+		 * of the request */
 
 		if (e->var) {
 			for (i = 0; i < e->varc; i++) {
@@ -1109,11 +1173,11 @@ static void xdebug_stack_element_dtor(void *dummy, void *elem)
 		}
 
 		if (e->profile.call_list) {
-			xdebug_llist_destroy(e->profile.call_list, NULL);
+			xdebug_llist_destroy(e->profile.call_list, e->profile.call_list->arena);
 			e->profile.call_list = NULL;
 		}
 
-		xdfree(e);
+		/* The frame's storage stays in XG(stack_segments) for the next call */
 	}
 }
 
@@ -1251,15 +1315,19 @@ PHP_RINIT_FUNCTION(xdebug)
 	XG(coverage_enable) = 0;
 	XG(do_code_coverage) = 0;
 	XG(code_coverage) = xdebug_hash_alloc(32, xdebug_coverage_file_dtor);
-	XG(stack)         = xdebug_llist_alloc(xdebug_stack_element_dtor);
+	XG(stack)         = xdebug_llist_alloc_intrusive(xdebug_stack_element_dtor, &XG(request_arena));
 	XG(trace_handler) = NULL;
 	XG(trace_context) = NULL;
 	XG(profile_file)  = NULL;
 	XG(profile_filename) = NULL;
-	XG(profile_filename_refs) = xdebug_hash_alloc(128, NULL);
-	XG(profile_functionname_refs) = xdebug_hash_alloc(128, NULL);
-	XG(profile_last_filename_ref) = 0;
-	XG(profile_last_functionname_ref) = 0;
+	XG(profile_buffer).l = 0;
+	XG(profile_buffer).a = 0;
+	XG(profile_buffer).d = NULL;
+	xdebug_profiler_reset_refs(TSRMLS_C);
+	XG(profile_internal_filename) = NULL;
+	XG(profile_paths) = NULL;
+	XG(profile_path_root) = NULL;
+	XG(profile_last_path_id) = 0;
 	XG(prev_memory)   = 0;
 	XG(function_count) = -1;
 	XG(active_symbol_table) = NULL;
@@ -1270,7 +1338,7 @@ PHP_RINIT_FUNCTION(xdebug)
 	XG(collected_errors)  = xdebug_llist_alloc(xdebug_llist_string_dtor);
 	XG(do_monitor_functions) = 0;
 	XG(functions_to_monitor) = NULL;
-	XG(monitored_functions_found) = xdebug_llist_alloc(xdebug_monitored_function_dtor);
+	XG(monitored_functions_found) = xdebug_llist_alloc_intrusive(xdebug_monitored_function_dtor, NULL);
 	XG(dead_code_analysis_tracker_offset) = zend_xdebug_global_offset;
 
 	XG(dead_code_last_start_id) = 1;
@@ -1332,6 +1400,7 @@ PHP_RINIT_FUNCTION(xdebug)
 
 	XG(remote_enabled) = 0;
 	XG(profiler_enabled) = 0;
+	XG(sampling_decided) = 0;
 	XG(breakpoints_allowed) = 1;
 	if (
 		(XG(auto_trace) || xdebug_trigger_enabled(XG(trace_enable_trigger), "XDEBUG_TRACE", XG(trace_enable_trigger_value) TSRMLS_CC))
@@ -1358,7 +1427,7 @@ PHP_RINIT_FUNCTION(xdebug)
 	XG(visited_branches) = xdebug_hash_alloc(2048, NULL);
 
 	/* Initialize start time */
-	XG(start_time) = xdebug_get_utime();
+	XG(start_time) = xdebug_get_nanotime();
 
 	/* Overload var_dump, set_time_limit, and pcntl_exec */
 	xdebug_overloaded_functions_setup(TSRMLS_C);
@@ -1393,10 +1462,23 @@ ZEND_MODULE_POST_ZEND_DEACTIVATE_D(xdebug)
 	xdebug_llist_destroy(XG(stack), NULL);
 	XG(stack) = NULL;
 
+	/* Everything allocated from the arena hangs off the stack, which is gone now */
+	xdebug_arena_reset(&XG(request_arena));
+
+	/* As are the last users of the interned file and function names */
+	xdebug_intern_table_reset(&XG(interned_strings));
+	XG(previous_filename) = "";
+	XG(previous_file) = NULL;
+
 	if (XG(do_trace) && XG(trace_context)) {
 		xdebug_stop_trace(TSRMLS_C);
 	}
 
+	xdebug_profiler_flush(TSRMLS_C);
+	xdebug_str_dtor(XG(profile_buffer));
+	XG(profile_buffer).l = 0;
+	XG(profile_buffer).a = 0;
+	XG(profile_buffer).d = NULL;
 	if (XG(profile_file)) {
 		fclose(XG(profile_file));
 		XG(profile_file) = NULL;
@@ -1407,10 +1489,12 @@ ZEND_MODULE_POST_ZEND_DEACTIVATE_D(xdebug)
 	}
 
 	XG(profiler_enabled) = 0;
-	xdebug_hash_destroy(XG(profile_filename_refs));
-	xdebug_hash_destroy(XG(profile_functionname_refs));
-	XG(profile_filename_refs) = NULL;
-	XG(profile_functionname_refs) = NULL;
+	XG(profile_internal_filename) = NULL;
+	if (XG(profile_paths)) {
+		xdebug_hash_destroy(XG(profile_paths));
+		XG(profile_paths) = NULL;
+	}
+	XG(profile_path_root) = NULL;
 
 	if (XG(ide_key)) {
 		xdfree(XG(ide_key));
@@ -1479,6 +1563,10 @@ ZEND_MODULE_POST_ZEND_DEACTIVATE_D(xdebug)
 
 PHP_RSHUTDOWN_FUNCTION(xdebug)
 {
+	/* The sampled function names belong to the executor, so they have to be
+	 * written out before it shuts down */
+	xdebug_sampler_stop(TSRMLS_C);
+
 	phuck_off_post_request();
 
 	/* Signal that we're no longer in a request */
@@ -1488,6 +1576,14 @@ PHP_RSHUTDOWN_FUNCTION(xdebug)
 }
 
 
+static void xdebug_info_print_ulong_row(const char *name, unsigned long value)
+{
+	char buffer[32];
+
+	snprintf(buffer, sizeof(buffer), "%lu", value);
+	php_info_print_table_row(2, name, buffer);
+}
+
 PHP_MINFO_FUNCTION(xdebug)
 {
 	xdebug_remote_handler_info *ptr = xdebug_handlers_get();
@@ -1496,6 +1592,17 @@ PHP_MINFO_FUNCTION(xdebug)
 	php_info_print_table_header(2, "xdebug support", "enabled");
 	php_info_print_table_row(2, "Version", XDEBUG_VERSION);
 	php_info_print_table_row(2, "IDE Key", XG(ide_key));
+	xdebug_clock_calibrate(&xdebug_global_clock);
+	php_info_print_table_row(2, "Clock source", xdebug_clock_source_name(&xdebug_global_clock));
+	php_info_print_table_end();
+
+	php_info_print_table_start();
+	php_info_print_table_header(2, "Request arena", "Value");
+	xdebug_info_print_ulong_row("Allocations", XG(request_arena).stats.allocations);
+	xdebug_info_print_ulong_row("Recycled from free lists", XG(request_arena).stats.recycled);
+	xdebug_info_print_ulong_row("Passed on to malloc()", XG(request_arena).stats.oversized);
+	xdebug_info_print_ulong_row("Bytes held in chunks", (unsigned long) XG(request_arena).stats.chunk_bytes);
+	xdebug_info_print_ulong_row("Resets", XG(request_arena).stats.resets);
 	php_info_print_table_end();
 
 	if (zend_xdebug_initialised == 0) {
@@ -1564,6 +1671,107 @@ static int xdebug_trigger_enabled(int setting, char *var_name, char *var_value T
 	return 0;
 }
 
+/* A xorshift64* generator, which is plenty for picking requests. It is
+ * seeded again in every process, as workers forked from one parent would
+ * otherwise all pick the same requests. */
+static double xdebug_sample_random(TSRMLS_D)
+{
+	uint64_t x;
+
+	if (XG(sample_rng_state) == 0 || XG(sample_rng_pid) != (long) getpid()) {
+		XG(sample_rng_pid) = (long) getpid();
+		XG(sample_rng_state) = (xdebug_get_nanotime() ^ ((uint64_t) XG(sample_rng_pid) << 32)) | 1;
+	}
+
+	x = XG(sample_rng_state);
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	XG(sample_rng_state) = x;
+
+	/* The top 53 bits, as a number in [0, 1) */
+	return (double) ((x * 0x2545F4914F6CDD1DULL) >> 11) / 9007199254740992.0;
+}
+
+/* Reads the "prefix=rate" entry from 'entry' up to 'end'. Entries without a
+ * prefix, or with a rate that is not a number from 0 to 1, are malformed. */
+static int xdebug_parse_uri_rate(char *entry, char *end, size_t *prefix_len, double *rate)
+{
+	char *eq = memchr(entry, '=', end - entry);
+	char *rate_end;
+
+	if (!eq || eq == entry) {
+		return 0;
+	}
+
+	*rate = zend_strtod(eq + 1, (const char **) &rate_end);
+	if (rate_end == eq + 1 || rate_end > end) {
+		return 0;
+	}
+	while (rate_end < end && *rate_end == ' ') {
+		rate_end++;
+	}
+	if (rate_end != end || !(*rate >= 0 && *rate <= 1)) {
+		return 0;
+	}
+
+	*prefix_len = eq - entry;
+	return 1;
+}
+
+/* Looks the request's URI up in a "prefix=rate,prefix=rate" list, where the
+ * longest matching prefix wins. Returns 'rate' when none match. Malformed
+ * entries are warned about and skipped. */
+static double xdebug_uri_sample_rate(double rate, char *uri_rates, const char *setting TSRMLS_DC)
+{
+	char   *uri = SG(request_info).request_uri;
+	char   *entry, *end;
+	size_t  best_len = 0, prefix_len;
+	double  entry_rate;
+
+	if (!uri || !uri_rates || !*uri_rates) {
+		return rate;
+	}
+
+	for (entry = uri_rates; *entry; entry = *end ? end + 1 : end) {
+		end = strchr(entry, ',');
+		if (!end) {
+			end = entry + strlen(entry);
+		}
+		while (entry < end && *entry == ' ') {
+			entry++;
+		}
+
+		if (!xdebug_parse_uri_rate(entry, end, &prefix_len, &entry_rate)) {
+			php_error(E_WARNING, "Ignoring malformed entry '%.*s' in %s", (int) (end - entry), entry, setting);
+			continue;
+		}
+		if (prefix_len >= best_len && strncmp(uri, entry, prefix_len) == 0) {
+			best_len = prefix_len;
+			rate = entry_rate;
+		}
+	}
+
+	return rate;
+}
+
+/* Whether this request is one of the 'rate' (0 to 1) of all requests that
+ * are picked at random. With a rate of 0 and no URI list, as by default, no
+ * random number is drawn at all. */
+static int xdebug_request_sampled(double rate, char *uri_rates, const char *setting TSRMLS_DC)
+{
+	rate = xdebug_uri_sample_rate(rate, uri_rates, setting TSRMLS_CC);
+
+	if (rate <= 0) {
+		return 0;
+	}
+	if (rate >= 1) {
+		return 1;
+	}
+
+	return xdebug_sample_random(TSRMLS_C) < rate;
+}
+
 static void add_used_variables(function_stack_entry *fse, zend_op_array *op_array)
 {
 	unsigned int i = 0;
@@ -1798,9 +2006,10 @@ void xdebug_execute(zend_op_array *op_array TSRMLS_DC)
 #endif
 	function_stack_entry *fse, *xfse;
 	char                 *magic_cookie = NULL;
+	int                   profile_sampled = 0;
 	int                   do_return = (XG(do_trace) && XG(trace_context));
 	int                   function_nr = 0;
-	xdebug_llist_element *le;
+	size_t                k;
 #if PHP_VERSION_ID < 70000
 	int                   clear = 0;
 	zval                 *return_val = NULL;
@@ -1825,6 +2034,11 @@ void xdebug_execute(zend_op_array *op_array TSRMLS_DC)
 		return;
 	}
 
+	/* Make room in the sampling profiler's buffers before they fill up */
+	if (xdebug_sampler_fold_needed) {
+		xdebug_sampler_fold(TSRMLS_C);
+	}
+
 	/* If we're evaluating for the debugger's eval capability, just bail out */
 	if (op_array && op_array->filename && strcmp("xdebug://debug-eval", STR_NAME_VAL(op_array->filename)) == 0) {
 #if PHP_VERSION_ID < 50500
@@ -1955,12 +2169,28 @@ void xdebug_execute(zend_op_array *op_array TSRMLS_DC)
 			magic_cookie = NULL;
 		}
 
+		/* Pick requests for xdebug.profiler_sample_rate and
+		 * xdebug.trace_sample_rate, once per request */
+		if (!XG(sampling_decided)) {
+			XG(sampling_decided) = 1;
+			profile_sampled = xdebug_request_sampled(XG(profiler_sample_rate), XG(profiler_sample_rate_uris), "xdebug.profiler_sample_rate_uris" TSRMLS_CC);
+
+			if (
+				!XG(do_trace) && XG(trace_output_dir) && strlen(XG(trace_output_dir)) &&
+				xdebug_request_sampled(XG(trace_sample_rate), XG(trace_sample_rate_uris), "xdebug.trace_sample_rate_uris" TSRMLS_CC)
+			) {
+				xdfree(xdebug_start_trace(NULL, XG(trace_options) TSRMLS_CC));
+			}
+		}
+
 		/* Check for special GET/POST parameter to start profiling */
 		if (
-			!XG(profiler_enabled) &&
-			(XG(profiler_enable) || xdebug_trigger_enabled(XG(profiler_enable_trigger), "XDEBUG_PROFILE", XG(profiler_enable_trigger_value) TSRMLS_CC))
+			!XG(profiler_enabled) && !xdebug_sampler_active() &&
+			(XG(profiler_enable) || profile_sampled || xdebug_trigger_enabled(XG(profiler_enable_trigger), "XDEBUG_PROFILE", XG(profiler_enable_trigger_value) TSRMLS_CC))
 		) {
-			if (xdebug_profiler_init((char*) STR_NAME_VAL(op_array->filename) TSRMLS_CC) == SUCCESS) {
+			if (XG(profiler_mode) == XDEBUG_PROFILER_SAMPLE) {
+				xdebug_sampler_start((char*) STR_NAME_VAL(op_array->filename) TSRMLS_CC);
+			} else if (xdebug_profiler_init((char*) STR_NAME_VAL(op_array->filename) TSRMLS_CC) == SUCCESS) {
 				XG(profiler_enabled) = 1;
 			}
 		}
@@ -2014,8 +2244,8 @@ void xdebug_execute(zend_op_array *op_array TSRMLS_DC)
 		 * show up correctly where they should be.  We always call
 		 * add_used_variables on the current stack level, otherwise vars in include
 		 * files do not show up in the locals list.  */
-		for (le = XDEBUG_LLIST_TAIL(XG(stack)); le != NULL; le = XDEBUG_LLIST_PREV(le)) {
-			xfse = XDEBUG_LLIST_VALP(le);
+		for (k = XG(stack)->size; k > 0; k--) {
+			xfse = XDEBUG_STACK_FRAME_AT(k - 1);
 			add_used_variables(xfse, op_array);
 			if (XDEBUG_IS_FUNCTION(xfse->function.type)) {
 				break;
@@ -2181,6 +2411,10 @@ void xdebug_execute_internal(zend_execute_data *current_execute_data, int return
 	int                   restore_error_handler_situation = 0;
 	void                (*tmp_error_cb)(int type, const char *error_filename, const uint error_lineno, const char *format, va_list args) = NULL;
 
+	if (xdebug_sampler_fold_needed) {
+		xdebug_sampler_fold(TSRMLS_C);
+	}
+
 	XG(level)++;
 	if ((signed long) XG(level) > XG(max_nesting_level) && (XG(max_nesting_level) != -1)) {
 		php_error(E_ERROR, "Maximum function nesting level of '%ld' reached, aborting!", XG(max_nesting_level));
@@ -2366,6 +2600,7 @@ PHP_FUNCTION(xdebug_set_time_limit)
 {
 	if (!XG(remote_enabled)) {
 		XG(orig_set_time_limit_func)(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+		xdebug_sampler_reinstall_handler();
 	}
 }
 /* }}} */
@@ -2378,6 +2613,7 @@ PHP_FUNCTION(xdebug_pcntl_exec)
 	if (XG(profiler_enabled)) {
 		xdebug_profiler_deinit(TSRMLS_C);
 	}
+	xdebug_sampler_stop(TSRMLS_C);
 
 	XG(orig_pcntl_exec_func)(INTERNAL_FUNCTION_PARAM_PASSTHRU);
 }
@@ -2675,6 +2911,9 @@ PHP_FUNCTION(xdebug_get_headers)
 
 PHP_FUNCTION(xdebug_get_profiler_filename)
 {
+	/* Whoever asks is likely to read the file */
+	xdebug_profiler_flush(TSRMLS_C);
+
 	if (XG(profile_filename)) {
 #if PHP_VERSION_ID >= 70000
 		RETURN_STRING(XG(profile_filename));
@@ -2713,10 +2952,42 @@ PHP_FUNCTION(xdebug_clear_aggr_profiling_data)
 	}
 
 	zend_hash_clean(&XG(aggr_calls));
+	xdebug_aggr_shm_clear();
 
 	RETURN_TRUE;
 }
 
+static void xdebug_add_aggr_shm_entry(void *ctxt, const char *filename, const char *function, int lineno, uint64_t calls, uint64_t time_own, uint64_t time_inclusive)
+{
+	zval *list = (zval *) ctxt;
+	zval *entry;
+
+	XDEBUG_MAKE_STD_ZVAL(entry);
+	array_init(entry);
+
+	add_assoc_string_ex(entry, "filename", HASH_KEY_SIZEOF("filename"), (char *) filename ADD_STRING_COPY);
+	add_assoc_string_ex(entry, "function", HASH_KEY_SIZEOF("function"), (char *) function ADD_STRING_COPY);
+	add_assoc_long(entry, "lineno", lineno);
+	add_assoc_long(entry, "calls", (long) calls);
+	add_assoc_double(entry, "time_own", XDEBUG_SECONDS_SINCE(0, time_own));
+	add_assoc_double(entry, "time_inclusive", XDEBUG_SECONDS_SINCE(0, time_inclusive));
+
+	add_next_index_zval(list, entry);
+#if PHP_VERSION_ID >= 70000
+	efree(entry);
+#endif
+}
+
+PHP_FUNCTION(xdebug_get_aggr_profiling_data)
+{
+	if (!xdebug_aggr_shm_enabled()) {
+		RETURN_FALSE;
+	}
+
+	array_init(return_value);
+	xdebug_aggr_shm_apply(xdebug_add_aggr_shm_entry, return_value);
+}
+
 PHP_FUNCTION(xdebug_memory_usage)
 {
 	RETURN_LONG(zend_memory_usage(0 TSRMLS_CC));
@@ -2729,7 +3000,7 @@ PHP_FUNCTION(xdebug_peak_memory_usage)
 
 PHP_FUNCTION(xdebug_time_index)
 {
-	RETURN_DOUBLE(xdebug_get_utime() - XG(start_time));
+	RETURN_DOUBLE(XDEBUG_SECONDS_SINCE(XG(start_time), xdebug_get_nanotime()));
 }
 
 #if PHP_VERSION_ID >= 70100
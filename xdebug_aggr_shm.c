@@ -0,0 +1,363 @@
+/*
+   +----------------------------------------------------------------------+
+   | Xdebug                                                               |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2002-2016 Derick Rethans                               |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 1.0 of the Xdebug license,    |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available at through the world-wide-web at                           |
+   | http://xdebug.derickrethans.nl/license.php                           |
+   | If you did not receive a copy of the Xdebug license and are unable   |
+   | to obtain it through the world-wide-web, please send a note to       |
+   | xdebug@derickrethans.nl so we can mail you a copy immediately.       |
+   +----------------------------------------------------------------------+
+ */
+
+#include <string.h>
+
+#include "xdebug_aggr_shm.h"
+
+#ifdef XDEBUG_AGGR_SHM_SUPPORTED
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#ifndef MAP_ANONYMOUS
+# define MAP_ANONYMOUS MAP_ANON
+#endif
+
+/* Average room for the names of one function */
+#define XDEBUG_AGGR_SHM_NAME_BYTES 128
+
+/* A lookup gives up after this many occupied slots */
+#define XDEBUG_AGGR_SHM_MAX_PROBES 64
+
+/* Keeps name offsets within 32 bits */
+#define XDEBUG_AGGR_SHM_MAX_SLOTS (1UL << 24)
+
+/* The name offset of a slot whose names did not fit */
+#define XDEBUG_AGGR_SHM_NO_NAMES UINT32_MAX
+
+/* How often a lookup yields to the process that is still writing a slot's
+ * names, before it treats the slot as somebody else's */
+#define XDEBUG_AGGR_SHM_MAX_WAITS 1000
+
+/* Tests narrow the hash to make functions collide */
+#ifndef XDEBUG_AGGR_SHM_HASH_MASK
+# define XDEBUG_AGGR_SHM_HASH_MASK (~(uint64_t) 0)
+#endif
+
+typedef struct _xdebug_aggr_shm_header {
+	uint64_t slot_count;
+	uint64_t names_size;
+	uint64_t names_used; /* starts at 1, as offset 0 means "not written yet" */
+
+	/* Counts the calls to every function that didn't get a slot of its own */
+	xdebug_aggr_shm_slot overflow;
+} xdebug_aggr_shm_header;
+
+/* The mapping is: the header, the slots, and then the names */
+static xdebug_aggr_shm_header *aggr_shm = NULL;
+static size_t                  aggr_shm_size = 0;
+static pid_t                   aggr_shm_owner = 0;
+
+#define AGGR_SHM_SLOTS() ((xdebug_aggr_shm_slot *) (aggr_shm + 1))
+#define AGGR_SHM_NAMES() ((char *) (AGGR_SHM_SLOTS() + aggr_shm->slot_count))
+
+int xdebug_aggr_shm_init(unsigned long slots)
+{
+	uint64_t count = 1;
+	void    *mapping;
+
+	if (aggr_shm) {
+		return 1;
+	}
+
+	if (slots > XDEBUG_AGGR_SHM_MAX_SLOTS) {
+		slots = XDEBUG_AGGR_SHM_MAX_SLOTS;
+	}
+	while (count < slots) {
+		count <<= 1;
+	}
+
+	aggr_shm_size = sizeof(xdebug_aggr_shm_header) +
+		count * sizeof(xdebug_aggr_shm_slot) +
+		count * XDEBUG_AGGR_SHM_NAME_BYTES;
+
+	/* Anonymous mappings start out zeroed, which is an empty table */
+	mapping = mmap(NULL, aggr_shm_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (mapping == MAP_FAILED) {
+		aggr_shm_size = 0;
+		return 0;
+	}
+
+	aggr_shm = mapping;
+	aggr_shm->slot_count = count;
+	aggr_shm->names_size = count * XDEBUG_AGGR_SHM_NAME_BYTES;
+	aggr_shm->names_used = 1;
+	aggr_shm_owner = getpid();
+
+	return 1;
+}
+
+void xdebug_aggr_shm_shutdown(void)
+{
+	if (!aggr_shm) {
+		return;
+	}
+
+	munmap(aggr_shm, aggr_shm_size);
+	aggr_shm = NULL;
+	aggr_shm_size = 0;
+	aggr_shm_owner = 0;
+}
+
+int xdebug_aggr_shm_enabled(void)
+{
+	return aggr_shm != NULL;
+}
+
+int xdebug_aggr_shm_is_owner(void)
+{
+	return aggr_shm != NULL && aggr_shm_owner == getpid();
+}
+
+/* FNV-1a over both names and the line */
+static uint64_t xdebug_aggr_shm_hash(const char *filename, const char *function, int lineno)
+{
+	uint64_t    hash = 14695981039346656037ULL;
+	const char *p;
+	int         i;
+
+	for (p = filename; *p; p++) {
+		hash = (hash ^ (unsigned char) *p) * 1099511628211ULL;
+	}
+	hash *= 1099511628211ULL;
+	for (p = function; *p; p++) {
+		hash = (hash ^ (unsigned char) *p) * 1099511628211ULL;
+	}
+	hash *= 1099511628211ULL;
+	for (i = 0; i < 4; i++) {
+		hash = (hash ^ ((unsigned int) lineno >> (i * 8) & 0xff)) * 1099511628211ULL;
+	}
+
+	hash &= XDEBUG_AGGR_SHM_HASH_MASK;
+	return hash ? hash : 1;
+}
+
+/* Only called by the process that claimed the slot. When the names area is
+ * full, the slot keeps counting but is never listed, so its calls count as
+ * dropped. */
+static void xdebug_aggr_shm_store_names(xdebug_aggr_shm_slot *slot, const char *filename, const char *function)
+{
+	size_t   filename_len = strlen(filename) + 1;
+	size_t   function_len = strlen(function) + 1;
+	uint64_t offset;
+	char    *names;
+
+	offset = __atomic_fetch_add(&aggr_shm->names_used, filename_len + function_len, __ATOMIC_RELAXED);
+	if (offset + filename_len + function_len > aggr_shm->names_size) {
+		__atomic_store_n(&slot->name_offset, XDEBUG_AGGR_SHM_NO_NAMES, __ATOMIC_RELEASE);
+		return;
+	}
+
+	names = AGGR_SHM_NAMES() + offset;
+	memcpy(names, filename, filename_len);
+	memcpy(names + filename_len, function, function_len);
+
+	__atomic_store_n(&slot->name_offset, (uint32_t) offset, __ATOMIC_RELEASE);
+}
+
+/* Whether a slot with the same hash is really for this function. The names
+ * are written just after the slot is claimed, so they may still have to be
+ * waited for. A slot whose names did not fit can only be told apart by its
+ * line. */
+static int xdebug_aggr_shm_slot_matches(xdebug_aggr_shm_slot *slot, const char *filename, const char *function, int lineno)
+{
+	uint32_t    offset;
+	const char *names;
+	int         waits = 0;
+
+	while ((offset = __atomic_load_n(&slot->name_offset, __ATOMIC_ACQUIRE)) == 0) {
+		/* Rather than hang on a process that died halfway */
+		if (++waits > XDEBUG_AGGR_SHM_MAX_WAITS) {
+			return 0;
+		}
+		sched_yield();
+	}
+
+	if (slot->lineno != (uint32_t) lineno) {
+		return 0;
+	}
+	if (offset == XDEBUG_AGGR_SHM_NO_NAMES) {
+		return 1;
+	}
+
+	names = AGGR_SHM_NAMES() + offset;
+	return strcmp(names, filename) == 0 && strcmp(names + strlen(names) + 1, function) == 0;
+}
+
+xdebug_aggr_shm_slot *xdebug_aggr_shm_find(const char *filename, const char *function, int lineno)
+{
+	xdebug_aggr_shm_slot *slots;
+	uint64_t              hash, mask, i, current;
+	int                   probe;
+
+	if (!aggr_shm) {
+		return NULL;
+	}
+
+	slots = AGGR_SHM_SLOTS();
+	hash = xdebug_aggr_shm_hash(filename, function, lineno);
+	mask = aggr_shm->slot_count - 1;
+
+	for (i = hash & mask, probe = 0; probe < XDEBUG_AGGR_SHM_MAX_PROBES && (uint64_t) probe <= mask; i = (i + 1) & mask, probe++) {
+		current = __atomic_load_n(&slots[i].hash, __ATOMIC_ACQUIRE);
+		if (current == hash && xdebug_aggr_shm_slot_matches(&slots[i], filename, function, lineno)) {
+			return &slots[i];
+		}
+		if (current != 0) {
+			continue;
+		}
+
+		if (__atomic_compare_exchange_n(&slots[i].hash, &current, hash, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+			slots[i].lineno = (uint32_t) lineno;
+			xdebug_aggr_shm_store_names(&slots[i], filename, function);
+			return &slots[i];
+		}
+		/* Somebody else just claimed it, possibly for the same function */
+		if (current == hash && xdebug_aggr_shm_slot_matches(&slots[i], filename, function, lineno)) {
+			return &slots[i];
+		}
+	}
+
+	return &aggr_shm->overflow;
+}
+
+void xdebug_aggr_shm_add(xdebug_aggr_shm_slot *slot, uint64_t time_own, uint64_t time_inclusive)
+{
+	__atomic_fetch_add(&slot->calls, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&slot->time_own, time_own, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&slot->time_inclusive, time_inclusive, __ATOMIC_RELAXED);
+}
+
+/* The totals are read one by one while others keep adding to them, so they
+ * can be a call apart from each other */
+void xdebug_aggr_shm_apply(xdebug_aggr_shm_apply_func cb, void *ctxt)
+{
+	xdebug_aggr_shm_slot *slots;
+	uint64_t              i;
+	uint32_t              offset;
+	uint64_t              calls;
+	const char           *filename;
+
+	if (!aggr_shm) {
+		return;
+	}
+
+	slots = AGGR_SHM_SLOTS();
+	for (i = 0; i < aggr_shm->slot_count; i++) {
+		offset = __atomic_load_n(&slots[i].name_offset, __ATOMIC_ACQUIRE);
+		calls = __atomic_load_n(&slots[i].calls, __ATOMIC_RELAXED);
+		if (offset == 0 || offset == XDEBUG_AGGR_SHM_NO_NAMES || calls == 0) {
+			continue;
+		}
+
+		filename = AGGR_SHM_NAMES() + offset;
+		cb(
+			ctxt, filename, filename + strlen(filename) + 1, (int) slots[i].lineno, calls,
+			__atomic_load_n(&slots[i].time_own, __ATOMIC_RELAXED),
+			__atomic_load_n(&slots[i].time_inclusive, __ATOMIC_RELAXED)
+		);
+	}
+}
+
+/* Functions keep their slots, only their totals start over */
+void xdebug_aggr_shm_clear(void)
+{
+	xdebug_aggr_shm_slot *slots;
+	uint64_t              i;
+
+	if (!aggr_shm) {
+		return;
+	}
+
+	slots = AGGR_SHM_SLOTS();
+	for (i = 0; i < aggr_shm->slot_count; i++) {
+		__atomic_store_n(&slots[i].calls, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&slots[i].time_own, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&slots[i].time_inclusive, 0, __ATOMIC_RELAXED);
+	}
+	__atomic_store_n(&aggr_shm->overflow.calls, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&aggr_shm->overflow.time_own, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&aggr_shm->overflow.time_inclusive, 0, __ATOMIC_RELAXED);
+}
+
+/* The calls that are not listed: those of functions without a slot, and
+ * those of slots whose names did not fit */
+uint64_t xdebug_aggr_shm_dropped(void)
+{
+	xdebug_aggr_shm_slot *slots;
+	uint64_t              i, dropped;
+
+	if (!aggr_shm) {
+		return 0;
+	}
+
+	dropped = __atomic_load_n(&aggr_shm->overflow.calls, __ATOMIC_RELAXED);
+	slots = AGGR_SHM_SLOTS();
+	for (i = 0; i < aggr_shm->slot_count; i++) {
+		if (__atomic_load_n(&slots[i].name_offset, __ATOMIC_ACQUIRE) == XDEBUG_AGGR_SHM_NO_NAMES) {
+			dropped += __atomic_load_n(&slots[i].calls, __ATOMIC_RELAXED);
+		}
+	}
+
+	return dropped;
+}
+
+#else
+
+int xdebug_aggr_shm_init(unsigned long slots)
+{
+	return 0;
+}
+
+void xdebug_aggr_shm_shutdown(void)
+{
+}
+
+int xdebug_aggr_shm_enabled(void)
+{
+	return 0;
+}
+
+int xdebug_aggr_shm_is_owner(void)
+{
+	return 0;
+}
+
+xdebug_aggr_shm_slot *xdebug_aggr_shm_find(const char *filename, const char *function, int lineno)
+{
+	return NULL;
+}
+
+void xdebug_aggr_shm_add(xdebug_aggr_shm_slot *slot, uint64_t time_own, uint64_t time_inclusive)
+{
+}
+
+void xdebug_aggr_shm_apply(xdebug_aggr_shm_apply_func cb, void *ctxt)
+{
+}
+
+void xdebug_aggr_shm_clear(void)
+{
+}
+
+uint64_t xdebug_aggr_shm_dropped(void)
+{
+	return 0;
+}
+
+#endif
@@ -0,0 +1,68 @@
+/*
+   +----------------------------------------------------------------------+
+   | Xdebug                                                               |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2002-2016 Derick Rethans                               |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 1.0 of the Xdebug license,    |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available at through the world-wide-web at                           |
+   | http://xdebug.derickrethans.nl/license.php                           |
+   | If you did not receive a copy of the Xdebug license and are unable   |
+   | to obtain it through the world-wide-web, please send a note to       |
+   | xdebug@derickrethans.nl so we can mail you a copy immediately.       |
+   +----------------------------------------------------------------------+
+ */
+
+#ifndef __XDEBUG_AGGR_SHM_H__
+#define __XDEBUG_AGGR_SHM_H__
+
+#include <stdint.h>
+
+/* Aggregate profile shared by all processes of a pool
+ * (xdebug.profiler_aggregate_shared).
+ *
+ * A fixed size open addressing table in an anonymous shared mapping, created
+ * in MINIT so that every forked worker inherits it. Functions are keyed on
+ * a 64 bit hash of their file, name and line, and a slot with the same hash
+ * is only used once its names match as well. A free slot is claimed with a
+ * compare-and-swap, its names are copied to a shared area, and the totals
+ * are updated with atomic adds. A lookup only ever waits for the names of a
+ * slot that another process claimed a moment ago. When the table or the
+ * names area is full, the calls to new functions are only counted as
+ * dropped. */
+
+#if !defined(PHP_WIN32) && !defined(_WIN32) && defined(__GNUC__)
+# define XDEBUG_AGGR_SHM_SUPPORTED 1
+#endif
+
+typedef struct _xdebug_aggr_shm_slot {
+	uint64_t hash;        /* 0 while the slot is free */
+	uint32_t name_offset; /* 0 until the names are written, UINT32_MAX if they didn't fit */
+	uint32_t lineno;
+	uint64_t calls;
+	uint64_t time_own;       /* nanoseconds */
+	uint64_t time_inclusive; /* nanoseconds */
+} xdebug_aggr_shm_slot;
+
+typedef void (*xdebug_aggr_shm_apply_func)(void *ctxt, const char *filename, const char *function, int lineno, uint64_t calls, uint64_t time_own, uint64_t time_inclusive);
+
+/* 'slots' is rounded up to a power of two */
+int  xdebug_aggr_shm_init(unsigned long slots);
+void xdebug_aggr_shm_shutdown(void);
+int  xdebug_aggr_shm_enabled(void);
+
+/* Whether this is the process that created the table */
+int  xdebug_aggr_shm_is_owner(void);
+
+/* Finds or adds the slot for a function. When the table is full, this is a
+ * slot that all functions without one share, and that is never listed. NULL
+ * only when the table is not enabled. */
+xdebug_aggr_shm_slot *xdebug_aggr_shm_find(const char *filename, const char *function, int lineno);
+void xdebug_aggr_shm_add(xdebug_aggr_shm_slot *slot, uint64_t time_own, uint64_t time_inclusive);
+
+void xdebug_aggr_shm_apply(xdebug_aggr_shm_apply_func cb, void *ctxt);
+void xdebug_aggr_shm_clear(void);
+uint64_t xdebug_aggr_shm_dropped(void);
+
+#endif
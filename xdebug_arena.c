@@ -0,0 +1,159 @@
+/*
+   +----------------------------------------------------------------------+
+   | Xdebug                                                               |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2002-2016 Derick Rethans                               |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 1.0 of the Xdebug license,    |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available at through the world-wide-web at                           |
+   | http://xdebug.derickrethans.nl/license.php                           |
+   | If you did not receive a copy of the Xdebug license and are unable   |
+   | to obtain it through the world-wide-web, please send a note to       |
+   | xdebug@derickrethans.nl so we can mail you a copy immediately.       |
+   +----------------------------------------------------------------------+
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "xdebug_arena.h"
+
+#define XDEBUG_ARENA_ROUND(__size) (((__size) + XDEBUG_ARENA_ALIGNMENT - 1) & ~((size_t) XDEBUG_ARENA_ALIGNMENT - 1))
+#define XDEBUG_ARENA_CLASS(__size) (XDEBUG_ARENA_ROUND(__size) / XDEBUG_ARENA_ALIGNMENT - 1)
+
+/* Chunk headers are padded so that the first block stays aligned */
+#define XDEBUG_ARENA_HEADER_SIZE XDEBUG_ARENA_ROUND(sizeof(xdebug_arena_chunk))
+
+void xdebug_arena_init(xdebug_arena *arena)
+{
+	memset(arena, 0, sizeof(xdebug_arena));
+}
+
+static int xdebug_arena_add_chunk(xdebug_arena *arena)
+{
+	xdebug_arena_chunk *chunk;
+
+	chunk = malloc(XDEBUG_ARENA_CHUNK_SIZE);
+	if (!chunk) {
+		return 0;
+	}
+
+	chunk->next = arena->chunks;
+	chunk->size = XDEBUG_ARENA_CHUNK_SIZE;
+	arena->chunks = chunk;
+	arena->bump = (char *) chunk + XDEBUG_ARENA_HEADER_SIZE;
+	arena->bump_end = (char *) chunk + XDEBUG_ARENA_CHUNK_SIZE;
+	arena->stats.chunk_bytes += XDEBUG_ARENA_CHUNK_SIZE;
+
+	return 1;
+}
+
+void *xdebug_arena_malloc(xdebug_arena *arena, size_t size)
+{
+	xdebug_arena_free_block **free_list;
+	void                     *ptr;
+
+	if (size == 0) {
+		size = 1;
+	}
+
+	if (size > XDEBUG_ARENA_MAX_CLASS_SIZE) {
+		ptr = malloc(size);
+		if (ptr) {
+			arena->stats.allocations++;
+			arena->stats.oversized++;
+		}
+		return ptr;
+	}
+
+	free_list = &arena->free_lists[XDEBUG_ARENA_CLASS(size)];
+	if (*free_list) {
+		ptr = *free_list;
+		*free_list = (*free_list)->next;
+		arena->stats.allocations++;
+		arena->stats.recycled++;
+		return ptr;
+	}
+
+	size = XDEBUG_ARENA_ROUND(size);
+	if ((size_t) (arena->bump_end - arena->bump) < size && !xdebug_arena_add_chunk(arena)) {
+		return NULL;
+	}
+
+	ptr = arena->bump;
+	arena->bump += size;
+	arena->stats.allocations++;
+
+	return ptr;
+}
+
+void xdebug_arena_free(xdebug_arena *arena, void *ptr, size_t size)
+{
+	xdebug_arena_free_block *block = ptr;
+
+	if (!ptr) {
+		return;
+	}
+
+	if (size == 0) {
+		size = 1;
+	}
+
+	if (size > XDEBUG_ARENA_MAX_CLASS_SIZE) {
+		free(ptr);
+		return;
+	}
+
+	block->next = arena->free_lists[XDEBUG_ARENA_CLASS(size)];
+	arena->free_lists[XDEBUG_ARENA_CLASS(size)] = block;
+}
+
+static void xdebug_arena_free_chunks(xdebug_arena_chunk *chunk)
+{
+	xdebug_arena_chunk *next;
+
+	for (; chunk; chunk = next) {
+		next = chunk->next;
+		free(chunk);
+	}
+}
+
+void xdebug_arena_reset(xdebug_arena *arena)
+{
+	xdebug_arena_chunk *keep;
+
+	/* The most recent chunk is at the head, keep the oldest one */
+	for (keep = arena->chunks; keep && keep->next; keep = keep->next);
+	if (keep && keep != arena->chunks) {
+		xdebug_arena_chunk *chunk;
+
+		for (chunk = arena->chunks; chunk->next != keep; chunk = chunk->next);
+		chunk->next = NULL;
+		xdebug_arena_free_chunks(arena->chunks);
+	}
+
+	arena->chunks = keep;
+	if (keep) {
+		arena->bump = (char *) keep + XDEBUG_ARENA_HEADER_SIZE;
+		arena->bump_end = (char *) keep + keep->size;
+		arena->stats.chunk_bytes = keep->size;
+	} else {
+		arena->bump = NULL;
+		arena->bump_end = NULL;
+		arena->stats.chunk_bytes = 0;
+	}
+
+	memset(arena->free_lists, 0, sizeof(arena->free_lists));
+	arena->stats.resets++;
+}
+
+void xdebug_arena_destroy(xdebug_arena *arena)
+{
+	xdebug_arena_free_chunks(arena->chunks);
+	arena->chunks = NULL;
+	arena->bump = NULL;
+	arena->bump_end = NULL;
+	arena->stats.chunk_bytes = 0;
+	memset(arena->free_lists, 0, sizeof(arena->free_lists));
+}
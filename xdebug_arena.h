@@ -0,0 +1,67 @@
+/*
+   +----------------------------------------------------------------------+
+   | Xdebug                                                               |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2002-2016 Derick Rethans                               |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 1.0 of the Xdebug license,    |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available at through the world-wide-web at                           |
+   | http://xdebug.derickrethans.nl/license.php                           |
+   | If you did not receive a copy of the Xdebug license and are unable   |
+   | to obtain it through the world-wide-web, please send a note to       |
+   | xdebug@derickrethans.nl so we can mail you a copy immediately.       |
+   +----------------------------------------------------------------------+
+ */
+
+#ifndef __XDEBUG_ARENA_H__
+#define __XDEBUG_ARENA_H__
+
+#include <stddef.h>
+
+/* Per-request allocator for bookkeeping that never outlives a request, such
+ * as stack frames, profiler call entries and their list elements.
+ *
+ * Memory is bumped out of large chunks. Freed blocks go onto a free list per
+ * 16 byte size class and are handed out again before bumping. Nothing is
+ * returned to libc until xdebug_arena_reset(), which drops everything at
+ * once and keeps the first chunk around for the next request. Blocks over
+ * XDEBUG_ARENA_MAX_CLASS_SIZE go straight to malloc() and free(). */
+
+#define XDEBUG_ARENA_CHUNK_SIZE     (64 * 1024)
+#define XDEBUG_ARENA_ALIGNMENT      16
+#define XDEBUG_ARENA_MAX_CLASS_SIZE 512
+#define XDEBUG_ARENA_CLASS_COUNT    (XDEBUG_ARENA_MAX_CLASS_SIZE / XDEBUG_ARENA_ALIGNMENT)
+
+typedef struct _xdebug_arena_chunk {
+	struct _xdebug_arena_chunk *next;
+	size_t                      size;
+} xdebug_arena_chunk;
+
+typedef struct _xdebug_arena_free_block {
+	struct _xdebug_arena_free_block *next;
+} xdebug_arena_free_block;
+
+typedef struct _xdebug_arena_stats {
+	unsigned long allocations;  /* all blocks handed out */
+	unsigned long recycled;     /* of which taken from a free list */
+	unsigned long oversized;    /* of which passed on to malloc() */
+	unsigned long resets;
+	size_t        chunk_bytes;  /* currently held in chunks */
+} xdebug_arena_stats;
+
+typedef struct _xdebug_arena {
+	xdebug_arena_chunk      *chunks;
+	char                    *bump;
+	char                    *bump_end;
+	xdebug_arena_free_block *free_lists[XDEBUG_ARENA_CLASS_COUNT];
+	xdebug_arena_stats       stats;
+} xdebug_arena;
+
+void  xdebug_arena_init(xdebug_arena *arena);
+void *xdebug_arena_malloc(xdebug_arena *arena, size_t size);
+void  xdebug_arena_free(xdebug_arena *arena, void *ptr, size_t size);
+void  xdebug_arena_reset(xdebug_arena *arena);
+void  xdebug_arena_destroy(xdebug_arena *arena);
+
+#endif
@@ -93,11 +93,12 @@ void xdebug_branch_post_process(zend_op_array *opa, xdebug_branch_info *branch_i
 {
 	unsigned int i;
 	int          in_branch = 0, last_start = -1;
+	xdebug_set  *boundaries;
 
 	/* Figure out which CATCHes are chained, and hence which ones should be
 	 * considered entry points */
-	for (i = 0; i < branch_info->entry_points->size; i++) {
-		if (xdebug_set_in(branch_info->entry_points, i) && opa->opcodes[i].opcode == ZEND_CATCH) {
+	for (i = xdebug_set_next(branch_info->entry_points, 0); i < branch_info->entry_points->size; i = xdebug_set_next(branch_info->entry_points, i + 1)) {
+		if (opa->opcodes[i].opcode == ZEND_CATCH) {
 #if PHP_VERSION_ID >= 70100
 			only_leave_first_catch(opa, branch_info, i + ((signed int) opa->opcodes[i].extended_value / sizeof(zend_op)));
 #else
@@ -106,7 +107,13 @@ void xdebug_branch_post_process(zend_op_array *opa, xdebug_branch_info *branch_i
 		}
 	}
 
-	for (i = 0; i < branch_info->starts->size; i++) {
+	/* Only opcodes that start or end a branch matter below, so skip straight
+	 * from one to the next */
+	boundaries = xdebug_set_create(branch_info->starts->size);
+	xdebug_set_union(boundaries, branch_info->starts);
+	xdebug_set_union(boundaries, branch_info->ends);
+
+	for (i = xdebug_set_next(boundaries, 0); i < boundaries->size; i = xdebug_set_next(boundaries, i + 1)) {
 		if (xdebug_set_in(branch_info->starts, i)) {
 			if (in_branch) {
 				branch_info->branches[last_start].out[0] = i;
@@ -124,6 +131,8 @@ void xdebug_branch_post_process(zend_op_array *opa, xdebug_branch_info *branch_i
 			in_branch = 0;
 		}
 	}
+
+	xdebug_set_free(boundaries);
 }
 
 void xdebug_path_add(xdebug_path *path, unsigned int nr)
@@ -296,10 +305,8 @@ void xdebug_branch_find_paths(xdebug_branch_info *branch_info)
 {
 	unsigned int i;
 
-	for (i = 0; i < branch_info->entry_points->size; i++) {
-		if (xdebug_set_in(branch_info->entry_points, i)) {
-			xdebug_branch_find_path(i, branch_info, NULL);
-		}
+	for (i = xdebug_set_next(branch_info->entry_points, 0); i < branch_info->entry_points->size; i = xdebug_set_next(branch_info->entry_points, i + 1)) {
+		xdebug_branch_find_path(i, branch_info, NULL);
 	}
 
 	branch_info->path_info.path_hash = xdebug_hash_alloc(128, NULL);
@@ -326,23 +333,21 @@ void xdebug_branch_info_dump(zend_op_array *opa, xdebug_branch_info *branch_info
 {
 	unsigned int i;
 
-	for (i = 0; i < branch_info->starts->size; i++) {
-		if (xdebug_set_in(branch_info->starts, i)) {
-			printf("branch: #%3d; line: %5d-%5d; sop: %5d; eop: %5d",
-				i,
-				branch_info->branches[i].start_lineno,
-				branch_info->branches[i].end_lineno,
-				i,
-				branch_info->branches[i].end_op
-			);
-			if (branch_info->branches[i].out[0]) {
-				printf("; out1: %3d", branch_info->branches[i].out[0]);
-			}
-			if (branch_info->branches[i].out[1]) {
-				printf("; out2: %3d", branch_info->branches[i].out[1]);
-			}
-			printf("\n");
+	for (i = xdebug_set_next(branch_info->starts, 0); i < branch_info->starts->size; i = xdebug_set_next(branch_info->starts, i + 1)) {
+		printf("branch: #%3d; line: %5d-%5d; sop: %5d; eop: %5d",
+			i,
+			branch_info->branches[i].start_lineno,
+			branch_info->branches[i].end_lineno,
+			i,
+			branch_info->branches[i].end_op
+		);
+		if (branch_info->branches[i].out[0]) {
+			printf("; out1: %3d", branch_info->branches[i].out[0]);
 		}
+		if (branch_info->branches[i].out[1]) {
+			printf("; out2: %3d", branch_info->branches[i].out[1]);
+		}
+		printf("\n");
 	}
 
 	for (i = 0; i < branch_info->path_info.paths_count; i++) {
@@ -451,7 +456,7 @@ void xdebug_branch_info_add_branches_and_paths(char *filename, char *function_na
 	xdebug_coverage_file *file;
 	xdebug_coverage_function *function;
 
-	if (strcmp(XG(previous_filename), filename) == 0) {
+	if (XG(previous_filename) == filename || strcmp(XG(previous_filename), filename) == 0) {
 		file = XG(previous_file);
 	} else {
 		/* Check if the file already exists in the hash */
@@ -461,7 +466,10 @@ void xdebug_branch_info_add_branches_and_paths(char *filename, char *function_na
 
 			xdebug_hash_add(XG(code_coverage), filename, strlen(filename), file);
 		}
-		XG(previous_filename) = file->name;
+		XG(previous_filename) = xdebug_intern_str(&XG(interned_strings), filename);
+		if (!XG(previous_filename)) {
+			XG(previous_filename) = file->name;
+		}
 		XG(previous_file) = file;
 	}
 
@@ -0,0 +1,143 @@
+/*
+   +----------------------------------------------------------------------+
+   | Xdebug                                                               |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2002-2016 Derick Rethans                               |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 1.0 of the Xdebug license,    |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available at through the world-wide-web at                           |
+   | http://xdebug.derickrethans.nl/license.php                           |
+   | If you did not receive a copy of the Xdebug license and are unable   |
+   | to obtain it through the world-wide-web, please send a note to       |
+   | xdebug@derickrethans.nl so we can mail you a copy immediately.       |
+   +----------------------------------------------------------------------+
+ */
+
+#include <string.h>
+
+#ifdef _WIN32
+# include <windows.h>
+#else
+# include <time.h>
+# include <sys/time.h>
+#endif
+
+#include "xdebug_clock.h"
+
+#ifdef XDEBUG_CLOCK_HAVE_TSC
+# include <cpuid.h>
+#endif
+
+/* The shortest time the TSC is measured against the monotonic clock. The
+ * error in the rate is about the cost of two clock reads over this. */
+#define XDEBUG_CLOCK_CALIBRATION_NANOS (2 * 1000 * 1000)
+
+xdebug_clock xdebug_global_clock = { XDEBUG_CLOCK_MONOTONIC, 0, 0, 0, 0 };
+
+uint64_t xdebug_clock_monotonic_nanos(void)
+{
+#if defined(_WIN32)
+	static LARGE_INTEGER frequency;
+	LARGE_INTEGER        counter;
+
+	if (frequency.QuadPart == 0) {
+		QueryPerformanceFrequency(&frequency);
+	}
+	QueryPerformanceCounter(&counter);
+
+	return (uint64_t) (counter.QuadPart / frequency.QuadPart) * XDEBUG_NANOS_IN_SEC +
+		(uint64_t) (counter.QuadPart % frequency.QuadPart) * XDEBUG_NANOS_IN_SEC / frequency.QuadPart;
+#elif defined(CLOCK_MONOTONIC_RAW) || defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+
+	/* The raw clock is not slewed by NTP, which would change the length of
+	 * a nanosecond while a request runs */
+# ifdef CLOCK_MONOTONIC_RAW
+	if (clock_gettime(CLOCK_MONOTONIC_RAW, &ts) != 0)
+# endif
+	{
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+	}
+
+	return (uint64_t) ts.tv_sec * XDEBUG_NANOS_IN_SEC + (uint64_t) ts.tv_nsec;
+#else
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return (uint64_t) tv.tv_sec * XDEBUG_NANOS_IN_SEC + (uint64_t) tv.tv_usec * XDEBUG_NANOS_IN_MICRO;
+#endif
+}
+
+#ifdef XDEBUG_CLOCK_HAVE_TSC
+/* Only a TSC that ticks at the same rate in every power state, on every
+ * core, can stand in for a clock */
+static int xdebug_clock_tsc_invariant(void)
+{
+	unsigned int eax, ebx, ecx, edx;
+
+	if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+		return 0;
+	}
+
+	return (edx & (1 << 8)) != 0;
+}
+
+/* Measures the TSC against the monotonic clock since init took both */
+static int xdebug_clock_calibrate_tsc(xdebug_clock *clock)
+{
+	uint64_t tsc_end, nanos_end, ticks, nanos;
+
+	do {
+		nanos_end = xdebug_clock_monotonic_nanos();
+		tsc_end = xdebug_clock_read_tsc();
+	} while (nanos_end - clock->nanos_start < XDEBUG_CLOCK_CALIBRATION_NANOS);
+
+	ticks = tsc_end - clock->tsc_start;
+	nanos = nanos_end - clock->nanos_start;
+	if (ticks == 0) {
+		return 0;
+	}
+
+	/* nanoseconds per tick, as a 32.32 fixed point number. The time since
+	 * init can be long enough for nanos << 32 to overflow. */
+	clock->mult = (uint64_t) ((double) nanos / (double) ticks * 4294967296.0);
+	return clock->mult != 0;
+}
+#endif
+
+void xdebug_clock_init(xdebug_clock *clock, const char *source)
+{
+	memset(clock, 0, sizeof(xdebug_clock));
+	clock->source = XDEBUG_CLOCK_MONOTONIC;
+
+#ifdef XDEBUG_CLOCK_HAVE_TSC
+	if (source && strcmp(source, "monotonic") == 0) {
+		return;
+	}
+	if (xdebug_clock_tsc_invariant()) {
+		clock->nanos_start = xdebug_clock_monotonic_nanos();
+		clock->tsc_start = xdebug_clock_read_tsc();
+		clock->pending = 1;
+	}
+#endif
+}
+
+void xdebug_clock_calibrate(xdebug_clock *clock)
+{
+	if (!clock->pending) {
+		return;
+	}
+	clock->pending = 0;
+
+#ifdef XDEBUG_CLOCK_HAVE_TSC
+	if (xdebug_clock_calibrate_tsc(clock)) {
+		clock->source = XDEBUG_CLOCK_TSC;
+	}
+#endif
+}
+
+const char *xdebug_clock_source_name(xdebug_clock *clock)
+{
+	return clock->source == XDEBUG_CLOCK_TSC ? "tsc" : "monotonic";
+}
@@ -0,0 +1,101 @@
+/*
+   +----------------------------------------------------------------------+
+   | Xdebug                                                               |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2002-2016 Derick Rethans                               |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 1.0 of the Xdebug license,    |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available at through the world-wide-web at                           |
+   | http://xdebug.derickrethans.nl/license.php                           |
+   | If you did not receive a copy of the Xdebug license and are unable   |
+   | to obtain it through the world-wide-web, please send a note to       |
+   | xdebug@derickrethans.nl so we can mail you a copy immediately.       |
+   +----------------------------------------------------------------------+
+ */
+
+#ifndef __XDEBUG_CLOCK_H__
+#define __XDEBUG_CLOCK_H__
+
+#include <stdint.h>
+
+/* The clock behind function timings, the profiler, traces and
+ * xdebug_time_index().
+ *
+ * Times are integer nanoseconds from an arbitrary starting point, and only
+ * differences between them mean anything. They come from the CPU's time
+ * stamp counter where it runs at a constant rate, scaled with a factor that
+ * is calibrated against the monotonic clock, and from the monotonic clock
+ * itself everywhere else. Neither is affected by changes to the wall clock.
+ *
+ * Calibrating takes both clocks at startup, and again when the profiler or a
+ * tracer first needs precise times. By then the two readings are normally far
+ * enough apart, so no process has to wait for the clocks, and one that never
+ * profiles or traces doesn't pay for it at all. Until then, times come from
+ * the monotonic clock. */
+
+#define XDEBUG_NANOS_IN_SEC   1000000000ULL
+#define XDEBUG_NANOS_IN_MICRO 1000ULL
+
+#define XDEBUG_SECONDS_SINCE(__start, __now) ((double) ((__now) - (__start)) / XDEBUG_NANOS_IN_SEC)
+
+#define XDEBUG_CLOCK_MONOTONIC 1
+#define XDEBUG_CLOCK_TSC       2
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+# define XDEBUG_CLOCK_HAVE_TSC 1
+#endif
+
+typedef struct _xdebug_clock {
+	int      source;
+	int      pending; /* the TSC is to be used, once calibrated */
+
+	/* For the TSC: nanos = nanos_start + (ticks - tsc_start) * mult / 2^32 */
+	uint64_t tsc_start;
+	uint64_t nanos_start;
+	uint64_t mult;
+} xdebug_clock;
+
+extern xdebug_clock xdebug_global_clock;
+
+/* 'source' is "auto", "tsc" or "monotonic". The TSC is only used when the
+ * CPU says it is invariant, and "tsc" falls back to the monotonic clock
+ * otherwise. */
+void     xdebug_clock_init(xdebug_clock *clock, const char *source);
+/* Switches to the TSC when init chose it, which only waits when this comes
+ * within XDEBUG_CLOCK_CALIBRATION_NANOS of init */
+void     xdebug_clock_calibrate(xdebug_clock *clock);
+uint64_t xdebug_clock_monotonic_nanos(void);
+const char *xdebug_clock_source_name(xdebug_clock *clock);
+
+#ifdef XDEBUG_CLOCK_HAVE_TSC
+static inline uint64_t xdebug_clock_read_tsc(void)
+{
+	uint32_t lo, hi;
+
+	__asm__ __volatile__("rdtsc" : "=a" (lo), "=d" (hi));
+	return ((uint64_t) hi << 32) | lo;
+}
+
+/* Split in two, so that the multiplication can't overflow */
+static inline uint64_t xdebug_clock_tsc_to_nanos(xdebug_clock *clock, uint64_t ticks)
+{
+	uint64_t delta = ticks - clock->tsc_start;
+
+	return clock->nanos_start +
+		(delta >> 32) * clock->mult +
+		(((delta & 0xffffffffULL) * clock->mult) >> 32);
+}
+#endif
+
+static inline uint64_t xdebug_get_nanotime(void)
+{
+#ifdef XDEBUG_CLOCK_HAVE_TSC
+	if (xdebug_global_clock.source == XDEBUG_CLOCK_TSC) {
+		return xdebug_clock_tsc_to_nanos(&xdebug_global_clock, xdebug_clock_read_tsc());
+	}
+#endif
+	return xdebug_clock_monotonic_nanos();
+}
+
+#endif
@@ -505,7 +505,9 @@ void xdebug_count_line(char *filename, int lineno, int executable, int deadcode
 	xdebug_coverage_file *file;
 	xdebug_coverage_line *line;
 
-	if (strcmp(XG(previous_filename), filename) == 0) {
+	/* Filenames coming from stack frames are interned, so those only need
+	 * a pointer comparison. Others still fall back to comparing strings. */
+	if (XG(previous_filename) == filename || strcmp(XG(previous_filename), filename) == 0) {
 		file = XG(previous_file);
 	} else {
 		/* Check if the file already exists in the hash */
@@ -515,7 +517,10 @@ void xdebug_count_line(char *filename, int lineno, int executable, int deadcode
 
 			xdebug_hash_add(XG(code_coverage), filename, strlen(filename), file);
 		}
-		XG(previous_filename) = file->name;
+		XG(previous_filename) = xdebug_intern_str(&XG(interned_strings), filename);
+		if (!XG(previous_filename)) {
+			XG(previous_filename) = file->name;
+		}
 		XG(previous_file) = file;
 	}
 
@@ -1131,44 +1136,42 @@ static void add_branches(zval *retval, xdebug_branch_info *branch_info TSRMLS_DC
 	XDEBUG_MAKE_STD_ZVAL(branches);
 	array_init(branches);
 
-	for (i = 0; i < branch_info->starts->size; i++) {
-		if (xdebug_set_in(branch_info->starts, i)) {
-			XDEBUG_MAKE_STD_ZVAL(branch);
-			array_init(branch);
-			add_assoc_long(branch, "op_start", i);
-			add_assoc_long(branch, "op_end", branch_info->branches[i].end_op);
-			add_assoc_long(branch, "line_start", branch_info->branches[i].start_lineno);
-			add_assoc_long(branch, "line_end", branch_info->branches[i].end_lineno);
-
-			add_assoc_long(branch, "hit", branch_info->branches[i].hit);
-
-			XDEBUG_MAKE_STD_ZVAL(out);
-			array_init(out);
-			if (branch_info->branches[i].out[0]) {
-				add_index_long(out, 0, branch_info->branches[i].out[0]);
-			}
-			if (branch_info->branches[i].out[1]) {
-				add_index_long(out, 1, branch_info->branches[i].out[1]);
-			}
-			add_assoc_zval(branch, "out", out);
+	for (i = xdebug_set_next(branch_info->starts, 0); i < branch_info->starts->size; i = xdebug_set_next(branch_info->starts, i + 1)) {
+		XDEBUG_MAKE_STD_ZVAL(branch);
+		array_init(branch);
+		add_assoc_long(branch, "op_start", i);
+		add_assoc_long(branch, "op_end", branch_info->branches[i].end_op);
+		add_assoc_long(branch, "line_start", branch_info->branches[i].start_lineno);
+		add_assoc_long(branch, "line_end", branch_info->branches[i].end_lineno);
 
-			XDEBUG_MAKE_STD_ZVAL(out_hit);
-			array_init(out_hit);
-			if (branch_info->branches[i].out[0]) {
-				add_index_long(out_hit, 0, branch_info->branches[i].out_hit[0]);
-			}
-			if (branch_info->branches[i].out[1]) {
-				add_index_long(out_hit, 1, branch_info->branches[i].out_hit[1]);
-			}
-			add_assoc_zval(branch, "out_hit", out_hit);
+		add_assoc_long(branch, "hit", branch_info->branches[i].hit);
+
+		XDEBUG_MAKE_STD_ZVAL(out);
+		array_init(out);
+		if (branch_info->branches[i].out[0]) {
+			add_index_long(out, 0, branch_info->branches[i].out[0]);
+		}
+		if (branch_info->branches[i].out[1]) {
+			add_index_long(out, 1, branch_info->branches[i].out[1]);
+		}
+		add_assoc_zval(branch, "out", out);
+
+		XDEBUG_MAKE_STD_ZVAL(out_hit);
+		array_init(out_hit);
+		if (branch_info->branches[i].out[0]) {
+			add_index_long(out_hit, 0, branch_info->branches[i].out_hit[0]);
+		}
+		if (branch_info->branches[i].out[1]) {
+			add_index_long(out_hit, 1, branch_info->branches[i].out_hit[1]);
+		}
+		add_assoc_zval(branch, "out_hit", out_hit);
 
-			add_index_zval(branches, i, branch);
+		add_index_zval(branches, i, branch);
 #if PHP_VERSION_ID >= 70000
-			efree(out_hit);
-			efree(out);
-			efree(branch);
+		efree(out_hit);
+		efree(out);
+		efree(branch);
 #endif
-		}
 	}
 
 	add_assoc_zval_ex(retval, "branches", HASH_KEY_SIZEOF("branches"), branches);
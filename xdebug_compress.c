@@ -0,0 +1,506 @@
+/*
+   +----------------------------------------------------------------------+
+   | Xdebug                                                               |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2002-2016 Derick Rethans                               |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 1.0 of the Xdebug license,    |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available at through the world-wide-web at                           |
+   | http://xdebug.derickrethans.nl/license.php                           |
+   | If you did not receive a copy of the Xdebug license and are unable   |
+   | to obtain it through the world-wide-web, please send a note to       |
+   | xdebug@derickrethans.nl so we can mail you a copy immediately.       |
+   +----------------------------------------------------------------------+
+ */
+
+/* For fopencookie() */
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "xdebug_compress.h"
+
+int xdebug_compress_method_from_name(const char *name)
+{
+	if (!name || !*name || strcmp(name, "none") == 0) {
+		return XDEBUG_COMPRESS_NONE;
+	}
+	if (strcmp(name, "gzip") == 0 || strcmp(name, "gz") == 0) {
+		return XDEBUG_COMPRESS_GZIP;
+	}
+	if (strcmp(name, "zstd") == 0 || strcmp(name, "zst") == 0) {
+		return XDEBUG_COMPRESS_ZSTD;
+	}
+	return -1;
+}
+
+int xdebug_compress_method_from_filename(const char *filename, size_t *suffix_len)
+{
+	size_t len = strlen(filename);
+
+	if (len > 3 && strcmp(filename + len - 3, ".gz") == 0) {
+		*suffix_len = 3;
+		return XDEBUG_COMPRESS_GZIP;
+	}
+	if (len > 4 && strcmp(filename + len - 4, ".zst") == 0) {
+		*suffix_len = 4;
+		return XDEBUG_COMPRESS_ZSTD;
+	}
+	*suffix_len = 0;
+	return XDEBUG_COMPRESS_NONE;
+}
+
+const char *xdebug_compress_extension(int method)
+{
+	switch (method) {
+		case XDEBUG_COMPRESS_GZIP: return "gz";
+		case XDEBUG_COMPRESS_ZSTD: return "zst";
+	}
+	return NULL;
+}
+
+#ifdef XDEBUG_COMPRESS_SUPPORTED
+#include <pthread.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#ifdef XDEBUG_HAVE_ZLIB
+# include <zlib.h>
+#endif
+#ifdef XDEBUG_HAVE_ZSTD
+# include <zstd.h>
+#endif
+
+/* What the request fills before handing it over. The tracers flush after
+ * every line, so this is where lines are gathered. */
+#define XDEBUG_COMPRESS_BLOCK_SIZE (128 * 1024)
+
+/* Blocks waiting for the writer. A request that writes faster than they can
+ * be compressed waits for the writer once this many are queued. */
+#define XDEBUG_COMPRESS_MAX_QUEUED 16
+
+typedef struct _xdebug_compress_block {
+	struct _xdebug_compress_block *next;
+	size_t                         len;
+	char                           data[XDEBUG_COMPRESS_BLOCK_SIZE];
+} xdebug_compress_block;
+
+typedef struct _xdebug_compressor {
+	FILE                  *file;
+	int                    method;
+	pid_t                  owner;
+	int                    warned; /* about a forked child writing */
+
+	/* Only touched by the request */
+	xdebug_compress_block *filling;
+
+	/* Shared with the writer, under 'lock' */
+	pthread_mutex_t        lock;
+	pthread_cond_t         not_empty;
+	pthread_cond_t         not_full;
+	xdebug_compress_block *head;
+	xdebug_compress_block *tail;
+	unsigned int           queued;
+	int                    closing;
+	int                    failed;
+
+	/* Only touched by the writer, once it runs */
+	pthread_t              writer;
+	unsigned char         *out;
+	size_t                 out_size;
+#ifdef XDEBUG_HAVE_ZLIB
+	z_stream               zlib;
+#endif
+#ifdef XDEBUG_HAVE_ZSTD
+	ZSTD_CCtx             *zstd;
+#endif
+} xdebug_compressor;
+
+static xdebug_compress_warning_func xdebug_compress_warning = NULL;
+
+void xdebug_compress_set_warning_handler(xdebug_compress_warning_func handler)
+{
+	xdebug_compress_warning = handler;
+}
+
+int xdebug_compress_supported(int method)
+{
+	switch (method) {
+		case XDEBUG_COMPRESS_NONE:
+			return 1;
+#ifdef XDEBUG_HAVE_ZLIB
+		case XDEBUG_COMPRESS_GZIP:
+			return 1;
+#endif
+#ifdef XDEBUG_HAVE_ZSTD
+		case XDEBUG_COMPRESS_ZSTD:
+			return 1;
+#endif
+	}
+	return 0;
+}
+
+static int xdebug_compress_write_out(xdebug_compressor *s, size_t len)
+{
+	return len == 0 || fwrite(s->out, 1, len, s->file) == len;
+}
+
+/* Compresses one block, or ends the stream when 'finish' is set */
+static int xdebug_compress_block_data(xdebug_compressor *s, const char *data, size_t len, int finish)
+{
+#ifdef XDEBUG_HAVE_ZLIB
+	if (s->method == XDEBUG_COMPRESS_GZIP) {
+		int ret;
+
+		s->zlib.next_in = (Bytef *) data;
+		s->zlib.avail_in = (uInt) len;
+		do {
+			s->zlib.next_out = s->out;
+			s->zlib.avail_out = (uInt) s->out_size;
+			ret = deflate(&s->zlib, finish ? Z_FINISH : Z_NO_FLUSH);
+			if (ret == Z_STREAM_ERROR) {
+				return 0;
+			}
+			if (!xdebug_compress_write_out(s, s->out_size - s->zlib.avail_out)) {
+				return 0;
+			}
+		} while (s->zlib.avail_out == 0);
+		return 1;
+	}
+#endif
+#ifdef XDEBUG_HAVE_ZSTD
+	if (s->method == XDEBUG_COMPRESS_ZSTD) {
+		ZSTD_inBuffer  in = { data, len, 0 };
+		ZSTD_outBuffer out;
+		size_t         remaining;
+
+		do {
+			out.dst = s->out;
+			out.size = s->out_size;
+			out.pos = 0;
+			remaining = ZSTD_compressStream2(s->zstd, &out, &in, finish ? ZSTD_e_end : ZSTD_e_continue);
+			if (ZSTD_isError(remaining)) {
+				return 0;
+			}
+			if (!xdebug_compress_write_out(s, out.pos)) {
+				return 0;
+			}
+		} while (finish ? remaining != 0 : in.pos < in.size);
+		return 1;
+	}
+#endif
+	return 0;
+}
+
+static void *xdebug_compress_writer(void *arg)
+{
+	xdebug_compressor     *s = arg;
+	xdebug_compress_block *blocks, *next;
+	int                    closing, ok = 1;
+
+	for (;;) {
+		pthread_mutex_lock(&s->lock);
+		while (!s->head && !s->closing) {
+			pthread_cond_wait(&s->not_empty, &s->lock);
+		}
+		blocks = s->head;
+		closing = s->closing;
+		s->head = s->tail = NULL;
+		s->queued = 0;
+		pthread_cond_broadcast(&s->not_full);
+		pthread_mutex_unlock(&s->lock);
+
+		for (; blocks; blocks = next) {
+			next = blocks->next;
+			if (ok) {
+				ok = xdebug_compress_block_data(s, blocks->data, blocks->len, 0);
+			}
+			free(blocks);
+		}
+		if (!ok) {
+			pthread_mutex_lock(&s->lock);
+			s->failed = 1;
+			pthread_cond_broadcast(&s->not_full);
+			pthread_mutex_unlock(&s->lock);
+		}
+		if (closing) {
+			break;
+		}
+	}
+
+	/* A stream that was given up on before it started is left empty */
+	pthread_mutex_lock(&s->lock);
+	if (!s->failed && !xdebug_compress_block_data(s, NULL, 0, 1)) {
+		s->failed = 1;
+	}
+	pthread_mutex_unlock(&s->lock);
+	return NULL;
+}
+
+/* Passes the block being filled to the writer */
+static int xdebug_compress_hand_over(xdebug_compressor *s)
+{
+	xdebug_compress_block *block = s->filling;
+	int                    failed;
+
+	s->filling = NULL;
+
+	pthread_mutex_lock(&s->lock);
+	while (s->queued >= XDEBUG_COMPRESS_MAX_QUEUED && !s->failed) {
+		pthread_cond_wait(&s->not_full, &s->lock);
+	}
+	failed = s->failed;
+	if (!failed) {
+		block->next = NULL;
+		if (s->tail) {
+			s->tail->next = block;
+		} else {
+			s->head = block;
+		}
+		s->tail = block;
+		s->queued++;
+		pthread_cond_signal(&s->not_empty);
+	}
+	pthread_mutex_unlock(&s->lock);
+
+	if (failed) {
+		free(block);
+	}
+	return !failed;
+}
+
+static size_t xdebug_compress_write(xdebug_compressor *s, const char *buf, size_t size)
+{
+	size_t done = 0, chunk;
+
+	/* A forked child has no writer; its copy of the stream must stay quiet */
+	if (s->owner != getpid()) {
+		if (!s->warned && xdebug_compress_warning) {
+			s->warned = 1;
+			xdebug_compress_warning("Compressed output can only be written by the process that opened it, so a forked process's output is discarded");
+		}
+		return 0;
+	}
+
+	while (done < size) {
+		if (!s->filling) {
+			s->filling = malloc(sizeof(xdebug_compress_block));
+			if (!s->filling) {
+				return 0;
+			}
+			s->filling->len = 0;
+		}
+
+		chunk = XDEBUG_COMPRESS_BLOCK_SIZE - s->filling->len;
+		if (chunk > size - done) {
+			chunk = size - done;
+		}
+		memcpy(s->filling->data + s->filling->len, buf + done, chunk);
+		s->filling->len += chunk;
+		done += chunk;
+
+		if (s->filling->len == XDEBUG_COMPRESS_BLOCK_SIZE && !xdebug_compress_hand_over(s)) {
+			return 0;
+		}
+	}
+
+	return size;
+}
+
+static void xdebug_compress_free(xdebug_compressor *s)
+{
+#ifdef XDEBUG_HAVE_ZLIB
+	if (s->method == XDEBUG_COMPRESS_GZIP) {
+		deflateEnd(&s->zlib);
+	}
+#endif
+#ifdef XDEBUG_HAVE_ZSTD
+	if (s->zstd) {
+		ZSTD_freeCCtx(s->zstd);
+	}
+#endif
+	pthread_cond_destroy(&s->not_full);
+	pthread_cond_destroy(&s->not_empty);
+	pthread_mutex_destroy(&s->lock);
+	free(s->out);
+	free(s->filling);
+	free(s);
+}
+
+static int xdebug_compress_close(xdebug_compressor *s)
+{
+	int failed;
+
+	if (s->owner != getpid()) {
+		/* The writer and the file belong to the parent, so only the
+		 * descriptor is closed */
+		fclose(s->file);
+		free(s->filling);
+		free(s);
+		return 0;
+	}
+
+	if (s->filling && s->filling->len > 0) {
+		xdebug_compress_hand_over(s);
+	}
+
+	pthread_mutex_lock(&s->lock);
+	s->closing = 1;
+	pthread_cond_signal(&s->not_empty);
+	pthread_mutex_unlock(&s->lock);
+	pthread_join(s->writer, NULL);
+
+	failed = s->failed;
+	if (fclose(s->file) != 0) {
+		failed = 1;
+	}
+	xdebug_compress_free(s);
+
+	return failed ? -1 : 0;
+}
+
+static int xdebug_compress_init_method(xdebug_compressor *s)
+{
+#ifdef XDEBUG_HAVE_ZLIB
+	if (s->method == XDEBUG_COMPRESS_GZIP) {
+		/* 16 + window bits asks for a gzip header. The fastest level is
+		 * still several times smaller than the text, and keeps up with the
+		 * tracers better. */
+		memset(&s->zlib, 0, sizeof(z_stream));
+		if (deflateInit2(&s->zlib, Z_BEST_SPEED, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+			return 0;
+		}
+		s->out_size = XDEBUG_COMPRESS_BLOCK_SIZE;
+		s->out = malloc(s->out_size);
+		return s->out != NULL;
+	}
+#endif
+#ifdef XDEBUG_HAVE_ZSTD
+	if (s->method == XDEBUG_COMPRESS_ZSTD) {
+		s->zstd = ZSTD_createCCtx();
+		if (!s->zstd) {
+			return 0;
+		}
+		s->out_size = ZSTD_CStreamOutSize();
+		s->out = malloc(s->out_size);
+		return s->out != NULL;
+	}
+#endif
+	return 0;
+}
+
+#if defined(__linux__)
+static ssize_t xdebug_compress_cookie_write(void *cookie, const char *buf, size_t size)
+{
+	return (ssize_t) xdebug_compress_write(cookie, buf, size);
+}
+
+static int xdebug_compress_cookie_close(void *cookie)
+{
+	return xdebug_compress_close(cookie);
+}
+
+static FILE *xdebug_compress_open_cookie(xdebug_compressor *s)
+{
+	cookie_io_functions_t functions = { NULL, xdebug_compress_cookie_write, NULL, xdebug_compress_cookie_close };
+
+	return fopencookie(s, "w", functions);
+}
+#else
+static int xdebug_compress_cookie_write(void *cookie, const char *buf, int size)
+{
+	return size > 0 && xdebug_compress_write(cookie, buf, (size_t) size) == 0 ? -1 : size;
+}
+
+static int xdebug_compress_cookie_close(void *cookie)
+{
+	return xdebug_compress_close(cookie);
+}
+
+static FILE *xdebug_compress_open_cookie(xdebug_compressor *s)
+{
+	return funopen(s, NULL, xdebug_compress_cookie_write, NULL, xdebug_compress_cookie_close);
+}
+#endif
+
+FILE *xdebug_compress_stream(FILE *file, int method)
+{
+	xdebug_compressor *s;
+	sigset_t           all, previous;
+	FILE              *stream;
+	int                started;
+
+	if (method == XDEBUG_COMPRESS_NONE || !xdebug_compress_supported(method)) {
+		return NULL;
+	}
+
+	s = calloc(1, sizeof(xdebug_compressor));
+	if (!s) {
+		return NULL;
+	}
+	s->file = file;
+	s->method = method;
+	s->owner = getpid();
+	pthread_mutex_init(&s->lock, NULL);
+	pthread_cond_init(&s->not_empty, NULL);
+	pthread_cond_init(&s->not_full, NULL);
+
+	if (!xdebug_compress_init_method(s)) {
+		xdebug_compress_free(s);
+		return NULL;
+	}
+
+	/* The writer already writes in large pieces, and this way a forked
+	 * child can't have any of them buffered to write a second time */
+	setvbuf(file, NULL, _IONBF, 0);
+
+	/* The writer must never run a signal handler meant for the request,
+	 * such as the sampling profiler's SIGPROF, so it starts with all of
+	 * them blocked */
+	sigfillset(&all);
+	pthread_sigmask(SIG_SETMASK, &all, &previous);
+	started = pthread_create(&s->writer, NULL, xdebug_compress_writer, s) == 0;
+	pthread_sigmask(SIG_SETMASK, &previous, NULL);
+	if (!started) {
+		xdebug_compress_free(s);
+		return NULL;
+	}
+
+	stream = xdebug_compress_open_cookie(s);
+	if (!stream) {
+		pthread_mutex_lock(&s->lock);
+		s->failed = 1;
+		s->closing = 1;
+		pthread_cond_signal(&s->not_empty);
+		pthread_mutex_unlock(&s->lock);
+		pthread_join(s->writer, NULL);
+		xdebug_compress_free(s);
+		return NULL;
+	}
+
+	return stream;
+}
+
+#else
+
+int xdebug_compress_supported(int method)
+{
+	return method == XDEBUG_COMPRESS_NONE;
+}
+
+void xdebug_compress_set_warning_handler(xdebug_compress_warning_func handler)
+{
+}
+
+FILE *xdebug_compress_stream(FILE *file, int method)
+{
+	return NULL;
+}
+
+#endif
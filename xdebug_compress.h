@@ -0,0 +1,67 @@
+/*
+   +----------------------------------------------------------------------+
+   | Xdebug                                                               |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2002-2016 Derick Rethans                               |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 1.0 of the Xdebug license,    |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available at through the world-wide-web at                           |
+   | http://xdebug.derickrethans.nl/license.php                           |
+   | If you did not receive a copy of the Xdebug license and are unable   |
+   | to obtain it through the world-wide-web, please send a note to       |
+   | xdebug@derickrethans.nl so we can mail you a copy immediately.       |
+   +----------------------------------------------------------------------+
+ */
+
+#ifndef __XDEBUG_COMPRESS_H__
+#define __XDEBUG_COMPRESS_H__
+
+#include <stdio.h>
+#include <stddef.h>
+
+/* Compressed profile and trace files (xdebug.output_compression).
+ *
+ * xdebug_compress_stream() puts a FILE in front of an open file, so that the
+ * profiler and the tracers keep using fprintf(), fwrite() and fflush(). What
+ * they write is gathered into large blocks, which are handed to a writer
+ * thread that compresses them and writes them out, so the request itself
+ * only copies memory. fclose() on the returned FILE waits for the writer to
+ * finish the stream, and then closes the file underneath.
+ *
+ * gzip needs zlib and zstd needs libzstd at build time, which config.m4
+ * passes on as XDEBUG_HAVE_ZLIB and XDEBUG_HAVE_ZSTD. */
+
+#define XDEBUG_COMPRESS_NONE 0
+#define XDEBUG_COMPRESS_GZIP 1
+#define XDEBUG_COMPRESS_ZSTD 2
+
+#if (defined(XDEBUG_HAVE_ZLIB) || defined(XDEBUG_HAVE_ZSTD)) && \
+	(defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__))
+# define XDEBUG_COMPRESS_SUPPORTED 1
+#endif
+
+int xdebug_compress_supported(int method);
+
+/* "gzip"/"gz" or "zstd"/"zst", and "" or "none" for no compression. Returns
+ * -1 for anything else. */
+int xdebug_compress_method_from_name(const char *name);
+
+/* For a filename ending in ".gz" or ".zst", also sets the length of that
+ * suffix, including the dot */
+int xdebug_compress_method_from_filename(const char *filename, size_t *suffix_len);
+
+/* "gz" or "zst", NULL for no compression */
+const char *xdebug_compress_extension(int method);
+
+/* Returns NULL, and leaves 'file' alone, when the method was not built in
+ * or the writer could not be started */
+FILE *xdebug_compress_stream(FILE *file, int method);
+
+/* The writer and the file of a stream belong to the process that opened it,
+ * so a forked child's writes to its copy are thrown away. The handler is
+ * told so once for every stream that this happens to. */
+typedef void (*xdebug_compress_warning_func)(const char *message);
+void xdebug_compress_set_warning_handler(xdebug_compress_warning_func handler);
+
+#endif
@@ -1830,7 +1830,6 @@ DBGP_FUNC(stack_depth)
 DBGP_FUNC(stack_get)
 {
 	xdebug_xml_node      *stackframe;
-	xdebug_llist_element *le;
 	int                   counter = 0;
 	long                  depth;
 
@@ -1843,11 +1842,9 @@ DBGP_FUNC(stack_get)
 			RETURN_RESULT(XG(status), XG(reason), XDEBUG_ERROR_STACK_DEPTH_INVALID);
 		}
 	} else {
-		counter = 0;
-		for (le = XDEBUG_LLIST_TAIL(XG(stack)); le != NULL; le = XDEBUG_LLIST_PREV(le)) {
+		for (counter = 0; (size_t) counter < XG(stack)->size; counter++) {
 			stackframe = return_stackframe(counter TSRMLS_CC);
 			xdebug_xml_add_child(*retval, stackframe);
-			counter++;
 		}
 	}
 }
@@ -19,12 +19,23 @@
  * Author(s): Sterling Hughes <sterling@php.net>
  */
 
+#include <stdint.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 #include "xdebug_hash.h"
-#include "xdebug_llist.h"
+
+#define XDEBUG_HASH_MIN_SLOTS 4
+#define XDEBUG_HASH_MAX_SLOTS (1 << 30)
+
+/* Maximum load factor is 3/4 */
+#define XDEBUG_HASH_OVERLOADED(__size, __slots) ((size_t) (__size) * 4 > (size_t) (__slots) * 3)
+
+/* Old slots migrated per insert or delete while growing. A new table starts
+ * out 3/8 full and grows again once 3/4 full, so any step of 2 or more
+ * finishes a migration before the next one is due. */
+#define XDEBUG_HASH_MIGRATE_STEP 8
 
 /*
  * Helper function to make a null terminated string from a key
@@ -41,234 +52,375 @@ char *xdebug_hash_key_to_str(xdebug_hash_key* key, int* new_len)
 	return tmp;
 }
 
+/* Final mixer from MurmurHash3, so that the low bits used to pick a slot
+ * depend on all bits of the input */
+static uint64_t xdebug_hash_mix(uint64_t h)
+{
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+
+	return h;
+}
+
+/* Consumes the key a word at a time rather than byte by byte */
 static xdebug_ui32 xdebug_hash_str(const char *key, unsigned int key_length)
 {
-	char *p = (char *) key;
-	char *end = (char *) key + key_length;
-	unsigned long h = 5381;
+	const unsigned char *p = (const unsigned char *) key;
+	uint64_t             h = 0x9e3779b97f4a7c15ULL ^ key_length;
+	uint64_t             w;
+
+	while (key_length >= sizeof(w)) {
+		memcpy(&w, p, sizeof(w));
+		h = ((h << 5) | (h >> 59)) ^ w;
+		h *= 0x517cc1b727220a95ULL;
+		p += sizeof(w);
+		key_length -= sizeof(w);
+	}
 
-	while (p < end) {
-		h += h << 5;
-		h ^= (unsigned long) *p++;
+	if (key_length) {
+		w = 0;
+		memcpy(&w, p, key_length);
+		h = ((h << 5) | (h >> 59)) ^ w;
+		h *= 0x517cc1b727220a95ULL;
 	}
 
-	return h;
+	return (xdebug_ui32) xdebug_hash_mix(h);
 }
 
 static xdebug_ui32 xdebug_hash_num(xdebug_ui32 key)
 {
-	key += ~(key << 15);
-	key ^= (key >> 10);
-	key += (key << 3);
-	key ^= (key >> 6);
-	key += (key << 11);
-	key ^= (key >> 16);
-
-	return key;
+	return (xdebug_ui32) xdebug_hash_mix((uint64_t) key);
 }
 
-static void hash_element_dtor(void *u, void *ele);
+static int xdebug_hash_slots_for(size_t size, int requested)
+{
+	int slots = XDEBUG_HASH_MIN_SLOTS;
+
+	while ((slots < requested || XDEBUG_HASH_OVERLOADED(size, slots)) && slots < XDEBUG_HASH_MAX_SLOTS) {
+		slots <<= 1;
+	}
+
+	return slots;
+}
 
-static xdebug_llist **xdebug_hash_table_alloc(int slots)
+static xdebug_hash_element *xdebug_hash_table_alloc(int slots)
 {
-	xdebug_llist **table;
-	int            i;
+	return (xdebug_hash_element *) calloc((size_t) slots, sizeof(xdebug_hash_element));
+}
 
-	table = (xdebug_llist **) malloc(slots * sizeof(xdebug_llist *));
-	if (!table) {
-		return NULL;
+static void xdebug_hash_table_free(xdebug_hash *h, xdebug_hash_element *table)
+{
+	if (table != h->borrowed_table) {
+		free(table);
 	}
-	for (i = 0; i < slots; ++i) {
-		table[i] = xdebug_llist_alloc((xdebug_llist_dtor) hash_element_dtor);
+}
+
+/* Inline keys point into their own element, so they need fixing up
+ * whenever an element is moved */
+static void xdebug_hash_element_relocated(xdebug_hash_element *e)
+{
+	if (e->key.type == XDEBUG_HASH_KEY_IS_STRING && e->key.value.str.len <= XDEBUG_HASH_INLINE_KEY_LEN) {
+		e->key.value.str.val = e->inline_key;
 	}
+}
 
-	return table;
+static void xdebug_hash_element_dtor(xdebug_hash *h, xdebug_hash_element *e)
+{
+	if (e->key.type == XDEBUG_HASH_KEY_IS_STRING && e->key.value.str.len > XDEBUG_HASH_INLINE_KEY_LEN) {
+		free(e->key.value.str.val);
+	}
+	if (h->dtor) {
+		h->dtor(e->ptr);
+	}
 }
 
-static void xdebug_hash_table_destroy_nodes(xdebug_llist **table, int slots)
+/* Places an element known not to be in the table yet */
+static void xdebug_hash_table_insert(xdebug_hash_element *table, int slots, xdebug_hash_element *e)
 {
-	xdebug_llist_element *le;
-	xdebug_llist_element *next;
-	int                   i;
+	int mask = slots - 1;
+	int i = (int) (e->hash & (xdebug_ui32) mask);
 
-	for (i = 0; i < slots; ++i) {
-		for (le = XDEBUG_LLIST_HEAD(table[i]); le != NULL; le = next) {
-			next = XDEBUG_LLIST_NEXT(le);
-			free(le);
-		}
-		free(table[i]);
+	while (table[i].key.type != XDEBUG_HASH_SLOT_EMPTY) {
+		i = (i + 1) & mask;
 	}
 
-	free(table);
+	table[i] = *e;
+	xdebug_hash_element_relocated(&table[i]);
 }
 
-static int xdebug_hash_rehash_slot(int slots, xdebug_hash_key *key)
+/* Backward shift deletion: move later elements of the same probe run into
+ * the hole, unless that would put them before their home slot. Slots
+ * already migrated out of an old table are empty and never part of a run,
+ * so this also holds for a table being migrated from. */
+static void xdebug_hash_table_remove(xdebug_hash_element *table, int slots, int hole)
 {
-	if (key->type == XDEBUG_HASH_KEY_IS_STRING) {
-		return xdebug_hash_str(key->value.str.val, key->value.str.len) % slots;
-	}
+	int mask = slots - 1;
+	int home;
+	int i;
 
-	return xdebug_hash_num(key->value.num) % slots;
+	for (i = (hole + 1) & mask; table[i].key.type != XDEBUG_HASH_SLOT_EMPTY; i = (i + 1) & mask) {
+		home = (int) (table[i].hash & (xdebug_ui32) mask);
+		if (hole <= i ? (hole < home && home <= i) : (hole < home || home <= i)) {
+			continue;
+		}
+		table[hole] = table[i];
+		xdebug_hash_element_relocated(&table[hole]);
+		hole = i;
+	}
+	table[hole].key.type = XDEBUG_HASH_SLOT_EMPTY;
 }
 
-static void hash_element_dtor(void *u, void *ele)
+static void xdebug_hash_migrate(xdebug_hash *h, int steps)
 {
-	xdebug_hash_element *e = (xdebug_hash_element *) ele;
-	xdebug_hash         *h = (xdebug_hash *) u;
+	int mask;
+	int i;
 
-	if (e->key.type == XDEBUG_HASH_KEY_IS_STRING) {
-		free(e->key.value.str.val);
+	if (!h->old_table) {
+		return;
 	}
-	if (h->dtor) {
-		h->dtor(e->ptr);
+
+	mask = h->old_slots - 1;
+	while (steps-- > 0 && h->migrated < h->old_slots - 1) {
+		i = (h->migrate_start + 1 + h->migrated) & mask;
+		if (h->old_table[i].key.type != XDEBUG_HASH_SLOT_EMPTY) {
+			xdebug_hash_table_insert(h->table, h->slots, &h->old_table[i]);
+			h->old_table[i].key.type = XDEBUG_HASH_SLOT_EMPTY;
+		}
+		h->migrated++;
+	}
+
+	if (h->migrated == h->old_slots - 1) {
+		xdebug_hash_table_free(h, h->old_table);
+		h->old_table = NULL;
+		h->old_slots = 0;
+	}
+}
+
+static void xdebug_hash_migrate_all(xdebug_hash *h)
+{
+	if (h->old_table) {
+		xdebug_hash_migrate(h, h->old_slots);
+	}
+}
+
+/* Swaps in a table of the given size, and starts migrating to it */
+static int xdebug_hash_grow(xdebug_hash *h, int slots)
+{
+	xdebug_hash_element *new_table;
+	int                  i;
+
+	xdebug_hash_migrate_all(h);
+
+	new_table = xdebug_hash_table_alloc(slots);
+	if (!new_table) {
+		return 0;
 	}
 
-	free(e);
-	e = NULL;
+	/* There always is an empty slot, the load factor is at most 3/4 */
+	for (i = 0; h->table[i].key.type != XDEBUG_HASH_SLOT_EMPTY; ++i);
+
+	h->old_table = h->table;
+	h->old_slots = h->slots;
+	h->migrate_start = i;
+	h->migrated = 0;
+	h->table = new_table;
+	h->slots = slots;
+
+	return 1;
 }
 
 xdebug_hash *xdebug_hash_alloc(int slots, xdebug_hash_dtor dtor)
+{
+	return xdebug_hash_alloc_in(slots, dtor, NULL);
+}
+
+size_t xdebug_hash_table_bytes(int slots)
+{
+	return (size_t) xdebug_hash_slots_for(0, slots) * sizeof(xdebug_hash_element);
+}
+
+xdebug_hash *xdebug_hash_alloc_in(int slots, xdebug_hash_dtor dtor, void *table)
 {
 	xdebug_hash *h;
 
 	h = malloc(sizeof(xdebug_hash));
+	if (!h) {
+		return NULL;
+	}
 	h->dtor  = dtor;
 	h->size  = 0;
-	h->slots = slots;
-
-	h->table = xdebug_hash_table_alloc(slots);
+	h->slots = xdebug_hash_slots_for(0, slots);
+	h->old_table = NULL;
+	h->old_slots = 0;
+	h->migrate_start = 0;
+	h->migrated = 0;
+	h->borrowed_table = (xdebug_hash_element *) table;
+
+	h->table = table ? h->borrowed_table : xdebug_hash_table_alloc(h->slots);
+	if (!h->table) {
+		free(h);
+		return NULL;
+	}
 
 	return h;
 }
 
-#define FIND_SLOT(__h, __s_key, __s_key_len, __n_key) \
-	((__s_key ? xdebug_hash_str(__s_key, __s_key_len) : xdebug_hash_num(__n_key)) % (__h)->slots)
-
-#define KEY_CREATE(__k, __s_key, __s_key_len, __n_key, __dup) \
-	if (__s_key) { \
-		if (__dup) { \
-			(__k)->value.str.val = (char *) malloc(__s_key_len); \
-			memcpy((__k)->value.str.val, __s_key, __s_key_len); \
-		} else { \
-			(__k)->value.str.val = __s_key; \
-		} \
-		(__k)->value.str.len = __s_key_len; \
-		(__k)->type = XDEBUG_HASH_KEY_IS_STRING; \
-	} else { \
-		(__k)->value.num = __n_key; \
-		(__k)->type = XDEBUG_HASH_KEY_IS_NUM; \
-	}
-
-static int xdebug_hash_key_compare(xdebug_hash_key *key1, xdebug_hash_key *key2)
+#define HASH_KEY(__s_key, __s_key_len, __n_key) \
+	(__s_key ? xdebug_hash_str(__s_key, __s_key_len) : xdebug_hash_num(__n_key))
+
+static int xdebug_hash_key_matches(xdebug_hash_element *e, xdebug_ui32 hash, const char *str_key, unsigned int str_key_len, xdebug_ui32 num_key)
 {
-	if (key1->type == XDEBUG_HASH_KEY_IS_NUM) {
-		if (key2->type == XDEBUG_HASH_KEY_IS_STRING)
-			return 0;
+	if (e->hash != hash) {
+		return 0;
+	}
 
-		if (key1->value.num == key2->value.num)
-			return 1;
-	} else {
-		if (key2->type == XDEBUG_HASH_KEY_IS_NUM)
-			return 0;
+	if (str_key) {
+		return e->key.type == XDEBUG_HASH_KEY_IS_STRING &&
+			e->key.value.str.len == str_key_len &&
+			memcmp(e->key.value.str.val, str_key, str_key_len) == 0;
+	}
+
+	return e->key.type == XDEBUG_HASH_KEY_IS_NUM && e->key.value.num == num_key;
+}
+
+static int xdebug_hash_probe(xdebug_hash_element *table, int slots, int i, xdebug_ui32 hash, const char *str_key, unsigned int str_key_len, xdebug_ui32 num_key)
+{
+	int mask = slots - 1;
 
-		if (key1->value.str.len == key2->value.str.len &&
-			*key1->value.str.val == *key2->value.str.val &&
-			memcmp(key1->value.str.val, key2->value.str.val, key1->value.str.len) == 0) {
-			return 1;
+	while (table[i].key.type != XDEBUG_HASH_SLOT_EMPTY) {
+		if (xdebug_hash_key_matches(&table[i], hash, str_key, str_key_len, num_key)) {
+			return i;
 		}
+		i = (i + 1) & mask;
+	}
+
+	return -1;
+}
+
+/* Returns the slot holding the key, or -1, and sets *table to the table
+ * holding that slot */
+static int xdebug_hash_lookup(xdebug_hash *h, xdebug_ui32 hash, const char *str_key, unsigned int str_key_len, xdebug_ui32 num_key, xdebug_hash_element **table)
+{
+	int slot;
+	int home;
+	int mask;
+
+	*table = h->table;
+	slot = xdebug_hash_probe(h->table, h->slots, (int) (hash & (xdebug_ui32) (h->slots - 1)), hash, str_key, str_key_len, num_key);
+	if (slot >= 0 || !h->old_table) {
+		return slot;
 	}
 
-	return 0;
+	/* An element whose home slot was already migrated can only be further
+	 * along the same run, that is from the first slot not migrated yet */
+	mask = h->old_slots - 1;
+	home = (int) (hash & (xdebug_ui32) mask);
+	if (((home - h->migrate_start - 1) & mask) < h->migrated) {
+		home = (h->migrate_start + 1 + h->migrated) & mask;
+	}
+
+	*table = h->old_table;
+	return xdebug_hash_probe(h->old_table, h->old_slots, home, hash, str_key, str_key_len, num_key);
 }
 
 int xdebug_hash_add_or_update(xdebug_hash *h, char *str_key, unsigned int str_key_len, unsigned long num_key, const void *p)
 {
-	xdebug_hash_element  *e;
-	xdebug_hash_key       tmp;
-	xdebug_llist         *l;
-	xdebug_llist_element *le;
-	int                slot;
-
-	slot = FIND_SLOT(h, str_key, str_key_len, num_key);
-	l = h->table[slot];
-	KEY_CREATE(&tmp, str_key, str_key_len, num_key, 0);
-	for (le = XDEBUG_LLIST_HEAD(l); le != NULL; le = XDEBUG_LLIST_NEXT(le)) {
-		if (xdebug_hash_key_compare(&tmp, &((xdebug_hash_element *) XDEBUG_LLIST_VALP(le))->key)) {
-			xdebug_hash_element *to_update = XDEBUG_LLIST_VALP(le);
-			if (h->dtor) {
-				h->dtor(to_update->ptr);
-			}
-			to_update->ptr = (void *) p;
-			return 1;
+	xdebug_hash_element  e;
+	xdebug_hash_element *table;
+	xdebug_ui32          hash;
+	int                  slot;
+
+	hash = HASH_KEY(str_key, str_key_len, num_key);
+	slot = xdebug_hash_lookup(h, hash, str_key, str_key_len, num_key, &table);
+	if (slot >= 0) {
+		if (h->dtor) {
+			h->dtor(table[slot].ptr);
 		}
+		table[slot].ptr = (void *) p;
+		return 1;
 	}
 
-	e = (xdebug_hash_element *) malloc(sizeof(xdebug_hash_element));
-	KEY_CREATE(&e->key, str_key, str_key_len, num_key, 1);
-	e->ptr = (void *) p;
+	if (XDEBUG_HASH_OVERLOADED(h->size + 1, h->slots)) {
+		if (h->slots >= XDEBUG_HASH_MAX_SLOTS || !xdebug_hash_grow(h, h->slots << 1)) {
+			return 0;
+		}
+	}
 
-	if (xdebug_llist_insert_next(l, XDEBUG_LLIST_TAIL(l), e)) {
-		++h->size;
-		return 1;
+	e.ptr = (void *) p;
+	e.hash = hash;
+	if (str_key) {
+		if (str_key_len <= XDEBUG_HASH_INLINE_KEY_LEN) {
+			memcpy(e.inline_key, str_key, str_key_len);
+		} else {
+			e.key.value.str.val = (char *) malloc(str_key_len);
+			if (!e.key.value.str.val) {
+				return 0;
+			}
+			memcpy(e.key.value.str.val, str_key, str_key_len);
+		}
+		e.key.value.str.len = str_key_len;
+		e.key.type = XDEBUG_HASH_KEY_IS_STRING;
 	} else {
-		return 0;
+		e.key.value.num = num_key;
+		e.key.type = XDEBUG_HASH_KEY_IS_NUM;
 	}
+
+	xdebug_hash_table_insert(h->table, h->slots, &e);
+	++h->size;
+	xdebug_hash_migrate(h, XDEBUG_HASH_MIGRATE_STEP);
+
+	return 1;
 }
 
 int xdebug_hash_extended_delete(xdebug_hash *h, char *str_key, unsigned int str_key_len, xdebug_ui32 num_key)
 {
-	xdebug_llist         *l;
-	xdebug_llist_element *le;
-	xdebug_hash_key       tmp;
-	int                slot;
-
-	slot = FIND_SLOT(h, str_key, str_key_len, num_key);
-	l = h->table[slot];
-
-	KEY_CREATE(&tmp, str_key, str_key_len, num_key, 0);
-	for (le = XDEBUG_LLIST_HEAD(l); le != NULL; le = XDEBUG_LLIST_NEXT(le)) {
-		if (xdebug_hash_key_compare(&tmp, &((xdebug_hash_element *) XDEBUG_LLIST_VALP(le))->key)) {
-			xdebug_llist_remove(l, le, (void *) h);
-			--h->size;
-			return 1;
-		}
+	xdebug_hash_element  removed;
+	xdebug_hash_element *table;
+	int                  slot;
+
+	slot = xdebug_hash_lookup(h, HASH_KEY(str_key, str_key_len, num_key), str_key, str_key_len, num_key, &table);
+	if (slot < 0) {
+		return 0;
 	}
 
-	return 0;
+	removed = table[slot];
+	xdebug_hash_table_remove(table, table == h->table ? h->slots : h->old_slots, slot);
+	--h->size;
+	xdebug_hash_migrate(h, XDEBUG_HASH_MIGRATE_STEP);
+
+	xdebug_hash_element_dtor(h, &removed);
+
+	return 1;
 }
 
 int xdebug_hash_extended_find(xdebug_hash *h, char *str_key, unsigned int str_key_len, xdebug_ui32 num_key, void **p)
 {
-	xdebug_llist         *l;
-	xdebug_llist_element *le;
-	xdebug_hash_key       tmp;
-	int                slot;
-
-	slot = FIND_SLOT(h, str_key, str_key_len, num_key);
-	l = h->table[slot];
-
-	KEY_CREATE(&tmp, str_key, str_key_len, num_key, 0);
-	for (le = XDEBUG_LLIST_HEAD(l); le != NULL; le = XDEBUG_LLIST_NEXT(le)) {
-		if (xdebug_hash_key_compare(&tmp, &((xdebug_hash_element *) XDEBUG_LLIST_VALP(le))->key)) {
-			*p = ((xdebug_hash_element *) XDEBUG_LLIST_VALP(le))->ptr;
-			return 1;
-		}
+	xdebug_hash_element *table;
+	int                  slot;
+
+	slot = xdebug_hash_lookup(h, HASH_KEY(str_key, str_key_len, num_key), str_key, str_key_len, num_key, &table);
+	if (slot < 0) {
+		return 0;
 	}
 
-	return 0;
+	*p = table[slot].ptr;
+	return 1;
 }
 
 int xdebug_hash_resize(xdebug_hash* h, int slots) {
-	xdebug_llist**        new_table;
-	xdebug_llist_element* le;
-	xdebug_hash_element*  he;
-	int                   i;
-	int                   slot;
+	xdebug_hash_element *new_table;
+	int                  i;
 
 	if (!h || slots <= 0) {
 		return 0;
 	}
 
+	xdebug_hash_migrate_all(h);
+
+	slots = xdebug_hash_slots_for(h->size, slots);
 	if (h->slots == slots) {
 		return 1;
 	}
@@ -279,81 +431,93 @@ int xdebug_hash_resize(xdebug_hash* h, int slots) {
 	}
 
 	for (i = 0; i < h->slots; ++i) {
-		for (le = XDEBUG_LLIST_HEAD(h->table[i]); le != NULL; le = XDEBUG_LLIST_NEXT(le)) {
-			he = (xdebug_hash_element*) XDEBUG_LLIST_VALP(le);
-			slot = xdebug_hash_rehash_slot(slots, &he->key);
-			xdebug_llist_insert_next(new_table[slot], XDEBUG_LLIST_TAIL(new_table[slot]), he);
+		if (h->table[i].key.type != XDEBUG_HASH_SLOT_EMPTY) {
+			xdebug_hash_table_insert(new_table, slots, &h->table[i]);
 		}
 	}
 
-	xdebug_hash_table_destroy_nodes(h->table, h->slots);
+	xdebug_hash_table_free(h, h->table);
 	h->table = new_table;
 	h->slots = slots;
 
 	return 1;
 }
 
+static void xdebug_hash_table_apply(xdebug_hash_element *table, int slots, void *user, void (*cb)(void *, xdebug_hash_element *))
+{
+	int i;
+
+	for (i = 0; i < slots; ++i) {
+		if (table[i].key.type != XDEBUG_HASH_SLOT_EMPTY) {
+			cb(user, &table[i]);
+		}
+	}
+}
+
 void xdebug_hash_apply(xdebug_hash *h, void *user, void (*cb)(void *, xdebug_hash_element *))
 {
-	 xdebug_llist_element  *le;
-	 int                    i;
-
-	 for (i = 0; i < h->slots; ++i) {
-		  for (le = XDEBUG_LLIST_HEAD(h->table[i]); le != NULL; le = XDEBUG_LLIST_NEXT(le)) {
-			   cb(user, (xdebug_hash_element *) XDEBUG_LLIST_VALP(le));
-		  }
-	 }
+	xdebug_hash_table_apply(h->table, h->slots, user, cb);
+	if (h->old_table) {
+		xdebug_hash_table_apply(h->old_table, h->old_slots, user, cb);
+	}
 }
 
-static int xdebug_compare_le_name(const void *le1, const void *le2)
+static int xdebug_compare_he_value(const void *he1, const void *he2)
 {
-	return strcmp((char *) XDEBUG_LLIST_VALP(*(xdebug_llist_element **) le1),
-		(char *) XDEBUG_LLIST_VALP(*(xdebug_llist_element **) le2));
+	return strcmp((char *) (*(xdebug_hash_element **) he1)->ptr,
+		(char *) (*(xdebug_hash_element **) he2)->ptr);
 }
 
 void xdebug_hash_apply_with_argument(xdebug_hash *h, void *user, void (*cb)(void *, xdebug_hash_element *, void *), void *argument)
 {
-	xdebug_llist_element  *le;
 	int                    i;
 	int                    num_items = 0;
 	xdebug_hash_element  **pp_he_list;
 
-	for (i = 0; i < h->slots; ++i) {
-		for (le = XDEBUG_LLIST_HEAD(h->table[i]); le != NULL; le = XDEBUG_LLIST_NEXT(le)) {
-			num_items += 1;
-		}
-	}
-	pp_he_list = (xdebug_hash_element **) malloc((size_t) (num_items * sizeof(xdebug_hash_element **)));
+	/* Only the current table is walked below */
+	xdebug_hash_migrate_all(h);
+
+	pp_he_list = (xdebug_hash_element **) malloc(h->size * sizeof(xdebug_hash_element *) + 1);
 	if (pp_he_list) {
-		int j = 0;
 		for (i = 0; i < h->slots; ++i) {
-			for (le = XDEBUG_LLIST_HEAD(h->table[i]); le != NULL; le = XDEBUG_LLIST_NEXT(le)) {
-				pp_he_list[j++] = XDEBUG_LLIST_VALP(le);
+			if (h->table[i].key.type != XDEBUG_HASH_SLOT_EMPTY) {
+				pp_he_list[num_items++] = &h->table[i];
 			}
 		}
-		qsort(pp_he_list, num_items, sizeof(xdebug_llist_element *), xdebug_compare_le_name);
+		qsort(pp_he_list, num_items, sizeof(xdebug_hash_element *), xdebug_compare_he_value);
 		for (i = 0; i < num_items; ++i) {
 			cb(user, pp_he_list[i], argument);
 		}
 		free((void *) pp_he_list);
 	} else {
 		for (i = 0; i < h->slots; ++i) {
-			for (le = XDEBUG_LLIST_HEAD(h->table[i]); le != NULL; le = XDEBUG_LLIST_NEXT(le)) {
-				cb(user, (xdebug_hash_element *) XDEBUG_LLIST_VALP(le), argument);
+			if (h->table[i].key.type != XDEBUG_HASH_SLOT_EMPTY) {
+				cb(user, &h->table[i], argument);
 			}
 		}
 	}
 }
 
-void xdebug_hash_destroy(xdebug_hash *h)
+static void xdebug_hash_table_destroy(xdebug_hash *h, xdebug_hash_element *table, int slots)
 {
 	int i;
 
-    for (i = 0; i < h->slots; ++i) {
-		xdebug_llist_destroy(h->table[i], (void *) h);
+	for (i = 0; i < slots; ++i) {
+		if (table[i].key.type != XDEBUG_HASH_SLOT_EMPTY) {
+			xdebug_hash_element_dtor(h, &table[i]);
+		}
+	}
+
+	xdebug_hash_table_free(h, table);
+}
+
+void xdebug_hash_destroy(xdebug_hash *h)
+{
+	xdebug_hash_table_destroy(h, h->table, h->slots);
+	if (h->old_table) {
+		xdebug_hash_table_destroy(h, h->old_table, h->old_slots);
 	}
 
-	free(h->table);
 	free(h);
 }
 
@@ -26,19 +26,21 @@
 
 #include "xdebug_llist.h"
 
-#define XDEBUG_HASH_KEY_IS_STRING 0
-#define XDEBUG_HASH_KEY_IS_NUM    1
+#define XDEBUG_HASH_KEY_IS_STRING 1
+#define XDEBUG_HASH_KEY_IS_NUM    2
 
 #define xdebug_ui32 unsigned long
 
 typedef void (*xdebug_hash_dtor)(void *);
 
-typedef struct _xdebug_hash {
-	xdebug_llist     **table;
-	xdebug_hash_dtor   dtor;
-	int             slots;
-	size_t          size;
-} xdebug_hash;
+/* Keys up to this length are stored inside the element itself, longer ones
+ * are copied to the heap. Chosen so that an element fills a cache line on
+ * LP64 platforms. */
+#define XDEBUG_HASH_INLINE_KEY_LEN 24
+
+/* Internal marker for unused slots, never passed to callbacks. Zero, so
+ * that fresh tables can come straight from calloc(). */
+#define XDEBUG_HASH_SLOT_EMPTY    0
 
 typedef struct _xdebug_hash_key {
 	union {
@@ -56,13 +58,46 @@ typedef struct _xdebug_hash_key {
 typedef struct _xdebug_hash_element {
 	void         *ptr;
 	xdebug_hash_key  key;
+	xdebug_ui32   hash;
+	char          inline_key[XDEBUG_HASH_INLINE_KEY_LEN];
 } xdebug_hash_element;
 
+/* Open addressing table with linear probing. 'slots' is always a power of
+ * two, and the table doubles before 'size' exceeds 3/4 of it. Growing is
+ * incremental: the previous table is kept around and every insert or delete
+ * migrates a few of its slots, so no single insert pays for a full rehash.
+ * xdebug_hash_resize() finishes any pending migration.
+ * Element pointers handed to callbacks are only valid until the next
+ * modification. */
+typedef struct _xdebug_hash {
+	xdebug_hash_element *table;
+	xdebug_hash_dtor     dtor;
+	int                  slots;
+	size_t               size;
+
+	/* Table being migrated from, NULL when not growing. Its slots are
+	 * migrated in order, starting right after the empty slot
+	 * 'migrate_start'. */
+	xdebug_hash_element *old_table;
+	int                  old_slots;
+	int                  migrate_start;
+	int                  migrated;
+
+	/* Table handed in through xdebug_hash_alloc_in(), which belongs to the
+	 * caller and is never freed here */
+	xdebug_hash_element *borrowed_table;
+} xdebug_hash;
+
 /* Helper functions */
 char* xdebug_hash_key_to_str(xdebug_hash_key* key, int* new_len);
 
 /* Standard functions */
 xdebug_hash *xdebug_hash_alloc(int slots, xdebug_hash_dtor dtor);
+/* Same, but starts out with the given zeroed memory as its table, which
+ * must be xdebug_hash_table_bytes(slots) long. Only useful for hashes that
+ * are sized up front, the first growth moves the elements out of it. */
+xdebug_hash *xdebug_hash_alloc_in(int slots, xdebug_hash_dtor dtor, void *table);
+size_t xdebug_hash_table_bytes(int slots);
 int  xdebug_hash_add_or_update(xdebug_hash *h, char *str_key, unsigned int str_key_len, unsigned long num_key, const void *p);
 int  xdebug_hash_extended_delete(xdebug_hash *h, char *str_key, unsigned int str_key_len, unsigned long num_key);
 int  xdebug_hash_extended_find(xdebug_hash *h, char *str_key, unsigned int str_key_len, unsigned long num_key, void **p);
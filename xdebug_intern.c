@@ -0,0 +1,140 @@
+/*
+   +----------------------------------------------------------------------+
+   | Xdebug                                                               |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2002-2016 Derick Rethans                               |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 1.0 of the Xdebug license,    |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available at through the world-wide-web at                           |
+   | http://xdebug.derickrethans.nl/license.php                           |
+   | If you did not receive a copy of the Xdebug license and are unable   |
+   | to obtain it through the world-wide-web, please send a note to       |
+   | xdebug@derickrethans.nl so we can mail you a copy immediately.       |
+   +----------------------------------------------------------------------+
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "xdebug_intern.h"
+
+#define XDEBUG_INTERN_INITIAL_SLOTS 256
+#define XDEBUG_INTERN_INITIAL_IDS   64
+
+void xdebug_intern_table_init(xdebug_intern_table *table)
+{
+	memset(table, 0, sizeof(xdebug_intern_table));
+}
+
+void xdebug_intern_table_reset(xdebug_intern_table *table)
+{
+	unsigned int i;
+
+	if (table->strings) {
+		xdebug_hash_destroy(table->strings);
+	}
+	for (i = 1; i <= table->count; i++) {
+		free(table->by_id[i]);
+	}
+	free(table->by_id);
+
+	xdebug_intern_table_init(table);
+}
+
+static int xdebug_intern_reserve_id(xdebug_intern_table *table)
+{
+	xdebug_interned_string **by_id;
+	unsigned int             size;
+
+	if (table->count + 1 < table->size) {
+		return 1;
+	}
+
+	size = table->size ? table->size * 2 : XDEBUG_INTERN_INITIAL_IDS;
+	by_id = realloc(table->by_id, size * sizeof(xdebug_interned_string *));
+	if (!by_id) {
+		return 0;
+	}
+
+	table->by_id = by_id;
+	table->size = size;
+	return 1;
+}
+
+xdebug_interned_string *xdebug_intern(xdebug_intern_table *table, const char *str, unsigned int len)
+{
+	xdebug_interned_string *s;
+
+	if (!table->strings) {
+		table->strings = xdebug_hash_alloc(XDEBUG_INTERN_INITIAL_SLOTS, NULL);
+		if (!table->strings) {
+			return NULL;
+		}
+	}
+
+	if (xdebug_hash_find(table->strings, (char *) str, len, (void *) &s)) {
+		return s;
+	}
+
+	if (!xdebug_intern_reserve_id(table)) {
+		return NULL;
+	}
+
+	s = malloc(offsetof(xdebug_interned_string, val) + len + 1);
+	if (!s) {
+		return NULL;
+	}
+	s->id = table->count + 1;
+	s->len = len;
+	s->refs_generation = 0;
+	s->filename_ref = 0;
+	s->functionname_ref[0] = 0;
+	s->functionname_ref[1] = 0;
+	s->aggr_shm_slot = NULL;
+	s->aggr_shm_filename = NULL;
+	s->aggr_shm_lineno = 0;
+	memcpy(s->val, str, len);
+	s->val[len] = '\0';
+
+	if (!xdebug_hash_add(table->strings, s->val, len, s)) {
+		free(s);
+		return NULL;
+	}
+
+	table->by_id[s->id] = s;
+	table->count++;
+
+	return s;
+}
+
+char *xdebug_intern_str(xdebug_intern_table *table, const char *str)
+{
+	xdebug_interned_string *s;
+
+	if (!str) {
+		return NULL;
+	}
+
+	s = xdebug_intern(table, str, strlen(str));
+	return s ? s->val : NULL;
+}
+
+char *xdebug_intern_take(xdebug_intern_table *table, char *str)
+{
+	char *interned;
+
+	interned = xdebug_intern_str(table, str);
+	free(str);
+
+	return interned;
+}
+
+char *xdebug_intern_find_id(xdebug_intern_table *table, unsigned int id)
+{
+	if (id == 0 || id > table->count) {
+		return NULL;
+	}
+
+	return table->by_id[id]->val;
+}
@@ -0,0 +1,75 @@
+/*
+   +----------------------------------------------------------------------+
+   | Xdebug                                                               |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2002-2016 Derick Rethans                               |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 1.0 of the Xdebug license,    |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available at through the world-wide-web at                           |
+   | http://xdebug.derickrethans.nl/license.php                           |
+   | If you did not receive a copy of the Xdebug license and are unable   |
+   | to obtain it through the world-wide-web, please send a note to       |
+   | xdebug@derickrethans.nl so we can mail you a copy immediately.       |
+   +----------------------------------------------------------------------+
+ */
+
+#ifndef __XDEBUG_INTERN_H__
+#define __XDEBUG_INTERN_H__
+
+#include <stddef.h>
+
+#include "xdebug_hash.h"
+
+/* Per-request table of filenames and function names.
+ *
+ * Every distinct string is stored once and gets a small ID, counting up from
+ * 1. The returned pointers stay valid, and keep their ID, until the table is
+ * reset at the end of the request. Two interned strings are equal if and only
+ * if they are the same pointer, so stack frames, the profiler and the tracers
+ * can share them without copying, and compare them without strcmp(). */
+
+typedef struct _xdebug_interned_string {
+	unsigned int id;
+	unsigned int len;
+
+	/* The profiler's cachegrind name references for this string, only valid
+	 * while refs_generation matches XG(profile_refs_generation) */
+	unsigned int refs_generation;
+	int          filename_ref;
+	int          functionname_ref[2]; /* user defined, internal */
+
+	/* For function names: the profiler's shared aggregate slot, and the
+	 * interned file and line it was last looked up for */
+	void        *aggr_shm_slot;
+	const char  *aggr_shm_filename;
+	int          aggr_shm_lineno;
+
+	char         val[1];
+} xdebug_interned_string;
+
+typedef struct _xdebug_intern_table {
+	xdebug_hash             *strings;
+	xdebug_interned_string **by_id;
+	unsigned int             count;
+	unsigned int             size;
+} xdebug_intern_table;
+
+/* Only valid for pointers returned by the functions below */
+#define XDEBUG_INTERNED(__s)    ((xdebug_interned_string *) ((char *) (__s) - offsetof(xdebug_interned_string, val)))
+#define XDEBUG_INTERNED_ID(__s) (XDEBUG_INTERNED(__s)->id)
+
+void xdebug_intern_table_init(xdebug_intern_table *table);
+void xdebug_intern_table_reset(xdebug_intern_table *table);
+
+xdebug_interned_string *xdebug_intern(xdebug_intern_table *table, const char *str, unsigned int len);
+
+/* Both return NULL for a NULL string, or when out of memory. The second one
+ * also frees the string it is given, which is handy for xdebug_sprintf()
+ * results. */
+char *xdebug_intern_str(xdebug_intern_table *table, const char *str);
+char *xdebug_intern_take(xdebug_intern_table *table, char *str);
+
+char *xdebug_intern_find_id(xdebug_intern_table *table, unsigned int id);
+
+#endif
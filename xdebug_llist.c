@@ -34,24 +34,60 @@ xdebug_llist *xdebug_llist_alloc(xdebug_llist_dtor dtor)
 	return l;
 }
 
+/* The list and its elements are allocated from the arena, so it must be
+ * destroyed before the arena is reset */
+xdebug_llist *xdebug_llist_alloc_in_arena(xdebug_llist_dtor dtor, xdebug_arena *arena)
+{
+	xdebug_llist *l;
+
+	l = xdebug_arena_malloc(arena, sizeof(xdebug_llist));
+	xdebug_llist_init(l, dtor);
+	l->arena = arena;
+
+	return l;
+}
+
+/* For lists whose values carry their own xdebug_llist_element. Only the
+ * insert_element functions may be used to add to them, and the dtor is called
+ * after the element has been unlinked, so it is free to release the value the
+ * element lives in. The arena, if any, only holds the list itself. */
+xdebug_llist *xdebug_llist_alloc_intrusive(xdebug_llist_dtor dtor, xdebug_arena *arena)
+{
+	xdebug_llist *l;
+
+	l = arena ? xdebug_arena_malloc(arena, sizeof(xdebug_llist)) : malloc(sizeof(xdebug_llist));
+	xdebug_llist_init(l, dtor);
+	l->arena = arena;
+	l->intrusive = 1;
+
+	return l;
+}
+
 void xdebug_llist_init(xdebug_llist *l, xdebug_llist_dtor dtor)
 {
 	l->size = 0;
 	l->dtor = dtor;
 	l->head = NULL;
 	l->tail = NULL;
+	l->arena = NULL;
+	l->intrusive = 0;
 }
 
-int xdebug_llist_insert_next(xdebug_llist *l, xdebug_llist_element *e, const void *p)
+static xdebug_llist_element *xdebug_llist_element_alloc(xdebug_llist *l)
 {
-	xdebug_llist_element  *ne;
+	if (l->arena) {
+		return (xdebug_llist_element *) xdebug_arena_malloc(l->arena, sizeof(xdebug_llist_element));
+	}
 
+	return (xdebug_llist_element *) malloc(sizeof(xdebug_llist_element));
+}
+
+static void xdebug_llist_link_next(xdebug_llist *l, xdebug_llist_element *e, xdebug_llist_element *ne)
+{
 	if (!e) {
 		e = XDEBUG_LLIST_TAIL(l);
 	}
 
-	ne = (xdebug_llist_element *) malloc(sizeof(xdebug_llist_element));
-	ne->ptr = (void *) p;
 	if (l->size == 0) {
 		l->head = ne;
 		l->head->prev = NULL;
@@ -69,20 +105,14 @@ int xdebug_llist_insert_next(xdebug_llist *l, xdebug_llist_element *e, const voi
 	}
 
 	++l->size;
-
-	return 1;
 }
 
-int xdebug_llist_insert_prev(xdebug_llist *l, xdebug_llist_element *e, const void *p)
+static void xdebug_llist_link_prev(xdebug_llist *l, xdebug_llist_element *e, xdebug_llist_element *ne)
 {
-	xdebug_llist_element *ne;
-
 	if (!e) {
 		e = XDEBUG_LLIST_HEAD(l);
 	}
 
-	ne = (xdebug_llist_element *) malloc(sizeof(xdebug_llist_element));
-	ne->ptr = (void *) p;
 	if (l->size == 0) {
 		l->head = ne;
 		l->head->prev = NULL;
@@ -99,6 +129,43 @@ int xdebug_llist_insert_prev(xdebug_llist *l, xdebug_llist_element *e, const voi
 	}
 
 	++l->size;
+}
+
+int xdebug_llist_insert_next(xdebug_llist *l, xdebug_llist_element *e, const void *p)
+{
+	xdebug_llist_element  *ne;
+
+	ne = xdebug_llist_element_alloc(l);
+	ne->ptr = (void *) p;
+	xdebug_llist_link_next(l, e, ne);
+
+	return 1;
+}
+
+int xdebug_llist_insert_prev(xdebug_llist *l, xdebug_llist_element *e, const void *p)
+{
+	xdebug_llist_element *ne;
+
+	ne = xdebug_llist_element_alloc(l);
+	ne->ptr = (void *) p;
+	xdebug_llist_link_prev(l, e, ne);
+
+	return 0;
+}
+
+/* ne is owned by the caller, normally it is a member of *p */
+int xdebug_llist_insert_element_next(xdebug_llist *l, xdebug_llist_element *e, xdebug_llist_element *ne, const void *p)
+{
+	ne->ptr = (void *) p;
+	xdebug_llist_link_next(l, e, ne);
+
+	return 1;
+}
+
+int xdebug_llist_insert_element_prev(xdebug_llist *l, xdebug_llist_element *e, xdebug_llist_element *ne, const void *p)
+{
+	ne->ptr = (void *) p;
+	xdebug_llist_link_prev(l, e, ne);
 
 	return 0;
 }
@@ -123,11 +190,24 @@ int xdebug_llist_remove(xdebug_llist *l, xdebug_llist_element *e, void *user)
 			e->next->prev = e->prev;
 	}
 
+	--l->size;
+
+	if (l->intrusive) {
+		/* e may live inside the value, so it can't be touched after the dtor */
+		if (l->dtor) {
+			l->dtor(user, e->ptr);
+		}
+		return 0;
+	}
+
 	if (l->dtor) {
 		l->dtor(user, e->ptr);
 	}
-	free(e);
-	--l->size;
+	if (l->arena) {
+		xdebug_arena_free(l->arena, e, sizeof(xdebug_llist_element));
+	} else {
+		free(e);
+	}
 
 	return 0;
 }
@@ -179,7 +259,11 @@ void xdebug_llist_destroy(xdebug_llist *l, void *user)
 {
 	xdebug_llist_empty(l, user);
 
-	free (l);
+	if (l->arena) {
+		xdebug_arena_free(l->arena, l, sizeof(xdebug_llist));
+	} else {
+		free (l);
+	}
 }
 
 /*
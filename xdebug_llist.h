@@ -25,6 +25,8 @@
 
 #include <stddef.h>
 
+#include "xdebug_arena.h"
+
 typedef void (*xdebug_llist_dtor)(void *, void *);
 
 typedef struct _xdebug_llist_element {
@@ -41,12 +43,23 @@ typedef struct _xdebug_llist {
 	xdebug_llist_dtor dtor;
 
 	size_t size;
+
+	/* Where elements come from, NULL for malloc() */
+	xdebug_arena *arena;
+
+	/* Elements are embedded in the values they point to, and are never
+	 * allocated or freed by the list */
+	int intrusive;
 } xdebug_llist;
 
 xdebug_llist *xdebug_llist_alloc(xdebug_llist_dtor dtor);
+xdebug_llist *xdebug_llist_alloc_in_arena(xdebug_llist_dtor dtor, xdebug_arena *arena);
+xdebug_llist *xdebug_llist_alloc_intrusive(xdebug_llist_dtor dtor, xdebug_arena *arena);
 void xdebug_llist_init(xdebug_llist *l, xdebug_llist_dtor dtor);
 int xdebug_llist_insert_next(xdebug_llist *l, xdebug_llist_element *e, const void *p);
 int xdebug_llist_insert_prev(xdebug_llist *l, xdebug_llist_element *e, const void *p);
+int xdebug_llist_insert_element_next(xdebug_llist *l, xdebug_llist_element *e, xdebug_llist_element *ne, const void *p);
+int xdebug_llist_insert_element_prev(xdebug_llist *l, xdebug_llist_element *e, xdebug_llist_element *ne, const void *p);
 int xdebug_llist_remove(xdebug_llist *l, xdebug_llist_element *e, void *user);
 int xdebug_llist_remove_next(xdebug_llist *l, xdebug_llist_element *e, void *user);
 xdebug_llist_element *xdebug_llist_jump(xdebug_llist *l, int where, int pos);
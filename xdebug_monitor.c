@@ -82,7 +82,7 @@ void xdebug_function_monitor_record(char *func_name, char *filename, int lineno
 	xdebug_monitored_function_entry *record;
 
 	record = xdebug_monitored_function_init(func_name, filename, lineno);
-	xdebug_llist_insert_next(XG(monitored_functions_found), XDEBUG_LLIST_TAIL(XG(monitored_functions_found)), record);
+	xdebug_llist_insert_element_next(XG(monitored_functions_found), XDEBUG_LLIST_TAIL(XG(monitored_functions_found)), &record->link, record);
 }
 
 PHP_FUNCTION(xdebug_start_function_monitor)
@@ -148,7 +148,7 @@ PHP_FUNCTION(xdebug_get_monitored_functions)
 
 	if (clear) {
 		xdebug_llist_destroy(XG(monitored_functions_found), NULL);
-		XG(monitored_functions_found) = xdebug_llist_alloc(xdebug_monitored_function_dtor);
+		XG(monitored_functions_found) = xdebug_llist_alloc_intrusive(xdebug_monitored_function_dtor, NULL);
 	}
 }
 /* }}} */
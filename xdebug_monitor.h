@@ -19,11 +19,15 @@
 #ifndef __HAVE_XDEBUG_MONITOR_H__
 #define __HAVE_XDEBUG_MONITOR_H__
 
+#include "xdebug_llist.h"
+
 typedef struct xdebug_monitored_function_entry
 {
 	char *func_name;
 	char *filename;
 	int   lineno;
+
+	xdebug_llist_element link; /* in XG(monitored_functions_found) */
 } xdebug_monitored_function_entry;
 
 void xdebug_monitored_function_dtor(void *dummy, void *elem);
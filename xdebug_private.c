@@ -17,60 +17,87 @@
  */
 
 #include "php_xdebug.h"
+#include "xdebug_mm.h"
 #include "xdebug_private.h"
 
 ZEND_EXTERN_MODULE_GLOBALS(xdebug)
 
-function_stack_entry *xdebug_get_stack_head(TSRMLS_D)
+function_stack_entry *xdebug_stack_frame_storage(unsigned int nr TSRMLS_DC)
 {
-	xdebug_llist_element *le;
+	unsigned int segment = nr / XDEBUG_STACK_SEGMENT_FRAMES;
+
+	if (segment >= XG(stack_segment_count)) {
+		function_stack_entry **segments;
+		unsigned int           count = XG(stack_segment_count) ? XG(stack_segment_count) * 2 : 4;
+		unsigned int           i;
+
+		while (count <= segment) {
+			count *= 2;
+		}
 
-	if (XG(stack)) {
-		if ((le = XDEBUG_LLIST_HEAD(XG(stack)))) {
-			return XDEBUG_LLIST_VALP(le);
-		} else {
+		segments = xdrealloc(XG(stack_segments), count * sizeof(function_stack_entry *));
+		if (!segments) {
+			return NULL;
+		}
+		for (i = XG(stack_segment_count); i < count; i++) {
+			segments[i] = NULL;
+		}
+		XG(stack_segments) = segments;
+		XG(stack_segment_count) = count;
+	}
+
+	if (!XG(stack_segments)[segment]) {
+		XG(stack_segments)[segment] = xdmalloc(XDEBUG_STACK_SEGMENT_FRAMES * sizeof(function_stack_entry));
+		if (!XG(stack_segments)[segment]) {
 			return NULL;
 		}
-	} else {
-		return NULL;
 	}
+
+	return XDEBUG_STACK_FRAME_AT(nr);
 }
 
-function_stack_entry *xdebug_get_stack_frame(int nr TSRMLS_DC)
+void xdebug_stack_frames_destroy(TSRMLS_D)
 {
-	xdebug_llist_element *le;
+	unsigned int i;
 
-	if (!XG(stack)) {
-		return NULL;
+	for (i = 0; i < XG(stack_segment_count); i++) {
+		if (XG(stack_segments)[i]) {
+			xdfree(XG(stack_segments)[i]);
+		}
+	}
+	if (XG(stack_segments)) {
+		xdfree(XG(stack_segments));
 	}
 
-	if (!(le = XDEBUG_LLIST_TAIL(XG(stack)))) {
-		return NULL;
+	XG(stack_segments) = NULL;
+	XG(stack_segment_count) = 0;
+}
+
+function_stack_entry *xdebug_get_stack_head(TSRMLS_D)
+{
+	if (XG(stack) && XG(stack)->size) {
+		return XDEBUG_STACK_FRAME_AT(0);
 	}
 
-	while (nr) {
-		nr--;
-		le = XDEBUG_LLIST_PREV(le);
-		if (!le) {
-			return NULL;
-		}
+	return NULL;
+}
+
+function_stack_entry *xdebug_get_stack_frame(int nr TSRMLS_DC)
+{
+	if (!XG(stack) || nr < 0 || (size_t) nr >= XG(stack)->size) {
+		return NULL;
 	}
-	return XDEBUG_LLIST_VALP(le);
+
+	return XDEBUG_STACK_FRAME_AT(XG(stack)->size - 1 - nr);
 }
 
 function_stack_entry *xdebug_get_stack_tail(TSRMLS_D)
 {
-	xdebug_llist_element *le;
-
-	if (XG(stack)) {
-		if ((le = XDEBUG_LLIST_TAIL(XG(stack)))) {
-			return XDEBUG_LLIST_VALP(le);
-		} else {
-			return NULL;
-		}
-	} else {
-		return NULL;
+	if (XG(stack) && XG(stack)->size) {
+		return XDEBUG_STACK_FRAME_AT(XG(stack)->size - 1);
 	}
+
+	return NULL;
 }
 
 static void xdebug_used_var_hash_from_llist_dtor(void *data)
@@ -73,6 +73,9 @@ typedef struct xdebug_var {
 #define XDEBUG_JIT           1
 #define XDEBUG_REQ           2
 
+#define XDEBUG_PROFILER_INSTRUMENT 0
+#define XDEBUG_PROFILER_SAMPLE     1
+
 #define XDEBUG_BREAK         1
 #define XDEBUG_STEP          2
 
@@ -144,7 +147,12 @@ typedef struct _xdebug_call_entry {
 	char       *filename;
 	char       *function;
 	int         lineno;
-	double      time_taken;
+	uint64_t    time_taken;
+	long        memory_inclusive;
+	long        memory_self;
+	long        peak;
+
+	xdebug_llist_element link; /* in the caller's profile.call_list */
 } xdebug_call_entry;
 
 typedef struct xdebug_aggregate_entry {
@@ -153,15 +161,42 @@ typedef struct xdebug_aggregate_entry {
 	char       *function;
 	int         lineno;
 	int         call_count;
-	double      time_own;
-	double      time_inclusive;
+	uint64_t    time_own;
+	uint64_t    time_inclusive;
 	HashTable  *call_list;
 } xdebug_aggregate_entry;
 
+/* One node of the calling context tree (xdebug.profiler_call_paths): a
+ * function as called through one particular chain of callers, with the
+ * totals of all those calls */
+typedef struct _xdebug_path_node {
+	unsigned int  id;
+	int           user_defined;
+	char         *filename; /* interned */
+	char         *funcname; /* interned */
+	int           lineno;
+	int           call_lineno; /* of the first call, in the parent */
+	unsigned long calls;
+	uint64_t      time_own;
+	uint64_t      time_inclusive;
+	long          memory_inclusive;
+	long          memory_self;
+	long          peak;
+	size_t        path_len; /* only used while writing the tree out */
+
+	struct _xdebug_path_node *parent;
+	struct _xdebug_path_node *children;
+	struct _xdebug_path_node *next; /* sibling */
+} xdebug_path_node;
+
 typedef struct xdebug_profile {
-	double        time;
-	double        mark;
+	uint64_t      time;
+	uint64_t      mark;
+	uint64_t      children_time; /* inclusive time of finished callees */
 	long          memory;
+	long          peak; /* zend_memory_peak_usage() when the call started */
+	long          children_memory; /* memory growth of finished callees */
+	uint64_t      children_overhead; /* profiler time inside this call, for callees */
 	xdebug_llist *call_list;
 } xdebug_profile;
 
@@ -193,7 +228,7 @@ typedef struct _function_stack_entry {
 	/* tracing properties */
 	signed long  memory;
 	signed long  prev_memory;
-	double       time;
+	uint64_t     time;
 
 	/* profiling properties */
 	xdebug_profile profile;
@@ -201,6 +236,7 @@ typedef struct _function_stack_entry {
 		int   lineno;
 		char *filename;
 		char *funcname;
+		xdebug_path_node *node;
 	} profiler;
 
 	/* misc properties */
@@ -208,8 +244,22 @@ typedef struct _function_stack_entry {
 	struct _function_stack_entry *prev;
 	zend_op_array *op_array;
 	xdebug_aggregate_entry *aggr_entry;
+
+	xdebug_llist_element stack_link; /* in XG(stack) */
 } function_stack_entry;
 
+/* Frames live in fixed size segments indexed by their position on the stack,
+ * so the storage of a returned frame is reused by the next call at the same
+ * depth, and frames never move while being referenced. Frame 0 is the
+ * bottom of the stack; only positions below XG(stack)->size hold live
+ * frames. */
+#define XDEBUG_STACK_SEGMENT_FRAMES 64
+#define XDEBUG_STACK_FRAME_AT(__nr) \
+	(&XG(stack_segments)[(__nr) / XDEBUG_STACK_SEGMENT_FRAMES][(__nr) % XDEBUG_STACK_SEGMENT_FRAMES])
+
+function_stack_entry *xdebug_stack_frame_storage(unsigned int nr TSRMLS_DC);
+void xdebug_stack_frames_destroy(TSRMLS_D);
+
 function_stack_entry *xdebug_get_stack_head(TSRMLS_D);
 function_stack_entry *xdebug_get_stack_frame(int nr TSRMLS_DC);
 function_stack_entry *xdebug_get_stack_tail(TSRMLS_D);
@@ -22,16 +22,22 @@
 #include "php_xdebug.h"
 #include "Zend/zend_alloc.h"
 #include "xdebug_mm.h"
+#include "xdebug_aggr_shm.h"
 #include "xdebug_profiler.h"
 #include "xdebug_str.h"
 #include "xdebug_var.h"
 #include "usefulstuff.h"
+#include <limits.h>
+
 #ifdef PHP_WIN32
 #include <process.h>
 #endif
 
 ZEND_EXTERN_MODULE_GLOBALS(xdebug)
 
+/* Costs are written in units of 10ns, as "Time_(10ns)" */
+#define XDEBUG_PROFILER_COST(__nanos) ((unsigned long) ((__nanos) / 10))
+
 void xdebug_profile_aggr_call_entry_dtor(void *elem)
 {
 	xdebug_aggregate_entry *xae = (xdebug_aggregate_entry *) elem;
@@ -43,28 +49,26 @@ void xdebug_profile_aggr_call_entry_dtor(void *elem)
 	}
 }
 
-void xdebug_profile_call_entry_dtor(void *dummy, void *elem)
+/* Call lists are destroyed with the arena their entries come from as the
+ * context, which is the one the list itself was allocated from */
+void xdebug_profile_call_entry_dtor(void *arena, void *elem)
 {
-	xdebug_call_entry *ce = elem;
-
-	if (ce->function) {
-		xdfree(ce->function);
-	}
-	if (ce->filename) {
-		xdfree(ce->filename);
-	}
-	xdfree(ce);
+	/* The names are interned, so they are not owned by the entry */
+	xdebug_arena_free((xdebug_arena *) arena, elem, sizeof(xdebug_call_entry));
 }
 
-int xdebug_profiler_init(char *script_name TSRMLS_DC)
+/* Opens the file named by xdebug.profiler_output_dir/_name, and remembers its
+ * name for xdebug_get_profiler_filename() */
+FILE *xdebug_profiler_open_file(char *script_name, char *extension TSRMLS_DC)
 {
 	char *filename = NULL, *fname = NULL;
+	FILE *fp;
 
 	if (!strlen(XG(profiler_output_name)) ||
 		xdebug_format_output_filename(&fname, XG(profiler_output_name), script_name) <= 0
 	) {
 		/* Invalid or empty xdebug.profiler_output_name */
-		return FAILURE;
+		return NULL;
 	}
 	if (IS_SLASH(XG(profiler_output_dir)[strlen(XG(profiler_output_dir)) - 1])) {
 		filename = xdebug_sprintf("%s%s", XG(profiler_output_dir), fname);
@@ -74,46 +78,78 @@ int xdebug_profiler_init(char *script_name TSRMLS_DC)
 	xdfree(fname);
 
 	if (XG(profiler_append)) {
-		XG(profile_file) = xdebug_fopen(filename, "a", NULL, &XG(profile_filename));
+		fp = xdebug_fopen_output(filename, "a", extension, &XG(profile_filename));
 	} else {
-		XG(profile_file) = xdebug_fopen(filename, "w", NULL, &XG(profile_filename));
+		fp = xdebug_fopen_output(filename, "w", extension, &XG(profile_filename));
 	}
 	xdfree(filename);
 
+	return fp;
+}
+
+static void xdebug_profiler_calibrate(TSRMLS_D);
+
+int xdebug_profiler_init(char *script_name TSRMLS_DC)
+{
+	xdebug_clock_calibrate(&xdebug_global_clock);
+	XG(profile_internal_filename) = xdebug_intern_str(&XG(interned_strings), "php:internal");
+
+	/* Calibrated once for each of the two ways calls are recorded */
+	if (XG(profiler_overhead_compensation) && XG(profiler_calibrated) != (XG(profiler_call_paths) ? 2 : 1)) {
+		xdebug_profiler_calibrate(TSRMLS_C);
+	}
+
+	XG(profile_file) = xdebug_profiler_open_file(script_name, NULL TSRMLS_CC);
 	if (!XG(profile_file)) {
 		return FAILURE;
 	}
+	XG(profile_pid) = (long) getpid();
 	if (XG(profiler_append)) {
 		fprintf(XG(profile_file), "\n==== NEW PROFILING FILE ==============================================\n");
 	}
 	fprintf(XG(profile_file), "version: 1\ncreator: xdebug %s (PHP %s)\n", XDEBUG_VERSION, PHP_VERSION);
-	fprintf(XG(profile_file), "cmd: %s\npart: 1\npositions: line\n\n", script_name);
-	fprintf(XG(profile_file), "events: Time\n\n");
+	fprintf(XG(profile_file), "cmd: %s\npart: 1\npositions: line\n", script_name);
+	fprintf(
+		XG(profile_file), "desc: Overhead per call: %lu ns inside, %lu ns outside, %s\n\n",
+		(unsigned long) XG(profiler_overhead_inner), (unsigned long) XG(profiler_overhead_outer),
+		XG(profiler_overhead_compensation) ? "subtracted" : "not subtracted"
+	);
+	fprintf(XG(profile_file), "events: Time_(10ns) Memory_Inclusive Memory_Self Peak\n\n");
 	fflush(XG(profile_file));
+
+	if (XG(profiler_call_paths)) {
+		if (XG(profile_paths)) {
+			xdebug_hash_destroy(XG(profile_paths));
+		}
+		XG(profile_paths) = xdebug_hash_alloc(256, NULL);
+		XG(profile_path_root) = xdebug_arena_malloc(&XG(request_arena), sizeof(xdebug_path_node));
+		memset(XG(profile_path_root), 0, sizeof(xdebug_path_node));
+		XG(profile_last_path_id) = 0;
+	}
 	return SUCCESS;
 }
 
 void xdebug_profiler_deinit(TSRMLS_D)
 {
 	function_stack_entry *fse;
-	xdebug_llist_element *le;
+	size_t                k;
 
-	for (le = XDEBUG_LLIST_TAIL(XG(stack)); le != NULL; le = XDEBUG_LLIST_PREV(le)) {
-		fse = XDEBUG_LLIST_VALP(le);
+	for (k = XG(stack)->size; k > 0; k--) {
+		fse = XDEBUG_STACK_FRAME_AT(k - 1);
 		xdebug_profiler_function_end(fse TSRMLS_CC);
 	}
 }
 
 static inline void xdebug_profiler_function_push(function_stack_entry *fse)
 {
-	fse->profile.time += xdebug_get_utime();
+	fse->profile.time += xdebug_get_nanotime();
 	fse->profile.time -= fse->profile.mark;
 	fse->profile.mark = 0;
 }
 
 void xdebug_profiler_function_continue(function_stack_entry *fse)
 {
-	fse->profile.mark = xdebug_get_utime();
+	fse->profile.mark = xdebug_get_nanotime();
 }
 
 void xdebug_profiler_function_pause(function_stack_entry *fse)
@@ -121,32 +157,124 @@ void xdebug_profiler_function_pause(function_stack_entry *fse)
 	xdebug_profiler_function_push(fse);
 }
 
-static char* get_filename_ref(char *name TSRMLS_DC)
+/* Writes out everything that was buffered so far. A child forked with
+ * pcntl_fork() inherits the file as well as whatever was still buffered, which
+ * the parent writes out itself, so a child drops it instead of writing it (and
+ * everything it records later) into the parent's file a second time. */
+static void xdebug_profiler_write_buffer(TSRMLS_D)
+{
+	if (XG(profile_buffer).l > 0 && XG(profile_pid) == (long) getpid()) {
+		fwrite(XG(profile_buffer).d, 1, XG(profile_buffer).l, XG(profile_file));
+		fflush(XG(profile_file));
+	}
+	XG(profile_buffer).l = 0;
+}
+
+void xdebug_profiler_flush(TSRMLS_D)
 {
-	long nr;
+	if (XG(profile_file)) {
+		xdebug_profiler_write_buffer(TSRMLS_C);
+	}
+}
 
-	if (xdebug_hash_find(XG(profile_filename_refs), name, strlen(name), (void*) &nr)) {
-		return xdebug_sprintf("(%d)", nr);
-	} else {
-		XG(profile_last_filename_ref)++;
-		xdebug_hash_add(XG(profile_filename_refs), name, strlen(name), (void*) (size_t) XG(profile_last_filename_ref));
-		return xdebug_sprintf("(%d) %s", XG(profile_last_filename_ref), name);
+/* Forgets all name references handed out so far, by moving every interned
+ * string's cached ones out of date at once */
+void xdebug_profiler_reset_refs(TSRMLS_D)
+{
+	XG(profile_refs_generation)++;
+	if (XG(profile_refs_generation) == 0) {
+		XG(profile_refs_generation) = 1;
+	}
+	XG(profile_last_filename_ref) = 0;
+	XG(profile_last_functionname_ref) = 0;
+}
+
+static xdebug_interned_string *profiler_refs(char *name TSRMLS_DC)
+{
+	xdebug_interned_string *s = XDEBUG_INTERNED(name);
+
+	if (s->refs_generation != XG(profile_refs_generation)) {
+		s->refs_generation = XG(profile_refs_generation);
+		s->filename_ref = 0;
+		s->functionname_ref[0] = 0;
+		s->functionname_ref[1] = 0;
 	}
+	return s;
 }
 
-static char* get_functionname_ref(char *name TSRMLS_DC)
+/* Both take interned names and add "<key>=(nr)" to the buffer, followed by
+ * the name the first time it is seen. The number is kept on the interned
+ * string, so a name that was seen before costs no lookup. */
+static void add_filename_ref(xdebug_str *out, char *key, char *name TSRMLS_DC)
 {
-	long nr;
+	xdebug_interned_string *s = profiler_refs(name TSRMLS_CC);
 
-	if (xdebug_hash_find(XG(profile_functionname_refs), name, strlen(name), (void*) &nr)) {
-		return xdebug_sprintf("(%d)", nr);
+	xdebug_str_add(out, key, 0);
+	if (s->filename_ref) {
+		xdebug_str_addl(out, "=(", 2, 0);
+		xdebug_str_add_long(out, s->filename_ref);
+		xdebug_str_addl(out, ")\n", 2, 0);
 	} else {
-		XG(profile_last_functionname_ref)++;
-		xdebug_hash_add(XG(profile_functionname_refs), name, strlen(name), (void*) (size_t) XG(profile_last_functionname_ref));
-		return xdebug_sprintf("(%d) %s", XG(profile_last_functionname_ref), name);
+		s->filename_ref = ++XG(profile_last_filename_ref);
+		xdebug_str_add_fmt(out, "=(%d) %s\n", s->filename_ref, name);
 	}
 }
 
+/* Internal functions are shown as "php::name", which gets its own reference */
+static void add_functionname_ref(xdebug_str *out, char *key, char *name, int internal TSRMLS_DC)
+{
+	xdebug_interned_string *s = profiler_refs(name TSRMLS_CC);
+	int                    *ref = &s->functionname_ref[internal ? 1 : 0];
+
+	xdebug_str_add(out, key, 0);
+	if (*ref) {
+		xdebug_str_addl(out, "=(", 2, 0);
+		xdebug_str_add_long(out, *ref);
+		xdebug_str_addl(out, ")\n", 2, 0);
+	} else {
+		*ref = ++XG(profile_last_functionname_ref);
+		xdebug_str_add_fmt(out, "=(%d) %s%s\n", *ref, internal ? "php::" : "", name);
+	}
+}
+
+/* KCachegrind only takes costs that are not negative, so a call that freed
+ * more than it allocated is written as not having grown memory at all */
+static inline void add_memory_cost(xdebug_str *out, long memory)
+{
+	xdebug_str_add_long(out, memory > 0 ? memory : 0);
+}
+
+/* "<line> <time> <memory inclusive> <memory self> <peak>\n". Memory is in
+ * bytes, and the growth of zend_memory_usage() during the call. Peak is how
+ * much the request's peak memory usage went up during the call. */
+static void add_cost_line(xdebug_str *out, int lineno, uint64_t time, long memory_inclusive, long memory_self, long peak)
+{
+	xdebug_str_add_long(out, lineno);
+	xdebug_str_addl(out, " ", 1, 0);
+	xdebug_str_add_ulong(out, XDEBUG_PROFILER_COST(time));
+	xdebug_str_addl(out, " ", 1, 0);
+	add_memory_cost(out, memory_inclusive);
+	xdebug_str_addl(out, " ", 1, 0);
+	add_memory_cost(out, memory_self);
+	xdebug_str_addl(out, " ", 1, 0);
+	xdebug_str_add_long(out, peak);
+	xdebug_str_addl(out, "\n", 1, 0);
+}
+
+/* "summary: ..." with the totals of every event */
+static void add_summary_line(xdebug_str *out, uint64_t time, long memory, long peak)
+{
+	xdebug_str_add(out, "\nsummary: ", 0);
+	xdebug_str_add_ulong(out, XDEBUG_PROFILER_COST(time));
+	xdebug_str_addl(out, " ", 1, 0);
+	add_memory_cost(out, memory);
+	xdebug_str_addl(out, " ", 1, 0);
+	add_memory_cost(out, memory);
+	xdebug_str_addl(out, " ", 1, 0);
+	xdebug_str_add_long(out, peak);
+	xdebug_str_addl(out, "\n\n", 2, 0);
+}
+
 void xdebug_profiler_add_function_details_user(function_stack_entry *fse, zend_op_array *op_array TSRMLS_DC)
 {
 	char *tmp_fname, *tmp_name;
@@ -176,12 +304,11 @@ void xdebug_profiler_add_function_details_user(function_stack_entry *fse, zend_o
 	}
 
 	if (op_array && op_array->filename) {
-		fse->profiler.filename = xdstrdup((char*) STR_NAME_VAL(op_array->filename));
+		fse->profiler.filename = xdebug_intern_str(&XG(interned_strings), (char*) STR_NAME_VAL(op_array->filename));
 	} else {
-		fse->profiler.filename = xdstrdup(fse->filename);
+		fse->profiler.filename = fse->filename;
 	}
-	fse->profiler.funcname = xdstrdup(tmp_name);
-	xdfree(tmp_name);
+	fse->profiler.funcname = xdebug_intern_take(&XG(interned_strings), tmp_name);
 }
 
 void xdebug_profiler_add_function_details_internal(function_stack_entry *fse TSRMLS_DC)
@@ -208,133 +335,438 @@ void xdebug_profiler_add_function_details_internal(function_stack_entry *fse TSR
 		fse->profiler.lineno = 1;
 	}
 
-	fse->profiler.filename = xdstrdup(fse->filename);
-	fse->profiler.funcname = xdstrdup(tmp_name);
+	fse->profiler.filename = fse->filename;
+	fse->profiler.funcname = xdebug_intern_take(&XG(interned_strings), tmp_name);
+}
 
-	xdfree(tmp_name);
+/* Finds, or adds, the child of 'parent' for the function of 'fse' */
+static xdebug_path_node *xdebug_profiler_path_child(xdebug_path_node *parent, function_stack_entry *fse TSRMLS_DC)
+{
+	xdebug_path_node *node;
+	unsigned int      key[2];
+
+	key[0] = parent->id;
+	key[1] = (XDEBUG_INTERNED_ID(fse->profiler.funcname) << 1) | (fse->user_defined == XDEBUG_INTERNAL ? 1 : 0);
+
+	if (xdebug_hash_find(XG(profile_paths), (char *) key, sizeof(key), (void *) &node)) {
+		return node;
+	}
+
+	node = xdebug_arena_malloc(&XG(request_arena), sizeof(xdebug_path_node));
+	memset(node, 0, sizeof(xdebug_path_node));
+	node->id = ++XG(profile_last_path_id);
+	node->user_defined = fse->user_defined;
+	node->filename = fse->profiler.filename;
+	node->funcname = fse->profiler.funcname;
+	node->lineno = fse->profiler.lineno;
+	node->call_lineno = fse->lineno;
+	node->parent = parent;
+	node->next = parent->children;
+	parent->children = node;
+
+	xdebug_hash_add(XG(profile_paths), (char *) key, sizeof(key), node);
+
+	return node;
 }
 
 void xdebug_profiler_function_begin(function_stack_entry *fse TSRMLS_DC)
 {
 	fse->profile.time = 0;
-	fse->profile.mark = xdebug_get_utime();
+	fse->profile.children_time = 0;
+	fse->profile.children_memory = 0;
+	fse->profile.children_overhead = 0;
+	fse->profile.peak = zend_memory_peak_usage(0 TSRMLS_CC);
+
+	if (XG(profile_path_root)) {
+		fse->profiler.node = xdebug_profiler_path_child(
+			fse->prev && fse->prev->profiler.node ? fse->prev->profiler.node : XG(profile_path_root),
+			fse TSRMLS_CC
+		);
+	}
+
+	fse->profile.mark = xdebug_get_nanotime();
+}
+
+static void xdebug_profiler_update_aggregates(function_stack_entry *fse, uint64_t time_own, uint64_t time_inclusive TSRMLS_DC)
+{
+	xdebug_aggr_shm_slot   *shared_slot;
+	xdebug_interned_string *funcname;
+	char                   *filename;
+
+	if (XG(profiler_calibrating)) {
+		return;
+	}
+
+	if (xdebug_aggr_shm_enabled()) {
+		/* Shared with every other process of the pool. The slot is kept on
+		 * the interned function name, so that calls from the same file and
+		 * line don't hash the names again. That includes the overflow slot
+		 * of a full table, so it isn't probed on every call either. */
+		funcname = XDEBUG_INTERNED(fse->profiler.funcname);
+		filename = fse->user_defined == XDEBUG_INTERNAL ? XG(profile_internal_filename) : fse->profiler.filename;
+		shared_slot = funcname->aggr_shm_slot;
+		if (
+			!shared_slot || funcname->aggr_shm_filename != filename ||
+			funcname->aggr_shm_lineno != fse->profiler.lineno
+		) {
+			shared_slot = xdebug_aggr_shm_find(filename, fse->profiler.funcname, fse->profiler.lineno);
+			funcname->aggr_shm_slot = shared_slot;
+			funcname->aggr_shm_filename = filename;
+			funcname->aggr_shm_lineno = fse->profiler.lineno;
+		}
+		if (shared_slot) {
+			xdebug_aggr_shm_add(shared_slot, time_own, time_inclusive);
+		}
+	} else if (XG(profiler_aggregate)) {
+		fse->aggr_entry->call_count++;
+		fse->aggr_entry->time_own += time_own;
+		fse->aggr_entry->time_inclusive += time_inclusive;
+	}
+}
+
+static void add_path_name(xdebug_str *out, xdebug_path_node *node)
+{
+	if (node->user_defined == XDEBUG_INTERNAL) {
+		xdebug_str_addl(out, "php::", 5, 0);
+	}
+	xdebug_str_add(out, node->funcname, 0);
+}
+
+/* Writes the calling context tree as cachegrind records, one for every path
+ * with its callees, and as folded stacks ("{main};foo;bar <cost>") to a file
+ * next to it. The tree is walked without recursion, as it is as deep as the
+ * deepest stack of the request. */
+static void xdebug_profiler_write_paths(TSRMLS_D)
+{
+	xdebug_str        *out = &XG(profile_buffer);
+	xdebug_str         folded = XDEBUG_STR_INITIALIZER;
+	xdebug_str         path = XDEBUG_STR_INITIALIZER;
+	xdebug_path_node  *node, *child;
+	FILE              *folded_file;
+	char              *folded_name;
+
+	node = XG(profile_path_root)->children;
+	while (node) {
+		if (node->user_defined == XDEBUG_INTERNAL) {
+			add_filename_ref(out, "fl", XG(profile_internal_filename) TSRMLS_CC);
+			add_functionname_ref(out, "fn", node->funcname, 1 TSRMLS_CC);
+		} else {
+			add_filename_ref(out, "fl", node->filename TSRMLS_CC);
+			add_functionname_ref(out, "fn", node->funcname, 0 TSRMLS_CC);
+		}
+		if (node->parent == XG(profile_path_root) && strcmp(node->funcname, "{main}") == 0) {
+			add_summary_line(out, node->time_inclusive, node->memory_inclusive, node->peak);
+		}
+		add_cost_line(out, node->lineno, node->time_own, node->memory_inclusive, node->memory_self, node->peak);
+
+		for (child = node->children; child; child = child->next) {
+			if (child->user_defined == XDEBUG_INTERNAL) {
+				add_filename_ref(out, "cfl", XG(profile_internal_filename) TSRMLS_CC);
+				add_functionname_ref(out, "cfn", child->funcname, 1 TSRMLS_CC);
+			} else {
+				add_filename_ref(out, "cfl", child->filename TSRMLS_CC);
+				add_functionname_ref(out, "cfn", child->funcname, 0 TSRMLS_CC);
+			}
+			xdebug_str_add_fmt(out, "calls=%lu 0 0\n", child->calls);
+			add_cost_line(out, child->call_lineno, child->time_inclusive, child->memory_inclusive, child->memory_self, child->peak);
+		}
+		xdebug_str_addl(out, "\n", 1, 0);
+
+		if (XG(profile_buffer).l >= XG(profiler_buffer_size)) {
+			xdebug_profiler_write_buffer(TSRMLS_C);
+		}
+
+		/* The folded name of a node is its parent's, plus its own */
+		path.l = (long) node->parent->path_len;
+		if (path.l > 0) {
+			xdebug_str_addl(&path, ";", 1, 0);
+		}
+		add_path_name(&path, node);
+		node->path_len = path.l;
+
+		if (node->time_own > 0) {
+			xdebug_str_addl(&folded, path.d, path.l, 0);
+			xdebug_str_addl(&folded, " ", 1, 0);
+			xdebug_str_add_ulong(&folded, XDEBUG_PROFILER_COST(node->time_own));
+			xdebug_str_addl(&folded, "\n", 1, 0);
+		}
+
+		/* Depth first: children, then siblings, then the parent's siblings */
+		if (node->children) {
+			node = node->children;
+			continue;
+		}
+		while (node && !node->next) {
+			node = node->parent;
+			if (node == XG(profile_path_root)) {
+				node = NULL;
+			}
+		}
+		if (node) {
+			node = node->next;
+		}
+	}
+	xdebug_profiler_write_buffer(TSRMLS_C);
+
+	/* Compressed like the profile, so "x.gz" goes with "x.folded.gz" */
+	folded_name = xdstrdup(XG(profile_filename));
+	folded_file = xdebug_fopen_output(folded_name, XG(profiler_append) ? "a" : "w", "folded", NULL);
+	xdfree(folded_name);
+	if (folded_file) {
+		if (folded.l > 0) {
+			fwrite(folded.d, 1, folded.l, folded_file);
+		}
+		fclose(folded_file);
+	}
+
+	xdebug_str_dtor(folded);
+	xdebug_str_dtor(path);
+}
+
+static void xdebug_profiler_path_end(function_stack_entry *fse, long memory_inclusive, long peak TSRMLS_DC)
+{
+	xdebug_path_node *node = fse->profiler.node;
+	uint64_t          time_inclusive = fse->profile.time;
+	uint64_t          time_own;
+
+	if (fse->prev) {
+		fse->prev->profile.children_time += time_inclusive;
+		fse->prev->profile.children_memory += memory_inclusive;
+	}
+	time_own = time_inclusive - (fse->profile.children_time < time_inclusive ? fse->profile.children_time : time_inclusive);
+
+	if (node) {
+		node->calls++;
+		node->time_own += time_own;
+		node->time_inclusive += time_inclusive;
+		node->memory_inclusive += memory_inclusive;
+		node->memory_self += memory_inclusive - fse->profile.children_memory;
+		node->peak += peak;
+	}
+	xdebug_profiler_update_aggregates(fse, time_own, time_inclusive TSRMLS_CC);
+
+	if (fse->function.function && strcmp(fse->function.function, "{main}") == 0) {
+		XG(profiler_enabled) = 0;
+		xdebug_profiler_write_paths(TSRMLS_C);
+	}
+}
+
+/* Takes the profiler's own time out of a call's time: the part of it that
+ * is inside every call, and all of it for the calls made from this one */
+static void xdebug_profiler_compensate(function_stack_entry *fse TSRMLS_DC)
+{
+	uint64_t overhead;
+
+	if (!XG(profiler_overhead_compensation)) {
+		return;
+	}
+
+	overhead = XG(profiler_overhead_inner) + fse->profile.children_overhead;
+	fse->profile.time -= overhead < fse->profile.time ? overhead : fse->profile.time;
+	if (fse->prev) {
+		fse->prev->profile.children_overhead += overhead + XG(profiler_overhead_outer);
+	}
 }
 
 void xdebug_profiler_function_end(function_stack_entry *fse TSRMLS_DC)
 {
 	xdebug_llist_element *le;
+	xdebug_str           *out = &XG(profile_buffer);
+	int                   main_ended = 0;
+	uint64_t              time_inclusive;
+	long                  memory_inclusive, memory_self, peak;
+
+	xdebug_profiler_function_push(fse);
+	xdebug_profiler_compensate(fse TSRMLS_CC);
+
+	/* Both only read counters of the memory manager */
+	memory_inclusive = zend_memory_usage(0 TSRMLS_CC) - fse->memory;
+	peak = zend_memory_peak_usage(0 TSRMLS_CC) - fse->profile.peak;
+
+	/* Calls are only added up in the tree, and written out at the end */
+	if (XG(profile_path_root)) {
+		xdebug_profiler_path_end(fse, memory_inclusive, peak TSRMLS_CC);
+		return;
+	}
 
 	if (fse->prev && !fse->prev->profile.call_list) {
-		fse->prev->profile.call_list = xdebug_llist_alloc(xdebug_profile_call_entry_dtor);
+		fse->prev->profile.call_list = xdebug_llist_alloc_intrusive(xdebug_profile_call_entry_dtor, &XG(request_arena));
 	}
 	if (!fse->profile.call_list) {
-		fse->profile.call_list = xdebug_llist_alloc(xdebug_profile_call_entry_dtor);
+		fse->profile.call_list = xdebug_llist_alloc_intrusive(xdebug_profile_call_entry_dtor, &XG(request_arena));
+	}
+
+	memory_self = memory_inclusive;
+	for (le = XDEBUG_LLIST_HEAD(fse->profile.call_list); le != NULL; le = XDEBUG_LLIST_NEXT(le))
+	{
+		memory_self -= ((xdebug_call_entry *) XDEBUG_LLIST_VALP(le))->memory_inclusive;
 	}
-	xdebug_profiler_function_push(fse);
 
 	if (fse->prev) {
-		xdebug_call_entry *ce = xdmalloc(sizeof(xdebug_call_entry));
-		ce->filename = xdstrdup(fse->profiler.filename);
-		ce->function = xdstrdup(fse->profiler.funcname);
+		xdebug_call_entry *ce = xdebug_arena_malloc(&XG(request_arena), sizeof(xdebug_call_entry));
+		ce->filename = fse->profiler.filename;
+		ce->function = fse->profiler.funcname;
 		ce->time_taken = fse->profile.time;
+		ce->memory_inclusive = memory_inclusive;
+		ce->memory_self = memory_self;
+		ce->peak = peak;
 		ce->lineno = fse->lineno;
 		ce->user_defined = fse->user_defined;
 
-		xdebug_llist_insert_next(fse->prev->profile.call_list, NULL, ce);
+		xdebug_llist_insert_element_next(fse->prev->profile.call_list, NULL, &ce->link, ce);
 	}
 
 	/* use previously created filename and funcname (or a reference to them) to show
 	 * time spend */
 	if (fse->user_defined == XDEBUG_INTERNAL) {
-		char *tmp_key = xdebug_sprintf("php::%s", fse->profiler.funcname);
-		char *fl_ref = NULL, *fn_ref = NULL;
-
-		fl_ref = get_filename_ref("php:internal" TSRMLS_CC);
-		fn_ref = get_functionname_ref(tmp_key TSRMLS_CC);
-
-		fprintf(XG(profile_file), "fl=%s\n", fl_ref);
-		fprintf(XG(profile_file), "fn=%s\n", fn_ref);
-
-		xdfree(fl_ref);
-		xdfree(fn_ref);
-		xdfree(tmp_key);
+		add_filename_ref(out, "fl", XG(profile_internal_filename) TSRMLS_CC);
+		add_functionname_ref(out, "fn", fse->profiler.funcname, 1 TSRMLS_CC);
 	} else {
-		char *fl_ref = NULL, *fn_ref = NULL;
-
-		fl_ref = get_filename_ref(fse->profiler.filename TSRMLS_CC);
-		fn_ref = get_functionname_ref(fse->profiler.funcname TSRMLS_CC);
-
-		fprintf(XG(profile_file), "fl=%s\n", fl_ref);
-		fprintf(XG(profile_file), "fn=%s\n", fn_ref);
-
-		xdfree(fl_ref);
-		xdfree(fn_ref);
+		add_filename_ref(out, "fl", fse->profiler.filename TSRMLS_CC);
+		add_functionname_ref(out, "fn", fse->profiler.funcname, 0 TSRMLS_CC);
 	}
 
 	if (fse->function.function && strcmp(fse->function.function, "{main}") == 0) {
-		fprintf(XG(profile_file), "\nsummary: %lu\n\n", (unsigned long) (fse->profile.time * 1000000));
+		add_summary_line(out, fse->profile.time, memory_inclusive, peak);
 		XG(profiler_enabled) = 0;
-	}
-	fflush(XG(profile_file));
-
-	/* update aggregate data */
-	if (XG(profiler_aggregate)) {
-		fse->aggr_entry->time_inclusive += fse->profile.time;
-		fse->aggr_entry->call_count++;
+		main_ended = 1;
 	}
 
 	/* Subtract time in calledfunction from time here */
+	time_inclusive = fse->profile.time;
 	for (le = XDEBUG_LLIST_HEAD(fse->profile.call_list); le != NULL; le = XDEBUG_LLIST_NEXT(le))
 	{
 		xdebug_call_entry *call_entry = XDEBUG_LLIST_VALP(le);
-		fse->profile.time -= call_entry->time_taken;
+		fse->profile.time -= call_entry->time_taken < fse->profile.time ? call_entry->time_taken : fse->profile.time;
 	}
-	fprintf(XG(profile_file), "%d %lu\n", fse->profiler.lineno, (unsigned long) (fse->profile.time * 1000000));
+	add_cost_line(out, fse->profiler.lineno, fse->profile.time, memory_inclusive, memory_self, peak);
 
 	/* update aggregate data */
-	if (XG(profiler_aggregate)) {
-		fse->aggr_entry->time_own += fse->profile.time;
-	}
+	xdebug_profiler_update_aggregates(fse, fse->profile.time, time_inclusive TSRMLS_CC);
 
 	/* dump call list */
 	for (le = XDEBUG_LLIST_HEAD(fse->profile.call_list); le != NULL; le = XDEBUG_LLIST_NEXT(le))
 	{
-		char *fl_ref = NULL, *fn_ref = NULL;
 		xdebug_call_entry *call_entry = XDEBUG_LLIST_VALP(le);
 
 		if (call_entry->user_defined == XDEBUG_INTERNAL) {
-			char *tmp_key = xdebug_sprintf("php::%s", call_entry->function);
-
-			fl_ref = get_filename_ref("php:internal" TSRMLS_CC);
-			fn_ref = get_functionname_ref(tmp_key TSRMLS_CC);
-
-			xdfree(tmp_key);
+			add_filename_ref(out, "cfl", XG(profile_internal_filename) TSRMLS_CC);
+			add_functionname_ref(out, "cfn", call_entry->function, 1 TSRMLS_CC);
 		} else {
-			fl_ref = get_filename_ref(call_entry->filename TSRMLS_CC);
-			fn_ref = get_functionname_ref(call_entry->function TSRMLS_CC);
+			add_filename_ref(out, "cfl", call_entry->filename TSRMLS_CC);
+			add_functionname_ref(out, "cfn", call_entry->function, 0 TSRMLS_CC);
 		}
 
-		fprintf(XG(profile_file), "cfl=%s\n", fl_ref);
-		fprintf(XG(profile_file), "cfn=%s\n", fn_ref);
-
-		xdfree(fl_ref);
-		xdfree(fn_ref);
+		xdebug_str_addl(out, "calls=1 0 0\n", 12, 0);
+		add_cost_line(out, call_entry->lineno, call_entry->time_taken, call_entry->memory_inclusive, call_entry->memory_self, call_entry->peak);
+	}
+	xdebug_str_addl(out, "\n", 1, 0);
 
-		fprintf(XG(profile_file), "calls=1 0 0\n");
-		fprintf(XG(profile_file), "%d %lu\n", call_entry->lineno, (unsigned long) (call_entry->time_taken * 1000000));
+	/* Records are only written out once xdebug.profiler_buffer_size bytes have
+	 * been collected, instead of flushing the file for every call. A size of 0
+	 * writes every record straight away. */
+	if (main_ended || XG(profile_buffer).l >= XG(profiler_buffer_size)) {
+		xdebug_profiler_write_buffer(TSRMLS_C);
 	}
-	fprintf(XG(profile_file), "\n");
-	fflush(XG(profile_file));
 }
 
 void xdebug_profiler_free_function_details(function_stack_entry *fse TSRMLS_DC)
 {
-	xdfree(fse->profiler.funcname);
-	xdfree(fse->profiler.filename);
+	/* Both names are interned, and freed at the end of the request */
 	fse->profiler.funcname = NULL;
 	fse->profiler.filename = NULL;
 }
 
+#define XDEBUG_PROFILER_CALIBRATION_ROUNDS 5
+#define XDEBUG_PROFILER_CALIBRATION_CALLS  200
+
+/* Profiles calls to a made up internal function, to find out how long the
+ * profiler's own work for a call takes. Of that, about one clock read falls
+ * between the two clock reads of the call, and the rest is charged to its
+ * caller. The fastest of a few rounds is used, as the others were
+ * interrupted. Work done by the rest of Xdebug for a call (creating the
+ * stack frame) is not included. */
+static void xdebug_profiler_calibrate(TSRMLS_D)
+{
+	function_stack_entry parent, child;
+	xdebug_str           saved_buffer = XG(profile_buffer);
+	xdebug_str           scratch = XDEBUG_STR_INITIALIZER;
+	xdebug_path_node    *saved_root = XG(profile_path_root);
+	xdebug_hash         *saved_paths = XG(profile_paths);
+	xdebug_path_node     scratch_root;
+	long                 saved_buffer_size = XG(profiler_buffer_size);
+	uint64_t             start, now, clock_cost = (uint64_t) -1, call_cost = (uint64_t) -1;
+	int                  round, i;
+
+	memset(&parent, 0, sizeof(function_stack_entry));
+	memset(&child, 0, sizeof(function_stack_entry));
+	child.prev = &parent;
+	child.user_defined = XDEBUG_INTERNAL;
+	child.function.type = XFUNC_NORMAL;
+	child.function.function = "{profiler calibration}";
+	child.filename = XG(profile_internal_filename);
+
+	/* Records go to a scratch buffer that is never written out */
+	XG(profile_buffer) = scratch;
+	XG(profiler_buffer_size) = LONG_MAX;
+	XG(profiler_calibrating) = 1;
+	if (XG(profiler_call_paths)) {
+		memset(&scratch_root, 0, sizeof(xdebug_path_node));
+		XG(profile_path_root) = &scratch_root;
+		XG(profile_paths) = xdebug_hash_alloc(16, NULL);
+	} else {
+		XG(profile_path_root) = NULL;
+	}
+
+	for (round = 0; round < XDEBUG_PROFILER_CALIBRATION_ROUNDS; round++) {
+		for (i = 0; i < XDEBUG_PROFILER_CALIBRATION_CALLS; i++) {
+			start = xdebug_get_nanotime();
+			now = xdebug_get_nanotime();
+			if (now - start < clock_cost) {
+				clock_cost = now - start;
+			}
+		}
+
+		start = xdebug_get_nanotime();
+		for (i = 0; i < XDEBUG_PROFILER_CALIBRATION_CALLS; i++) {
+			xdebug_profiler_add_function_details_internal(&child TSRMLS_CC);
+			xdebug_profiler_function_begin(&child TSRMLS_CC);
+			xdebug_profiler_function_end(&child TSRMLS_CC);
+			xdebug_profiler_free_function_details(&child TSRMLS_CC);
+			XG(profile_buffer).l = 0;
+		}
+		now = xdebug_get_nanotime();
+		if ((now - start) / XDEBUG_PROFILER_CALIBRATION_CALLS < call_cost) {
+			call_cost = (now - start) / XDEBUG_PROFILER_CALIBRATION_CALLS;
+		}
+
+		if (parent.profile.call_list) {
+			xdebug_llist_destroy(parent.profile.call_list, parent.profile.call_list->arena);
+			parent.profile.call_list = NULL;
+		}
+	}
+	if (child.profile.call_list) {
+		xdebug_llist_destroy(child.profile.call_list, child.profile.call_list->arena);
+	}
+
+	xdebug_str_dtor(XG(profile_buffer));
+	XG(profile_buffer) = saved_buffer;
+	XG(profiler_buffer_size) = saved_buffer_size;
+	if (XG(profiler_call_paths)) {
+		xdebug_hash_destroy(XG(profile_paths));
+	}
+	XG(profile_path_root) = saved_root;
+	XG(profile_paths) = saved_paths;
+	XG(profiler_calibrating) = 0;
+
+	/* The made up function must not keep the first name references */
+	xdebug_profiler_reset_refs(TSRMLS_C);
+
+	XG(profiler_overhead_inner) = clock_cost;
+	XG(profiler_overhead_outer) = call_cost > clock_cost ? call_cost - clock_cost : 0;
+	XG(profiler_calibrated) = XG(profiler_call_paths) ? 2 : 1;
+}
+
 #if PHP_VERSION_ID >= 70000
 static int xdebug_print_aggr_entry(zval *pDest, void *argument TSRMLS_DC)
 #else
@@ -346,9 +778,9 @@ static int xdebug_print_aggr_entry(void *pDest, void *argument TSRMLS_DC)
 
 	fprintf(fp, "fl=%s\n", xae->filename);
 	fprintf(fp, "fn=%s\n", xae->function);
-	fprintf(fp, "%d %lu\n", 0, (unsigned long) (xae->time_own * 1000000));
+	fprintf(fp, "%d %lu\n", 0, XDEBUG_PROFILER_COST(xae->time_own));
 	if (strcmp(xae->function, "{main}") == 0) {
-		fprintf(fp, "\nsummary: %lu\n\n", (unsigned long) (xae->time_inclusive * 1000000));
+		fprintf(fp, "\nsummary: %lu\n\n", XDEBUG_PROFILER_COST(xae->time_inclusive));
 	}
 	if (xae->call_list) {
 #if PHP_VERSION_ID >= 70000
@@ -357,7 +789,7 @@ static int xdebug_print_aggr_entry(void *pDest, void *argument TSRMLS_DC)
 		ZEND_HASH_FOREACH_PTR(xae->call_list, xae_call) {
 			fprintf(fp, "cfn=%s\n", (xae_call)->function);
 			fprintf(fp, "calls=%d 0 0\n", (xae_call)->call_count);
-			fprintf(fp, "%d %lu\n", (xae_call)->lineno, (unsigned long) ((xae_call)->time_inclusive * 1000000));
+			fprintf(fp, "%d %lu\n", (xae_call)->lineno, XDEBUG_PROFILER_COST((xae_call)->time_inclusive));
 		} ZEND_HASH_FOREACH_END();
 #else
 		xdebug_aggregate_entry **xae_call;
@@ -366,7 +798,7 @@ static int xdebug_print_aggr_entry(void *pDest, void *argument TSRMLS_DC)
 		while (zend_hash_get_current_data(xae->call_list, (void**)&xae_call) == SUCCESS) {
 			fprintf(fp, "cfn=%s\n", (*xae_call)->function);
 			fprintf(fp, "calls=%d 0 0\n", (*xae_call)->call_count);
-			fprintf(fp, "%d %lu\n", (*xae_call)->lineno, (unsigned long) ((*xae_call)->time_inclusive * 1000000));
+			fprintf(fp, "%d %lu\n", (*xae_call)->lineno, XDEBUG_PROFILER_COST((*xae_call)->time_inclusive));
 			zend_hash_move_forward(xae->call_list);
 		}
 #endif
@@ -377,6 +809,19 @@ static int xdebug_print_aggr_entry(void *pDest, void *argument TSRMLS_DC)
 	return ZEND_HASH_APPLY_KEEP;
 }
 
+static void xdebug_print_aggr_shm_entry(void *ctxt, const char *filename, const char *function, int lineno, uint64_t calls, uint64_t time_own, uint64_t time_inclusive)
+{
+	FILE *fp = (FILE *) ctxt;
+
+	fprintf(fp, "fl=%s\n", filename);
+	fprintf(fp, "fn=%s\n", function);
+	fprintf(fp, "%d %lu\n", lineno, XDEBUG_PROFILER_COST(time_own));
+	if (strcmp(function, "{main}") == 0) {
+		fprintf(fp, "\nsummary: %lu\n", XDEBUG_PROFILER_COST(time_inclusive));
+	}
+	fprintf(fp, "\n");
+}
+
 int xdebug_profiler_output_aggr_data(const char *prefix TSRMLS_DC)
 {
 	char *filename;
@@ -384,7 +829,7 @@ int xdebug_profiler_output_aggr_data(const char *prefix TSRMLS_DC)
 
 	fprintf(stderr, "in xdebug_profiler_output_aggr_data() with %d entries\n", zend_hash_num_elements(&XG(aggr_calls)));
 
-	if (zend_hash_num_elements(&XG(aggr_calls)) == 0) return SUCCESS;
+	if (!xdebug_aggr_shm_enabled() && zend_hash_num_elements(&XG(aggr_calls)) == 0) return SUCCESS;
 
 	if (prefix) {
 		filename = xdebug_sprintf("%s/cachegrind.out.aggregate.%s.%ld", XG(profiler_output_dir), prefix, getpid());
@@ -397,9 +842,15 @@ int xdebug_profiler_output_aggr_data(const char *prefix TSRMLS_DC)
 	if (!aggr_file) {
 		return FAILURE;
 	}
-	fprintf(aggr_file, "version: 0.9.6\ncmd: Aggregate\npart: 1\n\nevents: Time\n\n");
+	fprintf(aggr_file, "version: 0.9.6\ncmd: Aggregate\npart: 1\n\nevents: Time_(10ns)\n\n");
 	fflush(aggr_file);
-	zend_hash_apply_with_argument(&XG(aggr_calls), xdebug_print_aggr_entry, aggr_file TSRMLS_CC);
+	if (xdebug_aggr_shm_enabled()) {
+		/* The pool wide totals only; calls between functions are not kept */
+		fprintf(aggr_file, "# dropped calls: %lu\n\n", (unsigned long) xdebug_aggr_shm_dropped());
+		xdebug_aggr_shm_apply(xdebug_print_aggr_shm_entry, aggr_file);
+	} else {
+		zend_hash_apply_with_argument(&XG(aggr_calls), xdebug_print_aggr_entry, aggr_file TSRMLS_CC);
+	}
 	fclose(aggr_file);
 	fprintf(stderr, "wrote info for %d entries to %s\n", zend_hash_num_elements(&XG(aggr_calls)), filename);
 	return SUCCESS;
@@ -24,8 +24,11 @@
 #include "php_xdebug.h"
 #include "xdebug_private.h"
 
+FILE *xdebug_profiler_open_file(char *script_name, char *extension TSRMLS_DC);
 int xdebug_profiler_init(char *script_name TSRMLS_DC);
 void xdebug_profiler_deinit(TSRMLS_D);
+void xdebug_profiler_reset_refs(TSRMLS_D);
+void xdebug_profiler_flush(TSRMLS_D);
 int xdebug_profiler_output_aggr_data(const char *prefix TSRMLS_DC);
 
 void xdebug_profiler_add_function_details_user(function_stack_entry *fse, zend_op_array *op_array TSRMLS_DC);
@@ -35,7 +38,7 @@ void xdebug_profiler_free_function_details(function_stack_entry *fse TSRMLS_DC);
 void xdebug_profiler_function_begin(function_stack_entry *fse TSRMLS_DC);
 void xdebug_profiler_function_end(function_stack_entry *fse TSRMLS_DC);
 
-void xdebug_profile_call_entry_dtor(void *dummy, void *elem);
+void xdebug_profile_call_entry_dtor(void *arena, void *elem);
 void xdebug_profile_aggr_call_entry_dtor(void *elem);
 
 #endif
@@ -0,0 +1,390 @@
+/*
+   +----------------------------------------------------------------------+
+   | Xdebug                                                               |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2002-2016 Derick Rethans                               |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 1.0 of the Xdebug license,    |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available at through the world-wide-web at                           |
+   | http://xdebug.derickrethans.nl/license.php                           |
+   | If you did not receive a copy of the Xdebug license and are unable   |
+   | to obtain it through the world-wide-web, please send a note to       |
+   | xdebug@derickrethans.nl so we can mail you a copy immediately.       |
+   +----------------------------------------------------------------------+
+ */
+
+#include "php.h"
+#include "TSRM.h"
+#include "php_xdebug.h"
+#include "xdebug_hash.h"
+#include "xdebug_mm.h"
+#include "xdebug_profiler.h"
+#include "xdebug_sampler.h"
+#include "xdebug_str.h"
+
+ZEND_EXTERN_MODULE_GLOBALS(xdebug)
+
+volatile sig_atomic_t xdebug_sampler_fold_needed = 0;
+
+#ifdef XDEBUG_SAMPLER_SUPPORTED
+#include <errno.h>
+#include <time.h>
+
+#if PHP_VERSION_ID >= 70000
+# define XDEBUG_SAMPLE_NAME_VAL(n) (((zend_string *) (n))->val)
+#else
+# define XDEBUG_SAMPLE_NAME_VAL(n) ((const char *) (n))
+#endif
+
+static struct {
+	volatile sig_atomic_t active;
+	timer_t               timer;
+	struct sigaction      previous;
+
+	/* Filled by the signal handler. Everything else only touches them with
+	 * SIGPROF blocked. */
+	xdebug_sample_frame  *frames;
+	xdebug_sample        *samples;
+	unsigned int          frame_count;
+	unsigned int          sample_count;
+	unsigned long         dropped;
+
+	/* Folded stack -> number of samples */
+	xdebug_hash          *stacks;
+} sampler;
+
+/* Everything from here to the signal handler runs inside it, so it may only
+ * read memory and write to the preallocated buffers */
+static int xdebug_sample_add_frame(xdebug_sample_frame *frames, unsigned int *depth, const void *name, const void *scope, int kind)
+{
+	if (*depth == XDEBUG_SAMPLE_MAX_DEPTH) {
+		return 0;
+	}
+
+	frames[*depth].name = name;
+	frames[*depth].scope = scope;
+	frames[*depth].kind = kind;
+	(*depth)++;
+
+	return 1;
+}
+
+static void xdebug_sampler_take_sample(void)
+{
+	zend_execute_data   *ex;
+	zend_function       *func;
+	xdebug_sample       *sample;
+	xdebug_sample_frame *frames;
+	unsigned int         depth = 0;
+	int                  full = 0;
+
+	if (
+		sampler.sample_count == XDEBUG_SAMPLER_SAMPLES ||
+		sampler.frame_count + XDEBUG_SAMPLE_MAX_DEPTH > XDEBUG_SAMPLER_FRAMES
+	) {
+		sampler.dropped++;
+		xdebug_sampler_fold_needed = 1;
+		return;
+	}
+
+	/* Frames are only linked in once they are set up, so the chain is
+	 * consistent wherever the signal interrupts the engine. The innermost
+	 * frame comes first. */
+	frames = &sampler.frames[sampler.frame_count];
+	for (ex = EG(current_execute_data); ex && !full; ex = ex->prev_execute_data) {
+#if PHP_VERSION_ID >= 70000
+		func = ex->func;
+		if (!func) {
+			continue;
+		}
+		if (func->common.function_name) {
+			full = !xdebug_sample_add_frame(frames, &depth, func->common.function_name, func->common.scope ? func->common.scope->name : NULL, XDEBUG_SAMPLE_FUNCTION);
+		} else if (ZEND_USER_CODE(func->type)) {
+			full = !xdebug_sample_add_frame(frames, &depth, func->op_array.filename, NULL, XDEBUG_SAMPLE_FILE);
+		}
+#else
+		/* Internal functions don't get their own frame, but are set as the
+		 * function being called by the frame that calls them */
+		func = ex->function_state.function;
+		if (func && func->type == ZEND_INTERNAL_FUNCTION) {
+			full = !xdebug_sample_add_frame(frames, &depth, func->common.function_name, func->common.scope ? func->common.scope->name : NULL, XDEBUG_SAMPLE_FUNCTION);
+		}
+		if (!full && ex->op_array) {
+			if (ex->op_array->function_name) {
+				full = !xdebug_sample_add_frame(frames, &depth, ex->op_array->function_name, ex->op_array->scope ? ex->op_array->scope->name : NULL, XDEBUG_SAMPLE_FUNCTION);
+			} else {
+				full = !xdebug_sample_add_frame(frames, &depth, ex->op_array->filename, NULL, XDEBUG_SAMPLE_FILE);
+			}
+		}
+#endif
+	}
+
+	sample = &sampler.samples[sampler.sample_count];
+	sample->first_frame = sampler.frame_count;
+	sample->depth = depth;
+	sample->truncated = full;
+
+	sampler.frame_count += depth;
+	sampler.sample_count++;
+
+	if (
+		sampler.sample_count >= XDEBUG_SAMPLER_SAMPLES / 2 ||
+		sampler.frame_count >= XDEBUG_SAMPLER_FRAMES / 2
+	) {
+		xdebug_sampler_fold_needed = 1;
+	}
+}
+
+static void xdebug_sampler_signal_handler(int signo, siginfo_t *info, void *context)
+{
+	int saved_errno = errno;
+
+	if (info && info->si_code == SI_TIMER && info->si_value.sival_ptr == &sampler) {
+		if (sampler.active) {
+			xdebug_sampler_take_sample();
+		}
+		errno = saved_errno;
+		return;
+	}
+
+	/* Not ours: max_execution_time uses SIGPROF as well */
+	if (sampler.previous.sa_flags & SA_SIGINFO) {
+		sampler.previous.sa_sigaction(signo, info, context);
+	} else if (sampler.previous.sa_handler == SIG_DFL) {
+		signal(signo, SIG_DFL);
+		raise(signo);
+	} else if (sampler.previous.sa_handler != SIG_IGN) {
+		sampler.previous.sa_handler(signo);
+	}
+	errno = saved_errno;
+}
+
+static int xdebug_sampler_install_handler(void)
+{
+	struct sigaction sa;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_sigaction = xdebug_sampler_signal_handler;
+	sa.sa_flags = SA_SIGINFO | SA_RESTART;
+	sigemptyset(&sa.sa_mask);
+
+	return sigaction(SIGPROF, &sa, &sampler.previous) == 0;
+}
+
+/* set_time_limit() installs the engine's own SIGPROF handler again, which
+ * then becomes the one to pass other signals on to */
+void xdebug_sampler_reinstall_handler(void)
+{
+	struct sigaction current;
+
+	if (!sampler.active || sigaction(SIGPROF, NULL, &current) != 0) {
+		return;
+	}
+	if (!(current.sa_flags & SA_SIGINFO) || current.sa_sigaction != xdebug_sampler_signal_handler) {
+		xdebug_sampler_install_handler();
+	}
+}
+
+static void xdebug_sampler_free(void)
+{
+	xdfree(sampler.frames);
+	xdfree(sampler.samples);
+	sampler.frames = NULL;
+	sampler.samples = NULL;
+
+	if (sampler.stacks) {
+		xdebug_hash_destroy(sampler.stacks);
+		sampler.stacks = NULL;
+	}
+}
+
+int xdebug_sampler_start(char *script_name TSRMLS_DC)
+{
+	struct sigevent   sev;
+	struct itimerspec its;
+	long              interval = XG(profiler_sample_interval);
+
+	if (sampler.active) {
+		return SUCCESS;
+	}
+	if (interval <= 0) {
+		php_error(E_WARNING, "xdebug.profiler_sample_interval must be larger than 0");
+		return FAILURE;
+	}
+
+	XG(profile_file) = xdebug_profiler_open_file(script_name, "folded" TSRMLS_CC);
+	if (!XG(profile_file)) {
+		return FAILURE;
+	}
+
+	sampler.frames = xdmalloc(XDEBUG_SAMPLER_FRAMES * sizeof(xdebug_sample_frame));
+	sampler.samples = xdmalloc(XDEBUG_SAMPLER_SAMPLES * sizeof(xdebug_sample));
+	sampler.stacks = xdebug_hash_alloc(256, NULL);
+	sampler.frame_count = 0;
+	sampler.sample_count = 0;
+	sampler.dropped = 0;
+	xdebug_sampler_fold_needed = 0;
+
+	/* Counts CPU time, like ITIMER_PROF, but the signal carries a pointer
+	 * that tells it apart from the engine's own time limit */
+	memset(&sev, 0, sizeof(sev));
+	sev.sigev_notify = SIGEV_SIGNAL;
+	sev.sigev_signo = SIGPROF;
+	sev.sigev_value.sival_ptr = &sampler;
+	if (timer_create(CLOCK_PROCESS_CPUTIME_ID, &sev, &sampler.timer) != 0) {
+		goto failure;
+	}
+	if (!xdebug_sampler_install_handler()) {
+		timer_delete(sampler.timer);
+		goto failure;
+	}
+	sampler.active = 1;
+
+	its.it_interval.tv_sec = interval / 1000000;
+	its.it_interval.tv_nsec = (interval % 1000000) * 1000;
+	its.it_value = its.it_interval;
+	timer_settime(sampler.timer, 0, &its, NULL);
+
+	return SUCCESS;
+
+failure:
+	xdebug_sampler_free();
+	fclose(XG(profile_file));
+	XG(profile_file) = NULL;
+	return FAILURE;
+}
+
+int xdebug_sampler_active(void)
+{
+	return sampler.active;
+}
+
+/* Code outside of functions is named after its file, except for the script
+ * itself */
+static void xdebug_sampler_add_frame_name(xdebug_str *stack, xdebug_sample_frame *frame, int outermost)
+{
+	if (frame->kind == XDEBUG_SAMPLE_FILE) {
+		if (outermost) {
+			xdebug_str_addl(stack, "{main}", 6, 0);
+		} else {
+			xdebug_str_add_fmt(stack, "include(%s)", frame->name ? XDEBUG_SAMPLE_NAME_VAL(frame->name) : "?");
+		}
+		return;
+	}
+
+	if (frame->scope) {
+		xdebug_str_add(stack, (char *) XDEBUG_SAMPLE_NAME_VAL(frame->scope), 0);
+		xdebug_str_addl(stack, "::", 2, 0);
+	}
+	xdebug_str_add(stack, (char *) XDEBUG_SAMPLE_NAME_VAL(frame->name), 0);
+}
+
+/* Turns the buffered samples into "outer;...;inner" keys, and counts them.
+ * Runs at safe points, when the names can be read. */
+void xdebug_sampler_fold(TSRMLS_D)
+{
+	sigset_t     sigprof, old;
+	xdebug_str   stack = XDEBUG_STR_INITIALIZER;
+	unsigned int i, k;
+
+	if (!sampler.stacks) {
+		return;
+	}
+
+	sigemptyset(&sigprof);
+	sigaddset(&sigprof, SIGPROF);
+	sigprocmask(SIG_BLOCK, &sigprof, &old);
+
+	for (i = 0; i < sampler.sample_count; i++) {
+		xdebug_sample       *sample = &sampler.samples[i];
+		xdebug_sample_frame *frames = &sampler.frames[sample->first_frame];
+		void                *count;
+
+		if (sample->depth == 0) {
+			continue;
+		}
+
+		stack.l = 0;
+		if (sample->truncated) {
+			xdebug_str_addl(&stack, "[truncated];", 12, 0);
+		}
+		for (k = sample->depth; k > 0; k--) {
+			xdebug_sampler_add_frame_name(&stack, &frames[k - 1], k == sample->depth && !sample->truncated);
+			if (k > 1) {
+				xdebug_str_addl(&stack, ";", 1, 0);
+			}
+		}
+
+		if (!xdebug_hash_find(sampler.stacks, stack.d, stack.l, &count)) {
+			count = NULL;
+		}
+		xdebug_hash_update(sampler.stacks, stack.d, stack.l, (void *) ((size_t) count + 1));
+	}
+
+	sampler.sample_count = 0;
+	sampler.frame_count = 0;
+	xdebug_sampler_fold_needed = 0;
+
+	sigprocmask(SIG_SETMASK, &old, NULL);
+
+	xdebug_str_dtor(stack);
+}
+
+static void xdebug_sampler_write_stack(void *fp, xdebug_hash_element *he)
+{
+	fwrite(he->key.value.str.val, 1, he->key.value.str.len, (FILE *) fp);
+	fprintf((FILE *) fp, " %lu\n", (unsigned long) (size_t) he->ptr);
+}
+
+void xdebug_sampler_stop(TSRMLS_D)
+{
+	if (!sampler.active) {
+		return;
+	}
+
+	/* A signal that is still pending gets delivered when timer_delete()
+	 * returns, so the handler has to stay until then */
+	sampler.active = 0;
+	timer_delete(sampler.timer);
+	sigaction(SIGPROF, &sampler.previous, NULL);
+
+	xdebug_sampler_fold(TSRMLS_C);
+
+	if (XG(profile_file)) {
+		xdebug_hash_apply(sampler.stacks, XG(profile_file), xdebug_sampler_write_stack);
+		if (sampler.dropped) {
+			fprintf(XG(profile_file), "[dropped] %lu\n", sampler.dropped);
+		}
+		fflush(XG(profile_file));
+	}
+
+	xdebug_sampler_free();
+}
+
+#else
+
+int xdebug_sampler_start(char *script_name TSRMLS_DC)
+{
+	php_error(E_WARNING, "xdebug.profiler_mode=sample is not supported on this platform, or in thread safe builds");
+	return FAILURE;
+}
+
+void xdebug_sampler_stop(TSRMLS_D)
+{
+}
+
+int xdebug_sampler_active(void)
+{
+	return 0;
+}
+
+void xdebug_sampler_fold(TSRMLS_D)
+{
+}
+
+void xdebug_sampler_reinstall_handler(void)
+{
+}
+
+#endif
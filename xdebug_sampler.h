@@ -0,0 +1,76 @@
+/*
+   +----------------------------------------------------------------------+
+   | Xdebug                                                               |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2002-2016 Derick Rethans                               |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 1.0 of the Xdebug license,    |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available at through the world-wide-web at                           |
+   | http://xdebug.derickrethans.nl/license.php                           |
+   | If you did not receive a copy of the Xdebug license and are unable   |
+   | to obtain it through the world-wide-web, please send a note to       |
+   | xdebug@derickrethans.nl so we can mail you a copy immediately.       |
+   +----------------------------------------------------------------------+
+ */
+
+#ifndef __XDEBUG_SAMPLER_H__
+#define __XDEBUG_SAMPLER_H__
+
+#include <signal.h>
+
+#include "php.h"
+#include "TSRM.h"
+
+/* The sampling profiler (xdebug.profiler_mode=sample).
+ *
+ * Instead of timing every call, a SIGPROF timer fires every
+ * xdebug.profiler_sample_interval microseconds of CPU time, and the signal
+ * handler copies the engine's call stack into preallocated buffers. The
+ * buffers are folded into "outer;inner count" lines at safe points, and
+ * written out at the end of the request in the format that flame graph
+ * tools read.
+ *
+ * The timer is process wide, and the handler can't find the globals of the
+ * interrupted thread, so the sampler is not available in ZTS builds.
+ * config.m4 passes XDEBUG_HAVE_TIMER_CREATE on the command line, as this
+ * header is also included from files that don't include config.h. */
+#if !defined(ZTS) && !defined(PHP_WIN32) && defined(XDEBUG_HAVE_TIMER_CREATE)
+# define XDEBUG_SAMPLER_SUPPORTED 1
+#endif
+
+/* Deeper stacks keep their innermost frames */
+#define XDEBUG_SAMPLE_MAX_DEPTH 128
+
+/* How much the signal handler can store before the samples are folded */
+#define XDEBUG_SAMPLER_FRAMES   65536
+#define XDEBUG_SAMPLER_SAMPLES  4096
+
+#define XDEBUG_SAMPLE_FUNCTION  1
+#define XDEBUG_SAMPLE_FILE      2 /* code outside of functions */
+
+/* The name pointers are the engine's own (zend_string in PHP 7, char in
+ * PHP 5), which stay valid until the end of the request */
+typedef struct _xdebug_sample_frame {
+	const void *name;
+	const void *scope;
+	int         kind;
+} xdebug_sample_frame;
+
+typedef struct _xdebug_sample {
+	unsigned int first_frame;
+	unsigned int depth;
+	int          truncated;
+} xdebug_sample;
+
+/* Set by the signal handler once the buffers are half full */
+extern volatile sig_atomic_t xdebug_sampler_fold_needed;
+
+int  xdebug_sampler_start(char *script_name TSRMLS_DC);
+void xdebug_sampler_stop(TSRMLS_D);
+int  xdebug_sampler_active(void);
+
+void xdebug_sampler_fold(TSRMLS_D);
+void xdebug_sampler_reinstall_handler(void);
+
+#endif
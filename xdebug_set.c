@@ -20,14 +20,60 @@
 #include <stdlib.h>
 #include "xdebug_set.h"
 
+#if defined(_MSC_VER)
+# include <intrin.h>
+#endif
+
+/* Adding the position right after the last one has always been accepted, as
+ * xdebug_analyse_branch() does that. The word holding it is the last one, and
+ * the bits from size onwards in it are never treated as members. */
+#define XDEBUG_SET_WORDS(size)    ((size) / XDEBUG_SET_WORD_BITS + 1)
+#define XDEBUG_SET_WORD(position) ((position) / XDEBUG_SET_WORD_BITS)
+#define XDEBUG_SET_BIT(position)  (((xdebug_set_word) 1) << ((position) % XDEBUG_SET_WORD_BITS))
+#define XDEBUG_SET_LAST_WORD_MASK(size) (XDEBUG_SET_BIT(size) - 1)
+
+static unsigned int xdebug_set_word_ctz(xdebug_set_word word)
+{
+#if defined(__GNUC__)
+	return (unsigned int) __builtin_ctzl(word);
+#elif defined(_MSC_VER)
+	unsigned long index;
+
+	_BitScanForward(&index, word);
+	return (unsigned int) index;
+#else
+	unsigned int n = 0;
+
+	while (!(word & 1)) {
+		word >>= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+static unsigned int xdebug_set_word_popcount(xdebug_set_word word)
+{
+#if defined(__GNUC__)
+	return (unsigned int) __builtin_popcountl(word);
+#else
+	unsigned int n = 0;
+
+	while (word) {
+		word &= word - 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
 xdebug_set *xdebug_set_create(unsigned int size)
 {
 	xdebug_set *tmp;
 
 	tmp = calloc(1, sizeof(xdebug_set));
 	tmp->size = size;
-	size = (size / 8) + 1 + ((size % 8) != 0);
-	tmp->setinfo = calloc(1, size);
+	tmp->setinfo = calloc(XDEBUG_SET_WORDS(size), sizeof(xdebug_set_word));
 
 	return tmp;
 }
@@ -40,33 +86,78 @@ void xdebug_set_free(xdebug_set *set)
 
 void xdebug_set_add(xdebug_set *set, unsigned int position)
 {
-	unsigned char *byte;
-	unsigned int   bit;
+	set->setinfo[XDEBUG_SET_WORD(position)] |= XDEBUG_SET_BIT(position);
+}
+
+void xdebug_set_remove(xdebug_set *set, unsigned int position)
+{
+	set->setinfo[XDEBUG_SET_WORD(position)] &= ~XDEBUG_SET_BIT(position);
+}
+
+int xdebug_set_in_ex(xdebug_set *set, unsigned int position, int noisy)
+{
+	return (set->setinfo[XDEBUG_SET_WORD(position)] & XDEBUG_SET_BIT(position)) != 0;
+}
+
+unsigned int xdebug_set_next(xdebug_set *set, unsigned int position)
+{
+	unsigned int    i, words;
+	xdebug_set_word word;
+
+	if (position >= set->size) {
+		return set->size;
+	}
+
+	words = XDEBUG_SET_WORDS(set->size);
+	i = XDEBUG_SET_WORD(position);
 
-	byte = &(set->setinfo[position / 8]);
-	bit  = position % 8;
+	/* Mask out the bits before position in the first word */
+	word = set->setinfo[i] & ~(XDEBUG_SET_BIT(position) - 1);
+	while (!word) {
+		if (++i == words) {
+			return set->size;
+		}
+		word = set->setinfo[i];
+	}
 
-	*byte = *byte | 1 << bit;
+	position = i * XDEBUG_SET_WORD_BITS + xdebug_set_word_ctz(word);
+	return position < set->size ? position : set->size;
 }
 
-void xdebug_set_remove(xdebug_set *set, unsigned int position)
+static unsigned int xdebug_set_common_words(xdebug_set *set, xdebug_set *other)
 {
-	unsigned char *byte;
-	unsigned int   bit;
+	return XDEBUG_SET_WORDS(set->size < other->size ? set->size : other->size);
+}
 
-	byte = &(set->setinfo[position / 8]);
-	bit  = position % 8;
+void xdebug_set_union(xdebug_set *set, xdebug_set *other)
+{
+	unsigned int i, words = xdebug_set_common_words(set, other);
 
-	*byte = *byte & ~(1 << bit);
+	for (i = 0; i < words; i++) {
+		set->setinfo[i] |= other->setinfo[i];
+	}
+	set->setinfo[XDEBUG_SET_WORD(set->size)] &= XDEBUG_SET_LAST_WORD_MASK(set->size);
 }
 
-int xdebug_set_in_ex(xdebug_set *set, unsigned int position, int noisy)
+void xdebug_set_intersect(xdebug_set *set, xdebug_set *other)
+{
+	unsigned int i, words = xdebug_set_common_words(set, other);
+
+	for (i = 0; i < words; i++) {
+		set->setinfo[i] &= other->setinfo[i];
+	}
+	for (; i < XDEBUG_SET_WORDS(set->size); i++) {
+		set->setinfo[i] = 0;
+	}
+}
+
+unsigned int xdebug_set_count(xdebug_set *set)
 {
-	unsigned char *byte;
-	unsigned int   bit;
+	unsigned int i, last = XDEBUG_SET_WORD(set->size), count = 0;
 
-	byte = &(set->setinfo[position / 8]);
-	bit  = position % 8;
+	for (i = 0; i < last; i++) {
+		count += xdebug_set_word_popcount(set->setinfo[i]);
+	}
 
-	return (*byte & (1 << bit));
+	return count + xdebug_set_word_popcount(set->setinfo[last] & XDEBUG_SET_LAST_WORD_MASK(set->size));
 }
@@ -20,9 +20,15 @@
 #ifndef __XDEBUG_SET_H__
 #define __XDEBUG_SET_H__
 
+/* Bits are kept in machine words, so that scanning for members, combining
+ * sets and counting them works a word at a time */
+typedef unsigned long xdebug_set_word;
+
+#define XDEBUG_SET_WORD_BITS (sizeof(xdebug_set_word) * 8)
+
 typedef struct _xdebug_set {
 	unsigned int size;
-	unsigned char *setinfo;
+	xdebug_set_word *setinfo;
 } xdebug_set;
 
 xdebug_set *xdebug_set_create(unsigned int size);
@@ -33,4 +39,16 @@ int xdebug_set_in_ex(xdebug_set *set, unsigned int position, int noisy);
 void xdebug_set_dump(xdebug_set *set);
 void xdebug_set_free(xdebug_set *set);
 
+/* Returns the first member at or after position, or set->size if there is
+ * none. Loop over all members with:
+ *   for (i = xdebug_set_next(set, 0); i < set->size; i = xdebug_set_next(set, i + 1)) */
+unsigned int xdebug_set_next(xdebug_set *set, unsigned int position);
+
+/* Both update set in place. Members of other past the end of set are
+ * ignored. */
+void xdebug_set_union(xdebug_set *set, xdebug_set *other);
+void xdebug_set_intersect(xdebug_set *set, xdebug_set *other);
+
+unsigned int xdebug_set_count(xdebug_set *set);
+
 #endif
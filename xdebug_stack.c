@@ -17,6 +17,7 @@
  */
 #include "php_xdebug.h"
 #include "xdebug_private.h"
+#include "xdebug_aggr_shm.h"
 #include "xdebug_code_coverage.h"
 #include "xdebug_com.h"
 #include "xdebug_compat.h"
@@ -168,7 +169,7 @@ static void dump_used_var_with_contents(void *htmlq, xdebug_hash_element* he, vo
 
 void xdebug_log_stack(const char *error_type_str, char *buffer, const char *error_filename, const int error_lineno TSRMLS_DC)
 {
-	xdebug_llist_element *le;
+	size_t                k;
 	function_stack_entry *i;
 	char                 *tmp_log_message;
 
@@ -179,7 +180,7 @@ void xdebug_log_stack(const char *error_type_str, char *buffer, const char *erro
 	if (XG(stack) && XG(stack)->size) {
 		php_log_err("PHP Stack trace:" TSRMLS_CC);
 
-		for (le = XDEBUG_LLIST_HEAD(XG(stack)); le != NULL; le = XDEBUG_LLIST_NEXT(le))
+		for (k = 0; k < XG(stack)->size; k++)
 		{
 			int c = 0; /* Comma flag */
 			unsigned int j = 0; /* Counter */
@@ -187,7 +188,7 @@ void xdebug_log_stack(const char *error_type_str, char *buffer, const char *erro
 			xdebug_str log_buffer = XDEBUG_STR_INITIALIZER;
 			int variadic_opened = 0;
 
-			i = XDEBUG_LLIST_VALP(le);
+			i = XDEBUG_STACK_FRAME_AT(k);
 			tmp_name = xdebug_show_fname(i->function, 0, 0 TSRMLS_CC);
 			xdebug_str_add(&log_buffer, xdebug_sprintf("PHP %3d. %s(", i->level, tmp_name), 1);
 			xdfree(tmp_name);
@@ -413,29 +414,29 @@ static void add_single_value(xdebug_str *str, zval *zv, int html, int collecton_
 
 void xdebug_append_printable_stack(xdebug_str *str, int html TSRMLS_DC)
 {
-	xdebug_llist_element *le;
+	size_t                k;
 	function_stack_entry *i;
 	int    printed_frames = 0;
 	char **formats = select_formats(html TSRMLS_CC);
 
 	if (XG(stack) && XG(stack)->size) {
-		i = XDEBUG_LLIST_VALP(XDEBUG_LLIST_HEAD(XG(stack)));
+		i = XDEBUG_STACK_FRAME_AT(0);
 
 		xdebug_str_add(str, formats[2], 0);
 
-		for (le = XDEBUG_LLIST_HEAD(XG(stack)); le != NULL; le = XDEBUG_LLIST_NEXT(le))
+		for (k = 0; k < XG(stack)->size; k++)
 		{
 			int c = 0; /* Comma flag */
 			unsigned int j = 0; /* Counter */
 			char *tmp_name;
 			int variadic_opened = 0;
 
-			i = XDEBUG_LLIST_VALP(le);
+			i = XDEBUG_STACK_FRAME_AT(k);
 			tmp_name = xdebug_show_fname(i->function, html, 0 TSRMLS_CC);
 			if (html) {
-				xdebug_str_add(str, xdebug_sprintf(formats[3], i->level, i->time - XG(start_time), i->memory, tmp_name), 1);
+				xdebug_str_add(str, xdebug_sprintf(formats[3], i->level, XDEBUG_SECONDS_SINCE(XG(start_time), i->time), i->memory, tmp_name), 1);
 			} else {
-				xdebug_str_add(str, xdebug_sprintf(formats[3], i->time - XG(start_time), i->memory, i->level, tmp_name), 1);
+				xdebug_str_add(str, xdebug_sprintf(formats[3], XDEBUG_SECONDS_SINCE(XG(start_time), i->time), i->memory, i->level, tmp_name), 1);
 			}
 			xdfree(tmp_name);
 
@@ -1077,7 +1078,7 @@ static void xdebug_build_fname(xdebug_func *tmp, zend_execute_data *edata TSRMLS
 #if PHP_VERSION_ID >= 70100
 	if (edata && edata->func && edata->func == (zend_function*) &zend_pass_function) {
 		tmp->type     = XFUNC_ZEND_PASS;
-		tmp->function = xdstrdup("{zend_pass}");
+		tmp->function = xdebug_intern_str(&XG(interned_strings), "{zend_pass}");
 	} else
 #endif
 
@@ -1090,29 +1091,29 @@ static void xdebug_build_fname(xdebug_func *tmp, zend_execute_data *edata TSRMLS
 #endif
 			tmp->type = XFUNC_MEMBER;
 			if (edata->func->common.scope && strcmp(edata->func->common.scope->name->val, "class@anonymous") == 0) {
-				tmp->class = xdebug_sprintf(
+				tmp->class = xdebug_intern_take(&XG(interned_strings), xdebug_sprintf(
 					"{anonymous-class:%s:%d-%d}",
 					edata->func->common.scope->info.user.filename->val,
 					edata->func->common.scope->info.user.line_start,
 					edata->func->common.scope->info.user.line_end
-				);
+				));
 			} else {
-				tmp->class = xdstrdup(edata->This.value.obj->ce->name->val);
+				tmp->class = xdebug_intern_str(&XG(interned_strings), edata->This.value.obj->ce->name->val);
 			}
 		} else {
 			if (edata->func->common.scope) {
 				tmp->type = XFUNC_STATIC_MEMBER;
-				tmp->class = xdstrdup(edata->func->common.scope->name->val);
+				tmp->class = xdebug_intern_str(&XG(interned_strings), edata->func->common.scope->name->val);
 			}
 		}
 		if (edata->func->common.function_name) {
 			if (strcmp(edata->func->common.function_name->val, "{closure}") == 0) {
-				tmp->function = xdebug_sprintf(
+				tmp->function = xdebug_intern_take(&XG(interned_strings), xdebug_sprintf(
 					"{closure:%s:%d-%d}",
 					edata->func->op_array.filename->val,
 					edata->func->op_array.line_start,
 					edata->func->op_array.line_end
-				);
+				));
 			} else if (strncmp(edata->func->common.function_name->val, "call_user_func", 14) == 0) {
 				const char *fname = NULL;
 				int         lineno = 0;
@@ -1136,14 +1137,14 @@ static void xdebug_build_fname(xdebug_func *tmp, zend_execute_data *edata TSRMLS
 
 				lineno = find_line_number_for_current_execute_point(edata TSRMLS_CC);
 
-				tmp->function = xdebug_sprintf(
+				tmp->function = xdebug_intern_take(&XG(interned_strings), xdebug_sprintf(
 					"%s:{%s:%d}",
 					edata->func->common.function_name->val,
 					fname,
 					lineno
-				);
+				));
 			} else {
-				tmp->function = xdstrdup(edata->func->common.function_name->val);
+				tmp->function = xdebug_intern_str(&XG(interned_strings), edata->func->common.function_name->val);
 			}
 		} else if (
 			edata &&
@@ -1158,7 +1159,7 @@ static void xdebug_build_fname(xdebug_func *tmp, zend_execute_data *edata TSRMLS
 			)
 		) {
 			tmp->type = XFUNC_NORMAL;
-			tmp->function = xdstrdup("{internal eval}");
+			tmp->function = xdebug_intern_str(&XG(interned_strings), "{internal eval}");
 		} else if (
 			edata &&
 			edata->prev_execute_data &&
@@ -1206,21 +1207,21 @@ static void xdebug_build_fname(xdebug_func *tmp, zend_execute_data *edata TSRMLS
 			if (edata->object) {
 				tmp->type = XFUNC_MEMBER;
 				if (edata->function_state.function->common.scope) { /* __autoload has no scope */
-					tmp->class = xdstrdup(edata->function_state.function->common.scope->name);
+					tmp->class = xdebug_intern_str(&XG(interned_strings), edata->function_state.function->common.scope->name);
 				}
 			} else if (EG(scope) && edata->function_state.function->common.scope && edata->function_state.function->common.scope->name) {
 				tmp->type = XFUNC_STATIC_MEMBER;
-				tmp->class = xdstrdup(edata->function_state.function->common.scope->name);
+				tmp->class = xdebug_intern_str(&XG(interned_strings), edata->function_state.function->common.scope->name);
 			} else {
 				tmp->type = XFUNC_NORMAL;
 			}
 			if (strcmp(edata->function_state.function->common.function_name, "{closure}") == 0) {
-				tmp->function = xdebug_sprintf(
+				tmp->function = xdebug_intern_take(&XG(interned_strings), xdebug_sprintf(
 					"{closure:%s:%d-%d}",
 					edata->function_state.function->op_array.filename,
 					edata->function_state.function->op_array.line_start,
 					edata->function_state.function->op_array.line_end
-				);
+				));
 			} else if (strncmp(edata->function_state.function->common.function_name, "call_user_func", 14) == 0) {
 				const char *fname = NULL;
 				int         lineno = 0;
@@ -1244,14 +1245,14 @@ static void xdebug_build_fname(xdebug_func *tmp, zend_execute_data *edata TSRMLS
 
 				lineno = find_line_number_for_current_execute_point(edata TSRMLS_CC);
 
-				tmp->function = xdebug_sprintf(
+				tmp->function = xdebug_intern_take(&XG(interned_strings), xdebug_sprintf(
 					"%s:{%s:%d}",
 					edata->function_state.function->common.function_name,
 					fname,
 					lineno
-				);
+				));
 			} else {
-				tmp->function = xdstrdup(edata->function_state.function->common.function_name);
+				tmp->function = xdebug_intern_str(&XG(interned_strings), edata->function_state.function->common.function_name);
 			}
 		} else {
 			switch (edata->opline->extended_value) {
@@ -1291,6 +1292,7 @@ function_stack_entry *xdebug_add_stack_frame(zend_execute_data *zdata, zend_op_a
 	int                   i = 0;
 	char                 *aggr_key = NULL;
 	int                   aggr_key_len = 0;
+	int                   aggregate = XG(profiler_aggregate) && !xdebug_aggr_shm_enabled();
 #if PHP_VERSION_ID >= 70000
 	int                   hit_variadic = 0;
 	zend_string          *aggr_key_str = NULL;
@@ -1314,7 +1316,7 @@ function_stack_entry *xdebug_add_stack_frame(zend_execute_data *zdata, zend_op_a
 # endif
 #endif
 
-	tmp = xdmalloc (sizeof (function_stack_entry));
+	tmp = xdebug_stack_frame_storage(XG(stack) ? XG(stack)->size : 0 TSRMLS_CC);
 	tmp->var           = NULL;
 	tmp->varc          = 0;
 	tmp->refcount      = 1;
@@ -1325,6 +1327,7 @@ function_stack_entry *xdebug_add_stack_frame(zend_execute_data *zdata, zend_op_a
 	tmp->filename      = NULL;
 	tmp->include_filename  = NULL;
 	tmp->profile.call_list = NULL;
+	tmp->profiler.node = NULL;
 	tmp->op_array      = op_array;
 	tmp->symbol_table  = NULL;
 	tmp->execute_data  = NULL;
@@ -1341,29 +1344,29 @@ function_stack_entry *xdebug_add_stack_frame(zend_execute_data *zdata, zend_op_a
 			ptr = ptr->prev_execute_data;
 		}
 		if (ptr) {
-			tmp->filename = xdstrdup(ptr->func->op_array.filename->val);
+			tmp->filename = xdebug_intern_str(&XG(interned_strings), ptr->func->op_array.filename->val);
 		}
 	}
 #else
 	if (edata && edata->op_array) {
 		/* Normal function calls */
-		tmp->filename  = xdstrdup(edata->op_array->filename);
+		tmp->filename  = xdebug_intern_str(&XG(interned_strings), edata->op_array->filename);
 	} else if (
 		edata &&
 		edata->prev_execute_data &&
 		XDEBUG_LLIST_TAIL(XG(stack)) &&
 		((function_stack_entry*) XDEBUG_LLIST_VALP(XDEBUG_LLIST_TAIL(XG(stack))))->filename
 	) {
-		tmp->filename = xdstrdup(((function_stack_entry*) XDEBUG_LLIST_VALP(XDEBUG_LLIST_TAIL(XG(stack))))->filename);
+		tmp->filename = ((function_stack_entry*) XDEBUG_LLIST_VALP(XDEBUG_LLIST_TAIL(XG(stack))))->filename;
 	}
 #endif
 
 	if (!tmp->filename) {
 		/* Includes/main script etc */
 #if PHP_VERSION_ID >= 70000
-		tmp->filename  = (type == XDEBUG_EXTERNAL && op_array && op_array->filename) ? xdstrdup(op_array->filename->val): NULL;
+		tmp->filename  = (type == XDEBUG_EXTERNAL && op_array && op_array->filename) ? xdebug_intern_str(&XG(interned_strings), op_array->filename->val): NULL;
 #else
-		tmp->filename  = (op_array && op_array->filename) ? xdstrdup(op_array->filename): NULL;
+		tmp->filename  = (op_array && op_array->filename) ? xdebug_intern_str(&XG(interned_strings), op_array->filename): NULL;
 #endif
 	}
 	/* Call user function locations */
@@ -1374,22 +1377,22 @@ function_stack_entry *xdebug_add_stack_frame(zend_execute_data *zdata, zend_op_a
 		XDEBUG_LLIST_VALP(XDEBUG_LLIST_TAIL(XG(stack))) &&
 		((function_stack_entry*) XDEBUG_LLIST_VALP(XDEBUG_LLIST_TAIL(XG(stack))))->filename
 	) {
-		tmp->filename = xdstrdup(((function_stack_entry*) XDEBUG_LLIST_VALP(XDEBUG_LLIST_TAIL(XG(stack))))->filename);
+		tmp->filename = ((function_stack_entry*) XDEBUG_LLIST_VALP(XDEBUG_LLIST_TAIL(XG(stack))))->filename;
 	}
 
 	if (!tmp->filename) {
-		tmp->filename = xdstrdup("UNKNOWN?");
+		tmp->filename = xdebug_intern_str(&XG(interned_strings), "UNKNOWN?");
 	}
 	tmp->prev_memory = XG(prev_memory);
 	tmp->memory = zend_memory_usage(0 TSRMLS_CC);
 	XG(prev_memory) = tmp->memory;
-	tmp->time   = xdebug_get_utime();
+	tmp->time   = xdebug_get_nanotime();
 	tmp->lineno = 0;
 	tmp->prev   = 0;
 
 	xdebug_build_fname(&(tmp->function), zdata TSRMLS_CC);
 	if (!tmp->function.type) {
-		tmp->function.function = xdstrdup("{main}");
+		tmp->function.function = xdebug_intern_str(&XG(interned_strings), "{main}");
 		tmp->function.class    = NULL;
 		tmp->function.type     = XFUNC_NORMAL;
 
@@ -1543,7 +1546,7 @@ function_stack_entry *xdebug_add_stack_frame(zend_execute_data *zdata, zend_op_a
 		xdfree(func_name);
 	}
 
-	if (XG(profiler_aggregate)) {
+	if (aggregate) {
 		char *func_name = xdebug_show_fname(tmp->function, 0, 0 TSRMLS_CC);
 
 		aggr_key = xdebug_sprintf("%s.%s.%d", tmp->filename, func_name, tmp->lineno);
@@ -1585,7 +1588,7 @@ function_stack_entry *xdebug_add_stack_frame(zend_execute_data *zdata, zend_op_a
 		if (XDEBUG_LLIST_TAIL(XG(stack))) {
 			function_stack_entry *prev = XDEBUG_LLIST_VALP(XDEBUG_LLIST_TAIL(XG(stack)));
 			tmp->prev = prev;
-			if (XG(profiler_aggregate)) {
+			if (aggregate) {
 				if (prev->aggr_entry->call_list) {
 #if PHP_VERSION_ID >= 70000
 					if (!zend_hash_exists(prev->aggr_entry->call_list, aggr_key_str)) {
@@ -1606,10 +1609,10 @@ function_stack_entry *xdebug_add_stack_frame(zend_execute_data *zdata, zend_op_a
 				}
 			}
 		}
-		xdebug_llist_insert_next(XG(stack), XDEBUG_LLIST_TAIL(XG(stack)), tmp);
+		xdebug_llist_insert_element_next(XG(stack), XDEBUG_LLIST_TAIL(XG(stack)), &tmp->stack_link, tmp);
 	}
 
-	if (XG(profiler_aggregate)) {
+	if (aggregate) {
 #if PHP_VERSION_ID >= 70000
 		zend_string_release(aggr_key_str);
 #endif
@@ -1670,7 +1673,6 @@ PHP_FUNCTION(xdebug_get_stack_depth)
    Returns an array representing the current stack */
 PHP_FUNCTION(xdebug_get_function_stack)
 {
-	xdebug_llist_element *le;
 	unsigned int          j;
 	unsigned int          k;
 	zval                 *frame;
@@ -1678,10 +1680,9 @@ PHP_FUNCTION(xdebug_get_function_stack)
 	char                 *argument = NULL;
 
 	array_init(return_value);
-	le = XDEBUG_LLIST_HEAD(XG(stack));
 
-	for (k = 0; k < XG(stack)->size - 1; k++, le = XDEBUG_LLIST_NEXT(le)) {
-		function_stack_entry *i = XDEBUG_LLIST_VALP(le);
+	for (k = 0; k < XG(stack)->size - 1; k++) {
+		function_stack_entry *i = XDEBUG_STACK_FRAME_AT(k);
 
 		if (i->function.function) {
 			if (strcmp(i->function.function, "xdebug_get_function_stack") == 0) {
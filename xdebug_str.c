@@ -22,40 +22,41 @@
 #include <string.h>
 #include <locale.h>
 
+/* For PHP's own vsnprintf(), whose %G matches PHP's double output */
 #include "php.h"
-#include "ext/standard/php_string.h"
 
 #include "xdebug_mm.h"
 #include "xdebug_str.h"
 
-void xdebug_str_add(xdebug_str *xs, char *str, int f)
+/* Makes room for 'extra' more bytes and the trailing NUL. The buffer at least
+ * doubles every time it grows, so that building a string piece by piece only
+ * copies it a logarithmic number of times. */
+static void xdebug_str_reserve(xdebug_str *xs, long extra)
 {
-	int l = strlen(str);
+	long needed = xs->l + extra + 1;
+	long a;
 
-	if (xs->l + l > xs->a - 1) {
-		xs->d = xdrealloc(xs->d, xs->a + l + XDEBUG_STR_PREALLOC);
-		xs->a = xs->a + l + XDEBUG_STR_PREALLOC;
-	}
-	if (!xs->l) {
-		xs->d[0] = '\0';
+	if (needed <= xs->a) {
+		return;
 	}
-	memcpy(xs->d + xs->l, str, l);
-	xs->d[xs->l + l] = '\0';
-	xs->l = xs->l + l;
-	if (f) {
-		xdfree(str);
+
+	a = xs->a < XDEBUG_STR_PREALLOC ? XDEBUG_STR_PREALLOC : xs->a * 2;
+	while (a < needed) {
+		a *= 2;
 	}
+
+	xs->d = xdrealloc(xs->d, a);
+	xs->a = a;
+}
+
+void xdebug_str_add(xdebug_str *xs, char *str, int f)
+{
+	xdebug_str_addl(xs, str, strlen(str), f);
 }
 
 void xdebug_str_addl(xdebug_str *xs, char *str, int le, int f)
 {
-	if (xs->l + le > xs->a - 1) {
-		xs->d = xdrealloc(xs->d, xs->a + le + XDEBUG_STR_PREALLOC);
-		xs->a = xs->a + le + XDEBUG_STR_PREALLOC;
-	}
-	if (!xs->l) {
-		xs->d[0] = '\0';
-	}
+	xdebug_str_reserve(xs, le);
 	memcpy(xs->d + xs->l, str, le);
 	xs->d[xs->l + le] = '\0';
 	xs->l = xs->l + le;
@@ -65,6 +66,64 @@ void xdebug_str_addl(xdebug_str *xs, char *str, int le, int f)
 	}
 }
 
+/* Formats straight into the tail of the buffer, instead of going through a
+ * temporary string from xdebug_sprintf() */
+void xdebug_str_add_fmt(xdebug_str *xs, const char *fmt, ...)
+{
+	va_list args;
+	long    size;
+	int     n;
+
+	xdebug_str_reserve(xs, 0);
+
+	for (;;) {
+		size = xs->a - xs->l;
+
+		va_start(args, fmt);
+		n = vsnprintf(xs->d + xs->l, size, fmt, args);
+		va_end(args);
+
+		if (n > -1 && n < size) {
+			break;
+		}
+		xdebug_str_reserve(xs, n < 0 ? size * 2 : n);
+	}
+
+	xs->l = xs->l + n;
+}
+
+void xdebug_str_add_long(xdebug_str *xs, long long value)
+{
+	unsigned long long magnitude;
+
+	if (value < 0) {
+		xdebug_str_addl(xs, "-", 1, 0);
+		magnitude = 0ULL - (unsigned long long) value;
+	} else {
+		magnitude = (unsigned long long) value;
+	}
+	xdebug_str_add_ulong(xs, magnitude);
+}
+
+void xdebug_str_add_ulong(xdebug_str *xs, unsigned long long value)
+{
+	char  buffer[24];
+	char *p = buffer + sizeof(buffer);
+
+	do {
+		*--p = (char) ('0' + value % 10);
+		value /= 10;
+	} while (value);
+
+	xdebug_str_addl(xs, p, buffer + sizeof(buffer) - p, 0);
+}
+
+/* Same output as "%.*G" */
+void xdebug_str_add_double(xdebug_str *xs, double value, int precision)
+{
+	xdebug_str_add_fmt(xs, "%.*G", precision, value);
+}
+
 void xdebug_str_chop(xdebug_str *xs, int c)
 {
 	if (c > xs->l) {
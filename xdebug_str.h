@@ -21,6 +21,13 @@
 
 #include "xdebug_mm.h"
 
+/* Lets the compiler check format strings against their arguments */
+#if defined(__GNUC__) || defined(__clang__)
+# define XDEBUG_ATTRIBUTE_FORMAT(type, fmt_idx, first_arg_idx) __attribute__((format(type, fmt_idx, first_arg_idx)))
+#else
+# define XDEBUG_ATTRIBUTE_FORMAT(type, fmt_idx, first_arg_idx)
+#endif
+
 #define XDEBUG_STR_INITIALIZER { 0, 0, NULL }
 #define XDEBUG_STR_PREALLOC 1024
 #define xdebug_str_ptr_init(str) str = xdmalloc(sizeof(xdebug_str)); str->l = 0; str->a = 0; str->d = NULL;
@@ -35,6 +42,10 @@ typedef struct xdebug_str {
 
 void xdebug_str_add(xdebug_str *xs, char *str, int f);
 void xdebug_str_addl(xdebug_str *xs, char *str, int le, int f);
+void xdebug_str_add_fmt(xdebug_str *xs, const char *fmt, ...) XDEBUG_ATTRIBUTE_FORMAT(printf, 2, 3);
+void xdebug_str_add_long(xdebug_str *xs, long long value);
+void xdebug_str_add_ulong(xdebug_str *xs, unsigned long long value);
+void xdebug_str_add_double(xdebug_str *xs, double value, int precision);
 void xdebug_str_chop(xdebug_str *xs, int c);
 void xdebug_str_free(xdebug_str *s);
 
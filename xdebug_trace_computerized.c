@@ -62,11 +62,9 @@ void xdebug_trace_computerized_write_footer(void *ctxt TSRMLS_DC)
 {
 	xdebug_trace_computerized_context *context = (xdebug_trace_computerized_context*) ctxt;
 	char   *str_time;
-	double  u_time;
 	char   *tmp;
 
-	u_time = xdebug_get_utime();
-	tmp = xdebug_sprintf("\t\t\t%F\t", u_time - XG(start_time));
+	tmp = xdebug_sprintf("\t\t\t%F\t", XDEBUG_SECONDS_SINCE(XG(start_time), xdebug_get_nanotime()));
 	fprintf(context->trace_file, "%s", tmp);
 	xdfree(tmp);
 #if WIN32|WINNT
@@ -118,16 +116,20 @@ void xdebug_trace_computerized_function_entry(void *ctxt, function_stack_entry *
 	char *tmp_name;
 	xdebug_str str = XDEBUG_STR_INITIALIZER;
 
-	xdebug_str_add(&str, xdebug_sprintf("%d\t", fse->level), 1);
-	xdebug_str_add(&str, xdebug_sprintf("%d\t", function_nr), 1);
+	xdebug_str_add_long(&str, fse->level);
+	xdebug_str_addl(&str, "\t", 1, 0);
+	xdebug_str_add_long(&str, function_nr);
+	xdebug_str_addl(&str, "\t", 1, 0);
 
 	tmp_name = xdebug_show_fname(fse->function, 0, 0 TSRMLS_CC);
 
 	xdebug_str_add(&str, "0\t", 0);
-	xdebug_str_add(&str, xdebug_sprintf("%F\t", fse->time - XG(start_time)), 1);
-	xdebug_str_add(&str, xdebug_sprintf("%lu\t", fse->memory), 1);
-	xdebug_str_add(&str, xdebug_sprintf("%s\t", tmp_name), 1);
-	xdebug_str_add(&str, xdebug_sprintf("%d\t", fse->user_defined == XDEBUG_EXTERNAL ? 1 : 0), 1);
+	xdebug_str_add_fmt(&str, "%F\t", XDEBUG_SECONDS_SINCE(XG(start_time), fse->time));
+	xdebug_str_add_ulong(&str, (unsigned long) fse->memory);
+	xdebug_str_addl(&str, "\t", 1, 0);
+	xdebug_str_add(&str, tmp_name, 0);
+	xdebug_str_addl(&str, "\t", 1, 0);
+	xdebug_str_addl(&str, fse->user_defined == XDEBUG_EXTERNAL ? "1\t" : "0\t", 2, 0);
 	xdfree(tmp_name);
 
 	if (fse->include_filename) {
@@ -136,7 +138,7 @@ void xdebug_trace_computerized_function_entry(void *ctxt, function_stack_entry *
 			zend_string *i_filename = zend_string_init(fse->include_filename, strlen(fse->include_filename), 0);
 			zend_string *escaped;
 			escaped = php_addcslashes(i_filename, 0, "'\\\0..\37", 6);
-			xdebug_str_add(&str, xdebug_sprintf("'%s'", escaped->val), 1);
+			xdebug_str_add_fmt(&str, "'%s'", escaped->val);
 			zend_string_release(escaped);
 			zend_string_release(i_filename);
 #else
@@ -144,7 +146,7 @@ void xdebug_trace_computerized_function_entry(void *ctxt, function_stack_entry *
 
 			char *escaped;
 			escaped = php_addcslashes(fse->include_filename, strlen(fse->include_filename), &tmp_len, 0, "'\\\0..\37", 6 TSRMLS_CC);
-			xdebug_str_add(&str, xdebug_sprintf("'%s'", escaped), 1);
+			xdebug_str_add_fmt(&str, "'%s'", escaped);
 			efree(escaped);
 #endif
 		} else {
@@ -153,14 +155,18 @@ void xdebug_trace_computerized_function_entry(void *ctxt, function_stack_entry *
 	}
 
 	/* Filename and Lineno (9, 10) */
-	xdebug_str_add(&str, xdebug_sprintf("\t%s\t%d", fse->filename, fse->lineno), 1);
+	xdebug_str_addl(&str, "\t", 1, 0);
+	xdebug_str_add(&str, fse->filename, 0);
+	xdebug_str_addl(&str, "\t", 1, 0);
+	xdebug_str_add_long(&str, fse->lineno);
 
 
 	if (XG(collect_params) > 0) {
 		unsigned int j = 0; /* Counter */
 
 		/* Nr of arguments (11) */
-		xdebug_str_add(&str, xdebug_sprintf("\t%d", fse->varc), 1);
+		xdebug_str_addl(&str, "\t", 1, 0);
+		xdebug_str_add_long(&str, fse->varc);
 
 		/* Arguments (12-...) */
 		for (j = 0; j < fse->varc; j++) {
@@ -173,7 +179,7 @@ void xdebug_trace_computerized_function_entry(void *ctxt, function_stack_entry *
 			}
 
 			if (fse->var[j].name && XG(collect_params) == 4) {
-				xdebug_str_add(&str, xdebug_sprintf("$%s = ", fse->var[j].name), 1);
+				xdebug_str_add_fmt(&str, "$%s = ", fse->var[j].name);
 			}
 
 			tmp_value = render_variable(fse->var[j].addr, XG(collect_params) TSRMLS_CC);
@@ -199,12 +205,15 @@ void xdebug_trace_computerized_function_exit(void *ctxt, function_stack_entry *f
 	xdebug_trace_computerized_context *context = (xdebug_trace_computerized_context*) ctxt;
 	xdebug_str str = XDEBUG_STR_INITIALIZER;
 
-	xdebug_str_add(&str, xdebug_sprintf("%d\t", fse->level), 1);
-	xdebug_str_add(&str, xdebug_sprintf("%d\t", function_nr), 1);
+	xdebug_str_add_long(&str, fse->level);
+	xdebug_str_addl(&str, "\t", 1, 0);
+	xdebug_str_add_long(&str, function_nr);
+	xdebug_str_addl(&str, "\t", 1, 0);
 
 	xdebug_str_add(&str, "1\t", 0);
-	xdebug_str_add(&str, xdebug_sprintf("%F\t", xdebug_get_utime() - XG(start_time)), 1);
-	xdebug_str_add(&str, xdebug_sprintf("%lu\n", zend_memory_usage(0 TSRMLS_CC)), 1);
+	xdebug_str_add_fmt(&str, "%F\t", XDEBUG_SECONDS_SINCE(XG(start_time), xdebug_get_nanotime()));
+	xdebug_str_add_ulong(&str, zend_memory_usage(0 TSRMLS_CC));
+	xdebug_str_addl(&str, "\n", 1, 0);
 
 	fprintf(context->trace_file, "%s", str.d);
 	fflush(context->trace_file);
@@ -217,8 +226,10 @@ void xdebug_trace_computerized_function_return_value(void *ctxt, function_stack_
 	xdebug_str str = XDEBUG_STR_INITIALIZER;
 	char      *tmp_value = NULL;
 
-	xdebug_str_add(&str, xdebug_sprintf("%d\t", fse->level), 1);
-	xdebug_str_add(&str, xdebug_sprintf("%d\t", function_nr), 1);
+	xdebug_str_add_long(&str, fse->level);
+	xdebug_str_addl(&str, "\t", 1, 0);
+	xdebug_str_add_long(&str, function_nr);
+	xdebug_str_addl(&str, "\t", 1, 0);
 	xdebug_str_add(&str, "R\t\t\t", 0);
 
 	tmp_value = render_variable(return_value, XG(collect_params) TSRMLS_CC);
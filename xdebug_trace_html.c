@@ -80,11 +80,11 @@ void xdebug_trace_html_function_entry(void *ctxt, function_stack_entry *fse, int
 	xdebug_str str = XDEBUG_STR_INITIALIZER;
 
 	xdebug_str_add(&str, "\t<tr>", 0);
-	xdebug_str_add(&str, xdebug_sprintf("<td>%d</td>", function_nr), 1);
-	xdebug_str_add(&str, xdebug_sprintf("<td>%0.6F</td>", fse->time - XG(start_time)), 1);
-	xdebug_str_add(&str, xdebug_sprintf("<td align='right'>%lu</td>", fse->memory), 1);
+	xdebug_str_add_fmt(&str, "<td>%d</td>", function_nr);
+	xdebug_str_add_fmt(&str, "<td>%0.6F</td>", XDEBUG_SECONDS_SINCE(XG(start_time), fse->time));
+	xdebug_str_add_fmt(&str, "<td align='right'>%lu</td>", fse->memory);
 	if (XG(show_mem_delta)) {
-		xdebug_str_add(&str, xdebug_sprintf("<td align='right'>%ld</td>", fse->memory - fse->prev_memory), 1);
+		xdebug_str_add_fmt(&str, "<td align='right'>%ld</td>", fse->memory - fse->prev_memory);
 	}
 	xdebug_str_add(&str, "<td align='left'>", 0);
 	for (j = 0; j < fse->level - 1; j++) {
@@ -93,7 +93,7 @@ void xdebug_trace_html_function_entry(void *ctxt, function_stack_entry *fse, int
 	xdebug_str_add(&str, "-&gt;</td>", 0);
 
 	tmp_name = xdebug_show_fname(fse->function, 0, 0 TSRMLS_CC);
-	xdebug_str_add(&str, xdebug_sprintf("<td>%s(", tmp_name), 1);
+	xdebug_str_add_fmt(&str, "<td>%s(", tmp_name);
 	xdfree(tmp_name);
 
 	if (fse->include_filename) {
@@ -106,14 +106,14 @@ void xdebug_trace_html_function_entry(void *ctxt, function_stack_entry *fse, int
 			joined = xdebug_join("<br />", parts, 0, 99999);
 			xdebug_arg_dtor(parts);
 
-			xdebug_str_add(&str, xdebug_sprintf("'%s'", joined), 1);
+			xdebug_str_add_fmt(&str, "'%s'", joined);
 			xdfree(joined);
 		} else {
 			xdebug_str_add(&str, fse->include_filename, 0);
 		}
 	}
 
-	xdebug_str_add(&str, xdebug_sprintf(")</td><td>%s:%d</td>", fse->filename, fse->lineno), 1);
+	xdebug_str_add_fmt(&str, ")</td><td>%s:%d</td>", fse->filename, fse->lineno);
 	xdebug_str_add(&str, "</tr>\n", 0);
 
 	fprintf(context->trace_file, "%s", str.d);
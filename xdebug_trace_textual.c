@@ -60,11 +60,9 @@ void xdebug_trace_textual_write_footer(void *ctxt TSRMLS_DC)
 {
 	xdebug_trace_textual_context *context = (xdebug_trace_textual_context*) ctxt;
 	char   *str_time;
-	double  u_time;
 	char   *tmp;
 
-	u_time = xdebug_get_utime();
-	tmp = xdebug_sprintf("%10.4F ", u_time - XG(start_time));
+	tmp = xdebug_sprintf("%10.4F ", XDEBUG_SECONDS_SINCE(XG(start_time), xdebug_get_nanotime()));
 	fprintf(context->trace_file, "%s", tmp);
 	xdfree(tmp);
 #if WIN32|WINNT
@@ -121,15 +119,15 @@ void xdebug_trace_textual_function_entry(void *ctxt, function_stack_entry *fse,
 
 	tmp_name = xdebug_show_fname(fse->function, 0, 0 TSRMLS_CC);
 
-	xdebug_str_add(&str, xdebug_sprintf("%10.4F ", fse->time - XG(start_time)), 1);
-	xdebug_str_add(&str, xdebug_sprintf("%10lu ", fse->memory), 1);
+	xdebug_str_add_fmt(&str, "%10.4F ", XDEBUG_SECONDS_SINCE(XG(start_time), fse->time));
+	xdebug_str_add_fmt(&str, "%10lu ", fse->memory);
 	if (XG(show_mem_delta)) {
-		xdebug_str_add(&str, xdebug_sprintf("%+8ld ", fse->memory - fse->prev_memory), 1);
+		xdebug_str_add_fmt(&str, "%+8ld ", fse->memory - fse->prev_memory);
 	}
 	for (j = 0; j < fse->level; j++) {
 		xdebug_str_addl(&str, "  ", 2, 0);
 	}
-	xdebug_str_add(&str, xdebug_sprintf("-> %s(", tmp_name), 1);
+	xdebug_str_add_fmt(&str, "-> %s(", tmp_name);
 
 	xdfree(tmp_name);
 
@@ -159,7 +157,7 @@ void xdebug_trace_textual_function_entry(void *ctxt, function_stack_entry *fse,
 			}
 
 			if (fse->var[j].name && XG(collect_params) == 4) {
-				xdebug_str_add(&str, xdebug_sprintf("$%s = ", fse->var[j].name), 1);
+				xdebug_str_add_fmt(&str, "$%s = ", fse->var[j].name);
 			}
 
 			if (fse->var[j].is_variadic && fse->var[j].addr) {
@@ -175,7 +173,7 @@ void xdebug_trace_textual_function_entry(void *ctxt, function_stack_entry *fse,
 				&& (!(!fse->var[j].addr && fse->is_variadic && j == fse->varc - 1))
 #endif
 			) {
-				xdebug_str_add(&str, xdebug_sprintf("%d => ", variadic_count++), 1);
+				xdebug_str_add_fmt(&str, "%d => ", variadic_count++);
 			}
 
 			if (fse->var[j].addr) {
@@ -200,7 +198,7 @@ void xdebug_trace_textual_function_entry(void *ctxt, function_stack_entry *fse,
 			zend_string *i_filename = zend_string_init(fse->include_filename, strlen(fse->include_filename), 0);
 			zend_string *escaped;
 			escaped = php_addcslashes(i_filename, 0, "'\\\0..\37", 6);
-			xdebug_str_add(&str, xdebug_sprintf("'%s'", escaped->val), 1);
+			xdebug_str_add_fmt(&str, "'%s'", escaped->val);
 			zend_string_release(escaped);
 			zend_string_release(i_filename);
 #else
@@ -208,7 +206,7 @@ void xdebug_trace_textual_function_entry(void *ctxt, function_stack_entry *fse,
 
 			char *escaped;
 			escaped = php_addcslashes(fse->include_filename, strlen(fse->include_filename), &tmp_len, 0, "'\\\0..\37", 6 TSRMLS_CC);
-			xdebug_str_add(&str, xdebug_sprintf("'%s'", escaped), 1);
+			xdebug_str_add_fmt(&str, "'%s'", escaped);
 			efree(escaped);
 #endif
 		} else {
@@ -216,7 +214,7 @@ void xdebug_trace_textual_function_entry(void *ctxt, function_stack_entry *fse,
 		}
 	}
 
-	xdebug_str_add(&str, xdebug_sprintf(") %s:%d\n", fse->filename, fse->lineno), 1);
+	xdebug_str_add_fmt(&str, ") %s:%d\n", fse->filename, fse->lineno);
 
 	fprintf(context->trace_file, "%s", str.d);
 	fflush(context->trace_file);
@@ -229,8 +227,8 @@ static void xdebug_return_trace_stack_common(xdebug_str *str, function_stack_ent
 {
 	unsigned int j = 0; /* Counter */
 
-	xdebug_str_add(str, xdebug_sprintf("%10.4F ", xdebug_get_utime() - XG(start_time)), 1);
-	xdebug_str_add(str, xdebug_sprintf("%10lu ", zend_memory_usage(0 TSRMLS_CC)), 1);
+	xdebug_str_add_fmt(str, "%10.4F ", XDEBUG_SECONDS_SINCE(XG(start_time), xdebug_get_nanotime()));
+	xdebug_str_add_fmt(str, "%10lu ", zend_memory_usage(0 TSRMLS_CC));
 
 	if (XG(show_mem_delta)) {
 		xdebug_str_addl(str, "        ", 8, 0);
@@ -330,7 +328,7 @@ void xdebug_trace_textual_assignment(void *ctxt, function_stack_entry *fse, char
 	xdebug_str_add(&str, full_varname, 0);
 
 	if (op[0] != '\0' ) { /* pre/post inc/dec ops are special */
-		xdebug_str_add(&str, xdebug_sprintf(" %s ", op), 1);
+		xdebug_str_add_fmt(&str, " %s ", op);
 
 		tmp_value = xdebug_get_zval_value(retval, 0, NULL);
 
@@ -340,7 +338,7 @@ void xdebug_trace_textual_assignment(void *ctxt, function_stack_entry *fse, char
 			xdebug_str_addl(&str, "NULL", 4, 0);
 		}
 	}
-	xdebug_str_add(&str, xdebug_sprintf(" %s:%d\n", filename, lineno), 1);
+	xdebug_str_add_fmt(&str, " %s:%d\n", filename, lineno);
 
 	fprintf(context->trace_file, "%s", str.d);
 	fflush(context->trace_file);
@@ -75,9 +75,9 @@ FILE *xdebug_trace_open_file(char *fname, long options, char **used_fname TSRMLS
 		xdfree(fname);
 	}
 	if (options & XDEBUG_TRACE_OPTION_APPEND) {
-		file = xdebug_fopen(filename, "a", (options & XDEBUG_TRACE_OPTION_NAKED_FILENAME) ? NULL : "xt", used_fname);
+		file = xdebug_fopen_output(filename, "a", (options & XDEBUG_TRACE_OPTION_NAKED_FILENAME) ? NULL : "xt", used_fname);
 	} else {
-		file = xdebug_fopen(filename, "w", (options & XDEBUG_TRACE_OPTION_NAKED_FILENAME) ? NULL : "xt", used_fname);
+		file = xdebug_fopen_output(filename, "w", (options & XDEBUG_TRACE_OPTION_NAKED_FILENAME) ? NULL : "xt", used_fname);
 	}
 	xdfree(filename);
 
@@ -86,6 +86,8 @@ FILE *xdebug_trace_open_file(char *fname, long options, char **used_fname TSRMLS
 
 char* xdebug_start_trace(char* fname, long options TSRMLS_DC)
 {
+	xdebug_clock_calibrate(&xdebug_global_clock);
+
 	XG(trace_handler) = xdebug_select_trace_handler(options TSRMLS_CC);
 	XG(trace_context) = (void*) XG(trace_handler)->init(fname, options TSRMLS_CC);
 
@@ -944,9 +944,9 @@ static int xdebug_array_element_export(zval **zv TSRMLS_DC, int num_args, va_lis
 	{
 		if (HASH_KEY_IS_NUMERIC(hash_key)) { /* numeric key */
 #if PHP_VERSION_ID >= 70000
-			xdebug_str_add(str, xdebug_sprintf(XDEBUG_INT_FMT " => ", index_key), 1);
+			xdebug_str_add_fmt(str, XDEBUG_INT_FMT " => ", index_key);
 #else
-			xdebug_str_add(str, xdebug_sprintf(XDEBUG_INT_FMT " => ", HASH_APPLY_NUMERIC(hash_key)), 1);
+			xdebug_str_add_fmt(str, XDEBUG_INT_FMT " => ", HASH_APPLY_NUMERIC(hash_key));
 #endif
 		} else { /* string key */
 			SIZETorINT newlen = 0;
@@ -996,18 +996,18 @@ static int xdebug_object_element_export(zval **zv TSRMLS_DC, int num_args, va_li
 
 			modifier = xdebug_get_property_info((char*) HASH_APPLY_KEY_VAL(hash_key), HASH_APPLY_KEY_LEN(hash_key), &prop_name, &prop_class_name);
 			if (strcmp(modifier, "private") != 0 || strcmp(class_name, prop_class_name) == 0) {
-				xdebug_str_add(str, xdebug_sprintf("%s $%s = ", modifier, prop_name), 1);
+				xdebug_str_add_fmt(str, "%s $%s = ", modifier, prop_name);
 			} else {
-				xdebug_str_add(str, xdebug_sprintf("%s ${%s}:%s = ", modifier, prop_class_name, prop_name), 1);
+				xdebug_str_add_fmt(str, "%s ${%s}:%s = ", modifier, prop_class_name, prop_name);
 			}
 
 			xdfree(prop_name);
 			xdfree(prop_class_name);
 		} else {
 #if PHP_VERSION_ID >= 70000
-			xdebug_str_add(str, xdebug_sprintf("public $%d = ", index_key), 1);
+			xdebug_str_add_fmt(str, "public $%d = ", index_key);
 #else
-			xdebug_str_add(str, xdebug_sprintf("public $%d = ", HASH_APPLY_NUMERIC(hash_key)), 1);
+			xdebug_str_add_fmt(str, "public $%d = ", HASH_APPLY_NUMERIC(hash_key));
 #endif
 		}
 		xdebug_var_export(zv, str, level + 2, debug_zval, options TSRMLS_CC);
@@ -1039,7 +1039,7 @@ void xdebug_var_export(zval **struc, xdebug_str *str, int level, int debug_zval,
 #if PHP_VERSION_ID >= 70000
 	if (debug_zval) {
 		if (Z_TYPE_P(*struc) >= IS_STRING && Z_TYPE_P(*struc) != IS_INDIRECT) {
-			xdebug_str_add(str, xdebug_sprintf("(refcount=%d, is_ref=%d)=", (*struc)->value.counted->gc.refcount, Z_TYPE_P(*struc) == IS_REFERENCE), 1);
+			xdebug_str_add_fmt(str, "(refcount=%d, is_ref=%d)=", (*struc)->value.counted->gc.refcount, Z_TYPE_P(*struc) == IS_REFERENCE);
 		} else {
 			xdebug_str_add(str, "(refcount=0, is_ref=0)=", 0);
 		}
@@ -1050,7 +1050,7 @@ void xdebug_var_export(zval **struc, xdebug_str *str, int level, int debug_zval,
 	}
 #else
 	if (debug_zval) {
-		xdebug_str_add(str, xdebug_sprintf("(refcount=%d, is_ref=%d)=", (*struc)->refcount__gc, (*struc)->is_ref__gc), 1);
+		xdebug_str_add_fmt(str, "(refcount=%d, is_ref=%d)=", (*struc)->refcount__gc, (*struc)->is_ref__gc);
 	}
 #endif
 
@@ -1058,11 +1058,11 @@ void xdebug_var_export(zval **struc, xdebug_str *str, int level, int debug_zval,
 #if PHP_VERSION_ID >= 70000
 		case IS_TRUE:
 		case IS_FALSE:
-			xdebug_str_add(str, xdebug_sprintf("%s", Z_TYPE_P(*struc) == IS_TRUE ? "TRUE" : "FALSE"), 1);
+			xdebug_str_add(str, Z_TYPE_P(*struc) == IS_TRUE ? "TRUE" : "FALSE", 0);
 			break;
 #else
 		case IS_BOOL:
-			xdebug_str_add(str, xdebug_sprintf("%s", Z_LVAL_P(*struc) ? "TRUE" : "FALSE"), 1);
+			xdebug_str_add(str, Z_LVAL_P(*struc) ? "TRUE" : "FALSE", 0);
 			break;
 #endif
 
@@ -1071,11 +1071,11 @@ void xdebug_var_export(zval **struc, xdebug_str *str, int level, int debug_zval,
 			break;
 
 		case IS_LONG:
-			xdebug_str_add(str, xdebug_sprintf(XDEBUG_INT_FMT, Z_LVAL_P(*struc)), 1);
+			xdebug_str_add_long(str, Z_LVAL_P(*struc));
 			break;
 
 		case IS_DOUBLE:
-			xdebug_str_add(str, xdebug_sprintf("%.*G", (int) EG(precision), Z_DVAL_P(*struc)), 1);
+			xdebug_str_add_double(str, Z_DVAL_P(*struc), (int) EG(precision));
 			break;
 
 		case IS_STRING: {
@@ -1096,10 +1096,10 @@ void xdebug_var_export(zval **struc, xdebug_str *str, int level, int debug_zval,
 			if (options->no_decoration) {
 				xdebug_str_add(str, tmp_str, 0);
 			} else if ((size_t) Z_STRLEN_P(*struc) <= (size_t) options->max_data) {
-				xdebug_str_add(str, xdebug_sprintf("'%s'", tmp_str), 1);
+				xdebug_str_add_fmt(str, "'%s'", tmp_str);
 			} else {
 				xdebug_str_addl(str, "'", 1, 0);
-				xdebug_str_addl(str, xdebug_sprintf("%s", tmp_str), options->max_data, 1);
+				xdebug_str_addl(str, tmp_str, options->max_data, 0);
 				xdebug_str_addl(str, "...'", 4, 0);
 			}
 			efree(tmp_str);
@@ -1140,7 +1140,7 @@ void xdebug_var_export(zval **struc, xdebug_str *str, int level, int debug_zval,
 			myht = xdebug_objdebug_pp(struc, &is_temp TSRMLS_CC);
 			if (XDEBUG_APPLY_COUNT(myht) < 1) {
 				char *class_name = (char*) STR_NAME_VAL(Z_OBJCE_P(*struc)->name);
-				xdebug_str_add(str, xdebug_sprintf("class %s { ", class_name), 1);
+				xdebug_str_add_fmt(str, "class %s { ", class_name);
 
 				if (level <= options->max_depth) {
 					options->runtime[level].current_element_nr = 0;
@@ -1178,10 +1178,10 @@ void xdebug_var_export(zval **struc, xdebug_str *str, int level, int debug_zval,
 
 #if PHP_VERSION_ID >= 70000
 			type_name = (char *) zend_rsrc_list_get_rsrc_type(Z_RES_P(*struc) TSRMLS_CC);
-			xdebug_str_add(str, xdebug_sprintf("resource(%ld) of type (%s)", Z_RES_P(*struc)->handle, type_name ? type_name : "Unknown"), 1);
+			xdebug_str_add_fmt(str, "resource(%ld) of type (%s)", Z_RES_P(*struc)->handle, type_name ? type_name : "Unknown");
 #else
 			type_name = (char *) zend_rsrc_list_get_rsrc_type(Z_LVAL_P(*struc) TSRMLS_CC);
-			xdebug_str_add(str, xdebug_sprintf("resource(%ld) of type (%s)", Z_LVAL_P(*struc), type_name ? type_name : "Unknown"), 1);
+			xdebug_str_add_fmt(str, "resource(%ld) of type (%s)", Z_LVAL_P(*struc), type_name ? type_name : "Unknown");
 #endif
 			break;
 		}
@@ -1233,7 +1233,7 @@ static void xdebug_var_synopsis(zval **struc, xdebug_str *str, int level, int de
 #if PHP_VERSION_ID >= 70000
 	if (debug_zval) {
 		if (Z_TYPE_P(*struc) >= IS_STRING && Z_TYPE_P(*struc) != IS_INDIRECT) {
-			xdebug_str_add(str, xdebug_sprintf("(refcount=%d, is_ref=%d)=", (*struc)->value.counted->gc.refcount, Z_TYPE_P(*struc) == IS_REFERENCE), 1);
+			xdebug_str_add_fmt(str, "(refcount=%d, is_ref=%d)=", (*struc)->value.counted->gc.refcount, Z_TYPE_P(*struc) == IS_REFERENCE);
 		} else {
 			xdebug_str_add(str, "(refcount=0, is_ref=0)=", 0);
 		}
@@ -1244,7 +1244,7 @@ static void xdebug_var_synopsis(zval **struc, xdebug_str *str, int level, int de
 	}
 #else
 	if (debug_zval) {
-		xdebug_str_add(str, xdebug_sprintf("(refcount=%d, is_ref=%d)=", (*struc)->refcount__gc, (*struc)->is_ref__gc), 1);
+		xdebug_str_add_fmt(str, "(refcount=%d, is_ref=%d)=", (*struc)->refcount__gc, (*struc)->is_ref__gc);
 	}
 #endif
 
@@ -1275,16 +1275,16 @@ static void xdebug_var_synopsis(zval **struc, xdebug_str *str, int level, int de
 			break;
 
 		case IS_STRING:
-			xdebug_str_add(str, xdebug_sprintf("string(%d)", Z_STRLEN_P(*struc)), 1);
+			xdebug_str_add_fmt(str, "string(%d)", Z_STRLEN_P(*struc));
 			break;
 
 		case IS_ARRAY:
 			myht = Z_ARRVAL_P(*struc);
-			xdebug_str_add(str, xdebug_sprintf("array(%d)", myht->nNumOfElements), 1);
+			xdebug_str_add_fmt(str, "array(%d)", myht->nNumOfElements);
 			break;
 
 		case IS_OBJECT: {
-			xdebug_str_add(str, xdebug_sprintf("class %s", STR_NAME_VAL(Z_OBJCE_P(*struc)->name)), 1);
+			xdebug_str_add_fmt(str, "class %s", STR_NAME_VAL(Z_OBJCE_P(*struc)->name));
 			break;
 		}
 
@@ -1293,10 +1293,10 @@ static void xdebug_var_synopsis(zval **struc, xdebug_str *str, int level, int de
 
 #if PHP_VERSION_ID >= 70000
 			type_name = (char *) zend_rsrc_list_get_rsrc_type(Z_RES_P(*struc) TSRMLS_CC);
-			xdebug_str_add(str, xdebug_sprintf("resource(%ld) of type (%s)", Z_RES_P(*struc)->handle, type_name ? type_name : "Unknown"), 1);
+			xdebug_str_add_fmt(str, "resource(%ld) of type (%s)", Z_RES_P(*struc)->handle, type_name ? type_name : "Unknown");
 #else
 			type_name = (char *) zend_rsrc_list_get_rsrc_type(Z_LVAL_P(*struc) TSRMLS_CC);
-			xdebug_str_add(str, xdebug_sprintf("resource(%ld) of type (%s)", Z_LVAL_P(*struc), type_name ? type_name : "Unknown"), 1);
+			xdebug_str_add_fmt(str, "resource(%ld) of type (%s)", Z_LVAL_P(*struc), type_name ? type_name : "Unknown");
 #endif
 			break;
 		}
@@ -1371,13 +1371,13 @@ static int xdebug_array_element_export_text_ansi(zval **zv TSRMLS_DC, int num_ar
 	if (options->runtime[level].current_element_nr >= options->runtime[level].start_element_nr &&
 		options->runtime[level].current_element_nr < options->runtime[level].end_element_nr)
 	{
-		xdebug_str_add(str, xdebug_sprintf("%*s", (level * 2), ""), 1);
+		xdebug_str_add_fmt(str, "%*s", (level * 2), "");
 
 		if (HASH_KEY_IS_NUMERIC(hash_key)) { /* numeric key */
 #if PHP_VERSION_ID >= 70000
-			xdebug_str_add(str, xdebug_sprintf("[" XDEBUG_INT_FMT "] %s=>%s\n", index_key, ANSI_COLOR_POINTER, ANSI_COLOR_RESET), 1);
+			xdebug_str_add_fmt(str, "[" XDEBUG_INT_FMT "] %s=>%s\n", index_key, ANSI_COLOR_POINTER, ANSI_COLOR_RESET);
 #else
-			xdebug_str_add(str, xdebug_sprintf("[" XDEBUG_INT_FMT "] %s=>%s\n", HASH_APPLY_NUMERIC(hash_key), ANSI_COLOR_POINTER, ANSI_COLOR_RESET), 1);
+			xdebug_str_add_fmt(str, "[" XDEBUG_INT_FMT "] %s=>%s\n", HASH_APPLY_NUMERIC(hash_key), ANSI_COLOR_POINTER, ANSI_COLOR_RESET);
 #endif
 		} else { /* string key */
 			SIZETorINT newlen = 0;
@@ -1398,7 +1398,7 @@ static int xdebug_array_element_export_text_ansi(zval **zv TSRMLS_DC, int num_ar
 		xdebug_var_export_text_ansi(zv, str, mode, level + 1, debug_zval, options TSRMLS_CC);
 	}
 	if (options->runtime[level].current_element_nr == options->runtime[level].end_element_nr) {
-		xdebug_str_add(str, xdebug_sprintf("\n%*s(more elements)...\n", (level * 2), ""), 1);
+		xdebug_str_add_fmt(str, "\n%*s(more elements)...\n", (level * 2), "");
 	}
 	options->runtime[level].current_element_nr++;
 	return 0;
@@ -1421,23 +1421,23 @@ static int xdebug_object_element_export_text_ansi(zval **zv TSRMLS_DC, int num_a
 	if (options->runtime[level].current_element_nr >= options->runtime[level].start_element_nr &&
 		options->runtime[level].current_element_nr < options->runtime[level].end_element_nr)
 	{
-		xdebug_str_add(str, xdebug_sprintf("%*s", (level * 2), ""), 1);
+		xdebug_str_add_fmt(str, "%*s", (level * 2), "");
 
 		if (!HASH_KEY_IS_NUMERIC(hash_key)) {
 			char *prop_name, *class_name, *modifier;
 
 			modifier = xdebug_get_property_info((char*) HASH_APPLY_KEY_VAL(hash_key), HASH_APPLY_KEY_LEN(hash_key), &prop_name, &class_name);
-			xdebug_str_add(str, xdebug_sprintf("%s%s%s%s%s $%s %s=>%s\n",
+			xdebug_str_add_fmt(str, "%s%s%s%s%s $%s %s=>%s\n",
 			               ANSI_COLOR_MODIFIER, ANSI_COLOR_BOLD, modifier, ANSI_COLOR_BOLD_OFF, ANSI_COLOR_RESET,
-			               prop_name, ANSI_COLOR_POINTER, ANSI_COLOR_RESET), 1);
+			               prop_name, ANSI_COLOR_POINTER, ANSI_COLOR_RESET);
 
 			xdfree(prop_name);
 			xdfree(class_name);
 		} else {
-			xdebug_str_add(str, xdebug_sprintf("%s%spublic%s%s ${%d} %s=>%s\n",
+			xdebug_str_add_fmt(str, "%s%spublic%s%s ${%d} %s=>%s\n",
 			               ANSI_COLOR_MODIFIER, ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF, ANSI_COLOR_RESET,
 #if PHP_VERSION_ID >= 70000
-			               index_key, ANSI_COLOR_POINTER, ANSI_COLOR_RESET), 1);
+			               index_key, ANSI_COLOR_POINTER, ANSI_COLOR_RESET);
 #else
 			               HASH_APPLY_NUMERIC(hash_key), ANSI_COLOR_POINTER, ANSI_COLOR_RESET), 1);
 #endif
@@ -1445,7 +1445,7 @@ static int xdebug_object_element_export_text_ansi(zval **zv TSRMLS_DC, int num_a
 		xdebug_var_export_text_ansi(zv, str, mode, level + 1, debug_zval, options TSRMLS_CC);
 	}
 	if (options->runtime[level].current_element_nr == options->runtime[level].end_element_nr) {
-		xdebug_str_add(str, xdebug_sprintf("\n%*s(more elements)...\n", (level * 2), ""), 1);
+		xdebug_str_add_fmt(str, "\n%*s(more elements)...\n", (level * 2), "");
 	}
 	options->runtime[level].current_element_nr++;
 	return 0;
@@ -1468,12 +1468,12 @@ void xdebug_var_export_text_ansi(zval **struc, xdebug_str *str, int mode, int le
 		return;
 	}
 
-	xdebug_str_add(str, xdebug_sprintf("%*s", (level * 2) - 2, ""), 1);
+	xdebug_str_add_fmt(str, "%*s", (level * 2) - 2, "");
 
 #if PHP_VERSION_ID >= 70000
 	if (debug_zval) {
 		if (Z_TYPE_P(*struc) >= IS_STRING && Z_TYPE_P(*struc) != IS_INDIRECT) {
-			xdebug_str_add(str, xdebug_sprintf("(refcount=%d, is_ref=%d)=", (*struc)->value.counted->gc.refcount, Z_TYPE_P(*struc) == IS_REFERENCE), 1);
+			xdebug_str_add_fmt(str, "(refcount=%d, is_ref=%d)=", (*struc)->value.counted->gc.refcount, Z_TYPE_P(*struc) == IS_REFERENCE);
 		} else {
 			xdebug_str_add(str, "(refcount=0, is_ref=0)=", 0);
 		}
@@ -1484,7 +1484,7 @@ void xdebug_var_export_text_ansi(zval **struc, xdebug_str *str, int mode, int le
 	}
 #else
 	if (debug_zval) {
-		xdebug_str_add(str, xdebug_sprintf("(refcount=%d, is_ref=%d)=", (*struc)->refcount__gc, (*struc)->is_ref__gc), 1);
+		xdebug_str_add_fmt(str, "(refcount=%d, is_ref=%d)=", (*struc)->refcount__gc, (*struc)->is_ref__gc);
 	}
 #endif
 
@@ -1492,23 +1492,23 @@ void xdebug_var_export_text_ansi(zval **struc, xdebug_str *str, int mode, int le
 #if PHP_VERSION_ID >= 70000
 		case IS_TRUE:
 		case IS_FALSE:
-			xdebug_str_add(str, xdebug_sprintf("%sbool%s(%s%s%s)", ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF, ANSI_COLOR_BOOL, Z_TYPE_P(*struc) == IS_TRUE ? "true" : "false", ANSI_COLOR_RESET), 1);
+			xdebug_str_add_fmt(str, "%sbool%s(%s%s%s)", ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF, ANSI_COLOR_BOOL, Z_TYPE_P(*struc) == IS_TRUE ? "true" : "false", ANSI_COLOR_RESET);
 			break;
 #else
 		case IS_BOOL:
-			xdebug_str_add(str, xdebug_sprintf("%sbool%s(%s%s%s)", ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF, ANSI_COLOR_BOOL, Z_LVAL_P(*struc) ? "true" : "false", ANSI_COLOR_RESET), 1);
+			xdebug_str_add_fmt(str, "%sbool%s(%s%s%s)", ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF, ANSI_COLOR_BOOL, Z_LVAL_P(*struc) ? "true" : "false", ANSI_COLOR_RESET);
 			break;
 #endif
 		case IS_NULL:
-			xdebug_str_add(str, xdebug_sprintf("%s%sNULL%s%s", ANSI_COLOR_BOLD, ANSI_COLOR_NULL, ANSI_COLOR_RESET, ANSI_COLOR_BOLD_OFF), 1);
+			xdebug_str_add_fmt(str, "%s%sNULL%s%s", ANSI_COLOR_BOLD, ANSI_COLOR_NULL, ANSI_COLOR_RESET, ANSI_COLOR_BOLD_OFF);
 			break;
 
 		case IS_LONG:
-			xdebug_str_add(str, xdebug_sprintf("%sint%s(%s" XDEBUG_INT_FMT "%s)", ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF, ANSI_COLOR_LONG, Z_LVAL_P(*struc), ANSI_COLOR_RESET), 1);
+			xdebug_str_add_fmt(str, "%sint%s(%s" XDEBUG_INT_FMT "%s)", ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF, ANSI_COLOR_LONG, Z_LVAL_P(*struc), ANSI_COLOR_RESET);
 			break;
 
 		case IS_DOUBLE:
-			xdebug_str_add(str, xdebug_sprintf("%sdouble%s(%s%.*G%s)", ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF, ANSI_COLOR_DOUBLE, (int) EG(precision), Z_DVAL_P(*struc), ANSI_COLOR_RESET), 1);
+			xdebug_str_add_fmt(str, "%sdouble%s(%s%.*G%s)", ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF, ANSI_COLOR_DOUBLE, (int) EG(precision), Z_DVAL_P(*struc), ANSI_COLOR_RESET);
 			break;
 
 		case IS_STRING: {
@@ -1530,16 +1530,16 @@ void xdebug_var_export_text_ansi(zval **struc, xdebug_str *str, int mode, int le
 			if (options->no_decoration) {
 				xdebug_str_addl(str, tmp_str, tmp_len, 0);
 			} else if ((size_t) Z_STRLEN_P(*struc) <= (size_t) options->max_data) {
-				xdebug_str_add(str, xdebug_sprintf("%sstring%s(%s%ld%s) \"%s%s%s\"",
+				xdebug_str_add_fmt(str, "%sstring%s(%s%ld%s) \"%s%s%s\"",
 					ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF,
 					ANSI_COLOR_LONG, Z_STRLEN_P(*struc), ANSI_COLOR_RESET,
-					ANSI_COLOR_STRING, tmp_str, ANSI_COLOR_RESET), 1);
+					ANSI_COLOR_STRING, tmp_str, ANSI_COLOR_RESET);
 			} else {
-				xdebug_str_add(str, xdebug_sprintf("%sstring%s(%s%ld%s) \"%s",
+				xdebug_str_add_fmt(str, "%sstring%s(%s%ld%s) \"%s",
 					ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF,
-					ANSI_COLOR_LONG, Z_STRLEN_P(*struc), ANSI_COLOR_RESET, ANSI_COLOR_STRING), 1);
+					ANSI_COLOR_LONG, Z_STRLEN_P(*struc), ANSI_COLOR_RESET, ANSI_COLOR_STRING);
 				xdebug_str_addl(str, tmp_str, options->max_data, 0);
-				xdebug_str_add(str, xdebug_sprintf("%s\"...", ANSI_COLOR_RESET), 1);
+				xdebug_str_add_fmt(str, "%s\"...", ANSI_COLOR_RESET);
 			}
 			efree(tmp_str);
 		} break;
@@ -1547,7 +1547,7 @@ void xdebug_var_export_text_ansi(zval **struc, xdebug_str *str, int mode, int le
 		case IS_ARRAY:
 			myht = Z_ARRVAL_P(*struc);
 			if (XDEBUG_APPLY_COUNT(myht) < 1) {
-				xdebug_str_add(str, xdebug_sprintf("%sarray%s(%s%d%s) {\n", ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF, ANSI_COLOR_LONG, myht->nNumOfElements, ANSI_COLOR_RESET), 1);
+				xdebug_str_add_fmt(str, "%sarray%s(%s%d%s) {\n", ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF, ANSI_COLOR_LONG, myht->nNumOfElements, ANSI_COLOR_RESET);
 				if (level <= options->max_depth) {
 					options->runtime[level].current_element_nr = 0;
 					options->runtime[level].start_element_nr = 0;
@@ -1563,22 +1563,22 @@ void xdebug_var_export_text_ansi(zval **struc, xdebug_str *str, int mode, int le
 					zend_hash_apply_with_arguments(myht TSRMLS_CC, (apply_func_args_t) xdebug_array_element_export_text_ansi, 5, level, mode, str, debug_zval, options);
 #endif
 				} else {
-					xdebug_str_add(str, xdebug_sprintf("%*s...\n", (level * 2), ""), 1);
+					xdebug_str_add_fmt(str, "%*s...\n", (level * 2), "");
 				}
-				xdebug_str_add(str, xdebug_sprintf("%*s}", (level * 2) - 2 , ""), 1);
+				xdebug_str_add_fmt(str, "%*s}", (level * 2) - 2 , "");
 			} else {
-				xdebug_str_add(str, xdebug_sprintf("&%sarray%s", ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF), 1);
+				xdebug_str_add_fmt(str, "&%sarray%s", ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF);
 			}
 			break;
 
 		case IS_OBJECT:
 			myht = xdebug_objdebug_pp(struc, &is_temp TSRMLS_CC);
 			if (myht && XDEBUG_APPLY_COUNT(myht) < 1) {
-				xdebug_str_add(str, xdebug_sprintf("%sclass%s %s%s%s#%d (%s%d%s) {\n",
+				xdebug_str_add_fmt(str, "%sclass%s %s%s%s#%d (%s%d%s) {\n",
 					ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF,
 					ANSI_COLOR_OBJECT, STR_NAME_VAL(Z_OBJCE_P(*struc)->name), ANSI_COLOR_RESET,
 					Z_OBJ_HANDLE_P(*struc),
-					ANSI_COLOR_LONG, myht->nNumOfElements, ANSI_COLOR_RESET), 1);
+					ANSI_COLOR_LONG, myht->nNumOfElements, ANSI_COLOR_RESET);
 
 				if (level <= options->max_depth) {
 					options->runtime[level].current_element_nr = 0;
@@ -1594,11 +1594,11 @@ void xdebug_var_export_text_ansi(zval **struc, xdebug_str *str, int mode, int le
 					zend_hash_apply_with_arguments(myht TSRMLS_CC, (apply_func_args_t) xdebug_object_element_export_text_ansi, 5, level, mode, str, debug_zval, options);
 #endif
 				} else {
-					xdebug_str_add(str, xdebug_sprintf("%*s...\n", (level * 2), ""), 1);
+					xdebug_str_add_fmt(str, "%*s...\n", (level * 2), "");
 				}
-				xdebug_str_add(str, xdebug_sprintf("%*s}", (level * 2) - 2, ""), 1);
+				xdebug_str_add_fmt(str, "%*s}", (level * 2) - 2, "");
 			} else {
-				xdebug_str_add(str, xdebug_sprintf("%*s...\n", (level * 2), ""), 1);
+				xdebug_str_add_fmt(str, "%*s...\n", (level * 2), "");
 			}
 			if (is_temp) {
 				zend_hash_destroy(myht);
@@ -1611,26 +1611,26 @@ void xdebug_var_export_text_ansi(zval **struc, xdebug_str *str, int mode, int le
 
 #if PHP_VERSION_ID >= 70000
 			type_name = (char *) zend_rsrc_list_get_rsrc_type(Z_RES_P(*struc) TSRMLS_CC);
-			xdebug_str_add(str, xdebug_sprintf("%sresource%s(%s%ld%s) of type (%s)",
+			xdebug_str_add_fmt(str, "%sresource%s(%s%ld%s) of type (%s)",
 				ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF,
-				ANSI_COLOR_RESOURCE, Z_RES_P(*struc)->handle, ANSI_COLOR_RESET, type_name ? type_name : "Unknown"), 1);
+				ANSI_COLOR_RESOURCE, Z_RES_P(*struc)->handle, ANSI_COLOR_RESET, type_name ? type_name : "Unknown");
 #else
 			type_name = (char *) zend_rsrc_list_get_rsrc_type(Z_LVAL_P(*struc) TSRMLS_CC);
-			xdebug_str_add(str, xdebug_sprintf("%sresource%s(%s%ld%s) of type (%s)",
+			xdebug_str_add_fmt(str, "%sresource%s(%s%ld%s) of type (%s)",
 				ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF,
-				ANSI_COLOR_RESOURCE, Z_LVAL_P(*struc), ANSI_COLOR_RESET, type_name ? type_name : "Unknown"), 1);
+				ANSI_COLOR_RESOURCE, Z_LVAL_P(*struc), ANSI_COLOR_RESET, type_name ? type_name : "Unknown");
 #endif
 			break;
 		}
 
 #if PHP_VERSION_ID >= 70000
 		case IS_UNDEF:
-			xdebug_str_add(str, xdebug_sprintf("%s*uninitialized*%s", ANSI_COLOR_NULL, ANSI_COLOR_RESET), 0);
+			xdebug_str_add_fmt(str, "%s*uninitialized*%s", ANSI_COLOR_NULL, ANSI_COLOR_RESET);
 			break;
 #endif
 
 		default:
-			xdebug_str_add(str, xdebug_sprintf("%sNFC%s", ANSI_COLOR_NULL, ANSI_COLOR_RESET), 0);
+			xdebug_str_add_fmt(str, "%sNFC%s", ANSI_COLOR_NULL, ANSI_COLOR_RESET);
 			break;
 	}
 
@@ -1648,7 +1648,7 @@ char* xdebug_get_zval_value_text_ansi(zval *val, int mode, int debug_zval, xdebu
 	}
 
 	if (options->show_location && !debug_zval) {
-		xdebug_str_add(&str, xdebug_sprintf("%s%s%s:%s%d%s:\n", ANSI_COLOR_BOLD, zend_get_executed_filename(TSRMLS_C), ANSI_COLOR_BOLD_OFF, ANSI_COLOR_BOLD, zend_get_executed_lineno(TSRMLS_C), ANSI_COLOR_BOLD_OFF), 1);
+		xdebug_str_add_fmt(&str, "%s%s%s:%s%d%s:\n", ANSI_COLOR_BOLD, zend_get_executed_filename(TSRMLS_C), ANSI_COLOR_BOLD_OFF, ANSI_COLOR_BOLD, zend_get_executed_lineno(TSRMLS_C), ANSI_COLOR_BOLD_OFF);
 	}
 
 	xdebug_var_export_text_ansi(&val, (xdebug_str*) &str, mode, 1, debug_zval, options TSRMLS_CC);
@@ -1675,7 +1675,7 @@ static void xdebug_var_synopsis_text_ansi(zval **struc, xdebug_str *str, int mod
 #if PHP_VERSION_ID >= 70000
 	if (debug_zval) {
 		if (Z_TYPE_P(*struc) >= IS_STRING && Z_TYPE_P(*struc) != IS_INDIRECT) {
-			xdebug_str_add(str, xdebug_sprintf("(refcount=%d, is_ref=%d)=", (*struc)->value.counted->gc.refcount, Z_TYPE_P(*struc) == IS_REFERENCE), 1);
+			xdebug_str_add_fmt(str, "(refcount=%d, is_ref=%d)=", (*struc)->value.counted->gc.refcount, Z_TYPE_P(*struc) == IS_REFERENCE);
 		} else {
 			xdebug_str_add(str, "(refcount=0, is_ref=0)=", 0);
 		}
@@ -1686,47 +1686,47 @@ static void xdebug_var_synopsis_text_ansi(zval **struc, xdebug_str *str, int mod
 	}
 #else
 	if (debug_zval) {
-		xdebug_str_add(str, xdebug_sprintf("(refcount=%d, is_ref=%d)=", (*struc)->refcount__gc, (*struc)->is_ref__gc), 1);
+		xdebug_str_add_fmt(str, "(refcount=%d, is_ref=%d)=", (*struc)->refcount__gc, (*struc)->is_ref__gc);
 	}
 #endif
 
 	switch (Z_TYPE_P(*struc)) {
 #if PHP_VERSION_ID >= 70000
 		case IS_TRUE:
-			xdebug_str_add(str, xdebug_sprintf("%strue%s", ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF), 1);
+			xdebug_str_add_fmt(str, "%strue%s", ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF);
 			break;
 
 		case IS_FALSE:
-			xdebug_str_add(str, xdebug_sprintf("%sfalse%s", ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF), 1);
+			xdebug_str_add_fmt(str, "%sfalse%s", ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF);
 			break;
 #else
 		case IS_BOOL:
-			xdebug_str_add(str, xdebug_sprintf("%sbool%s", ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF), 1);
+			xdebug_str_add_fmt(str, "%sbool%s", ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF);
 			break;
 #endif
 		case IS_NULL:
-			xdebug_str_add(str, xdebug_sprintf("%snull%s", ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF), 1);
+			xdebug_str_add_fmt(str, "%snull%s", ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF);
 			break;
 
 		case IS_LONG:
-			xdebug_str_add(str, xdebug_sprintf("%sint%s", ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF), 1);
+			xdebug_str_add_fmt(str, "%sint%s", ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF);
 			break;
 
 		case IS_DOUBLE:
-			xdebug_str_add(str, xdebug_sprintf("%sdouble%s", ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF), 1);
+			xdebug_str_add_fmt(str, "%sdouble%s", ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF);
 			break;
 
 		case IS_STRING:
-			xdebug_str_add(str, xdebug_sprintf("%sstring%s(%s%d%s)", ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF, ANSI_COLOR_LONG, Z_STRLEN_P(*struc), ANSI_COLOR_RESET), 1);
+			xdebug_str_add_fmt(str, "%sstring%s(%s%d%s)", ANSI_COLOR_BOLD, ANSI_COLOR_BOLD_OFF, ANSI_COLOR_LONG, Z_STRLEN_P(*struc), ANSI_COLOR_RESET);
 			break;
 
 		case IS_ARRAY:
 			myht = Z_ARRVAL_P(*struc);
-			xdebug_str_add(str, xdebug_sprintf("array(%s%d%s)", ANSI_COLOR_LONG, myht->nNumOfElements, ANSI_COLOR_RESET), 1);
+			xdebug_str_add_fmt(str, "array(%s%d%s)", ANSI_COLOR_LONG, myht->nNumOfElements, ANSI_COLOR_RESET);
 			break;
 
 		case IS_OBJECT: {
-			xdebug_str_add(str, xdebug_sprintf("class %s", STR_NAME_VAL(Z_OBJCE_P(*struc)->name)), 1);
+			xdebug_str_add_fmt(str, "class %s", STR_NAME_VAL(Z_OBJCE_P(*struc)->name));
 			break;
 		}
 
@@ -1735,22 +1735,22 @@ static void xdebug_var_synopsis_text_ansi(zval **struc, xdebug_str *str, int mod
 
 #if PHP_VERSION_ID >= 70000
 			type_name = (char *) zend_rsrc_list_get_rsrc_type(Z_RES_P(*struc) TSRMLS_CC);
-			xdebug_str_add(str, xdebug_sprintf("resource(%s%ld%s) of type (%s)", ANSI_COLOR_LONG, Z_RES_P(*struc)->handle, ANSI_COLOR_RESET, type_name ? type_name : "Unknown"), 1);
+			xdebug_str_add_fmt(str, "resource(%s%ld%s) of type (%s)", ANSI_COLOR_LONG, Z_RES_P(*struc)->handle, ANSI_COLOR_RESET, type_name ? type_name : "Unknown");
 #else
 			type_name = (char *) zend_rsrc_list_get_rsrc_type(Z_LVAL_P(*struc) TSRMLS_CC);
-			xdebug_str_add(str, xdebug_sprintf("resource(%s%ld%s) of type (%s)", ANSI_COLOR_LONG, Z_LVAL_P(*struc), ANSI_COLOR_RESET, type_name ? type_name : "Unknown"), 1);
+			xdebug_str_add_fmt(str, "resource(%s%ld%s) of type (%s)", ANSI_COLOR_LONG, Z_LVAL_P(*struc), ANSI_COLOR_RESET, type_name ? type_name : "Unknown");
 #endif
 			break;
 		}
 
 #if PHP_VERSION_ID >= 70000
 		case IS_UNDEF:
-			xdebug_str_add(str, xdebug_sprintf("%s*uninitialized*%s", ANSI_COLOR_NULL, ANSI_COLOR_RESET), 0);
+			xdebug_str_add_fmt(str, "%s*uninitialized*%s", ANSI_COLOR_NULL, ANSI_COLOR_RESET);
 			break;
 #endif
 
 		default:
-			xdebug_str_add(str, xdebug_sprintf("%sNFC%s", ANSI_COLOR_NULL, ANSI_COLOR_RESET), 0);
+			xdebug_str_add_fmt(str, "%sNFC%s", ANSI_COLOR_NULL, ANSI_COLOR_RESET);
 			break;
 	}
 }
@@ -1766,7 +1766,7 @@ char* xdebug_get_zval_synopsis_text_ansi(zval *val, int mode, int debug_zval, xd
 	}
 
 	if (options->show_location && !debug_zval) {
-		xdebug_str_add(&str, xdebug_sprintf("%s%s: %d%s\n", ANSI_COLOR_BOLD, zend_get_executed_filename(TSRMLS_C), zend_get_executed_lineno(TSRMLS_C), ANSI_COLOR_BOLD_OFF), 1);
+		xdebug_str_add_fmt(&str, "%s%s: %d%s\n", ANSI_COLOR_BOLD, zend_get_executed_filename(TSRMLS_C), zend_get_executed_lineno(TSRMLS_C), ANSI_COLOR_BOLD_OFF);
 	}
 
 	xdebug_var_synopsis_text_ansi(&val, (xdebug_str*) &str, mode, 1, debug_zval, options TSRMLS_CC);
@@ -1927,7 +1927,7 @@ static int xdebug_array_element_export_xml_node(zval **zv TSRMLS_DC, int num_arg
 #endif
 			name_len = strlen(name);
 			if (parent_name) {
-				xdebug_str_add(&full_name, xdebug_sprintf("%s[%s]", parent_name, name), 1);
+				xdebug_str_add_fmt(&full_name, "%s[%s]", parent_name, name);
 			}
 		}
 
@@ -2387,25 +2387,25 @@ static int xdebug_array_element_export_fancy(zval **zv TSRMLS_DC, int num_args,
 	if (options->runtime[level].current_element_nr >= options->runtime[level].start_element_nr &&
 		options->runtime[level].current_element_nr < options->runtime[level].end_element_nr)
 	{
-		xdebug_str_add(str, xdebug_sprintf("%*s", (level * 4) - 2, ""), 1);
+		xdebug_str_add_fmt(str, "%*s", (level * 4) - 2, "");
 
 		if (HASH_KEY_IS_NUMERIC(hash_key)) { /* numeric key */
 #if PHP_VERSION_ID >= 70000
-			xdebug_str_add(str, xdebug_sprintf(XDEBUG_INT_FMT " <font color='%s'>=&gt;</font> ", index_key, COLOR_POINTER), 1);
+			xdebug_str_add_fmt(str, XDEBUG_INT_FMT " <font color='%s'>=&gt;</font> ", index_key, COLOR_POINTER);
 #else
-			xdebug_str_add(str, xdebug_sprintf(XDEBUG_INT_FMT " <font color='%s'>=&gt;</font> ", HASH_APPLY_NUMERIC(hash_key), COLOR_POINTER), 1);
+			xdebug_str_add_fmt(str, XDEBUG_INT_FMT " <font color='%s'>=&gt;</font> ", HASH_APPLY_NUMERIC(hash_key), COLOR_POINTER);
 #endif
 		} else { /* string key */
 			xdebug_str_addl(str, "'", 1, 0);
 			tmp_str = xdebug_xmlize((char*) HASH_APPLY_KEY_VAL(hash_key), HASH_APPLY_KEY_LEN(hash_key) - 1, &newlen);
 			xdebug_str_addl(str, tmp_str, newlen, 0);
 			efree(tmp_str);
-			xdebug_str_add(str, xdebug_sprintf("' <font color='%s'>=&gt;</font> ", COLOR_POINTER), 1);
+			xdebug_str_add_fmt(str, "' <font color='%s'>=&gt;</font> ", COLOR_POINTER);
 		}
 		xdebug_var_export_fancy(zv, str, level + 1, debug_zval, options TSRMLS_CC);
 	}
 	if (options->runtime[level].current_element_nr == options->runtime[level].end_element_nr) {
-		xdebug_str_add(str, xdebug_sprintf("%*s", (level * 4) - 2, ""), 1);
+		xdebug_str_add_fmt(str, "%*s", (level * 4) - 2, "");
 		xdebug_str_addl(str, "<i>more elements...</i>\n", 24, 0);
 	}
 	options->runtime[level].current_element_nr++;
@@ -2429,31 +2429,31 @@ static int xdebug_object_element_export_fancy(zval **zv TSRMLS_DC, int num_args,
 	if (options->runtime[level].current_element_nr >= options->runtime[level].start_element_nr &&
 		options->runtime[level].current_element_nr < options->runtime[level].end_element_nr)
 	{
-		xdebug_str_add(str, xdebug_sprintf("%*s", (level * 4) - 2, ""), 1);
+		xdebug_str_add_fmt(str, "%*s", (level * 4) - 2, "");
 
 		if (!HASH_KEY_IS_NUMERIC(hash_key)) {
 			char *prop_name, *modifier, *prop_class_name;
 
 			modifier = xdebug_get_property_info((char*) HASH_APPLY_KEY_VAL(hash_key), HASH_APPLY_KEY_LEN(hash_key), &prop_name, &prop_class_name);
 			if (strcmp(modifier, "private") != 0 || strcmp(class_name, prop_class_name) == 0) {
-				xdebug_str_add(str, xdebug_sprintf("<i>%s</i> '%s' <font color='%s'>=&gt;</font> ", modifier, prop_name, COLOR_POINTER), 1);
+				xdebug_str_add_fmt(str, "<i>%s</i> '%s' <font color='%s'>=&gt;</font> ", modifier, prop_name, COLOR_POINTER);
 			} else {
-				xdebug_str_add(str, xdebug_sprintf("<i>%s</i> '%s' <small>(%s)</small> <font color='%s'>=&gt;</font> ", modifier, prop_name, prop_class_name, COLOR_POINTER), 1);
+				xdebug_str_add_fmt(str, "<i>%s</i> '%s' <small>(%s)</small> <font color='%s'>=&gt;</font> ", modifier, prop_name, prop_class_name, COLOR_POINTER);
 			}
 
 			xdfree(prop_name);
 			xdfree(prop_class_name);
 		} else {
 #if PHP_VERSION_ID >= 70000
-			xdebug_str_add(str, xdebug_sprintf("<i>public</i> %d <font color='%s'>=&gt;</font> ", index_key, COLOR_POINTER), 1);
+			xdebug_str_add_fmt(str, "<i>public</i> %d <font color='%s'>=&gt;</font> ", index_key, COLOR_POINTER);
 #else
-			xdebug_str_add(str, xdebug_sprintf("<i>public</i> %d <font color='%s'>=&gt;</font> ", HASH_APPLY_NUMERIC(hash_key), COLOR_POINTER), 1);
+			xdebug_str_add_fmt(str, "<i>public</i> %d <font color='%s'>=&gt;</font> ", HASH_APPLY_NUMERIC(hash_key), COLOR_POINTER);
 #endif
 		}
 		xdebug_var_export_fancy(zv, str, level + 1, debug_zval, options TSRMLS_CC);
 	}
 	if (options->runtime[level].current_element_nr == options->runtime[level].end_element_nr) {
-		xdebug_str_add(str, xdebug_sprintf("%*s", (level * 4) - 2, ""), 1);
+		xdebug_str_add_fmt(str, "%*s", (level * 4) - 2, "");
 		xdebug_str_addl(str, "<i>more elements...</i>\n", 24, 0);
 	}
 	options->runtime[level].current_element_nr++;
@@ -2476,7 +2476,7 @@ void xdebug_var_export_fancy(zval **struc, xdebug_str *str, int level, int debug
 #if PHP_VERSION_ID >= 70000
 	if (debug_zval) {
 		if (Z_TYPE_P(*struc) >= IS_STRING && Z_TYPE_P(*struc) != IS_INDIRECT) {
-			xdebug_str_add(str, xdebug_sprintf("<i>(refcount=%d, is_ref=%d)</i>", (*struc)->value.counted->gc.refcount, Z_TYPE_P(*struc) == IS_REFERENCE), 1);
+			xdebug_str_add_fmt(str, "<i>(refcount=%d, is_ref=%d)</i>", (*struc)->value.counted->gc.refcount, Z_TYPE_P(*struc) == IS_REFERENCE);
 		} else {
 			xdebug_str_add(str, "<i>(refcount=0, is_ref=0)</i>", 0);
 		}
@@ -2487,7 +2487,7 @@ void xdebug_var_export_fancy(zval **struc, xdebug_str *str, int level, int debug
 	}
 #else
 	if (debug_zval) {
-		xdebug_str_add(str, xdebug_sprintf("<i>(refcount=%d, is_ref=%d)</i>,", (*struc)->refcount__gc, (*struc)->is_ref__gc), 1);
+		xdebug_str_add_fmt(str, "<i>(refcount=%d, is_ref=%d)</i>,", (*struc)->refcount__gc, (*struc)->is_ref__gc);
 	}
 #endif
 
@@ -2495,28 +2495,28 @@ void xdebug_var_export_fancy(zval **struc, xdebug_str *str, int level, int debug
 #if PHP_VERSION_ID >= 70000
 		case IS_TRUE:
 		case IS_FALSE:
-			xdebug_str_add(str, xdebug_sprintf("<small>boolean</small> <font color='%s'>%s</font>", COLOR_BOOL, Z_TYPE_P(*struc) == IS_TRUE ? "true" : "false"), 1);
+			xdebug_str_add_fmt(str, "<small>boolean</small> <font color='%s'>%s</font>", COLOR_BOOL, Z_TYPE_P(*struc) == IS_TRUE ? "true" : "false");
 			break;
 #else
 		case IS_BOOL:
-			xdebug_str_add(str, xdebug_sprintf("<small>boolean</small> <font color='%s'>%s</font>", COLOR_BOOL, Z_LVAL_P(*struc) ? "true" : "false"), 1);
+			xdebug_str_add_fmt(str, "<small>boolean</small> <font color='%s'>%s</font>", COLOR_BOOL, Z_LVAL_P(*struc) ? "true" : "false");
 			break;
 #endif
 
 		case IS_NULL:
-			xdebug_str_add(str, xdebug_sprintf("<font color='%s'>null</font>", COLOR_NULL), 1);
+			xdebug_str_add_fmt(str, "<font color='%s'>null</font>", COLOR_NULL);
 			break;
 
 		case IS_LONG:
-			xdebug_str_add(str, xdebug_sprintf("<small>int</small> <font color='%s'>" XDEBUG_INT_FMT "</font>", COLOR_LONG, Z_LVAL_P(*struc)), 1);
+			xdebug_str_add_fmt(str, "<small>int</small> <font color='%s'>" XDEBUG_INT_FMT "</font>", COLOR_LONG, Z_LVAL_P(*struc));
 			break;
 
 		case IS_DOUBLE:
-			xdebug_str_add(str, xdebug_sprintf("<small>float</small> <font color='%s'>%.*G</font>", COLOR_DOUBLE, (int) EG(precision), Z_DVAL_P(*struc)), 1);
+			xdebug_str_add_fmt(str, "<small>float</small> <font color='%s'>%.*G</font>", COLOR_DOUBLE, (int) EG(precision), Z_DVAL_P(*struc));
 			break;
 
 		case IS_STRING:
-			xdebug_str_add(str, xdebug_sprintf("<small>string</small> <font color='%s'>'", COLOR_STRING), 1);
+			xdebug_str_add_fmt(str, "<small>string</small> <font color='%s'>'", COLOR_STRING);
 			if ((size_t) Z_STRLEN_P(*struc) > (size_t) options->max_data) {
 				tmp_str = xdebug_xmlize(Z_STRVAL_P(*struc), options->max_data, &newlen);
 				xdebug_str_addl(str, tmp_str, newlen, 0);
@@ -2528,14 +2528,14 @@ void xdebug_var_export_fancy(zval **struc, xdebug_str *str, int level, int debug
 				efree(tmp_str);
 				xdebug_str_addl(str, "'</font>", 8, 0);
 			}
-			xdebug_str_add(str, xdebug_sprintf(" <i>(length=%d)</i>", Z_STRLEN_P(*struc)), 1);
+			xdebug_str_add_fmt(str, " <i>(length=%d)</i>", Z_STRLEN_P(*struc));
 			break;
 
 		case IS_ARRAY:
 			myht = Z_ARRVAL_P(*struc);
-			xdebug_str_add(str, xdebug_sprintf("\n%*s", (level - 1) * 4, ""), 1);
+			xdebug_str_add_fmt(str, "\n%*s", (level - 1) * 4, "");
 			if (XDEBUG_APPLY_COUNT(myht) < 1) {
-				xdebug_str_add(str, xdebug_sprintf("<b>array</b> <i>(size=%d)</i>\n", myht->nNumOfElements), 1);
+				xdebug_str_add_fmt(str, "<b>array</b> <i>(size=%d)</i>\n", myht->nNumOfElements);
 				if (level <= options->max_depth) {
 					if (myht->nNumOfElements) {
 						options->runtime[level].current_element_nr = 0;
@@ -2552,11 +2552,11 @@ void xdebug_var_export_fancy(zval **struc, xdebug_str *str, int level, int debug
 						zend_hash_apply_with_arguments(myht TSRMLS_CC, (apply_func_args_t) xdebug_array_element_export_fancy, 4, level, str, debug_zval, options);
 #endif
 					} else {
-						xdebug_str_add(str, xdebug_sprintf("%*s", (level * 4) - 2, ""), 1);
-						xdebug_str_add(str, xdebug_sprintf("<i><font color='%s'>empty</font></i>\n", COLOR_EMPTY), 1);
+						xdebug_str_add_fmt(str, "%*s", (level * 4) - 2, "");
+						xdebug_str_add_fmt(str, "<i><font color='%s'>empty</font></i>\n", COLOR_EMPTY);
 					}
 				} else {
-					xdebug_str_add(str, xdebug_sprintf("%*s...\n", (level * 4) - 2, ""), 1);
+					xdebug_str_add_fmt(str, "%*s...\n", (level * 4) - 2, "");
 				}
 			} else {
 				xdebug_str_addl(str, "<i>&amp;</i><b>array</b>\n", 21, 0);
@@ -2565,11 +2565,11 @@ void xdebug_var_export_fancy(zval **struc, xdebug_str *str, int level, int debug
 
 		case IS_OBJECT:
 			myht = xdebug_objdebug_pp(struc, &is_temp TSRMLS_CC);
-			xdebug_str_add(str, xdebug_sprintf("\n%*s", (level - 1) * 4, ""), 1);
+			xdebug_str_add_fmt(str, "\n%*s", (level - 1) * 4, "");
 			if (XDEBUG_APPLY_COUNT(myht) < 1) {
 				char *class_name = (char*) STR_NAME_VAL(Z_OBJCE_P(*struc)->name);
-				xdebug_str_add(str, xdebug_sprintf("<b>object</b>(<i>%s</i>)", class_name), 1);
-				xdebug_str_add(str, xdebug_sprintf("[<i>%d</i>]\n", Z_OBJ_HANDLE_P(*struc)), 1);
+				xdebug_str_add_fmt(str, "<b>object</b>(<i>%s</i>)", class_name);
+				xdebug_str_add_fmt(str, "[<i>%d</i>]\n", Z_OBJ_HANDLE_P(*struc));
 
 				if (level <= options->max_depth) {
 					options->runtime[level].current_element_nr = 0;
@@ -2586,11 +2586,11 @@ void xdebug_var_export_fancy(zval **struc, xdebug_str *str, int level, int debug
 					zend_hash_apply_with_arguments(myht TSRMLS_CC, (apply_func_args_t) xdebug_object_element_export_fancy, 5, level, str, debug_zval, options, class_name);
 #endif
 				} else {
-					xdebug_str_add(str, xdebug_sprintf("%*s...\n", (level * 4) - 2, ""), 1);
+					xdebug_str_add_fmt(str, "%*s...\n", (level * 4) - 2, "");
 				}
 			} else {
-				xdebug_str_add(str, xdebug_sprintf("<i>&amp;</i><b>object</b>(<i>%s</i>)", STR_NAME_VAL(Z_OBJCE_P(*struc)->name)), 1);
-				xdebug_str_add(str, xdebug_sprintf("[<i>%d</i>]\n", Z_OBJ_HANDLE_P(*struc)), 1);
+				xdebug_str_add_fmt(str, "<i>&amp;</i><b>object</b>(<i>%s</i>)", STR_NAME_VAL(Z_OBJCE_P(*struc)->name));
+				xdebug_str_add_fmt(str, "[<i>%d</i>]\n", Z_OBJ_HANDLE_P(*struc));
 			}
 			if (is_temp) {
 				zend_hash_destroy(myht);
@@ -2604,22 +2604,22 @@ void xdebug_var_export_fancy(zval **struc, xdebug_str *str, int level, int debug
 
 #if PHP_VERSION_ID >= 70000
 			type_name = (char *) zend_rsrc_list_get_rsrc_type(Z_RES_P(*struc) TSRMLS_CC);
-			xdebug_str_add(str, xdebug_sprintf("<b>resource</b>(<i>%ld</i><font color='%s'>,</font> <i>%s</i>)", Z_RES_P(*struc)->handle, COLOR_RESOURCE, type_name ? type_name : "Unknown"), 1);
+			xdebug_str_add_fmt(str, "<b>resource</b>(<i>%ld</i><font color='%s'>,</font> <i>%s</i>)", Z_RES_P(*struc)->handle, COLOR_RESOURCE, type_name ? type_name : "Unknown");
 #else
 			type_name = (char *) zend_rsrc_list_get_rsrc_type(Z_LVAL_P(*struc) TSRMLS_CC);
-			xdebug_str_add(str, xdebug_sprintf("<b>resource</b>(<i>%ld</i><font color='%s'>,</font> <i>%s</i>)", Z_LVAL_P(*struc), COLOR_RESOURCE, type_name ? type_name : "Unknown"), 1);
+			xdebug_str_add_fmt(str, "<b>resource</b>(<i>%ld</i><font color='%s'>,</font> <i>%s</i>)", Z_LVAL_P(*struc), COLOR_RESOURCE, type_name ? type_name : "Unknown");
 #endif
 			break;
 		}
 
 #if PHP_VERSION_ID >= 70000
 		case IS_UNDEF:
-			xdebug_str_add(str, xdebug_sprintf("<font color='%s'>*uninitialized*</font>", COLOR_NULL), 0);
+			xdebug_str_add_fmt(str, "<font color='%s'>*uninitialized*</font>", COLOR_NULL);
 			break;
 #endif
 
 		default:
-			xdebug_str_add(str, xdebug_sprintf("<font color='%s'>NFC</font>", COLOR_NULL), 0);
+			xdebug_str_add_fmt(str, "<font color='%s'>NFC</font>", COLOR_NULL);
 			break;
 	}
 	if (Z_TYPE_P(*struc) != IS_ARRAY && Z_TYPE_P(*struc) != IS_OBJECT) {
@@ -2643,10 +2643,10 @@ char* xdebug_get_zval_value_fancy(char *name, zval *val, int *len, int debug_zva
 			char *file_link;
 
 			xdebug_format_file_link(&file_link, zend_get_executed_filename(TSRMLS_C), zend_get_executed_lineno(TSRMLS_C) TSRMLS_CC);
-			xdebug_str_add(&str, xdebug_sprintf("\n<small><a href='%s'>%s:%d</a>:</small>", file_link, zend_get_executed_filename(TSRMLS_C), zend_get_executed_lineno(TSRMLS_C)), 1);
+			xdebug_str_add_fmt(&str, "\n<small><a href='%s'>%s:%d</a>:</small>", file_link, zend_get_executed_filename(TSRMLS_C), zend_get_executed_lineno(TSRMLS_C));
 			xdfree(file_link);
 		} else {
-			xdebug_str_add(&str, xdebug_sprintf("\n<small>%s:%d:</small>", zend_get_executed_filename(TSRMLS_C), zend_get_executed_lineno(TSRMLS_C)), 1);
+			xdebug_str_add_fmt(&str, "\n<small>%s:%d:</small>", zend_get_executed_filename(TSRMLS_C), zend_get_executed_lineno(TSRMLS_C));
 		}
 	}
 	xdebug_var_export_fancy(&val, (xdebug_str*) &str, 1, debug_zval, options TSRMLS_CC);
@@ -2724,7 +2724,7 @@ static void xdebug_var_synopsis_fancy(zval **struc, xdebug_str *str, int level,
 
 	if (debug_zval) {
 		if (Z_TYPE_P(*struc) >= IS_STRING && Z_TYPE_P(*struc) != IS_INDIRECT) {
-			xdebug_str_add(str, xdebug_sprintf("<i>(refcount=%d, is_ref=%d)</i>", (*struc)->value.counted->gc.refcount, Z_TYPE_P(*struc) == IS_REFERENCE), 1);
+			xdebug_str_add_fmt(str, "<i>(refcount=%d, is_ref=%d)</i>", (*struc)->value.counted->gc.refcount, Z_TYPE_P(*struc) == IS_REFERENCE);
 		} else {
 			xdebug_str_add(str, "<i>(refcount=0, is_ref=0)</i>", 0);
 		}
@@ -2735,7 +2735,7 @@ static void xdebug_var_synopsis_fancy(zval **struc, xdebug_str *str, int level,
 	}
 #else
 	if (debug_zval) {
-		xdebug_str_add(str, xdebug_sprintf("<i>(refcount=%d, is_ref=%d)</i>,", (*struc)->refcount__gc, (*struc)->is_ref__gc), 1);
+		xdebug_str_add_fmt(str, "<i>(refcount=%d, is_ref=%d)</i>,", (*struc)->refcount__gc, (*struc)->is_ref__gc);
 	}
 #endif
 
@@ -2743,37 +2743,37 @@ static void xdebug_var_synopsis_fancy(zval **struc, xdebug_str *str, int level,
 #if PHP_VERSION_ID >= 70000
 		case IS_TRUE:
 		case IS_FALSE:
-			xdebug_str_add(str, xdebug_sprintf("<font color='%s'>%s</font>", COLOR_BOOL, Z_TYPE_P(*struc) == IS_TRUE ? "true" : "false"), 1);
+			xdebug_str_add_fmt(str, "<font color='%s'>%s</font>", COLOR_BOOL, Z_TYPE_P(*struc) == IS_TRUE ? "true" : "false");
 			break;
 #else
 		case IS_BOOL:
-			xdebug_str_add(str, xdebug_sprintf("<font color='%s'>bool</font>", COLOR_BOOL), 1);
+			xdebug_str_add_fmt(str, "<font color='%s'>bool</font>", COLOR_BOOL);
 			break;
 #endif
 		case IS_NULL:
-			xdebug_str_add(str, xdebug_sprintf("<font color='%s'>null</font>", COLOR_NULL), 1);
+			xdebug_str_add_fmt(str, "<font color='%s'>null</font>", COLOR_NULL);
 			break;
 
 		case IS_LONG:
-			xdebug_str_add(str, xdebug_sprintf("<font color='%s'>long</font>", COLOR_LONG), 1);
+			xdebug_str_add_fmt(str, "<font color='%s'>long</font>", COLOR_LONG);
 			break;
 
 		case IS_DOUBLE:
-			xdebug_str_add(str, xdebug_sprintf("<font color='%s'>double</font>", COLOR_DOUBLE), 1);
+			xdebug_str_add_fmt(str, "<font color='%s'>double</font>", COLOR_DOUBLE);
 			break;
 
 		case IS_STRING:
-			xdebug_str_add(str, xdebug_sprintf("<font color='%s'>string(%d)</font>", COLOR_STRING, Z_STRLEN_P(*struc)), 1);
+			xdebug_str_add_fmt(str, "<font color='%s'>string(%d)</font>", COLOR_STRING, Z_STRLEN_P(*struc));
 			break;
 
 		case IS_ARRAY:
 			myht = Z_ARRVAL_P(*struc);
-			xdebug_str_add(str, xdebug_sprintf("<font color='%s'>array(%d)</font>", COLOR_ARRAY, myht->nNumOfElements), 1);
+			xdebug_str_add_fmt(str, "<font color='%s'>array(%d)</font>", COLOR_ARRAY, myht->nNumOfElements);
 			break;
 
 		case IS_OBJECT:
-			xdebug_str_add(str, xdebug_sprintf("<font color='%s'>object(%s)", COLOR_OBJECT, STR_NAME_VAL(Z_OBJCE_P(*struc)->name)), 1);
-			xdebug_str_add(str, xdebug_sprintf("[%d]", Z_OBJ_HANDLE_P(*struc)), 1);
+			xdebug_str_add_fmt(str, "<font color='%s'>object(%s)", COLOR_OBJECT, STR_NAME_VAL(Z_OBJCE_P(*struc)->name));
+			xdebug_str_add_fmt(str, "[%d]", Z_OBJ_HANDLE_P(*struc));
 			xdebug_str_addl(str, "</font>", 7, 0);
 			break;
 
@@ -2782,22 +2782,22 @@ static void xdebug_var_synopsis_fancy(zval **struc, xdebug_str *str, int level,
 
 #if PHP_VERSION_ID >= 70000
 			type_name = (char *) zend_rsrc_list_get_rsrc_type(Z_RES_P(*struc) TSRMLS_CC);
-			xdebug_str_add(str, xdebug_sprintf("<font color='%s'>resource(%ld, %s)</font>", COLOR_RESOURCE, Z_RES_P(*struc)->handle, type_name ? type_name : "Unknown"), 1);
+			xdebug_str_add_fmt(str, "<font color='%s'>resource(%ld, %s)</font>", COLOR_RESOURCE, Z_RES_P(*struc)->handle, type_name ? type_name : "Unknown");
 #else
 			type_name = (char *) zend_rsrc_list_get_rsrc_type(Z_LVAL_P(*struc) TSRMLS_CC);
-			xdebug_str_add(str, xdebug_sprintf("<font color='%s'>resource(%ld, %s)</font>", COLOR_RESOURCE, Z_LVAL_P(*struc), type_name ? type_name : "Unknown"), 1);
+			xdebug_str_add_fmt(str, "<font color='%s'>resource(%ld, %s)</font>", COLOR_RESOURCE, Z_LVAL_P(*struc), type_name ? type_name : "Unknown");
 #endif
 			break;
 		}
 
 #if PHP_VERSION_ID >= 70000
 		case IS_UNDEF:
-			xdebug_str_add(str, xdebug_sprintf("<font color='%s'>*uninitialized*</font>", COLOR_NULL), 0);
+			xdebug_str_add_fmt(str, "<font color='%s'>*uninitialized*</font>", COLOR_NULL);
 			break;
 #endif
 
 		default:
-			xdebug_str_add(str, xdebug_sprintf("<font color='%s'>NFC</font>", COLOR_NULL), 0);
+			xdebug_str_add_fmt(str, "<font color='%s'>NFC</font>", COLOR_NULL);
 			break;
 	}
 }